@@ -18,6 +18,8 @@
 #include "ns3/drop-tail-queue.h"
 #include "ns3/red-queue.h"
 #include "ns3/netanim-module.h"
+#include "ns3/mpi-interface.h"
+#include "ns3/point-to-point-partition.h"
 
 using namespace ns3;
 using namespace std;
@@ -66,6 +68,9 @@ double g_rtt = 4*Time(g_linkDelay).GetMicroSeconds();
 bool g_slowDownXmpLike = false;
 bool g_queueModeBytes = false;// If true, the queues perform per bytes rather than packets.
 bool g_dctcpAlphaPerAck = false;
+bool g_dctcpFixedPoint = false;
+bool g_lazyRto = false;
+bool g_distributed = false;
 bool g_dctcpFastAlpha = false;
 uint32_t g_DTQmarkTh = 1;
 bool g_SDEL = false;
@@ -83,6 +88,17 @@ bool     g_specialSubflow = false;
 // Cwnd/Rwnd
 uint32_t g_cwndMin = 1;
 uint32_t g_rwndScale = 100;
+// Receiver ACKs: one per segment by default
+uint32_t g_delAckCount = 0;
+uint32_t g_delAckTimeout = 200000; // us
+uint32_t g_ackCoalesceTime = 0;   // us, 0 disables
+// Sender: MSS per super-segment, 1 sends every segment on its own
+uint32_t g_superSegment = 1;
+uint32_t g_rcvBuf = 0;          // 0 keeps the constant receive window scaled by RwndScale
+uint32_t g_rcvBufMax = 6291456; // 0 disables receive buffer autotuning
+// Event list: empty keeps the SchedulerType default, a trace file records every scheduler operation
+string g_scheduler = "";
+string g_schedTrace = "";
 //IsAdaptiveSubflows
 bool g_IsAdaptiveSubflow = false;
 uint32_t g_incastThreshold = 10;
@@ -130,6 +146,13 @@ GetIpAddr(NodeContainer nc, uint32_t dst)
   return iaddrServer.GetLocal ();
 }
 
+// In distributed runs, applications and monitors only go on the nodes of this rank
+bool
+IsLocal (Ptr<Node> node)
+{
+  return !g_distributed || node->GetSystemId () == MpiInterface::GetSystemId ();
+}
+
 
 string
 SetupSource (MpTcpBulkSendHelper& source, uint32_t i)
@@ -475,6 +498,8 @@ FlowSchedulerNormal()
         tmpFlowType = SetupSource (source, i);
 
       source.SetAttribute ("OutputFileName", StringValue (SetupSimFileName (i + 1)));
+      if (!IsLocal (Sender_c.Get (i)))
+        continue;
       ApplicationContainer sourceApps = source.Install (Sender_c.Get (i));
       sourceApps.Start (Seconds (i * g_flowgap));
       sourceApps.Stop (Seconds (g_simTime));
@@ -516,6 +541,8 @@ FlowSchedulerIncastInterval()
       else
         tmpFlowType = SetupSource (source, i);
 
+      if (!IsLocal (Sender_c.Get (i)))
+        continue;
       ApplicationContainer sourceApps = source.Install (Sender_c.Get (i));
       sourceApps.Start (Seconds (i * g_flowgap));
       sourceApps.Stop (Seconds (g_simTime));
@@ -736,6 +763,41 @@ SetDctcpAlphaPerAck (std::string input)
   return true;
 }
 bool
+SetScheduler (std::string input)
+{
+  cout << "Scheduler        : " << g_scheduler << " -> " << input << endl;
+  g_scheduler = input;
+  return true;
+}
+bool
+SetSchedTrace (std::string input)
+{
+  cout << "SchedTrace       : " << g_schedTrace << " -> " << input << endl;
+  g_schedTrace = input;
+  return true;
+}
+bool
+SetDctcpFixedPoint (std::string input)
+{
+  cout << "DctcpFixedPoint  : " << g_dctcpFixedPoint << " -> " << input << endl;
+  g_dctcpFixedPoint = atoi (input.c_str ());
+  return true;
+}
+bool
+SetLazyRto (std::string input)
+{
+  cout << "LazyRto          : " << g_lazyRto << " -> " << input << endl;
+  g_lazyRto = atoi (input.c_str ());
+  return true;
+}
+bool
+SetDistributed (std::string input)
+{
+  cout << "Distributed      : " << g_distributed << " -> " << input << endl;
+  g_distributed = atoi (input.c_str ());
+  return true;
+}
+bool
 SetDctcpFastAlpha (std::string input)
 {
   cout << "DctcpFastAlpha   : " << g_dctcpFastAlpha << " -> " << input << endl;
@@ -817,6 +879,54 @@ SetRcwndScale (std::string input)
   return true;
 }
 
+bool
+SetDelAckCount (std::string input)
+{
+  cout << "DelAckCount      : " << g_delAckCount << " -> " << input << endl;
+  g_delAckCount = atoi (input.c_str ());
+  return true;
+}
+
+bool
+SetDelAckTimeout (std::string input)
+{
+  cout << "DelAckTimeout    : " << g_delAckTimeout << "us -> " << input + "us" << endl;
+  g_delAckTimeout = atoi (input.c_str ());
+  return true;
+}
+
+bool
+SetAckCoalesceTime (std::string input)
+{
+  cout << "AckCoalesceTime  : " << g_ackCoalesceTime << " -> " << input + "us" << endl;
+  g_ackCoalesceTime = atoi (input.c_str ());
+  return true;
+}
+
+bool
+SetSuperSegment (std::string input)
+{
+  cout << "SuperSegment     : " << g_superSegment << " -> " << input << endl;
+  g_superSegment = atoi (input.c_str ());
+  return true;
+}
+
+bool
+SetRcvBuf (std::string input)
+{
+  cout << "RcvBuf           : " << g_rcvBuf << " -> " << input << endl;
+  g_rcvBuf = atoi (input.c_str ());
+  return true;
+}
+
+bool
+SetRcvBufMax (std::string input)
+{
+  cout << "RcvBufMax        : " << g_rcvBufMax << " -> " << input << endl;
+  g_rcvBufMax = atoi (input.c_str ());
+  return true;
+}
+
 bool
 SetCwndMin (std::string input)
 {
@@ -927,6 +1037,14 @@ main (int argc, char *argv[])
   cmd.AddValue ("ds", "Dynamic Subflow ", MakeCallback(SetIsAdaptiveSubflow));
   cmd.AddValue ("cwndmin", "Flows", MakeCallback (SetCwndMin));
   cmd.AddValue ("rwndscale", "Flows", MakeCallback (SetRcwndScale));
+  cmd.AddValue ("dac", "Delayed ACK count, 0 ACKs every segment", MakeCallback (SetDelAckCount));
+  cmd.AddValue ("dat", "Delayed ACK timeout (us)", MakeCallback (SetDelAckTimeout));
+  cmd.AddValue ("act", "ACK coalescing time (us), 0 disables", MakeCallback (SetAckCoalesceTime));
+  cmd.AddValue ("tso", "MSS per super-segment, 1 disables", MakeCallback (SetSuperSegment));
+  cmd.AddValue ("rcvbuf", "Receive buffer in bytes advertised as window, 0 disables flow control", MakeCallback (SetRcvBuf));
+  cmd.AddValue ("sched", "Scheduler TypeId, e.g. ns3::MapScheduler", MakeCallback (SetScheduler));
+  cmd.AddValue ("schedtrace", "Record the scheduler operations to this file for bench-scheduler", MakeCallback (SetSchedTrace));
+  cmd.AddValue ("rcvbufmax", "Receive buffer autotuning limit in bytes, 0 disables autotuning", MakeCallback (SetRcvBufMax));
   cmd.AddValue ("ssf", "Special subflow", MakeCallback (SetSpecialSubflow));
   cmd.AddValue ("ss",  "Special Source Active", MakeCallback (SetSpecialSource));
   cmd.AddValue ("sft", "Special FlowType", MakeCallback (SetSpecialFlowType));
@@ -938,6 +1056,9 @@ main (int argc, char *argv[])
   cmd.AddValue ("dtqmt", "DropTailQueue Marking Threshold", MakeCallback(SetDTQMarkTh));
   cmd.AddValue ("dfa", " DCTCP Non-Smoothed Alpha", MakeCallback (SetDctcpFastAlpha));
   cmd.AddValue ("dapa", "DCTCP ALPHA PER ACK", MakeCallback (SetDctcpAlphaPerAck));
+  cmd.AddValue ("dfp", "DCTCP alpha in fixed-point from bytes acked", MakeCallback (SetDctcpFixedPoint));
+  cmd.AddValue ("lrto", "Lazy retransmission timers", MakeCallback (SetLazyRto));
+  cmd.AddValue ("mpi", "Run distributed over the ranks of mpirun", MakeCallback (SetDistributed));
   cmd.AddValue ("qsi", "queue sampling interval", MakeCallback (SetQueueSamplingInterval));
   cmd.AddValue ("qmb", "QUEUE_MODE_BYTES", MakeCallback (SetQueueMode));
   cmd.AddValue ("sdxl", " slow down xmp like", MakeCallback (SetSDXL));
@@ -964,12 +1085,38 @@ main (int argc, char *argv[])
   cmd.AddValue ("ratebeat", " Activate Rate Plotting", MakeCallback (SetRateBeat));
 
   cmd.Parse (argc, argv);
+  if (g_distributed)
+    { // Replace the simulator created above by the distributed one
+      Simulator::Destroy ();
+      GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DistributedSimulatorImpl"));
+      MpiInterface::Enable (&argc, &argv);
+    }
+  // The simulator already exists (RedTxQueue above), so SchedulerType cannot be used to pick its scheduler
+  if (g_schedTrace != "" || g_scheduler != "")
+    {
+      ObjectFactory scheduler;
+      TypeIdValue schedulerType;
+      GlobalValue::GetValueByName ("SchedulerType", schedulerType);
+      if (g_scheduler != "")
+        schedulerType.Set (TypeId::LookupByName (g_scheduler));
+      if (g_schedTrace != "")
+        {
+          scheduler.SetTypeId ("ns3::RecordingScheduler");
+          scheduler.Set ("Scheduler", schedulerType);
+          scheduler.Set ("FileName", StringValue (g_schedTrace));
+        }
+      else
+        scheduler.SetTypeId (schedulerType.Get ());
+      Simulator::SetScheduler (scheduler);
+    }
   Config::SetDefault ("ns3::MpTcpSocketBase::IncastExitThresh", UintegerValue(g_incastExitThreshold));
   Config::SetDefault ("ns3::MpTcpSocketBase::IncastThresh", UintegerValue(g_incastThreshold));
   Config::SetDefault ("ns3::MpTcpSocketBase::IsAdaptiveSubflow", BooleanValue(g_IsAdaptiveSubflow));
   Config::SetDefault ("ns3::MpTcpSocketBase::CwndMin", UintegerValue (g_cwndMin));
   Config::SetDefault ("ns3::MpTcpSocketBase::RwndScale", UintegerValue (g_rwndScale));
   Config::SetDefault ("ns3::MpTcpSocketBase::DctcpAlphaPerAck", BooleanValue (g_dctcpAlphaPerAck)); //SHOULD BE FALSE!!!
+  Config::SetDefault ("ns3::MpTcpSocketBase::DctcpFixedPoint", BooleanValue (g_dctcpFixedPoint));
+  Config::SetDefault ("ns3::MpTcpSocketBase::LazyRto", BooleanValue (g_lazyRto));
   Config::SetDefault ("ns3::MpTcpSocketBase::SlowDownXmpLike", BooleanValue (g_slowDownXmpLike));
   Config::SetDefault ("ns3::MpTcpSocketBase::ECN", BooleanValue (g_ecn));
   Config::SetDefault ("ns3::MpTcpSocketBase::LargePlotting", BooleanValue (g_enableLfPlotting));
@@ -996,7 +1143,17 @@ main (int argc, char *argv[])
   Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue (g_segmentSize));
   Config::SetDefault ("ns3::MpTcpSocketBase::gamma", UintegerValue (g_XmpGamma));
   Config::SetDefault ("ns3::MpTcpSocketBase::beta", UintegerValue (g_XmpBeta));
-  Config::SetDefault ("ns3::TcpSocket::DelAckCount", UintegerValue (0));
+  Config::SetDefault ("ns3::TcpSocket::DelAckCount", UintegerValue (g_delAckCount));
+  Config::SetDefault ("ns3::TcpSocket::DelAckTimeout", TimeValue (MicroSeconds (g_delAckTimeout)));
+  Config::SetDefault ("ns3::MpTcpSocketBase::AckCoalesceTime", TimeValue (MicroSeconds (g_ackCoalesceTime)));
+  Config::SetDefault ("ns3::MpTcpSocketBase::SuperSegment", UintegerValue (g_superSegment));
+  if (g_rcvBuf > 0)
+    {
+      Config::SetDefault ("ns3::MpTcpSocketBase::FlowControl", BooleanValue (true));
+      Config::SetDefault ("ns3::TcpSocket::RcvBufSize", UintegerValue (g_rcvBuf));
+      Config::SetDefault ("ns3::MpTcpSocketBase::RcvBufAutoTuning", BooleanValue (g_rcvBufMax > 0));
+      Config::SetDefault ("ns3::MpTcpSocketBase::RcvBufMax", UintegerValue (g_rcvBufMax));
+    }
 
   if (g_enableDCTCP)
     {
@@ -1054,6 +1211,22 @@ main (int argc, char *argv[])
   InternetStackHelper netStack;
   netStack.Install (Total_c);
 
+  if (g_distributed)
+    { // Weight the links by the flows expected on them: each flow goes from its sender
+      // to receiver 0 and its subflows are spread over the core switches
+      PointToPointPartitionHelper partition;
+      double coreShare = 1.0 / Core_c.GetN ();
+      for (uint32_t s = 0; s < Sender_c.GetN (); s++)
+        for (uint32_t c = 0; c < Core_c.GetN (); c++)
+          partition.AddLink (Sender_c.Get (s), Core_c.Get (c), Time (g_linkDelay), s < g_flowNumber ? coreShare : 0);
+      for (uint32_t c = 0; c < Core_c.GetN (); c++)
+        for (uint32_t r = 0; r < Receiver_c.GetN (); r++)
+          partition.AddLink (Core_c.Get (c), Receiver_c.Get (r), Time (g_linkDelay), r == 0 ? g_flowNumber * coreShare : 0);
+      partition.Partition (Total_c, MpiInterface::GetSize ());
+      cout << "Rank " << MpiInterface::GetSystemId () << "/" << MpiInterface::GetSize () << " lookahead "
+          << partition.GetLookAhead ().GetSeconds () << "s cut traffic " << partition.GetCutTraffic () << endl;
+    }
+
   NS_LOG_INFO("Create channel");
 
   PointToPointHelper p2p;
@@ -1109,13 +1282,16 @@ main (int argc, char *argv[])
   NS_LOG_INFO("Install Routing tables");
   Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
-  QueueMonitor ();
+  if (IsLocal (Core_c.Get (0)))
+    QueueMonitor ();
 
   NS_LOG_INFO("Create Applications");
   // MPTCP SINK
   for (uint32_t i = 0; i < Receiver_c.GetN (); i++)
     {
       MpTcpPacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), servPort));
+      if (!IsLocal (Receiver_c.Get (i)))
+        continue;
       ApplicationContainer sinkApp = sink.Install (Receiver_c.Get (i));
       sinkApp.Start (Seconds (0.0));
     }
@@ -1143,8 +1319,13 @@ main (int argc, char *argv[])
   SimTimeMonitor();//Simulator::Schedule (Seconds (1), &SimTimeMonitor);
   Simulator::Run ();
   Simulator::Stop (Seconds (100));
-  GenerateQueuePlot ();
-  GenerateQueueCDFPlot ();
+  if (IsLocal (Core_c.Get (0)))
+    {
+      GenerateQueuePlot ();
+      GenerateQueueCDFPlot ();
+    }
   Simulator::Destroy ();
+  if (g_distributed)
+    MpiInterface::Disable ();
   NS_LOG_INFO("Simulation End");
 }
@@ -0,0 +1,57 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef ATOMIC_COUNTER_H
+#define ATOMIC_COUNTER_H
+
+#include "ns3/core-config.h"
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup ptr
+ * \brief Reference count updates of objects which may be shared between threads
+ *
+ * In builds configured with --enable-mtp, objects such as packets are handed from one
+ * thread of ns3::MultithreadedSimulatorImpl to another while both hold references, so
+ * their counts are updated atomically. Other builds use plain increments.
+ *
+ * \returns the count after the update
+ */
+inline uint32_t
+AtomicIncrement (uint32_t &count)
+{
+#ifdef NS3_MTP
+  return __sync_add_and_fetch (&count, 1);
+#else
+  return ++count;
+#endif
+}
+
+inline uint32_t
+AtomicDecrement (uint32_t &count)
+{
+#ifdef NS3_MTP
+  return __sync_sub_and_fetch (&count, 1);
+#else
+  return --count;
+#endif
+}
+
+} // namespace ns3
+
+#endif /* ATOMIC_COUNTER_H */
@@ -25,6 +25,104 @@ NS_LOG_COMPONENT_DEFINE ("EventImpl");
 
 namespace ns3 {
 
+namespace {
+
+struct FreeBlock
+{
+  FreeBlock *next;
+};
+
+// Zero-initialized, as thread-local storage needs a POD type
+struct EventPool
+{
+  FreeBlock *free[EventImpl::POOL_CLASSES];
+  uint32_t nFree[EventImpl::POOL_CLASSES];
+  uint64_t allocations;
+  uint64_t heapAllocations;
+};
+
+#if defined (__GNUC__)
+#define EVENT_POOL_ENABLED 1
+__thread EventPool g_eventPool;
+#else
+#define EVENT_POOL_ENABLED 0
+EventPool g_eventPool;
+#endif
+
+} // anonymous namespace
+
+void *
+EventImpl::operator new (std::size_t size)
+{
+  EventPool &pool = g_eventPool;
+  pool.allocations++;
+  std::size_t c = (size - 1) / POOL_GRANULE;
+  if (!EVENT_POOL_ENABLED || c >= POOL_CLASSES)
+    {
+      pool.heapAllocations++;
+      return ::operator new (size);
+    }
+  FreeBlock *block = pool.free[c];
+  if (block != 0)
+    {
+      pool.free[c] = block->next;
+      pool.nFree[c]--;
+      return block;
+    }
+  pool.heapAllocations++;
+  // Round up so that the block can be reused by any event of the class
+  return ::operator new ((c + 1) * POOL_GRANULE);
+}
+
+void
+EventImpl::operator delete (void *p, std::size_t size)
+{
+  if (p == 0)
+    {
+      return;
+    }
+  EventPool &pool = g_eventPool;
+  std::size_t c = (size - 1) / POOL_GRANULE;
+  if (!EVENT_POOL_ENABLED || c >= POOL_CLASSES || pool.nFree[c] >= POOL_MAX_FREE)
+    {
+      ::operator delete (p);
+      return;
+    }
+  FreeBlock *block = static_cast<FreeBlock *> (p);
+  block->next = pool.free[c];
+  pool.free[c] = block;
+  pool.nFree[c]++;
+}
+
+uint64_t
+EventImpl::GetAllocations (void)
+{
+  return g_eventPool.allocations;
+}
+
+uint64_t
+EventImpl::GetHeapAllocations (void)
+{
+  return g_eventPool.heapAllocations;
+}
+
+void
+EventImpl::ReleasePool (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  EventPool &pool = g_eventPool;
+  for (uint32_t c = 0; c < POOL_CLASSES; c++)
+    {
+      while (pool.free[c] != 0)
+        {
+          FreeBlock *block = pool.free[c];
+          pool.free[c] = block->next;
+          ::operator delete (block);
+        }
+      pool.nFree[c] = 0;
+    }
+}
+
 EventImpl::~EventImpl ()
 {
   NS_LOG_FUNCTION (this);
@@ -21,6 +21,7 @@
 #define EVENT_IMPL_H
 
 #include <stdint.h>
+#include <cstddef>
 #include "simple-ref-count.h"
 
 namespace ns3 {
@@ -35,6 +36,14 @@ namespace ns3 {
  * obviously (there are Ref and Unref methods) reference-counted and
  * most subclasses are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * Since events are created and freed at a high rate, they are allocated from
+ * free lists kept by each thread, one per size class of POOL_GRANULE bytes
+ * up to POOL_CLASSES * POOL_GRANULE bytes. Larger subclasses, and all of
+ * them on compilers without thread-local storage, use the global allocator.
+ * An event may be freed by another thread than the one which created it, as
+ * the realtime simulator does with events scheduled from other threads: its
+ * memory then moves to the free lists of the thread which freed it.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -58,6 +67,30 @@ public:
    */
   bool IsCancelled (void);
 
+  static void * operator new (std::size_t size);
+  static void operator delete (void *p, std::size_t size);
+  /**
+   * \returns the number of events created by the calling thread
+   */
+  static uint64_t GetAllocations (void);
+  /**
+   * \returns the number of events created by the calling thread which
+   * could not reuse memory from its free lists
+   */
+  static uint64_t GetHeapAllocations (void);
+  /**
+   * Return the memory held in the free lists of the calling thread to the
+   * global allocator.
+   */
+  static void ReleasePool (void);
+
+  enum
+  {
+    POOL_GRANULE = 16,
+    POOL_CLASSES = 16,
+    POOL_MAX_FREE = 1 << 16   // Largest number of free blocks kept per class
+  };
+
 protected:
   virtual void Notify (void) = 0;
 
@@ -147,7 +147,14 @@ void
 HeapScheduler::BottomUp (void)
 {
   NS_LOG_FUNCTION (this);
-  uint32_t index = Last ();
+  BottomUp (Last ());
+}
+
+void
+HeapScheduler::BottomUp (uint32_t start)
+{
+  NS_LOG_FUNCTION (this << start);
+  uint32_t index = start;
   while (!IsRoot (index)
          && IsLessStrictly (index, Parent (index)))
     {
@@ -230,7 +237,12 @@ HeapScheduler::Remove (const Event &ev)
           NS_ASSERT (m_heap[i].impl == ev.impl);
           Exch (i, Last ());
           m_heap.pop_back ();
-          TopDown (i);
+          if (i < m_heap.size ())
+            {
+              // The last event may belong above i as well as below it
+              BottomUp (i);
+              TopDown (i);
+            }
           return;
         }
     }
@@ -75,6 +75,7 @@ private:
 
   inline void Exch (uint32_t a, uint32_t b);
   void BottomUp (void);
+  void BottomUp (uint32_t start);
   void TopDown (uint32_t start);
 
   BinaryHeap m_heap;
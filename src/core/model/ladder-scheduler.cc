@@ -0,0 +1,315 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LadderScheduler")
+  ;
+
+NS_OBJECT_ENSURE_REGISTERED (LadderScheduler)
+  ;
+
+namespace {
+
+bool
+IsLater (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return a.key > b.key;
+}
+
+} // anonymous namespace
+
+TypeId
+LadderScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LadderScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<LadderScheduler> ()
+  ;
+  return tid;
+}
+
+LadderScheduler::LadderScheduler ()
+  : m_topMin (0),
+    m_topMax (0),
+    m_topStart (0),
+    m_nRungs (0),
+    m_size (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+LadderScheduler::~LadderScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint64_t
+LadderScheduler::CurrentStart (const Rung &rung) const
+{
+  return rung.start + rung.current * rung.width;
+}
+
+void
+LadderScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint64_t ts = ev.key.m_ts;
+  m_size++;
+  if (ts >= m_topStart)
+    {
+      if (m_top.empty ())
+        {
+          m_topMin = ts;
+          m_topMax = ts;
+        }
+      else
+        {
+          m_topMin = std::min (m_topMin, ts);
+          m_topMax = std::max (m_topMax, ts);
+        }
+      m_top.push_back (ev);
+      return;
+    }
+  for (uint32_t i = 0; i < m_nRungs; i++)
+    {
+      Rung &rung = m_rungs[i];
+      if (ts >= CurrentStart (rung))
+        {
+          rung.buckets[(ts - rung.start) / rung.width].push_back (ev);
+          rung.count++;
+          return;
+        }
+    }
+  InsertBottom (ev);
+  if (m_bottom.size () > THRESHOLD && m_nRungs < MAX_RUNGS
+      && m_bottom.front ().key.m_ts != m_bottom.back ().key.m_ts)
+    {
+      SpawnFromBottom ();
+    }
+}
+
+void
+LadderScheduler::InsertBottom (const Event &ev)
+{
+  m_bottom.insert (std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, IsLater), ev);
+}
+
+/*
+ * Spread events over a new rung covering [start, end), with about one event per bucket.
+ */
+void
+LadderScheduler::SpawnRung (uint64_t start, uint64_t end, Bucket &events)
+{
+  NS_LOG_FUNCTION (this << start << end << events.size ());
+  NS_ASSERT (m_nRungs < MAX_RUNGS && start < end);
+  Rung &rung = m_rungs[m_nRungs++];
+  uint64_t span = end - start;
+  uint64_t n = std::max<uint64_t> (events.size (), 1);
+  rung.width = (span - 1) / std::min<uint64_t> (n, MAX_BUCKETS) + 1;
+  rung.nBuckets = (span - 1) / rung.width + 1;
+  rung.start = start;
+  rung.current = 0;
+  rung.count = events.size ();
+  if (rung.buckets.size () < rung.nBuckets)
+    {
+      rung.buckets.resize (rung.nBuckets);
+    }
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      NS_ASSERT (i->key.m_ts >= start && i->key.m_ts < end);
+      rung.buckets[(i->key.m_ts - start) / rung.width].push_back (*i);
+    }
+  events.clear ();
+}
+
+/*
+ * Too many events were inserted in the range of the bottom: move them to a new rung spanning
+ * the bottom, so that they are not kept sorted one insertion at a time. Without rungs, the
+ * bottom extends up to the top.
+ */
+void
+LadderScheduler::SpawnFromBottom (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint64_t end = m_topStart;
+  if (m_nRungs > 0)
+    {
+      end = CurrentStart (m_rungs[m_nRungs - 1]);
+    }
+  SpawnRung (m_bottom.back ().key.m_ts, end, m_bottom);
+}
+
+void
+LadderScheduler::TopToLadder (void)
+{
+  NS_LOG_FUNCTION (this << m_top.size () << m_topMin << m_topMax);
+  NS_ASSERT (m_nRungs == 0 && m_bottom.empty () && !m_top.empty ());
+  if (m_top.size () <= THRESHOLD || m_topMin == m_topMax)
+    {
+      m_bottom.swap (m_top);
+      std::sort (m_bottom.begin (), m_bottom.end (), IsLater);
+      m_topStart = m_topMax + 1;
+    }
+  else
+    {
+      SpawnRung (m_topMin, m_topMax + 1, m_top);
+      m_topStart = m_rungs[0].start + m_rungs[0].nBuckets * m_rungs[0].width;
+    }
+}
+
+/*
+ * Move the earliest non empty bucket down to the bottom, splitting it over new rungs while
+ * it holds too many events.
+ */
+void
+LadderScheduler::Refill (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_bottom.empty () && m_size > 0);
+  while (m_bottom.empty ())
+    {
+      if (m_nRungs == 0)
+        {
+          TopToLadder ();
+          continue;
+        }
+      Rung &rung = m_rungs[m_nRungs - 1];
+      if (rung.count == 0)
+        {
+          m_nRungs--;
+          continue;
+        }
+      while (rung.buckets[rung.current].empty ())
+        {
+          rung.current++;
+        }
+      Bucket &bucket = rung.buckets[rung.current];
+      uint64_t start = CurrentStart (rung);
+      rung.current++;
+      rung.count -= bucket.size ();
+
+      bool split = bucket.size () > THRESHOLD && m_nRungs < MAX_RUNGS && rung.width > 1;
+      if (split)
+        {
+          uint64_t tsMin = bucket[0].key.m_ts;
+          uint64_t tsMax = tsMin;
+          for (Bucket::const_iterator i = bucket.begin (); i != bucket.end (); ++i)
+            {
+              tsMin = std::min (tsMin, i->key.m_ts);
+              tsMax = std::max (tsMax, i->key.m_ts);
+            }
+          split = tsMin != tsMax;
+        }
+      if (split)
+        {
+          SpawnRung (start, start + rung.width, bucket);
+        }
+      else
+        {
+          m_bottom.swap (bucket);
+          std::sort (m_bottom.begin (), m_bottom.end (), IsLater);
+        }
+    }
+}
+
+bool
+LadderScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_size == 0;
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottom.empty ())
+    {
+      // Moving events down the ladder does not change the event list
+      const_cast<LadderScheduler *> (this)->Refill ();
+    }
+  return m_bottom.back ();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_bottom.empty ())
+    {
+      Refill ();
+    }
+  Scheduler::Event ev = m_bottom.back ();
+  m_bottom.pop_back ();
+  m_size--;
+  NS_LOG_LOGIC ("remove ts=" << ev.key.m_ts << ", key=" << ev.key.m_uid);
+  return ev;
+}
+
+void
+LadderScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  NS_ASSERT (!IsEmpty ());
+  uint64_t ts = ev.key.m_ts;
+  Bucket *bucket = &m_bottom;
+  if (ts >= m_topStart)
+    {
+      bucket = &m_top;
+    }
+  else
+    {
+      for (uint32_t i = 0; i < m_nRungs; i++)
+        {
+          Rung &rung = m_rungs[i];
+          if (ts >= CurrentStart (rung))
+            {
+              bucket = &rung.buckets[(ts - rung.start) / rung.width];
+              rung.count--;
+              break;
+            }
+        }
+    }
+  m_size--;
+  if (bucket == &m_bottom)
+    {
+      Bucket::iterator i = std::lower_bound (m_bottom.begin (), m_bottom.end (), ev, IsLater);
+      NS_ASSERT (i != m_bottom.end () && i->key.m_uid == ev.key.m_uid);
+      m_bottom.erase (i);
+      return;
+    }
+  for (Bucket::iterator i = bucket->begin (); i != bucket->end (); ++i)
+    {
+      if (i->key.m_uid == ev.key.m_uid)
+        {
+          NS_ASSERT (ev.impl == i->impl);
+          *i = bucket->back ();
+          bucket->pop_back ();
+          return;
+        }
+    }
+  NS_ASSERT (false);
+}
+
+} // namespace ns3
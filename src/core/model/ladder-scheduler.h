@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+class EventImpl;
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue of "Ladder Queue: An O(1) Priority
+ * Queue Structure for Large-Scale Discrete Event Simulation" by Tang, Goh and Thng (2005).
+ * Events are kept in three tiers:
+ *  - Top: an unsorted list of the events beyond the range of the rungs. Far future
+ *    events, such as retransmission timers which are usually cancelled before they
+ *    expire, are appended to it in O(1) and only looked at again once the simulation
+ *    gets near them.
+ *  - Rungs: up to MAX_RUNGS arrays of unsorted buckets. Each rung spans the current
+ *    bucket of the rung above it, with a bucket width derived from the number of
+ *    events it had to split, so the bucket width adapts to the event density.
+ *  - Bottom: a short sorted list holding the earliest events, from which events are
+ *    dequeued.
+ * A bucket is only sorted once it reaches the bottom with at most THRESHOLD events;
+ * larger buckets are split over a new rung first, and a bottom grown past THRESHOLD by
+ * insertions is moved to a new rung. Insert and RemoveNext are close to O(1) while the
+ * rungs can follow the event density. Events sharing a timestamp cannot be split, and
+ * once all MAX_RUNGS rungs are in use the bottom grows with sorted insertions, linear
+ * in its size. Remove is linear in the size of the tier which holds the event.
+ */
+class LadderScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  LadderScheduler ();
+  virtual ~LadderScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+private:
+  enum
+  {
+    MAX_RUNGS = 8,
+    THRESHOLD = 50,         // Largest bucket sorted into the bottom as is
+    MAX_BUCKETS = 1 << 16   // Largest number of buckets of a rung
+  };
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  struct Rung
+  {
+    uint64_t start;         // Timestamp of the start of bucket 0
+    uint64_t width;         // Time span of a bucket
+    uint32_t current;       // First bucket not yet moved down
+    uint32_t nBuckets;
+    uint32_t count;         // Events in the buckets from current on
+    std::vector<Bucket> buckets;
+  };
+
+  uint64_t CurrentStart (const Rung &rung) const;
+  void InsertBottom (const Event &ev);
+  void SpawnRung (uint64_t start, uint64_t end, Bucket &events);
+  void SpawnFromBottom (void);
+  void TopToLadder (void);
+  void Refill (void);
+
+  Bucket m_top;
+  uint64_t m_topMin;
+  uint64_t m_topMax;
+  // Events at or after this timestamp go to the top
+  uint64_t m_topStart;
+  Rung m_rungs[MAX_RUNGS];
+  uint32_t m_nRungs;
+  // Sorted from the latest to the earliest event, which is dequeued from the back
+  Bucket m_bottom;
+  uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
@@ -0,0 +1,133 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "recording-scheduler.h"
+#include "map-scheduler.h"
+#include "object-factory.h"
+#include "string.h"
+#include "fatal-error.h"
+#include "log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("RecordingScheduler")
+  ;
+
+NS_OBJECT_ENSURE_REGISTERED (RecordingScheduler)
+  ;
+
+TypeId
+RecordingScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::RecordingScheduler")
+    .SetParent<Scheduler> ()
+    .AddConstructor<RecordingScheduler> ()
+    .AddAttribute ("FileName",
+                   "The file the scheduler operations are written to.",
+                   StringValue ("scheduler.trace"),
+                   MakeStringAccessor (&RecordingScheduler::SetFileName),
+                   MakeStringChecker ())
+    .AddAttribute ("Scheduler",
+                   "The type of the scheduler which holds the events.",
+                   TypeIdValue (MapScheduler::GetTypeId ()),
+                   MakeTypeIdAccessor (&RecordingScheduler::SetScheduler,
+                                       &RecordingScheduler::GetScheduler),
+                   MakeTypeIdChecker ())
+  ;
+  return tid;
+}
+
+RecordingScheduler::RecordingScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+RecordingScheduler::~RecordingScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+  m_trace.close ();
+}
+
+void
+RecordingScheduler::SetFileName (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  if (m_trace.is_open ())
+    {
+      m_trace.close ();
+    }
+  m_trace.open (fileName.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_trace.good ())
+    {
+      NS_FATAL_ERROR ("Cannot open scheduler trace " << fileName);
+    }
+}
+
+void
+RecordingScheduler::SetScheduler (TypeId tid)
+{
+  NS_LOG_FUNCTION (this << tid);
+  NS_ASSERT_MSG (tid != GetTypeId (), "A RecordingScheduler cannot record itself");
+  NS_ASSERT_MSG (m_scheduler == 0 || m_scheduler->IsEmpty (), "Cannot change the scheduler of pending events");
+  ObjectFactory factory;
+  factory.SetTypeId (tid);
+  m_scheduler = factory.Create<Scheduler> ();
+}
+
+TypeId
+RecordingScheduler::GetScheduler (void) const
+{
+  return m_scheduler->GetInstanceTypeId ();
+}
+
+void
+RecordingScheduler::Record (char op, const EventKey &key)
+{
+  m_trace.write (&op, 1);
+  m_trace.write (reinterpret_cast<const char *> (&key.m_ts), sizeof (key.m_ts));
+  m_trace.write (reinterpret_cast<const char *> (&key.m_uid), sizeof (key.m_uid));
+}
+
+void
+RecordingScheduler::Insert (const Event &ev)
+{
+  Record ('i', ev.key);
+  m_scheduler->Insert (ev);
+}
+bool
+RecordingScheduler::IsEmpty (void) const
+{
+  return m_scheduler->IsEmpty ();
+}
+Scheduler::Event
+RecordingScheduler::PeekNext (void) const
+{
+  return m_scheduler->PeekNext ();
+}
+Scheduler::Event
+RecordingScheduler::RemoveNext (void)
+{
+  Event ev = m_scheduler->RemoveNext ();
+  Record ('r', ev.key);
+  return ev;
+}
+void
+RecordingScheduler::Remove (const Event &ev)
+{
+  Record ('x', ev.key);
+  m_scheduler->Remove (ev);
+}
+
+} // namespace ns3
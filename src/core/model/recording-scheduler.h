@@ -0,0 +1,67 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RECORDING_SCHEDULER_H
+#define RECORDING_SCHEDULER_H
+
+#include "scheduler.h"
+#include "type-id.h"
+#include <stdint.h>
+#include <string>
+#include <fstream>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a scheduler which records the operations made on another one
+ *
+ * Every Insert, RemoveNext and Remove is forwarded to a scheduler of type
+ * Scheduler, and appended to FileName as a record of 13 bytes: the operation
+ * ('i', 'r' or 'x'), then the timestamp (8 bytes) and the uid (4 bytes) of
+ * the event, in host byte order. utils/bench-scheduler replays these traces
+ * against each scheduler. Cancelled events are not removed from the scheduler
+ * (EventId::Cancel is lazy), so they show up as 'r' records too.
+ *
+ * Select it with --SchedulerType=ns3::RecordingScheduler.
+ */
+class RecordingScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void);
+
+  RecordingScheduler ();
+  virtual ~RecordingScheduler ();
+
+  virtual void Insert (const Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Event PeekNext (void) const;
+  virtual Event RemoveNext (void);
+  virtual void Remove (const Event &ev);
+
+private:
+  void SetFileName (std::string fileName);
+  void SetScheduler (TypeId tid);
+  TypeId GetScheduler (void) const;
+  void Record (char op, const EventKey &key);
+
+  Ptr<Scheduler> m_scheduler;
+  std::ofstream m_trace;
+};
+
+} // namespace ns3
+
+#endif /* RECORDING_SCHEDULER_H */
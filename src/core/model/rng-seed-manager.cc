@@ -10,6 +10,11 @@ NS_LOG_COMPONENT_DEFINE ("RngSeedManager");
 namespace ns3 {
 
 static uint64_t g_nextStreamIndex = 0;
+#if defined (__GNUC__)
+static __thread uint64_t *g_streamIndexCounter = 0;
+#else
+static uint64_t *g_streamIndexCounter = 0;
+#endif
 static ns3::GlobalValue g_rngSeed ("RngSeed", 
                                    "The global seed of all rng streams",
                                    ns3::IntegerValue(1),
@@ -52,9 +57,15 @@ uint64_t RngSeedManager::GetRun ()
 uint64_t RngSeedManager::GetNextStreamIndex (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint64_t next = g_nextStreamIndex;
-  g_nextStreamIndex++;
+  uint64_t *counter = g_streamIndexCounter != 0 ? g_streamIndexCounter : &g_nextStreamIndex;
+  uint64_t next = *counter;
+  (*counter)++;
   return next;
 }
 
+void RngSeedManager::SetStreamIndexCounter (uint64_t *counter)
+{
+  g_streamIndexCounter = counter;
+}
+
 } // namespace ns3
@@ -62,6 +62,15 @@ public:
 
   static uint64_t GetNextStreamIndex(void);
 
+  /**
+   * \param counter next automatic stream index of the calling thread, 0 for the global one
+   *
+   * Parallel simulators point each thread at a counter of the partition it runs, so
+   * that random variables created during the simulation get the same streams
+   * whichever thread creates them.
+   */
+  static void SetStreamIndexCounter (uint64_t *counter);
+
 };
 
 // for compatibility
@@ -137,6 +137,7 @@ Simulator::Destroy (void)
   (*pimpl)->Destroy ();
   (*pimpl)->Unref ();
   *pimpl = 0;
+  EventImpl::ReleasePool ();
 }
 
 void
@@ -302,6 +303,18 @@ Simulator::GetContext (void)
   return GetImpl ()->GetContext ();
 }
 
+uint64_t
+Simulator::GetEventAllocations (void)
+{
+  return EventImpl::GetAllocations ();
+}
+
+uint64_t
+Simulator::GetEventHeapAllocations (void)
+{
+  return EventImpl::GetHeapAllocations ();
+}
+
 uint32_t
 Simulator::GetSystemId (void)
 {
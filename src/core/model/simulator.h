@@ -748,6 +748,18 @@ public:
    */
   static uint32_t GetContext (void);
 
+  /**
+   * \returns the number of events created by the calling thread, which is
+   * the simulation thread for events scheduled by simulation code
+   */
+  static uint64_t GetEventAllocations (void);
+
+  /**
+   * \returns the number of events created by the calling thread which were
+   * not recycled from the memory of freed events, see EventImpl
+   */
+  static uint64_t GetEventHeapAllocations (void);
+
   /**
    * \param time delay until the event expires
    * \param event the event to schedule
@@ -809,12 +809,6 @@ TypeId::LookupTraceSourceByName (std::string name) const
   return 0;
 }
 
-uint16_t 
-TypeId::GetUid (void) const
-{
-  NS_LOG_FUNCTION (this);
-  return m_tid;
-}
 void 
 TypeId::SetUid (uint16_t tid)
 {
@@ -329,7 +329,7 @@ public:
    * This is really an internal method which users are not expected
    * to use.
    */
-  uint16_t GetUid (void) const;
+  inline uint16_t GetUid (void) const;
   /**
    * \param tid the internal integer which uniquely identifies 
    *        this TypeId.
@@ -391,6 +391,11 @@ TypeId &TypeId::operator = (const TypeId &o)
 TypeId::~TypeId ()
 {
 }
+uint16_t
+TypeId::GetUid (void) const
+{
+  return m_tid;
+}
 inline bool operator == (TypeId a, TypeId b)
 {
   return a.m_tid == b.m_tid;
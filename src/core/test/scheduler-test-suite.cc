@@ -0,0 +1,203 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/scheduler.h"
+#include "ns3/object-factory.h"
+#include <set>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * Drive a scheduler directly with the event pattern of a data center run: bursts of events
+ * at the same time, many events in the next few microseconds, timers far in the future, and
+ * removals of pending events. Every event dequeued should be the earliest pending one.
+ */
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (std::string scheduler);
+  virtual void DoRun (void);
+
+private:
+  uint32_t Random (void);
+
+  std::string m_scheduler;
+  uint32_t m_seed;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (std::string scheduler)
+  : TestCase ("Check the event order of " + scheduler),
+    m_scheduler (scheduler),
+    m_seed (1)
+{
+}
+
+uint32_t
+SchedulerOrderTestCase::Random (void)
+{
+  m_seed = m_seed * 1103515245 + 12345;
+  return m_seed >> 8;
+}
+
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (m_scheduler);
+  Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+
+  std::set<std::pair<uint64_t, uint32_t> > pending;
+  std::vector<Scheduler::Event> inserted;
+  uint64_t now = 0;
+  uint32_t uid = 0;
+  for (uint32_t op = 0; op < 200000; op++)
+    {
+      uint32_t r = Random () % 100;
+      if (r < 55 || pending.empty ())
+        {
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key.m_uid = uid++;
+          ev.key.m_context = 0;
+          uint32_t kind = Random () % 10;
+          if (kind < 2)
+            {
+              ev.key.m_ts = now;
+            }
+          else if (kind < 7)
+            {
+              ev.key.m_ts = now + Random () % 2000;
+            }
+          else if (kind < 9)
+            {
+              ev.key.m_ts = now + Random () % 1000000;
+            }
+          else
+            {
+              ev.key.m_ts = now + 200000000 + Random () % 1000;
+            }
+          scheduler->Insert (ev);
+          pending.insert (std::make_pair (ev.key.m_ts, ev.key.m_uid));
+          inserted.push_back (ev);
+        }
+      else if (r < 60)
+        {
+          Scheduler::Event ev = inserted[Random () % inserted.size ()];
+          if (pending.erase (std::make_pair (ev.key.m_ts, ev.key.m_uid)) > 0)
+            {
+              scheduler->Remove (ev);
+            }
+        }
+      else
+        {
+          Scheduler::Event peek = scheduler->PeekNext ();
+          Scheduler::Event ev = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (peek.key.m_uid, ev.key.m_uid, "PeekNext and RemoveNext disagree");
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_ts, pending.begin ()->first, "Wrong time of event " << op);
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, pending.begin ()->second, "Wrong event " << op);
+          pending.erase (pending.begin ());
+          now = ev.key.m_ts;
+        }
+      NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), pending.empty (), "Wrong emptiness");
+    }
+  while (!pending.empty ())
+    {
+      Scheduler::Event ev = scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, pending.begin ()->second, "Wrong event while draining");
+      pending.erase (pending.begin ());
+    }
+  NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), true, "The scheduler should be empty");
+}
+
+/**
+ * A burst of near events behind a single far event: the near events all fall below the
+ * start of the far event's tier, and should still be dequeued in order without being kept
+ * sorted one insertion at a time, which is quadratic in the burst size.
+ */
+class SchedulerBurstTestCase : public TestCase
+{
+public:
+  SchedulerBurstTestCase (std::string scheduler);
+  virtual void DoRun (void);
+
+private:
+  std::string m_scheduler;
+};
+
+SchedulerBurstTestCase::SchedulerBurstTestCase (std::string scheduler)
+  : TestCase ("Check a burst behind a far event with " + scheduler),
+    m_scheduler (scheduler)
+{
+}
+
+void
+SchedulerBurstTestCase::DoRun (void)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (m_scheduler);
+  Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+
+  Scheduler::Event ev;
+  ev.impl = 0;
+  ev.key.m_context = 0;
+  ev.key.m_uid = 0;
+  ev.key.m_ts = 0;
+  scheduler->Insert (ev);
+  ev.key.m_uid = 1;
+  ev.key.m_ts = 1000000000;
+  scheduler->Insert (ev);
+  NS_TEST_ASSERT_MSG_EQ (scheduler->RemoveNext ().key.m_uid, 0, "Wrong first event");
+
+  const uint32_t burst = 300000;
+  uint32_t seed = 1;
+  for (uint32_t i = 0; i < burst; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      ev.key.m_uid = 2 + i;
+      ev.key.m_ts = 1 + (seed >> 8) % 10000000;
+      scheduler->Insert (ev);
+    }
+  Scheduler::Event last = scheduler->RemoveNext ();
+  for (uint32_t i = 1; i < burst; i++)
+    {
+      Scheduler::Event next = scheduler->RemoveNext ();
+      NS_TEST_ASSERT_MSG_EQ ((last.key < next.key), true, "Burst event " << i << " out of order");
+      last = next;
+    }
+  NS_TEST_ASSERT_MSG_EQ (scheduler->RemoveNext ().key.m_uid, 1, "The far event should come last");
+  NS_TEST_ASSERT_MSG_EQ (scheduler->IsEmpty (), true, "The scheduler should be empty");
+}
+
+static class SchedulerTestSuite : public TestSuite
+{
+public:
+  SchedulerTestSuite ()
+    : TestSuite ("scheduler", UNIT)
+  {
+    AddTestCase (new SchedulerOrderTestCase ("ns3::MapScheduler"), TestCase::QUICK);
+    AddTestCase (new SchedulerOrderTestCase ("ns3::HeapScheduler"), TestCase::QUICK);
+    AddTestCase (new SchedulerOrderTestCase ("ns3::CalendarScheduler"), TestCase::QUICK);
+    AddTestCase (new SchedulerOrderTestCase ("ns3::LadderScheduler"), TestCase::QUICK);
+    AddTestCase (new SchedulerBurstTestCase ("ns3::MapScheduler"), TestCase::QUICK);
+    AddTestCase (new SchedulerBurstTestCase ("ns3::HeapScheduler"), TestCase::QUICK);
+    AddTestCase (new SchedulerBurstTestCase ("ns3::CalendarScheduler"), TestCase::QUICK);
+    AddTestCase (new SchedulerBurstTestCase ("ns3::LadderScheduler"), TestCase::QUICK);
+  }
+} g_schedulerTestSuite;
+
+} // namespace ns3
@@ -23,6 +23,7 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/ladder-scheduler.h"
 
 using namespace ns3;
 
@@ -459,6 +460,50 @@ SimulatorTemplateTestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * A chain of events, each scheduling the next one, should only allocate memory for the
+ * first events: the others reuse the memory of the events which already ran.
+ */
+class SimulatorEventPoolTestCase : public TestCase
+{
+public:
+  SimulatorEventPoolTestCase ();
+  virtual void DoRun (void);
+  void Next (uint32_t left, double unused);
+};
+
+SimulatorEventPoolTestCase::SimulatorEventPoolTestCase ()
+  : TestCase ("Check that events are recycled")
+{
+}
+
+void
+SimulatorEventPoolTestCase::Next (uint32_t left, double unused)
+{
+  if (left > 0)
+    {
+      Simulator::Schedule (MicroSeconds (1), &SimulatorEventPoolTestCase::Next, this, left - 1, unused);
+      Simulator::ScheduleNow (&SimulatorEventPoolTestCase::Next, this, 0, unused);
+    }
+}
+
+void
+SimulatorEventPoolTestCase::DoRun (void)
+{
+  uint64_t allocations = Simulator::GetEventAllocations ();
+  Simulator::Schedule (MicroSeconds (1), &SimulatorEventPoolTestCase::Next, this, 10, 0.0);
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetEventAllocations (), allocations + 1, "One event should be counted");
+  Simulator::Run ();
+  uint64_t heapAllocations = Simulator::GetEventHeapAllocations ();
+  allocations = Simulator::GetEventAllocations ();
+
+  Simulator::Schedule (MicroSeconds (1), &SimulatorEventPoolTestCase::Next, this, 1000, 0.0);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetEventAllocations (), allocations + 2001, "Wrong number of events");
+  NS_TEST_EXPECT_MSG_EQ (Simulator::GetEventHeapAllocations (), heapAllocations, "Events were not recycled");
+  Simulator::Destroy ();
+}
+
 class SimulatorTestSuite : public TestSuite
 {
 public:
@@ -475,5 +520,8 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (LadderScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    AddTestCase (new SimulatorEventPoolTestCase (), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -0,0 +1,1012 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/core-config.h"
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+#include "flow-results-sink.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/system-condition.h"
+#endif
+#include <map>
+#include <algorithm>
+#include <sstream>
+#include <string.h>
+#include <stdlib.h>
+
+NS_LOG_COMPONENT_DEFINE ("FlowResultsSink");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (FlowResultsSink);
+
+const uint32_t FlowResultsSink::SCHEMA_CHUNK;
+const uint32_t FlowResultsSink::ROW_GROUP_CHUNK;
+
+FlowResult::FlowResult ()
+  : node (0),
+    flowId (0),
+    goodput (0),
+    fct (0),
+    timeOuts (0),
+    fastReTxs (0),
+    partialAcks (0),
+    fullAcks (0),
+    fastRecoveries (0),
+    subflows (0),
+    estSubflows (0),
+    retxThresh (0),
+    flowSize (0),
+    bytesSent (0),
+    pktsSent (0),
+    lastRtt (0),
+    rtt (0),
+    slowDownHits (0),
+    adaptiveSubflows (0),
+    congestionThreshold (0),
+    congestionExitThreshold (0),
+    congestionRound (0),
+    congestionEnterHits (0),
+    congestionExitHits (0),
+    cwndMin (0),
+    rwndScale (0),
+    backoffBeta (0),
+    initGamma (0)
+{
+}
+
+namespace {
+
+// Where each column of the schema lives in a FlowResult; one member pointer is set
+struct ColumnField
+{
+  const char *name;
+  FlowResultsSink::ColumnType type;
+  uint32_t FlowResult::*u32;
+  uint64_t FlowResult::*u64;
+  int64_t FlowResult::*i64;
+  double FlowResult::*f64;
+  std::string FlowResult::*str;
+};
+
+#define FR_UINT32(f) { #f, FlowResultsSink::UINT32, &FlowResult::f, 0, 0, 0, 0 }
+#define FR_UINT64(f) { #f, FlowResultsSink::UINT64, 0, &FlowResult::f, 0, 0, 0 }
+#define FR_INT64(f)  { #f, FlowResultsSink::INT64, 0, 0, &FlowResult::f, 0, 0 }
+#define FR_DOUBLE(f) { #f, FlowResultsSink::DOUBLE, 0, 0, 0, &FlowResult::f, 0 }
+#define FR_STRING(f) { #f, FlowResultsSink::STRING, 0, 0, 0, 0, &FlowResult::f }
+
+const ColumnField g_fields[] = {
+  FR_UINT32 (node),
+  FR_UINT32 (flowId),
+  FR_STRING (flowType),
+  FR_STRING (flowLayer),
+  FR_STRING (socket),
+  FR_DOUBLE (goodput),
+  FR_DOUBLE (fct),
+  FR_UINT32 (timeOuts),
+  FR_UINT32 (fastReTxs),
+  FR_UINT32 (partialAcks),
+  FR_UINT32 (fullAcks),
+  FR_UINT32 (fastRecoveries),
+  FR_UINT32 (subflows),
+  FR_UINT32 (estSubflows),
+  FR_STRING (typeId),
+  FR_UINT32 (retxThresh),
+  FR_UINT32 (flowSize),
+  FR_UINT64 (bytesSent),
+  FR_UINT32 (pktsSent),
+  FR_INT64 (lastRtt),
+  FR_INT64 (rtt),
+  FR_STRING (model),
+  FR_STRING (cc),
+  FR_UINT64 (slowDownHits),
+  FR_UINT32 (adaptiveSubflows),
+  FR_UINT32 (congestionThreshold),
+  FR_UINT32 (congestionExitThreshold),
+  FR_UINT32 (congestionRound),
+  FR_UINT64 (congestionEnterHits),
+  FR_UINT64 (congestionExitHits),
+  FR_UINT32 (cwndMin),
+  FR_UINT32 (rwndScale),
+  FR_UINT32 (backoffBeta),
+  FR_UINT32 (initGamma)
+};
+
+#undef FR_UINT32
+#undef FR_UINT64
+#undef FR_INT64
+#undef FR_DOUBLE
+#undef FR_STRING
+
+const uint32_t g_nFields = sizeof (g_fields) / sizeof (g_fields[0]);
+
+typedef std::map<std::string, Ptr<FlowResultsSink> > SinkMap;
+
+SinkMap &
+GetSinks (void)
+{
+  static SinkMap sinks;
+  return sinks;
+}
+
+// Little endian encoding of the BINARY format
+void
+PutU32 (std::string &out, uint32_t v)
+{
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      out.push_back ((char)((v >> (8 * i)) & 0xff));
+    }
+}
+
+void
+PutU64 (std::string &out, uint64_t v)
+{
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      out.push_back ((char)((v >> (8 * i)) & 0xff));
+    }
+}
+
+uint32_t
+GetU32 (const char *in)
+{
+  uint32_t v = 0;
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      v |= ((uint32_t)(uint8_t) in[i]) << (8 * i);
+    }
+  return v;
+}
+
+uint64_t
+GetU64 (const char *in)
+{
+  uint64_t v = 0;
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      v |= ((uint64_t)(uint8_t) in[i]) << (8 * i);
+    }
+  return v;
+}
+
+bool
+ReadU32 (std::istream &in, uint32_t &v)
+{
+  char buf[4];
+  if (!in.read (buf, 4))
+    {
+      return false;
+    }
+  v = GetU32 (buf);
+  return true;
+}
+
+uint32_t
+FixedSize (uint8_t type)
+{
+  switch (type)
+    {
+    case FlowResultsSink::UINT32:
+      return 4;
+    case FlowResultsSink::UINT64:
+    case FlowResultsSink::INT64:
+    case FlowResultsSink::DOUBLE:
+      return 8;
+    default:
+      return 0;
+    }
+}
+
+void
+EncodeColumn (const ColumnField &f, const std::vector<FlowResult> &rows, std::string &out)
+{
+  for (std::vector<FlowResult>::const_iterator it = rows.begin (); it != rows.end (); ++it)
+    {
+      switch (f.type)
+        {
+        case FlowResultsSink::UINT32:
+          PutU32 (out, (*it).*f.u32);
+          break;
+        case FlowResultsSink::UINT64:
+          PutU64 (out, (*it).*f.u64);
+          break;
+        case FlowResultsSink::INT64:
+          PutU64 (out, (uint64_t)((*it).*f.i64));
+          break;
+        case FlowResultsSink::DOUBLE:
+          {
+            uint64_t bits;
+            double v = (*it).*f.f64;
+            memcpy (&bits, &v, sizeof (bits));
+            PutU64 (out, bits);
+            break;
+          }
+        case FlowResultsSink::STRING:
+          PutU32 (out, ((*it).*f.str).size ());
+          out.append ((*it).*f.str);
+          break;
+        }
+    }
+}
+
+// Decode one column chunk into rows; false if the chunk is malformed
+bool
+DecodeColumn (const ColumnField &f, const std::string &chunk, std::vector<FlowResult> &rows)
+{
+  const char *p = chunk.data ();
+  const char *end = p + chunk.size ();
+  for (std::vector<FlowResult>::iterator it = rows.begin (); it != rows.end (); ++it)
+    {
+      uint32_t size = (f.type == FlowResultsSink::STRING) ? 4 : FixedSize (f.type);
+      if ((uint32_t)(end - p) < size)
+        {
+          return false;
+        }
+      switch (f.type)
+        {
+        case FlowResultsSink::UINT32:
+          (*it).*f.u32 = GetU32 (p);
+          break;
+        case FlowResultsSink::UINT64:
+          (*it).*f.u64 = GetU64 (p);
+          break;
+        case FlowResultsSink::INT64:
+          (*it).*f.i64 = (int64_t) GetU64 (p);
+          break;
+        case FlowResultsSink::DOUBLE:
+          {
+            uint64_t bits = GetU64 (p);
+            memcpy (&((*it).*f.f64), &bits, sizeof (bits));
+            break;
+          }
+        case FlowResultsSink::STRING:
+          {
+            uint32_t len = GetU32 (p);
+            if ((uint32_t)(end - p - 4) < len)
+              {
+                return false;
+              }
+            ((*it).*f.str).assign (p + 4, len);
+            size += len;
+            break;
+          }
+        }
+      p += size;
+    }
+  return true;
+}
+
+void
+PutCsvValue (std::ostream &os, const ColumnField &f, const FlowResult &r)
+{
+  switch (f.type)
+    {
+    case FlowResultsSink::UINT32:
+      os << r.*f.u32;
+      break;
+    case FlowResultsSink::UINT64:
+      os << r.*f.u64;
+      break;
+    case FlowResultsSink::INT64:
+      os << r.*f.i64;
+      break;
+    case FlowResultsSink::DOUBLE:
+      os << r.*f.f64;
+      break;
+    case FlowResultsSink::STRING:
+      {
+        const std::string &s = r.*f.str;
+        if (s.find_first_of (",\"\n") == std::string::npos)
+          {
+            os << s;
+            break;
+          }
+        os << '"';
+        for (std::string::const_iterator c = s.begin (); c != s.end (); ++c)
+          {
+            if (*c == '"')
+              {
+                os << '"';
+              }
+            os << *c;
+          }
+        os << '"';
+        break;
+      }
+    }
+}
+
+void
+GetCsvValue (const std::string &s, const ColumnField &f, FlowResult &r)
+{
+  switch (f.type)
+    {
+    case FlowResultsSink::UINT32:
+      r.*f.u32 = strtoul (s.c_str (), 0, 10);
+      break;
+    case FlowResultsSink::UINT64:
+      r.*f.u64 = strtoull (s.c_str (), 0, 10);
+      break;
+    case FlowResultsSink::INT64:
+      r.*f.i64 = strtoll (s.c_str (), 0, 10);
+      break;
+    case FlowResultsSink::DOUBLE:
+      r.*f.f64 = strtod (s.c_str (), 0);
+      break;
+    case FlowResultsSink::STRING:
+      r.*f.str = s;
+      break;
+    }
+}
+
+// Split one CSV record, which may span several lines inside quotes
+bool
+GetCsvRecord (std::istream &in, std::vector<std::string> &values)
+{
+  values.clear ();
+  std::string line;
+  if (!std::getline (in, line))
+    {
+      return false;
+    }
+  std::string value;
+  bool quoted = false;
+  for (uint32_t i = 0;; i++)
+    {
+      if (i == line.size ())
+        {
+          if (quoted && std::getline (in, line))
+            {
+              value.push_back ('\n');
+              i = (uint32_t) -1;
+              continue;
+            }
+          break;
+        }
+      char c = line[i];
+      if (quoted)
+        {
+          if (c == '"' && i + 1 < line.size () && line[i + 1] == '"')
+            {
+              value.push_back ('"');
+              i++;
+            }
+          else if (c == '"')
+            {
+              quoted = false;
+            }
+          else
+            {
+              value.push_back (c);
+            }
+        }
+      else if (c == '"')
+        {
+          quoted = true;
+        }
+      else if (c == ',')
+        {
+          values.push_back (value);
+          value.clear ();
+        }
+      else if (c != '\r')
+        {
+          value.push_back (c);
+        }
+    }
+  values.push_back (value);
+  return true;
+}
+
+} // anonymous namespace
+
+TypeId
+FlowResultsSink::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FlowResultsSink")
+    .SetParent<Object> ()
+    .AddConstructor<FlowResultsSink> ()
+    .AddAttribute ("Format",
+                   "Encoding of the results file",
+                   EnumValue (TEXT),
+                   MakeEnumAccessor (&FlowResultsSink::m_format),
+                   MakeEnumChecker (TEXT, "Text", CSV, "Csv", BINARY, "Binary"))
+    .AddAttribute ("RowGroupSize",
+                   "Number of queued rows that triggers a write, also the largest BINARY row group",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&FlowResultsSink::m_rowGroupSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("FlushInterval",
+                   "Wall clock time between two writes of the queued rows by the background thread",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&FlowResultsSink::m_flushInterval),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+FlowResultsSink::FlowResultsSink ()
+  : m_format (TEXT),
+    m_rowGroupSize (1024),
+    m_headerWritten (false),
+    m_closed (true),
+    m_rowsWritten (0),
+    m_mutex (0),
+    m_fileMutex (0),
+    m_wakeUp (0),
+    m_stop (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FlowResultsSink::~FlowResultsSink ()
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+}
+
+void
+FlowResultsSink::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  Close ();
+  Object::DoDispose ();
+}
+
+Ptr<FlowResultsSink>
+FlowResultsSink::Get (std::string fileName)
+{
+  SinkMap &sinks = GetSinks ();
+  SinkMap::iterator it = sinks.find (fileName);
+  if (it != sinks.end ())
+    {
+      return it->second;
+    }
+  if (sinks.empty ())
+    {
+      Simulator::ScheduleDestroy (&FlowResultsSink::CloseAll);
+    }
+  Ptr<FlowResultsSink> sink = CreateObject<FlowResultsSink> ();
+  sink->Open (fileName);
+  sinks[fileName] = sink;
+  return sink;
+}
+
+void
+FlowResultsSink::CloseAll (void)
+{
+  SinkMap &sinks = GetSinks ();
+  for (SinkMap::iterator it = sinks.begin (); it != sinks.end (); ++it)
+    {
+      it->second->Dispose ();
+    }
+  sinks.clear ();
+}
+
+const std::vector<FlowResultsSink::Column> &
+FlowResultsSink::GetSchema (void)
+{
+  static std::vector<Column> schema;
+  if (schema.empty ())
+    {
+      for (uint32_t i = 0; i < g_nFields; i++)
+        {
+          Column c = { g_fields[i].name, g_fields[i].type };
+          schema.push_back (c);
+        }
+    }
+  return schema;
+}
+
+void
+FlowResultsSink::Open (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  NS_ASSERT_MSG (m_closed, "FlowResultsSink already open on " << m_fileName);
+  m_fileName = fileName;
+  m_rowsWritten = 0;
+  m_stop = false;
+  // Append to results of earlier runs; a CSV header is only needed in an empty file
+  std::ifstream existing (fileName.c_str (), std::ios::in | std::ios::binary | std::ios::ate);
+  m_headerWritten = (m_format == CSV && existing.is_open () && existing.tellg () > 0);
+  existing.close ();
+  m_file.open (fileName.c_str (), std::ios::out | std::ios::app | std::ios::binary);
+  if (!m_file.is_open ())
+    {
+      NS_FATAL_ERROR ("Cannot open results file " << fileName);
+    }
+  m_closed = false;
+#ifdef HAVE_PTHREAD_H
+  m_mutex = new SystemMutex ();
+  m_fileMutex = new SystemMutex ();
+  m_wakeUp = new SystemCondition ();
+  m_thread = Create<SystemThread> (MakeCallback (&FlowResultsSink::FlushLoop, this));
+  m_thread->Start ();
+#endif
+}
+
+void
+FlowResultsSink::Write (const FlowResult &result)
+{
+  NS_LOG_FUNCTION (this << result.node << result.flowId);
+  NS_ASSERT_MSG (!m_closed, "FlowResultsSink is not open");
+#ifdef HAVE_PTHREAD_H
+  bool full;
+  {
+    CriticalSection cs (*m_mutex);
+    m_pending.push_back (result);
+    full = m_pending.size () >= m_rowGroupSize;
+  }
+  if (full)
+    {
+      m_wakeUp->SetCondition (true);
+      m_wakeUp->Signal ();
+    }
+#else
+  m_pending.push_back (result);
+  if (m_pending.size () >= m_rowGroupSize)
+    {
+      Flush ();
+    }
+#endif
+}
+
+void
+FlowResultsSink::Flush (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_closed)
+    {
+      return;
+    }
+  std::vector<FlowResult> rows;
+#ifdef HAVE_PTHREAD_H
+  CriticalSection fileCs (*m_fileMutex);
+  {
+    CriticalSection cs (*m_mutex);
+    rows.swap (m_pending);
+  }
+#else
+  rows.swap (m_pending);
+#endif
+  WriteRows (rows);
+}
+
+void
+FlowResultsSink::FlushLoop (void)
+{
+#ifdef HAVE_PTHREAD_H
+  while (true)
+    {
+      m_wakeUp->TimedWait (m_flushInterval.GetNanoSeconds ());
+      m_wakeUp->SetCondition (false);
+      bool stop;
+      {
+        CriticalSection cs (*m_mutex);
+        stop = m_stop;
+      }
+      if (stop)
+        {
+          return;
+        }
+      Flush ();
+    }
+#endif
+}
+
+void
+FlowResultsSink::Close (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_closed)
+    {
+      return;
+    }
+#ifdef HAVE_PTHREAD_H
+  {
+    CriticalSection cs (*m_mutex);
+    m_stop = true;
+  }
+  m_wakeUp->SetCondition (true);
+  m_wakeUp->Signal ();
+  m_thread->Join ();
+  m_thread = 0;
+#endif
+  Flush ();
+  m_file.close ();
+  m_closed = true;
+#ifdef HAVE_PTHREAD_H
+  delete m_wakeUp;
+  delete m_fileMutex;
+  delete m_mutex;
+  m_wakeUp = 0;
+  m_fileMutex = 0;
+  m_mutex = 0;
+#endif
+}
+
+FlowResultsSink::Format
+FlowResultsSink::GetFormat (void) const
+{
+  return m_format;
+}
+
+uint64_t
+FlowResultsSink::GetRowsWritten (void) const
+{
+  return m_rowsWritten;
+}
+
+void
+FlowResultsSink::WriteRows (const std::vector<FlowResult> &rows)
+{
+  if (rows.empty ())
+    {
+      return;
+    }
+  switch (m_format)
+    {
+    case TEXT:
+      WriteText (rows);
+      break;
+    case CSV:
+      WriteCsv (rows);
+      break;
+    case BINARY:
+      for (uint32_t i = 0; i < rows.size (); i += m_rowGroupSize)
+        {
+          uint32_t n = std::min<uint32_t> (m_rowGroupSize, rows.size () - i);
+          WriteBinary (std::vector<FlowResult> (rows.begin () + i, rows.begin () + i + n));
+        }
+      break;
+    }
+  m_file.flush ();
+  m_rowsWritten += rows.size ();
+}
+
+void
+FlowResultsSink::WriteText (const std::vector<FlowResult> &rows)
+{
+  // [: NodeId :][+FlowId+][= FlowType =][# Throughput #][* FlowComplTime *]
+  // [$ timeOut $][! fastReTx !][( PartialAck )][@ FullAck @][^ FastRecovery ^]
+  // [& Subflows &][% TypeId %][-RTT-][_EstSubflows_]
+  for (std::vector<FlowResult>::const_iterator it = rows.begin (); it != rows.end (); ++it)
+    {
+      const FlowResult &r = *it;
+      m_file << "[:"  << r.node               << ":]"
+             << "[+"  << r.flowId             << "+]"
+             << "[="  << r.flowType           << "=]"
+             << "[?"  << r.flowLayer          << "?]"
+             << "[|"  << r.socket             << "|]"
+             << "[#"  << r.goodput            << "#]"
+             << "[*"  << r.fct                << "*]"
+             << "[$"  << r.timeOuts           << "$]"
+             << "[!"  << r.fastReTxs          << "!]"
+             << "[("  << r.partialAcks        << ")]"
+             << "[@"  << r.fullAcks           << "@]"
+             << "[^"  << r.fastRecoveries     << "^]"
+             << "[&"  << r.subflows           << "&]"
+             << "[_"  << r.estSubflows        << "_]"
+             << "[%"  << r.typeId             << "%]"
+             << "[~"  << r.retxThresh         << "~]"
+             << "[>"  << r.flowSize           << "<]"
+             << "[<"  << r.bytesSent          << ">]"
+             << "[;"  << r.pktsSent           << ";]"
+             << "[/"  << r.lastRtt            << "/]"
+             << "[,"  << r.rtt                << ",]"
+             << "[{"  << r.model              << "}]"
+             << "[\xef\xbf\xbd" << r.cc       << "\xef\xbf\xbd]"
+             << "[-"  << r.slowDownHits       << "-]"
+             << "[{DS"<< r.adaptiveSubflows   << "}]"
+             << "[{IT"<< r.congestionThreshold << "}]"
+             << "[{ET"<< r.congestionExitThreshold << "}]"
+             << "[{IC"<< r.congestionRound    << "}]"
+             << "[."  << r.congestionEnterHits << ".]"
+             << "[\xef\xbf\xbd" << r.congestionExitHits << "\xef\xbf\xbd]"
+             << "[{CM"<< r.cwndMin            << "}]"
+             << "[{RS"<< r.rwndScale          << "}]"
+             << "[{B" << r.backoffBeta        << "_G" << r.initGamma << "}]"
+             << std::endl;
+    }
+}
+
+void
+FlowResultsSink::PrintCsvHeader (std::ostream &os)
+{
+  for (uint32_t i = 0; i < g_nFields; i++)
+    {
+      os << (i ? "," : "") << g_fields[i].name;
+    }
+  os << "\n";
+}
+
+void
+FlowResultsSink::PrintCsv (std::ostream &os, const FlowResult &result)
+{
+  std::streamsize precision = os.precision (15);
+  for (uint32_t i = 0; i < g_nFields; i++)
+    {
+      if (i)
+        {
+          os << ",";
+        }
+      PutCsvValue (os, g_fields[i], result);
+    }
+  os << "\n";
+  os.precision (precision);
+}
+
+void
+FlowResultsSink::WriteCsv (const std::vector<FlowResult> &rows)
+{
+  std::ostringstream os;
+  if (!m_headerWritten)
+    {
+      PrintCsvHeader (os);
+      m_headerWritten = true;
+    }
+  for (std::vector<FlowResult>::const_iterator it = rows.begin (); it != rows.end (); ++it)
+    {
+      PrintCsv (os, *it);
+    }
+  m_file << os.str ();
+}
+
+void
+FlowResultsSink::WriteBinary (const std::vector<FlowResult> &rows)
+{
+  std::string out;
+  if (!m_headerWritten)
+    {
+      PutU32 (out, SCHEMA_CHUNK);
+      PutU32 (out, g_nFields);
+      for (uint32_t i = 0; i < g_nFields; i++)
+        {
+          uint8_t len = strlen (g_fields[i].name);
+          out.push_back ((char) g_fields[i].type);
+          out.push_back ((char) len);
+          out.append (g_fields[i].name, len);
+        }
+      m_headerWritten = true;
+    }
+  PutU32 (out, ROW_GROUP_CHUNK);
+  PutU32 (out, rows.size ());
+  std::string column;
+  for (uint32_t i = 0; i < g_nFields; i++)
+    {
+      column.clear ();
+      EncodeColumn (g_fields[i], rows, column);
+      PutU32 (out, column.size ());
+      out.append (column);
+    }
+  m_file.write (out.data (), out.size ());
+}
+
+FlowResultsReader::FlowResultsReader ()
+  : m_format (FlowResultsSink::CSV),
+    m_next (0)
+{
+}
+
+bool
+FlowResultsReader::Open (std::string fileName)
+{
+  NS_LOG_FUNCTION (this << fileName);
+  m_file.close ();
+  m_file.clear ();
+  m_names.clear ();
+  m_types.clear ();
+  m_map.clear ();
+  m_rows.clear ();
+  m_next = 0;
+  m_file.open (fileName.c_str (), std::ios::in | std::ios::binary);
+  if (!m_file.is_open ())
+    {
+      return false;
+    }
+  char magic[4];
+  if (!m_file.read (magic, 4))
+    {
+      return false;
+    }
+  if (GetU32 (magic) == FlowResultsSink::SCHEMA_CHUNK)
+    {
+      m_format = FlowResultsSink::BINARY;
+      return ReadSchema ();
+    }
+  m_format = FlowResultsSink::CSV;
+  m_file.seekg (0);
+  std::vector<std::string> header;
+  if (!GetCsvRecord (m_file, header))
+    {
+      return false;
+    }
+  m_names = header;
+  m_types.assign (m_names.size (), FlowResultsSink::STRING);
+  MapColumns ();
+  for (uint32_t i = 0; i < m_map.size (); i++)
+    {
+      if (m_map[i] >= 0)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+FlowResultsSink::Format
+FlowResultsReader::GetFormat (void) const
+{
+  return m_format;
+}
+
+std::vector<std::string>
+FlowResultsReader::GetColumnNames (void) const
+{
+  return m_names;
+}
+
+void
+FlowResultsReader::MapColumns (void)
+{
+  m_map.assign (m_names.size (), -1);
+  for (uint32_t i = 0; i < m_names.size (); i++)
+    {
+      for (uint32_t j = 0; j < g_nFields; j++)
+        {
+          if (m_names[i] == g_fields[j].name
+              && (m_format == FlowResultsSink::CSV || m_types[i] == g_fields[j].type))
+            {
+              m_map[i] = j;
+              break;
+            }
+        }
+    }
+}
+
+bool
+FlowResultsReader::ReadSchema (void)
+{
+  uint32_t n;
+  if (!ReadU32 (m_file, n))
+    {
+      return false;
+    }
+  m_names.clear ();
+  m_types.clear ();
+  for (uint32_t i = 0; i < n; i++)
+    {
+      char typeLen[2];
+      if (!m_file.read (typeLen, 2))
+        {
+          return false;
+        }
+      std::string name ((uint8_t) typeLen[1], '\0');
+      if (!m_file.read (&name[0], name.size ()))
+        {
+          return false;
+        }
+      m_types.push_back ((uint8_t) typeLen[0]);
+      m_names.push_back (name);
+    }
+  MapColumns ();
+  return true;
+}
+
+bool
+FlowResultsReader::ReadRowGroup (void)
+{
+  uint32_t magic;
+  while (ReadU32 (m_file, magic))
+    {
+      if (magic == FlowResultsSink::SCHEMA_CHUNK)
+        {
+          // Results appended by another run
+          if (!ReadSchema ())
+            {
+              return false;
+            }
+          continue;
+        }
+      uint32_t n;
+      if (magic != FlowResultsSink::ROW_GROUP_CHUNK || !ReadU32 (m_file, n))
+        {
+          return false;
+        }
+      m_rows.assign (n, FlowResult ());
+      m_next = 0;
+      std::string chunk;
+      for (uint32_t i = 0; i < m_names.size (); i++)
+        {
+          uint32_t size;
+          if (!ReadU32 (m_file, size))
+            {
+              return false;
+            }
+          if (m_map[i] < 0)
+            {
+              m_file.seekg (size, std::ios::cur);
+              continue;
+            }
+          chunk.resize (size);
+          if (size > 0 && !m_file.read (&chunk[0], size))
+            {
+              return false;
+            }
+          if (!DecodeColumn (g_fields[m_map[i]], chunk, m_rows))
+            {
+              return false;
+            }
+        }
+      if (n > 0)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+bool
+FlowResultsReader::ReadCsvRow (FlowResult &result)
+{
+  std::vector<std::string> values;
+  do
+    {
+      if (!GetCsvRecord (m_file, values))
+        {
+          return false;
+        }
+    }
+  while (values.size () == 1 && values[0].empty ());
+  result = FlowResult ();
+  for (uint32_t i = 0; i < values.size () && i < m_map.size (); i++)
+    {
+      if (m_map[i] >= 0)
+        {
+          GetCsvValue (values[i], g_fields[m_map[i]], result);
+        }
+    }
+  return true;
+}
+
+bool
+FlowResultsReader::Read (FlowResult &result)
+{
+  if (!m_file.is_open ())
+    {
+      return false;
+    }
+  if (m_format == FlowResultsSink::CSV)
+    {
+      return ReadCsvRow (result);
+    }
+  if (m_next == m_rows.size () && !ReadRowGroup ())
+    {
+      m_rows.clear ();
+      m_next = 0;
+      return false;
+    }
+  result = m_rows[m_next++];
+  return true;
+}
+
+} // namespace ns3
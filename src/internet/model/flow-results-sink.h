@@ -0,0 +1,247 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef FLOW_RESULTS_SINK_H
+#define FLOW_RESULTS_SINK_H
+
+#include "ns3/object.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace ns3 {
+
+class SystemThread;
+class SystemMutex;
+class SystemCondition;
+
+/**
+ * \brief Summary of one completed flow, one row of a results file.
+ *
+ * The fields follow the bracket delimited record MpTcpSocketBase has always
+ * written at the end of a flow, in the same order.
+ */
+struct FlowResult
+{
+  FlowResult ();
+
+  uint32_t node;
+  uint32_t flowId;
+  std::string flowType;
+  std::string flowLayer;
+  std::string socket;
+  double goodput;                 // Mbps
+  double fct;                     // Flow completion time in seconds
+  uint32_t timeOuts;
+  uint32_t fastReTxs;
+  uint32_t partialAcks;
+  uint32_t fullAcks;
+  uint32_t fastRecoveries;
+  uint32_t subflows;
+  uint32_t estSubflows;
+  std::string typeId;
+  uint32_t retxThresh;
+  uint32_t flowSize;
+  uint64_t bytesSent;
+  uint32_t pktsSent;
+  int64_t lastRtt;                // us
+  int64_t rtt;                    // Current RTT estimate in us
+  std::string model;
+  std::string cc;
+  uint64_t slowDownHits;
+  uint32_t adaptiveSubflows;
+  uint32_t congestionThreshold;
+  uint32_t congestionExitThreshold;
+  uint32_t congestionRound;
+  uint64_t congestionEnterHits;
+  uint64_t congestionExitHits;
+  uint32_t cwndMin;
+  uint32_t rwndScale;
+  uint32_t backoffBeta;
+  uint32_t initGamma;
+};
+
+/**
+ * \brief Long-lived, buffered writer of the per flow results of a simulation.
+ *
+ * Sockets hand their FlowResult to the sink of their output file name, see
+ * Get (); there is one sink per file for the whole simulation. Rows are
+ * queued in memory and written out by a background thread, either every
+ * FlushInterval or as soon as RowGroupSize rows are queued, so that results
+ * survive a simulation that never returns from Simulator::Run. Sinks are
+ * flushed and closed by Simulator::Destroy. Without thread support rows are
+ * written synchronously, one row group at a time.
+ *
+ * Three formats are supported:
+ *  - TEXT: the legacy bracket delimited records, one line per flow
+ *  - CSV: a header line with the column names, then one line per flow
+ *  - BINARY: a columnar stream of little endian row groups; each row group
+ *    stores its columns one after the other, each in a length prefixed chunk
+ *
+ * Files are opened in append mode: a BINARY file written by several runs
+ * holds one schema chunk per run, a CSV header is only written to an empty
+ * file. FlowResultsReader reads back the CSV and BINARY formats.
+ */
+class FlowResultsSink : public Object
+{
+public:
+  enum Format
+  {
+    TEXT,
+    CSV,
+    BINARY
+  };
+
+  enum ColumnType
+  {
+    UINT32 = 1,
+    UINT64 = 2,
+    INT64 = 3,
+    DOUBLE = 4,
+    STRING = 5
+  };
+
+  struct Column
+  {
+    const char *name;
+    ColumnType type;
+  };
+
+  static TypeId GetTypeId (void);
+
+  FlowResultsSink ();
+  virtual ~FlowResultsSink ();
+
+  /**
+   * \param fileName results file name
+   * \returns the sink writing to fileName, created on first use
+   */
+  static Ptr<FlowResultsSink> Get (std::string fileName);
+  /**
+   * \brief Flush and close every sink, scheduled on Simulator::Destroy
+   */
+  static void CloseAll (void);
+
+  /**
+   * \returns the columns of a results file, in file order
+   */
+  static const std::vector<Column> & GetSchema (void);
+  /**
+   * \brief Print the CSV header line of the schema, with its end of line
+   */
+  static void PrintCsvHeader (std::ostream &os);
+  /**
+   * \brief Print one result as a CSV line, with its end of line
+   */
+  static void PrintCsv (std::ostream &os, const FlowResult &result);
+
+  /**
+   * \param fileName results file, opened on the first write
+   */
+  void Open (std::string fileName);
+  void Write (const FlowResult &result);
+  /**
+   * \brief Write every queued row and wait for it to reach the file
+   */
+  void Flush (void);
+  void Close (void);
+
+  Format GetFormat (void) const;
+  uint64_t GetRowsWritten (void) const;
+
+  // Magic numbers of the chunks of a BINARY file
+  static const uint32_t SCHEMA_CHUNK = 0x48535246; // "FRSH"
+  static const uint32_t ROW_GROUP_CHUNK = 0x47525246; // "FRRG"
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  void WriteRows (const std::vector<FlowResult> &rows);
+  void WriteText (const std::vector<FlowResult> &rows);
+  void WriteCsv (const std::vector<FlowResult> &rows);
+  void WriteBinary (const std::vector<FlowResult> &rows);
+  void FlushLoop (void);
+
+  Format m_format;
+  uint32_t m_rowGroupSize;
+  Time m_flushInterval;
+  std::string m_fileName;
+  std::ofstream m_file;
+  bool m_headerWritten;
+  bool m_closed;
+  uint64_t m_rowsWritten;
+  std::vector<FlowResult> m_pending;   // Rows not yet handed to WriteRows
+
+  // Background flush, only used with thread support
+  Ptr<SystemThread> m_thread;
+  SystemMutex *m_mutex;                // Guards m_pending and m_stop
+  SystemMutex *m_fileMutex;            // Keeps row groups in order, taken before m_mutex
+  SystemCondition *m_wakeUp;
+  bool m_stop;
+};
+
+/**
+ * \brief Reads back the CSV and BINARY files written by FlowResultsSink.
+ *
+ * Columns are matched by name, so files written with an older or newer
+ * schema can be read; unknown columns are skipped and missing ones keep
+ * their FlowResult default. A row group cut short by a killed simulation
+ * ends the file.
+ */
+class FlowResultsReader
+{
+public:
+  FlowResultsReader ();
+
+  /**
+   * \param fileName results file
+   * \returns false if the file cannot be opened or is neither CSV nor BINARY
+   */
+  bool Open (std::string fileName);
+  /**
+   * \param result next row of the file
+   * \returns false at the end of the file
+   */
+  bool Read (FlowResult &result);
+  FlowResultsSink::Format GetFormat (void) const;
+  /**
+   * \returns the column names of the file, in file order
+   */
+  std::vector<std::string> GetColumnNames (void) const;
+
+private:
+  bool ReadSchema (void);
+  bool ReadRowGroup (void);
+  bool ReadCsvRow (FlowResult &result);
+  void MapColumns (void);
+
+  std::ifstream m_file;
+  FlowResultsSink::Format m_format;
+  std::vector<std::string> m_names;
+  std::vector<uint8_t> m_types;
+  std::vector<int32_t> m_map;          // File column -> schema column, -1 if unknown
+  std::vector<FlowResult> m_rows;      // Current BINARY row group
+  uint32_t m_next;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_RESULTS_SINK_H */
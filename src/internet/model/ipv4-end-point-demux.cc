@@ -21,14 +21,32 @@
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ns3/log.h"
+#include <algorithm>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux")
   ;
 
+bool
+Ipv4EndPointDemux::TupleEqual::operator() (const Tuple &a, const Tuple &b) const
+{
+  return a.localAddress == b.localAddress && a.peerAddress == b.peerAddress
+         && a.localPort == b.localPort && a.peerPort == b.peerPort;
+}
+
+size_t
+Ipv4EndPointDemux::TupleHash::operator() (const Tuple &t) const
+{
+  uint32_t h = t.peerAddress * 2654435761U;
+  h ^= t.localAddress + 0x9e3779b9U + (h << 6) + (h >> 2);
+  h ^= ((uint32_t (t.peerPort) << 16) | t.localPort) + 0x9e3779b9U + (h << 6) + (h >> 2);
+  return h;
+}
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
-  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
+  : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152),
+    m_nextId (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -36,36 +54,96 @@ Ipv4EndPointDemux::Ipv4EndPointDemux ()
 Ipv4EndPointDemux::~Ipv4EndPointDemux ()
 {
   NS_LOG_FUNCTION (this);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (std::map<uint64_t, Ipv4EndPoint *>::iterator i = m_endPoints.begin ();
+       i != m_endPoints.end (); i++)
     {
-      Ipv4EndPoint *endPoint = *i;
+      Ipv4EndPoint *endPoint = i->second;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_ports.clear ();
+  m_tuples.clear ();
+}
+
+Ipv4EndPointDemux::Tuple
+Ipv4EndPointDemux::MakeTuple (Ipv4Address localAddress, uint16_t localPort,
+                              Ipv4Address peerAddress, uint16_t peerPort)
+{
+  Tuple t;
+  t.localAddress = localAddress.Get ();
+  t.peerAddress = peerAddress.Get ();
+  t.localPort = localPort;
+  t.peerPort = peerPort;
+  return t;
 }
 
 bool
-Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+Ipv4EndPointDemux::AllocatedBefore (const Ipv4EndPoint *a, const Ipv4EndPoint *b)
 {
-  NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  return a->m_demuxId < b->m_demuxId;
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  endPoint->m_demux = this;
+  endPoint->m_demuxId = m_nextId++;
+  m_endPoints.insert (m_endPoints.end (), std::make_pair (endPoint->m_demuxId, endPoint));
+  // Ids only grow, so appending keeps the port bucket in allocation order
+  m_ports[endPoint->GetLocalPort ()].push_back (endPoint);
+  Index (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  return endPoint;
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  Bucket &bucket = m_tuples[MakeTuple (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                                       endPoint->GetPeerAddress (), endPoint->GetPeerPort ())];
+  // An endpoint connected after allocation may join the bucket behind
+  // younger ones: insert it at its allocation rank
+  bucket.insert (std::upper_bound (bucket.begin (), bucket.end (), endPoint, &AllocatedBefore),
+                 endPoint);
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  TupleIndex::iterator t = m_tuples.find (MakeTuple (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                                                     endPoint->GetPeerAddress (), endPoint->GetPeerPort ()));
+  NS_ASSERT (t != m_tuples.end ());
+  Bucket &bucket = t->second;
+  bucket.erase (std::find (bucket.begin (), bucket.end (), endPoint));
+  if (bucket.empty ())
     {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
+      m_tuples.erase (t);
     }
-  return false;
+}
+
+bool
+Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
+{
+  NS_LOG_FUNCTION (this << port);
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  PortIndex::iterator p = m_ports.find (port);
+  if (p == m_ports.end ())
+    {
+      return false;
+    }
+  for (Bucket::iterator i = p->second.begin (); i != p->second.end (); i++)
     {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
+      if ((*i)->GetLocalAddress () == addr)
         {
           return true;
         }
@@ -83,10 +161,7 @@ Ipv4EndPointDemux::Allocate (void)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (Ipv4Address::GetAny (), port));
 }
 
 Ipv4EndPoint *
@@ -99,10 +174,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       NS_LOG_WARN ("Ephemeral port allocation failed.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -122,10 +194,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       NS_LOG_WARN ("Duplicate address/port; failing.");
       return 0;
     }
-  Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-  return endPoint;
+  return Insert (new Ipv4EndPoint (address, port));
 }
 
 Ipv4EndPoint *
@@ -133,40 +202,36 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (m_tuples.find (MakeTuple (localAddress, localPort, peerAddress, peerPort)) != m_tuples.end ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
-        {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
-        }
+      NS_LOG_WARN ("No way we can allocate this end-point.");
+      /* no way we can allocate this end-point. */
+      return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
-  return endPoint;
+  return Insert (endPoint);
 }
 
 void 
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  if (endPoint->m_demux != this)
     {
-      if (*i == endPoint)
-        {
-          delete endPoint;
-          m_endPoints.erase (i);
-          break;
-        }
+      return;
+    }
+  Unindex (endPoint);
+  PortIndex::iterator p = m_ports.find (endPoint->GetLocalPort ());
+  NS_ASSERT (p != m_ports.end ());
+  p->second.erase (std::find (p->second.begin (), p->second.end (), endPoint));
+  if (p->second.empty ())
+    {
+      m_ports.erase (p);
     }
+  m_endPoints.erase (endPoint->m_demuxId);
+  endPoint->m_demux = 0;
+  delete endPoint;
 }
 
 /*
@@ -178,14 +243,41 @@ Ipv4EndPointDemux::GetAllEndPoints (void)
   NS_LOG_FUNCTION (this);
   EndPoints ret;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (std::map<uint64_t, Ipv4EndPoint *>::iterator i = m_endPoints.begin ();
+       i != m_endPoints.end (); i++)
     {
-      Ipv4EndPoint* endP = *i;
-      ret.push_back (endP);
+      ret.push_back (i->second);
     }
   return ret;
 }
 
+void
+Ipv4EndPointDemux::Collect (const Tuple &key, Ptr<Ipv4Interface> incomingInterface,
+                            EndPoints &result)
+{
+  NS_LOG_FUNCTION (this << incomingInterface);
+  TupleIndex::iterator t = m_tuples.find (key);
+  if (t == m_tuples.end ())
+    {
+      return;
+    }
+  for (Bucket::iterator i = t->second.begin (); i != t->second.end (); i++)
+    {
+      Ipv4EndPoint* endP = *i;
+      if (endP->GetBoundNetDevice ())
+        {
+          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+            {
+              NS_LOG_LOGIC ("Skipping endpoint " << &endP
+                                                 << " because endpoint is bound to specific device and"
+                                                 << endP->GetBoundNetDevice ()
+                                                 << " does not match packet device " << incomingInterface->GetDevice ());
+              continue;
+            }
+        }
+      result.push_back (endP);
+    }
+}
 
 /*
  * If we have an exact match, we return it.
@@ -198,114 +290,59 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
                            Ptr<Ipv4Interface> incomingInterface)
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport << incomingInterface);
-  
-  EndPoints retval1; // Matches exact on local port, wildcards on others
-  EndPoints retval2; // Matches exact on local port/adder, wildcards on others
-  EndPoints retval3; // Matches all but local address
-  EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
     {
-      Ipv4EndPoint* endP = *i;
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
-      if (endP->GetLocalPort () != dport) 
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
         }
-      if (endP->GetBoundNetDevice ())
-        {
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
-            {
-              NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
-              continue;
-            }
-        }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
-            {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
-            }
-        }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
-      bool localAddressMatchesWildCard = 
-        endP->GetLocalAddress () == Ipv4Address::GetAny ();
-      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
 
-      if (isBroadcast)
-        {
-          NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
-        }
+  // The local address an endpoint bound to a specific address must have to
+  // match exactly: the address of the interface for a subnet-directed
+  // broadcast, the destination otherwise.  Endpoints bound to any address
+  // only match exactly a packet sent to any address.
+  Ipv4Address any = Ipv4Address::GetAny ();
+  bool exactUsable = !(incomingInterfaceAddr == any) || daddr == any;
+  EndPoints retval;
 
-      if (isBroadcast && (endP->GetLocalAddress () != Ipv4Address::GetAny ()))
-        {
-          localAddressMatchesExact = (endP->GetLocalAddress () ==
-                                      incomingInterfaceAddr);
-        }
-      // if no match here, keep looking
-      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
-        continue; 
-      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
-        Ipv4Address::GetAny ();
-      // If remote does not match either with exact or wildcard,
-      // skip this one
-      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
-        continue;
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-        continue;
-
-      // Now figure out which return list to add this one to
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port matches exactly
-          retval1.push_back (endP);
-        }
-      if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port and local address matches exactly
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All but local address
-          retval3.push_back (endP);
-        }
-      if (localAddressMatchesExact &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All 4 match
-          retval4.push_back (endP);
-        }
+  // Exact match on all 4
+  if (exactUsable)
+    {
+      Collect (MakeTuple (incomingInterfaceAddr, dport, saddr, sport), incomingInterface, retval);
+      if (!retval.empty ()) return retval;
+    }
+
+  // Matches all but local address
+  Collect (MakeTuple (any, dport, saddr, sport), incomingInterface, retval);
+  if (!retval.empty ()) return retval;
+
+  // Matches exact on local port/adder, wildcards on others; a broadcast
+  // is also delivered to the endpoints bound to any address
+  if (exactUsable)
+    {
+      Collect (MakeTuple (incomingInterfaceAddr, dport, any, 0), incomingInterface, retval);
+    }
+  if (isBroadcast && !(incomingInterfaceAddr == any))
+    {
+      EndPoints wildcards;
+      Collect (MakeTuple (any, dport, any, 0), incomingInterface, wildcards);
+      retval.merge (wildcards, &Ipv4EndPointDemux::AllocatedBefore);
     }
+  if (!retval.empty ()) return retval;
 
-  // Here we find the most exact match
-  if (!retval4.empty ()) return retval4;
-  if (!retval3.empty ()) return retval3;
-  if (!retval2.empty ()) return retval2;
-  return retval1;  // might be empty if no matches
+  // Matches exact on local port, wildcards on others
+  Collect (MakeTuple (any, dport, any, 0), incomingInterface, retval);
+  return retval;  // might be empty if no matches
 }
 
 Ipv4EndPoint *
@@ -318,14 +355,15 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
+  PortIndex::iterator p = m_ports.find (dport);
+  if (p == m_ports.end ())
+    {
+      return 0;
+    }
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (Bucket::iterator i = p->second.begin (); i != p->second.end (); i++) 
     {
-      if ((*i)->GetLocalPort () != dport) 
-        {
-          continue;
-        }
       if ((*i)->GetLocalAddress () == daddr &&
           (*i)->GetPeerPort () == sport &&
           (*i)->GetPeerAddress () == saddr) 
@@ -350,10 +388,13 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
     }
   return generic;
 }
+
 uint16_t
 Ipv4EndPointDemux::AllocateEphemeralPort (void)
 {
-  // Similar to counting up logic in netinet/in_pcb.c
+  // Similar to counting up logic in netinet/in_pcb.c.  Each probe is a
+  // lookup in the port index, so a busy port range costs one hash lookup
+  // per port in use rather than a walk over every endpoint.
   NS_LOG_FUNCTION (this);
   uint16_t port = m_ephemeral;
   int count = m_portLast - m_portFirst;
@@ -23,7 +23,10 @@
 
 #include <stdint.h>
 #include <list>
+#include <map>
+#include <vector>
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "ipv4-interface.h"
 
 namespace ns3 {
@@ -38,6 +41,12 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are also hashed by local port and by full four-tuple
+ * (wildcards included), so that Lookup only visits the few buckets that
+ * can match a packet instead of every endpoint: the exact four-tuple
+ * first, then the listening (wildcard) buckets.  Ipv4EndPoint tells its
+ * demux when its addresses change, which keeps these indexes up to date.
  */
 
 class Ipv4EndPointDemux {
@@ -152,6 +161,102 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief Four-tuple key of the endpoint index.
+   *
+   * Wildcards are stored as they are (any address, port 0).
+   */
+  struct Tuple
+  {
+    uint32_t localAddress;  //!< local address
+    uint32_t peerAddress;   //!< peer address
+    uint16_t localPort;     //!< local port
+    uint16_t peerPort;      //!< peer port
+  };
+
+  /**
+   * \brief Equality of two four-tuples.
+   */
+  struct TupleEqual
+  {
+    bool operator() (const Tuple &a, const Tuple &b) const;
+  };
+
+  /**
+   * \brief Hash of a four-tuple.
+   */
+  struct TupleHash
+  {
+    size_t operator() (const Tuple &t) const;
+  };
+
+  /**
+   * \brief Endpoints sharing a key, in allocation order.
+   */
+  typedef std::vector<Ipv4EndPoint *> Bucket;
+
+  /**
+   * \brief Endpoints by local port.
+   */
+  typedef sgi::hash_map<uint16_t, Bucket> PortIndex;
+
+  /**
+   * \brief Endpoints by four-tuple.
+   */
+  typedef sgi::hash_map<Tuple, Bucket, TupleHash, TupleEqual> TupleIndex;
+
+  /**
+   * \brief Build the index key of an endpoint.
+   * \param localAddress local address
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \returns the key
+   */
+  static Tuple MakeTuple (Ipv4Address localAddress, uint16_t localPort,
+                          Ipv4Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Order of the endpoints in the buckets and in the lists returned
+   * by Lookup: the order in which they were allocated.
+   * \param a an endpoint of this demux
+   * \param b another endpoint of this demux
+   * \returns true if a was allocated before b
+   */
+  static bool AllocatedBefore (const Ipv4EndPoint *a, const Ipv4EndPoint *b);
+
+  /**
+   * \brief Add an endpoint to the container and to the indexes.
+   * \param endPoint the endpoint, not yet known to any demux
+   * \returns the endpoint
+   */
+  Ipv4EndPoint *Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add an endpoint to the port and four-tuple indexes.
+   * \param endPoint the endpoint
+   */
+  void Index (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the port and four-tuple indexes.
+   *
+   * Called before the addresses of the endpoint change.
+   * \param endPoint the endpoint
+   */
+  void Unindex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Append the endpoints of a four-tuple that can receive from
+   * an interface.
+   * \param key the four-tuple
+   * \param incomingInterface the incoming interface
+   * \param result list the endpoints are appended to
+   */
+  void Collect (const Tuple &key, Ptr<Ipv4Interface> incomingInterface,
+                EndPoints &result);
 
   /**
    * \brief Allocate an ephemeral port.
@@ -175,9 +280,24 @@ private:
   uint16_t m_portFirst;
 
   /**
-   * \brief A list of IPv4 end points.
+   * \brief The IPv4 end points, by allocation number.
+   */
+  std::map<uint64_t, Ipv4EndPoint *> m_endPoints;
+
+  /**
+   * \brief Allocation number of the next end point.
+   */
+  uint64_t m_nextId;
+
+  /**
+   * \brief The end points, by local port.
+   */
+  PortIndex m_ports;
+
+  /**
+   * \brief The end points, by four-tuple.
    */
-  EndPoints m_endPoints;
+  TupleIndex m_tuples;
 };
 
 } // namespace ns3
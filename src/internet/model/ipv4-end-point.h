@@ -32,6 +32,7 @@ namespace ns3 {
 
 class Header;
 class Packet;
+class Ipv4EndPointDemux;
 
 /**
  * \brief A representation of an internet endpoint/connection
@@ -169,6 +170,8 @@ public:
                     uint32_t icmpInfo);
 
 private:
+  friend class Ipv4EndPointDemux;
+
   /**
    * \brief ForwardUp wrapper.
    * \param p packet
@@ -229,6 +232,16 @@ private:
    * \brief The destroy callback.
    */
   Callback<void> m_destroyCallback;
+
+  /**
+   * \brief The demux indexing this EndPoint by its addresses (if any).
+   */
+  Ipv4EndPointDemux *m_demux;
+
+  /**
+   * \brief The allocation number of this EndPoint in m_demux.
+   */
+  uint64_t m_demuxId;
 };
 
 } // namespace ns3
@@ -32,7 +32,8 @@
 #include "udp-header.h"
 #include "tcp-header.h"
 #include "ns3/node.h"
-#include "ns3/ecmp-tag.h"
+#include "ns3/dc-tag.h"
+#include "ns3/enum.h"
 //#include "ns3/hash.h"
 //#include <functional>
 
@@ -60,6 +61,13 @@ Ipv4GlobalRouting::GetTypeId (void)
                    BooleanValue(false),
                    MakeBooleanAccessor(&Ipv4GlobalRouting::m_flowEcmpRouting),
                    MakeBooleanChecker())
+    .AddAttribute ("EcmpHashFunction",
+                   "Hash function used to map flows onto equal cost routes when FlowEcmpRouting is enabled",
+                   EnumValue (ECMP_HASH_MURMUR3),
+                   MakeEnumAccessor (&Ipv4GlobalRouting::m_ecmpHash),
+                   MakeEnumChecker (ECMP_HASH_STRING, "String",
+                                    ECMP_HASH_MURMUR3, "Murmur3",
+                                    ECMP_HASH_FNV1A, "Fnv1a"))
     .AddAttribute ("RespondToInterfaceEvents",
                    "Set to true if you want to dynamically recompute the global routes upon Interface notification events (up/down, or add/remove address)",
                    BooleanValue (false),
@@ -72,14 +80,14 @@ Ipv4GlobalRouting::GetTypeId (void)
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
     m_flowEcmpRouting(false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_fnvHasher (Create<Hash::Function::Fnv1a> ()),
+    m_ecmpHash (ECMP_HASH_MURMUR3),
+    m_fibValid (false)
 {
   NS_LOG_FUNCTION (this);
 
   m_rand = CreateObject<UniformRandomVariable> ();
-  //Hasher hasher = Hasher(Create<Hash::Function::Fnv1a> ());
-  Hasher hasher = Hasher();
-  //uint32_t hash = Hasher.GetHash32 (data);
 }
 
 Ipv4GlobalRouting::~Ipv4GlobalRouting ()
@@ -96,6 +104,10 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  if (m_fibValid)
+    {
+      FibAddHost (route);
+    }
 }
 
 void 
@@ -106,6 +118,10 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  if (m_fibValid)
+    {
+      FibAddHost (route);
+    }
 }
 
 void 
@@ -121,6 +137,10 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  if (m_fibValid)
+    {
+      FibAddNetwork (route);
+    }
 }
 
 void 
@@ -134,6 +154,10 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  if (m_fibValid)
+    {
+      FibAddNetwork (route);
+    }
 }
 
 void 
@@ -151,84 +175,166 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
   m_ASexternalRoutes.push_back (route);
 }
 
+uint32_t
+Ipv4GlobalRouting::GetFlowHash (Ipv4Address src, Ipv4Address dst, uint8_t protocol,
+                                uint16_t sPort, uint16_t dPort, uint32_t salt)
+{
+  if (m_ecmpHash == ECMP_HASH_STRING)
+    {
+      // Protocol is not part of the original textual tuple
+      ostringstream oss;
+      oss << dPort << sPort << src << dst << salt;
+      hasher.clear ();
+      return hasher.GetHash64 (oss.str ());
+    }
+
+  // Fixed width, byte order independent image of the salt and the 5-tuple.
+  // The salt goes first so that it is mixed by every following byte.
+  char tuple[17];
+  uint32_t srcAddr = src.Get ();
+  uint32_t dstAddr = dst.Get ();
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      tuple[i] = (salt >> (24 - 8 * i)) & 0xff;
+      tuple[4 + i] = (srcAddr >> (24 - 8 * i)) & 0xff;
+      tuple[8 + i] = (dstAddr >> (24 - 8 * i)) & 0xff;
+    }
+  tuple[12] = sPort >> 8;
+  tuple[13] = sPort & 0xff;
+  tuple[14] = dPort >> 8;
+  tuple[15] = dPort & 0xff;
+  tuple[16] = protocol;
+
+  if (m_ecmpHash == ECMP_HASH_FNV1A)
+    {
+      m_fnvHasher.clear ();
+      uint32_t hash = m_fnvHasher.GetHash32 (tuple, sizeof (tuple));
+      // Low order bits of FNV only depend on the low order bits of each byte,
+      // fold the high half in since routes are picked by a small modulo.
+      return hash ^ (hash >> 16);
+    }
+  hasher.clear ();
+  return hasher.GetHash32 (tuple, sizeof (tuple));
+}
+
 uint64_t
 Ipv4GlobalRouting::GetTupleValue(const Ipv4Header &header, Ptr<const Packet> ipPayload)
 {
   NS_LOG_FUNCTION(header);
+  uint8_t protocol = header.GetProtocol ();
+  if (protocol != TCP_PROT_NUMBER && protocol != UDP_PROT_NUMBER)
+    {
+      NS_FATAL_ERROR("Udp or Tcp header not found " << (int) protocol);
+    }
+  // Source and destination ports are the first four bytes of both UDP and TCP headers,
+  // so there is no need to deserialize the whole (option carrying) transport header.
+  uint8_t ports[4] = { 0, 0, 0, 0 };
+  ipPayload->CopyData (ports, 4);
+  uint16_t sPort = (ports[0] << 8) | ports[1];
+  uint16_t dPort = (ports[2] << 8) | ports[3];
+  NS_LOG_DEBUG ("FiveTuple() -> (src, dst, protNb, sPort, dPort) - "
+      << header.GetSource() << " , "
+      << header.GetDestination() << " , "
+      << (int)protocol << " , "
+      << sPort << " , "
+      << dPort);
+
   Ptr<Node> node = m_ipv4->GetObject<Node>();
-  uint32_t node_id = node->GetId();
-
-  uint64_t fiveTuple = header.GetSource().Get()
-                     + header.GetDestination().Get()
-                     + header.GetProtocol();
-
-  switch (header.GetProtocol())
-    {
-  case UDP_PROT_NUMBER:
-    {
-      UdpHeader udpHeader;
-      ipPayload->PeekHeader(udpHeader);
-      NS_LOG_DEBUG ("FiveTuple() -> UDP: (src, dst, protNb, sPort, dPort) - "
-          << header.GetSource() << " , "
-          << header.GetDestination() << " , "
-          << (int)header.GetProtocol() << " , "
-          << (int)udpHeader.GetSourcePort () << " , "
-          << (int)udpHeader.GetDestinationPort ());
-      fiveTuple += udpHeader.GetSourcePort();
-      fiveTuple += udpHeader.GetDestinationPort();
-      break;
-    }
-  case TCP_PROT_NUMBER:
-    {
-      TcpHeader tcpHeader;
-      ipPayload->PeekHeader(tcpHeader);
-      NS_LOG_DEBUG ("FiveTuple() -> TCP: (src, dst, protNb, sPort, dPort) -  "
-          << header.GetSource() << " , "
-          << header.GetDestination() << " , "
-          << (int)header.GetProtocol() << " , "
-          << (int)tcpHeader.GetSourcePort () << " , "
-          << (int)tcpHeader.GetDestinationPort ());
-      fiveTuple += (uint32_t)tcpHeader.GetSourcePort();
-      fiveTuple += (uint32_t)tcpHeader.GetDestinationPort();
-      break;
-    }
-  default:
-    {
-      NS_FATAL_ERROR("Udp or Tcp header not found " << (int) header.GetProtocol());
-      break;
-    }
-    }
-  //NS_LOG_DEBUG("FiveTuple() -> HashedValue: " <<  fiveTuple);
-  hasher.clear();
-
-  TcpHeader tcpHeader;
-  ipPayload->PeekHeader(tcpHeader);
-
-//  char *buffer_to_hash = new char[12];
-//  uint32_t src_ip_to_hash = header.GetSource().Get();
-//  uint32_t dst_ip_to_hash = header.GetDestination().Get();
-//  uint16_t src_port_to_hash = tcpHeader.GetSourcePort();
-//  uint16_t dst_port_to_hash = tcpHeader.GetDestinationPort();
-//  memcpy(buffer_to_hash, &src_ip_to_hash,sizeof(uint32_t));
-//  memcpy(buffer_to_hash + sizeof(uint32_t), &dst_ip_to_hash,sizeof(uint32_t));
-//  memcpy(buffer_to_hash + sizeof(uint32_t) + sizeof(uint32_t), &src_port_to_hash,sizeof(uint16_t));
-//  memcpy(buffer_to_hash + sizeof(uint32_t) + sizeof(uint32_t) + sizeof(uint16_t), &dst_port_to_hash,sizeof(uint16_t));
-//  std::hash<std::string> str_hash;
-
-  //uint64_t hash = hasher.GetHash64 ((const char *)buffer_to_hash, 12);
-//  delete buffer_to_hash;
-
-  ostringstream oss;
-  //oss << tcpHeader.GetDestinationPort() << tcpHeader.GetSourcePort() << header.GetSource() << header.GetDestination() << header.GetTtl();
-  oss << tcpHeader.GetDestinationPort() << tcpHeader.GetSourcePort() << header.GetSource() << header.GetDestination() << node_id;
-//  oss << fiveTuple;
-  std::string data = oss.str();
-  uint32_t hash = hasher.GetHash64(data);
-//  NS_LOG_INFO("Hash fro Hasher is: " << hash << " fiveTuple:" << fiveTuple << " Data: " << data);
-  oss.str("");
-  return hash;
-//  return fiveTuple;
-//  return tcpHeader.GetSourcePort();
+  return GetFlowHash (header.GetSource (), header.GetDestination (), protocol, sPort, dPort, node->GetId ());
+}
+
+void
+Ipv4GlobalRouting::FibAddHost (Ipv4RoutingTableEntry *route)
+{
+  NS_LOG_FUNCTION (this << route);
+  NS_ASSERT (route->IsHost ());
+  m_fibHosts[route->GetDest ().Get ()].push_back (route);
+}
+
+void
+Ipv4GlobalRouting::FibAddNetwork (Ipv4RoutingTableEntry *route)
+{
+  NS_LOG_FUNCTION (this << route);
+  uint32_t network = route->GetDestNetwork ().Get ();
+  uint16_t prefixLength = route->GetDestNetworkMask ().GetPrefixLength ();
+  uint32_t node = 0;
+  for (uint16_t bit = 0; bit < prefixLength; bit++)
+    {
+      uint32_t b = (network >> (31 - bit)) & 1;
+      if (m_fibTrie[node].child[b] < 0)
+        {
+          FibNode child = { { -1, -1 }, -1 };
+          m_fibTrie[node].child[b] = m_fibTrie.size ();
+          m_fibTrie.push_back (child);
+        }
+      node = m_fibTrie[node].child[b];
+    }
+  if (m_fibTrie[node].group < 0)
+    {
+      m_fibTrie[node].group = m_fibGroups.size ();
+      m_fibGroups.push_back (EcmpGroup ());
+    }
+  m_fibGroups[m_fibTrie[node].group].push_back (route);
+}
+
+void
+Ipv4GlobalRouting::BuildFib (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_fibHosts.clear ();
+  m_fibTrie.clear ();
+  m_fibGroups.clear ();
+  FibNode root = { { -1, -1 }, -1 };
+  m_fibTrie.push_back (root);
+  for (HostRoutesCI i = m_hostRoutes.begin (); i != m_hostRoutes.end (); i++)
+    {
+      FibAddHost (*i);
+    }
+  for (NetworkRoutesCI j = m_networkRoutes.begin (); j != m_networkRoutes.end (); j++)
+    {
+      FibAddNetwork (*j);
+    }
+  m_fibValid = true;
+  NS_LOG_LOGIC ("Forwarding table built: " << m_fibHosts.size () << " hosts, "
+                << m_fibGroups.size () << " prefixes, " << m_fibTrie.size () << " trie nodes");
+}
+
+uint32_t
+Ipv4GlobalRouting::LookupFib (Ipv4Address dest, Ipv4RoutingTableEntry * const *&routes)
+{
+  NS_LOG_FUNCTION (this << dest);
+  if (!m_fibValid)
+    {
+      BuildFib ();
+    }
+  uint32_t addr = dest.Get ();
+  FibHosts::const_iterator host = m_fibHosts.find (addr);
+  if (host != m_fibHosts.end ())
+    {
+      routes = &host->second[0];
+      return host->second.size ();
+    }
+  // Walk down the trie remembering the deepest prefix that has routes
+  int32_t group = -1;
+  int32_t node = 0;
+  for (uint32_t bit = 0; node >= 0; bit++)
+    {
+      if (m_fibTrie[node].group >= 0)
+        {
+          group = m_fibTrie[node].group;
+        }
+      if (bit == 32)
+        {
+          break;
+        }
+      node = m_fibTrie[node].child[(addr >> (31 - bit)) & 1];
+    }
+  if (group < 0)
+    {
+      return 0;
+    }
+  routes = &m_fibGroups[group][0];
+  return m_fibGroups[group].size ();
 }
 
 //Ptr<Ipv4Route>
@@ -240,55 +346,60 @@ Ipv4GlobalRouting::LookupGlobal(const Ipv4Header &header, Ptr<const Packet> ipPa
   NS_LOG_FUNCTION (this << header.GetDestination() << oif);
   NS_LOG_LOGIC ("Looking for route for destination " << header.GetDestination());
   Ptr<Ipv4Route> rtentry = 0;
-  // store all available routes that bring packets to their destination
+  // all available routes that bring packets to their destination
+  Ipv4RoutingTableEntry * const *routes = 0;
+  uint32_t nRoutes = 0;
+  // only filled when the lookup cannot be served by the forwarding table
   typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
   RouteVec_t allRoutes;
 
-  NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
-       i++) 
+  if (oif == 0)
+    {
+      nRoutes = LookupFib (header.GetDestination (), routes);
+      NS_LOG_LOGIC ("Found " << nRoutes << " global routes in the forwarding table");
+    }
+  else
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (header.GetDestination()))
+      NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
+      for (HostRoutesCI i = m_hostRoutes.begin (); 
+           i != m_hostRoutes.end (); 
+           i++) 
         {
-          if (oif != 0)
+          NS_ASSERT ((*i)->IsHost ());
+          if ((*i)->GetDest ().IsEqual (header.GetDestination()))
             {
               if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
                 {
                   NS_LOG_LOGIC ("Not on requested interface, skipping");
                   continue;
                 }
+              allRoutes.push_back (*i);
+              NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
             }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
         }
-    }
-  if (allRoutes.size () == 0) // if no host route is found
-    {
-      NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
-           j++) 
+      if (allRoutes.size () == 0) // if no host route is found
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (header.GetDestination(), entry))
+          NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
+          for (NetworkRoutesI j = m_networkRoutes.begin (); 
+               j != m_networkRoutes.end (); 
+               j++) 
             {
-              if (oif != 0)
+              Ipv4Mask mask = (*j)->GetDestNetworkMask ();
+              Ipv4Address entry = (*j)->GetDestNetwork ();
+              if (mask.IsMatch (header.GetDestination(), entry))
                 {
                   if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
                     {
                       NS_LOG_LOGIC ("Not on requested interface, skipping");
                       continue;
                     }
+                  allRoutes.push_back (*j);
+                  NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
             }
         }
     }
-  if (allRoutes.size () == 0)  // consider external if no host/network found
+  if (nRoutes == 0 && allRoutes.size () == 0)  // consider external if no host/network found
     {
       for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
            k != m_ASexternalRoutes.end ();
@@ -312,7 +423,12 @@ Ipv4GlobalRouting::LookupGlobal(const Ipv4Header &header, Ptr<const Packet> ipPa
             }
         }
     }
-  if (allRoutes.size () > 0 ) // if route(s) is found
+  if (allRoutes.size () > 0)
+    {
+      routes = &allRoutes[0];
+      nRoutes = allRoutes.size ();
+    }
+  if (nRoutes > 0) // if route(s) is found
     {
       // pick up one of the routes uniformly at random if random
       // ECMP routing is enabled, or always select the first route
@@ -321,33 +437,29 @@ Ipv4GlobalRouting::LookupGlobal(const Ipv4Header &header, Ptr<const Packet> ipPa
       if (m_randomEcmpRouting)
         {
           NS_FATAL_ERROR("At the moment this should not be run");
-          selectIndex = m_rand->GetInteger(0, allRoutes.size() - 1);
+          selectIndex = m_rand->GetInteger(0, nRoutes - 1);
         }
-      else if (m_flowEcmpRouting && allRoutes.size() > 1)
+      else if (m_flowEcmpRouting && nRoutes > 1)
         {
-          selectIndex = (GetTupleValue(header, ipPayload) % (allRoutes.size()));
+          selectIndex = (GetTupleValue(header, ipPayload) % nRoutes);
          
-          TcpHeader tcpHeader;
-          EcmpTag ecmp;
-          ipPayload->PeekHeader(tcpHeader);
-          bool found = ipPayload->PeekPacketTag(ecmp);
-          Ipv4RoutingTableEntry* route = allRoutes.at(selectIndex);
-          Ptr<NetDevice> NIC = m_ipv4->GetNetDevice(route->GetInterface());
-          std::string tmp = Names::FindName (NIC->GetNode ());
-          if (found && tmp.find ("tor") != std::string::npos)
+          DcTag dcTag;
+          bool found = ipPayload->PeekPacketTag (dcTag) && dcTag.HasEcmp ();
+          // Node name is only looked up for packets which carry an explicit path (ECMP index)
+          if (found && Names::FindName (m_ipv4->GetObject<Node> ()).find ("tor") != std::string::npos)
             {
               /*
               cout<< "Name("<<Names::FindName (NIC->GetNode ()) << ")  "
                   << "Paths(" << allRoutes.size()<< ")  "
                   << "OldIdx("<< selectIndex << ") "
-                  << "NewIdx("<< (int)ecmp.GetEcmp() % allRoutes.size() << ")  "
-                  << "NewGW(" << allRoutes.at(ecmp.GetEcmp() % allRoutes.size())->GetGateway()<< ")   \t"
+                  << "NewIdx("<< (int)dcTag.GetEcmp() % allRoutes.size() << ")  "
+                  << "NewGW(" << allRoutes.at(dcTag.GetEcmp() % allRoutes.size())->GetGateway()<< ")   \t"
                   << header.GetSource() << ":"<< tcpHeader.GetSourcePort()
                   << "  ->  "
                   << header.GetDestination()<< ":"<< tcpHeader.GetDestinationPort() << "\t"
                   << endl;
               */
-              selectIndex = (int)ecmp.GetEcmp() % allRoutes.size();
+              selectIndex = (int)dcTag.GetEcmp() % nRoutes;
             }
 //          if (NIC->GetNode()->GetId() > 4 && NIC->GetNode()->GetId() <= 11)
 //            {
@@ -367,7 +479,7 @@ Ipv4GlobalRouting::LookupGlobal(const Ipv4Header &header, Ptr<const Packet> ipPa
         {
           selectIndex = 0;
         }
-      Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex); 
+      Ipv4RoutingTableEntry* route = routes[selectIndex];
       // create a Ipv4Route object from the selected routing table entry
       rtentry = Create<Ipv4Route> ();
       rtentry->SetDestination (route->GetDest ());
@@ -448,6 +560,9 @@ void
 Ipv4GlobalRouting::RemoveRoute (uint32_t index)
 {
   NS_LOG_FUNCTION (this << index);
+  // Removals are batched (GlobalRouteManager deletes every route before
+  // recomputing them), so the forwarding table is rebuilt on the next lookup
+  m_fibValid = false;
   if (index < m_hostRoutes.size ())
     {
       uint32_t tmp = 0;
@@ -531,6 +646,10 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_fibHosts.clear ();
+  m_fibTrie.clear ();
+  m_fibGroups.clear ();
+  m_fibValid = false;
 
   Ipv4RoutingProtocol::DoDispose ();
 }
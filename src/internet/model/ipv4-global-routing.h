@@ -21,6 +21,8 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <map>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -226,8 +228,42 @@ public:
    */
   int64_t AssignStreams (int64_t stream);
 
+  /// Hash functions available for flow based ECMP (FlowEcmpRouting)
+  enum EcmpHashFunction
+  {
+    ECMP_HASH_STRING,   //!< Murmur3 over the textual tuple, the original (slow) scheme kept for reproducibility
+    ECMP_HASH_MURMUR3,  //!< Murmur3 over the packed binary tuple
+    ECMP_HASH_FNV1A     //!< FNV1a over the packed binary tuple
+  };
+
+  /**
+   * \brief Hash a flow for ECMP path selection.
+   *
+   * The hash covers the 5-tuple and is salted with the node id, so that
+   * every hop makes an independent choice among its equal cost routes.
+   *
+   * \return the flow hash computed with the configured EcmpHashFunction
+   */
+  uint32_t GetFlowHash (Ipv4Address src, Ipv4Address dst, uint8_t protocol,
+                        uint16_t sPort, uint16_t dPort, uint32_t salt);
+
   uint64_t GetTupleValue(const Ipv4Header &header, Ptr<const Packet> ipPayload);
 
+  /**
+   * \brief Look up the equal cost routes to a destination in the forwarding table.
+   *
+   * Host routes take precedence over network routes, and among the network
+   * routes the longest matching prefix wins.  The routes of a group keep the
+   * order in which they were added.  AS external routes are not part of the
+   * forwarding table.  The table is compiled from the route lists on the first
+   * lookup after a route removal and kept up to date as routes are added.
+   *
+   * \param dest the destination address
+   * \param routes set to the first route of the group
+   * \return the number of routes in the group, 0 if no route matches
+   */
+  uint32_t LookupFib (Ipv4Address dest, Ipv4RoutingTableEntry * const *&routes);
+
 protected:
   void DoDispose (void);
 
@@ -262,13 +298,47 @@ private:
   /// iterator of container of Ipv4RoutingTableEntry (routes to external AS)
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
+  /// Equal cost routes to one destination, in the order they were added
+  typedef std::vector<Ipv4RoutingTableEntry *> EcmpGroup;
+  /// Forwarding table of the host routes, indexed by host address
+  typedef std::map<uint32_t, EcmpGroup> FibHosts;
+
+  /// Node of the binary trie holding the network routes of the forwarding table
+  struct FibNode
+  {
+    int32_t child[2]; //!< index of the child for the next address bit, -1 if none
+    int32_t group;    //!< index in m_fibGroups of the routes to this prefix, -1 if none
+  };
+
+  /**
+   * \brief Add a host route to the forwarding table.
+   * \param route the route
+   */
+  void FibAddHost (Ipv4RoutingTableEntry *route);
+  /**
+   * \brief Add a network route to the forwarding table.
+   * \param route the route
+   */
+  void FibAddNetwork (Ipv4RoutingTableEntry *route);
+  /**
+   * \brief Compile the forwarding table from the host and network route lists.
+   */
+  void BuildFib (void);
+
   //Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
   Ptr<Ipv4Route> LookupGlobal (const Ipv4Header &header, Ptr<const Packet> ipPayload, Ptr<NetDevice> oif = 0);
-  Hasher hasher;
+  Hasher hasher;                       //!< Murmur3 hasher used by ECMP_HASH_STRING and ECMP_HASH_MURMUR3
+  Hasher m_fnvHasher;                  //!< FNV1a hasher used by ECMP_HASH_FNV1A
+  EcmpHashFunction m_ecmpHash;         //!< Hash function for flow based ECMP
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  FibHosts m_fibHosts;                 //!< Forwarding table of the host routes
+  std::vector<FibNode> m_fibTrie;      //!< Prefix trie of the network routes, root at index 0
+  std::vector<EcmpGroup> m_fibGroups;  //!< Network route groups referenced by the trie
+  bool m_fibValid;                     //!< False when the forwarding table must be rebuilt
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
@@ -32,6 +32,7 @@
 #include "ns3/ipv4-header.h"
 #include "ns3/boolean.h"
 #include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/dc-tag.h"
 
 #include "loopback-net-device.h"
 #include "arp-l3-protocol.h"
@@ -767,7 +768,7 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to gateway " << route->GetGateway ());
-          if ( packet->GetSize () > outInterface->GetDevice ()->GetMtu () )
+          if (MustFragment (packet, outInterface->GetDevice ()->GetMtu ()))
             {
               std::list<Ptr<Packet> > listFragments;
               DoFragmentation (packet, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -796,7 +797,7 @@ Ipv4L3Protocol::SendRealOut (Ptr<Ipv4Route> route,
       if (outInterface->IsUp ())
         {
           NS_LOG_LOGIC ("Send to destination " << ipHeader.GetDestination ());
-          if ( packet->GetSize () > outInterface->GetDevice ()->GetMtu () )
+          if (MustFragment (packet, outInterface->GetDevice ()->GetMtu ()))
             {
               std::list<Ptr<Packet> > listFragments;
               DoFragmentation (packet, outInterface->GetDevice ()->GetMtu (), listFragments);
@@ -1206,6 +1207,17 @@ Ipv4L3Protocol::RouteInputError (Ptr<const Packet> p, const Ipv4Header & ipHeade
   m_dropTrace (ipHeader, p, DROP_ROUTE_ERROR, m_node->GetObject<Ipv4> (), 0);
 }
 
+bool
+Ipv4L3Protocol::MustFragment (Ptr<const Packet> packet, uint32_t outIfaceMtu) const
+{
+  if (packet->GetSize () <= outIfaceMtu)
+    {
+      return false;
+    }
+  DcTag dcTag;
+  return !packet->PeekPacketTag (dcTag) || dcTag.GetSegments () == 1;
+}
+
 void
 Ipv4L3Protocol::DoFragmentation (Ptr<Packet> packet, uint32_t outIfaceMtu, std::list<Ptr<Packet> >& listFragments)
 {
@@ -351,6 +351,17 @@ private:
    */
   bool IsUnicast (Ipv4Address ad, Ipv4Mask interfaceMask) const;
 
+  /**
+   * \brief Check if a packet has to be fragmented to go through an interface
+   *
+   * Super-segments (see DcTag::SetSegments) are made of segments that each
+   * fit the MTU, so they are sent whole.
+   * \param packet the packet
+   * \param outIfaceMtu the MTU of the interface
+   * \return true if the packet is larger than the MTU and not a super-segment
+   */
+  bool MustFragment (Ptr<const Packet> packet, uint32_t outIfaceMtu) const;
+
   /**
    * \brief Fragment a packet
    * \param packet the packet
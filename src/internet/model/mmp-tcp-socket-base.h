@@ -24,7 +24,7 @@ public:
 
 protected:
   virtual Ptr<TcpSocketBase> Fork(void);
-  virtual void DoForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface);
+  virtual void DoForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface, int sFlowIdx);
   virtual bool SendPendingData(uint8_t sFlowIdx);
   virtual int SendDataPacket(uint8_t sFlowIdx, uint32_t pktSize, bool withAck);
   virtual void DoRetransmit   (uint8_t sFlowIdx);
@@ -0,0 +1,609 @@
+/*
+ * MultiPath-TCP (MPTCP) implementation.
+ * Programmed by Morteza Kheirkhah from University of Sussex.
+ * Some codes here are modeled from ns3::TCPNewReno implementation.
+ * Email: m.kheirkhah@sussex.ac.uk
+ */
+#include <algorithm>
+#include <stdlib.h>
+#include <stdio.h>
+#include <cmath>
+#include "ns3/log.h"
+#include "ns3/mp-tcp-congestion-ops.h"
+
+NS_LOG_COMPONENT_DEFINE("MpTcpCongestionOps");
+
+namespace ns3{
+
+NS_OBJECT_ENSURE_REGISTERED(MpTcpCongestionOps);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpUncoupledTcps);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpLinkedIncreases);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpRttCompensator);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpFullyCoupled);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpCoupledScalable);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpUncoupled);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpCoupledEpsilon);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpCoupledInc);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpCoupledFully);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpFastUncoupled);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpFastIncreases);
+NS_OBJECT_ENSURE_REGISTERED(MpTcpXca);
+
+TypeId
+MpTcpCongestionOps::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpCongestionOps")
+      .SetParent<Object>();
+  return tid;
+}
+
+Ptr<MpTcpCongestionOps>
+MpTcpCongestionOps::CreateFor(CongestionCtrl_t algo)
+{
+  switch (algo)
+    {
+  case Uncoupled_TCPs:
+    return CreateObject<MpTcpUncoupledTcps>();
+  case Linked_Increases:
+    return CreateObject<MpTcpLinkedIncreases>();
+  case RTT_Compensator:
+    return CreateObject<MpTcpRttCompensator>();
+  case Fully_Coupled:
+    return CreateObject<MpTcpFullyCoupled>();
+  case COUPLED_SCALABLE_TCP:
+    return CreateObject<MpTcpCoupledScalable>();
+  case UNCOUPLED:
+    return CreateObject<MpTcpUncoupled>();
+  case COUPLED_EPSILON:
+    return CreateObject<MpTcpCoupledEpsilon>();
+  case COUPLED_INC:
+    return CreateObject<MpTcpCoupledInc>();
+  case COUPLED_FULLY:
+    return CreateObject<MpTcpCoupledFully>();
+  case Fast_Uncoupled:
+    return CreateObject<MpTcpFastUncoupled>();
+  case Fast_Increases:
+    return CreateObject<MpTcpFastIncreases>();
+  case XCA:
+    return CreateObject<MpTcpXca>();
+  default:
+    NS_FATAL_ERROR("Unknown congestion control " << algo);
+    return 0;
+    }
+}
+
+uint32_t
+MpTcpCongestionOps::GetSsThresh(MpTcpSocketBase *sock, uint8_t sFlowIdx, uint32_t flightSize)
+{
+  return std::max(2 * GetSubflow(sock, sFlowIdx)->MSS, flightSize / 2);
+}
+
+bool
+MpTcpCongestionOps::ReduceWindowOnEce(MpTcpSocketBase *sock, uint8_t sFlowIdx)
+{
+  return false;
+}
+
+void
+MpTcpCongestionOps::PktsAcked(MpTcpSocketBase *sock, uint8_t sFlowIdx, Time rtt)
+{
+}
+
+void
+MpTcpCongestionOps::WindowChanged(MpTcpSocketBase *sock)
+{
+}
+
+Ptr<MpTcpSubFlow>
+MpTcpCongestionOps::GetSubflow(MpTcpSocketBase *sock, uint8_t sFlowIdx)
+{
+  return sock->subflows[sFlowIdx];
+}
+
+uint32_t
+MpTcpCongestionOps::GetNSubflows(MpTcpSocketBase *sock)
+{
+  return sock->subflows.size();
+}
+
+uint32_t
+MpTcpCongestionOps::GetTotalCwnd(MpTcpSocketBase *sock)
+{
+  return sock->totalCwnd;
+}
+
+void
+MpTcpCongestionOps::UpdateTotalCwnd(MpTcpSocketBase *sock)
+{
+  sock->calculateTotalCWND();
+}
+
+uint32_t
+MpTcpCongestionOps::ComputeTotalWindow(MpTcpSocketBase *sock)
+{
+  return sock->compute_total_window();
+}
+
+double
+MpTcpCongestionOps::ComputeLinkedAlpha(MpTcpSocketBase *sock)
+{
+  sock->calculateAlpha();
+  return sock->alpha;
+}
+
+uint32_t
+MpTcpCongestionOps::ComputeScaledA(MpTcpSocketBase *sock)
+{
+  return sock->compute_a_scaled();
+}
+
+double
+MpTcpCongestionOps::ComputeEpsilonAlpha(MpTcpSocketBase *sock)
+{
+  return sock->compute_alfa();
+}
+
+uint32_t &
+MpTcpCongestionOps::ScaledA(MpTcpSocketBase *sock)
+{
+  return sock->a;
+}
+
+double &
+MpTcpCongestionOps::Alpha(MpTcpSocketBase *sock)
+{
+  return sock->alpha;
+}
+
+double
+MpTcpCongestionOps::GetEpsilon(MpTcpSocketBase *sock)
+{
+  return sock->_e;
+}
+
+bool
+MpTcpCongestionOps::IsAlphaPerAck(MpTcpSocketBase *sock)
+{
+  return sock->m_alphaPerAck;
+}
+
+double
+MpTcpCongestionOps::Drand(MpTcpSocketBase *sock)
+{
+  return sock->drand();
+}
+
+/*
+ * Uncoupled_TCPs
+ */
+TypeId
+MpTcpUncoupledTcps::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpUncoupledTcps")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpUncoupledTcps>();
+  return tid;
+}
+
+std::string
+MpTcpUncoupledTcps::GetName(void) const
+{
+  return "Uncoupled_TCPs";
+}
+
+void
+MpTcpUncoupledTcps::CongestionAvoidance(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx,
+    uint32_t ackedBytes)
+{
+  uint32_t cwnd = sFlow->cwnd.Get();
+  double adder = static_cast<double>(sFlow->MSS * sFlow->MSS) / cwnd;
+  adder = std::max(1.0, adder);
+  sFlow->cwnd += static_cast<double>(adder);
+  NS_LOG_WARN ("Subflow "<<(int)sFlowIdx<<" Congestion Control (Uncoupled_TCPs) increment is "<<adder<<" ssthresh "<< sFlow->ssthresh << " cwnd "<<cwnd);
+}
+
+/*
+ * Linked_Increases
+ */
+TypeId
+MpTcpLinkedIncreases::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpLinkedIncreases")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpLinkedIncreases>();
+  return tid;
+}
+
+std::string
+MpTcpLinkedIncreases::GetName(void) const
+{
+  return "Linked_Increases";
+}
+
+void
+MpTcpLinkedIncreases::CongestionAvoidance(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx,
+    uint32_t ackedBytes)
+{
+  double alpha = ComputeLinkedAlpha(sock);
+  double adder = alpha * sFlow->MSS * sFlow->MSS / GetTotalCwnd(sock);
+  adder = std::max(1.0, adder);
+  sFlow->cwnd += static_cast<double>(adder);
+  NS_LOG_ERROR ("Subflow "<<(int)sFlowIdx<<" Congestion Control (Linked_Increases): alpha "<<alpha<<" increment is "<<adder<<" ssthresh "<< sFlow->ssthresh << " cwnd "<<sFlow->cwnd );
+}
+
+/*
+ * RTT_Compensator
+ */
+TypeId
+MpTcpRttCompensator::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpRttCompensator")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpRttCompensator>();
+  return tid;
+}
+
+std::string
+MpTcpRttCompensator::GetName(void) const
+{
+  return "RTT_Compensator";
+}
+
+void
+MpTcpRttCompensator::CongestionAvoidance(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx,
+    uint32_t ackedBytes)
+{
+  // Calculate alpha per drop or RTT...RFC 6356 (Section 4.1)
+  double alpha = ComputeLinkedAlpha(sock);
+  uint32_t totalCwnd = GetTotalCwnd(sock);
+  double adder = std::min(alpha * sFlow->MSS * sFlow->MSS / totalCwnd,
+      static_cast<double>(sFlow->MSS * sFlow->MSS) / sFlow->cwnd.Get());
+  adder = std::max(1.0, adder);
+  sFlow->cwnd += static_cast<double>(adder);
+  NS_LOG_ERROR ("Congestion Control (RTT_Compensator): alpha "<<alpha<<" ackedBytes (" << ackedBytes << ") totalCwnd ("<< totalCwnd / sFlow->MSS<<" packets) -> increment is "<<adder << " cwnd: " << sFlow->cwnd);
+}
+
+/*
+ * Fully_Coupled
+ */
+TypeId
+MpTcpFullyCoupled::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpFullyCoupled")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpFullyCoupled>();
+  return tid;
+}
+
+std::string
+MpTcpFullyCoupled::GetName(void) const
+{
+  return "Fully_Coupled";
+}
+
+void
+MpTcpFullyCoupled::CongestionAvoidance(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx,
+    uint32_t ackedBytes)
+{
+  double adder = static_cast<double>(sFlow->MSS * sFlow->MSS) / GetTotalCwnd(sock);
+  adder = std::max(1.0, adder);
+  sFlow->cwnd += static_cast<double>(adder);
+  NS_LOG_ERROR ("Subflow "<<(int)sFlowIdx<<" Congestion Control (Fully_Coupled) increment is "<<adder<<" ssthresh "<< sFlow->ssthresh << " cwnd "<<sFlow->cwnd);
+}
+
+uint32_t
+MpTcpFullyCoupled::GetSsThresh(MpTcpSocketBase *sock, uint8_t sFlowIdx, uint32_t flightSize)
+{
+  Ptr<MpTcpSubFlow> sFlow = GetSubflow(sock, sFlowIdx);
+  int d = sFlow->cwnd.Get() - GetTotalCwnd(sock) / 2;
+  if (d < 0)
+    d = 0;
+  return std::max(2 * sFlow->MSS, (uint32_t) d);
+}
+
+/*
+ * COUPLED_SCALABLE_TCP
+ */
+TypeId
+MpTcpCoupledScalable::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpCoupledScalable")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpCoupledScalable>();
+  return tid;
+}
+
+std::string
+MpTcpCoupledScalable::GetName(void) const
+{
+  return "COUPLED_SCALABLE_TCP";
+}
+
+void
+MpTcpCoupledScalable::CongestionAvoidance(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx,
+    uint32_t ackedBytes)
+{
+  uint32_t cwnd = sFlow->cwnd.Get();
+  sFlow->cwnd = cwnd + ackedBytes * 0.01;
+}
+
+uint32_t
+MpTcpCoupledScalable::GetSsThresh(MpTcpSocketBase *sock, uint8_t sFlowIdx, uint32_t flightSize)
+{
+  Ptr<MpTcpSubFlow> sFlow = GetSubflow(sock, sFlowIdx);
+  int d = (int) sFlow->cwnd.Get() - (ComputeTotalWindow(sock) >> 3);
+  if (d < 0)
+    d = 0;
+  return std::max(2 * sFlow->MSS, (uint32_t) d);
+}
+
+/*
+ * UNCOUPLED
+ */
+TypeId
+MpTcpUncoupled::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpUncoupled")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpUncoupled>();
+  return tid;
+}
+
+std::string
+MpTcpUncoupled::GetName(void) const
+{
+  return "UNCOUPLED";
+}
+
+void
+MpTcpUncoupled::CongestionAvoidance(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx,
+    uint32_t ackedBytes)
+{
+  sFlow->cwnd += Increase(sFlow, ackedBytes);
+}
+
+/*
+ * COUPLED_EPSILON
+ */
+TypeId
+MpTcpCoupledEpsilon::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpCoupledEpsilon")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpCoupledEpsilon>();
+  return tid;
+}
+
+std::string
+MpTcpCoupledEpsilon::GetName(void) const
+{
+  return "COUPLED_EPSILON";
+}
+
+void
+MpTcpCoupledEpsilon::AckReceived(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint32_t &ackedBytes)
+{
+  MpTcpScalableOpsImpl<MpTcpCoupledEpsilon>::AckReceived(sock, sFlow, ackedBytes);
+  if (IsAlphaPerAck(sock))
+    Alpha(sock) = ComputeEpsilonAlpha(sock);
+}
+
+void
+MpTcpCoupledEpsilon::CongestionAvoidance(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx,
+    uint32_t ackedBytes)
+{
+  uint32_t cwnd = sFlow->cwnd.Get();
+  uint32_t mss = sFlow->MSS;
+  double alpha = Alpha(sock);
+  double e = GetEpsilon(sock);
+  int tcp_inc = Increase(sFlow, ackedBytes);
+  int total_cwnd = ComputeTotalWindow(sock);
+  double tmp_float = ((double) ackedBytes * mss * alpha * pow(alpha * cwnd, 1 - e)) / pow(total_cwnd, 2 - e);
+  int tmp = (int) floor(tmp_float);
+
+  if (Drand(sock) < tmp_float - tmp)
+    tmp++;
+
+  if (tmp > tcp_inc)    //capping
+    tmp = tcp_inc;
+
+  if ((cwnd + tmp) / mss != cwnd / mss)
+    {
+      if (e > 0 && e < 2)
+        Alpha(sock) = ComputeEpsilonAlpha(sock);
+    }
+  sFlow->cwnd = cwnd + tmp;
+}
+
+void
+MpTcpCoupledEpsilon::WindowChanged(MpTcpSocketBase *sock)
+{
+  double e = GetEpsilon(sock);
+  if (e > 0 && e < 2)
+    Alpha(sock) = ComputeEpsilonAlpha(sock);
+}
+
+/*
+ * COUPLED_INC
+ */
+TypeId
+MpTcpCoupledInc::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpCoupledInc")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpCoupledInc>();
+  return tid;
+}
+
+std::string
+MpTcpCoupledInc::GetName(void) const
+{
+  return "COUPLED_INC";
+}
+
+void
+MpTcpCoupledInc::AckReceived(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint32_t &ackedBytes)
+{
+  MpTcpScalableOpsImpl<MpTcpCoupledInc>::AckReceived(sock, sFlow, ackedBytes);
+  if (IsAlphaPerAck(sock))
+    ScaledA(sock) = ComputeScaledA(sock);
+}
+
+void
+MpTcpCoupledInc::CongestionAvoidance(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx,
+    uint32_t ackedBytes)
+{
+  uint32_t cwnd = sFlow->cwnd.Get();
+  uint32_t mss = sFlow->MSS;
+  int tcp_inc = Increase(sFlow, ackedBytes);
+  int total_cwnd = ComputeTotalWindow(sock);
+  int tmp2 = (ackedBytes * mss * ScaledA(sock)) / total_cwnd;
+  int tmp = tmp2 / A_SCALE;
+
+  if (tmp < 0)
+    {
+      printf("Negative increase!");
+      tmp = 0;
+    }
+
+  if (rand() % A_SCALE < tmp2 % A_SCALE)
+    tmp++;
+
+  if (tmp > tcp_inc)    //capping
+    tmp = tcp_inc;
+
+  if ((cwnd + tmp) / mss != cwnd / mss)
+    ScaledA(sock) = ComputeScaledA(sock);
+
+  sFlow->cwnd = cwnd + tmp;
+}
+
+void
+MpTcpCoupledInc::WindowChanged(MpTcpSocketBase *sock)
+{
+  ScaledA(sock) = ComputeScaledA(sock);
+}
+
+/*
+ * COUPLED_FULLY
+ */
+TypeId
+MpTcpCoupledFully::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpCoupledFully")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpCoupledFully>();
+  return tid;
+}
+
+std::string
+MpTcpCoupledFully::GetName(void) const
+{
+  return "COUPLED_FULLY";
+}
+
+void
+MpTcpCoupledFully::CongestionAvoidance(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx,
+    uint32_t ackedBytes)
+{
+  uint32_t cwnd = sFlow->cwnd.Get();
+  int tcp_inc = Increase(sFlow, ackedBytes);
+  int total_cwnd = ComputeTotalWindow(sock);
+  int tt = (int) (ackedBytes * sFlow->MSS * A);
+  int tmp = tt / total_cwnd;
+  if (tmp > tcp_inc)
+    tmp = tcp_inc;
+  sFlow->cwnd = cwnd + tmp;
+}
+
+uint32_t
+MpTcpCoupledFully::GetSsThresh(MpTcpSocketBase *sock, uint8_t sFlowIdx, uint32_t flightSize)
+{
+  Ptr<MpTcpSubFlow> sFlow = GetSubflow(sock, sFlowIdx);
+  int d = (int) sFlow->cwnd.Get() - ComputeTotalWindow(sock) / B;
+  if (d < 0)
+    d = 0;
+  return std::max(2 * sFlow->MSS, (uint32_t) d);
+}
+
+/*
+ * Fast_Uncoupled
+ */
+TypeId
+MpTcpFastUncoupled::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpFastUncoupled")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpFastUncoupled>();
+  return tid;
+}
+
+std::string
+MpTcpFastUncoupled::GetName(void) const
+{
+  return "Fast_Uncoupled";
+}
+
+void
+MpTcpFastUncoupled::CongestionAvoidance(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx,
+    uint32_t ackedBytes)
+{
+  double adder = ((1 - sFlow->dctcp_last_fraction) * sFlow->MSS * sFlow->MSS) / sFlow->cwnd.Get();
+  adder = std::max(1.0, adder);
+  sFlow->cwnd += static_cast<double>(adder);
+}
+
+/*
+ * Fast_Increases
+ */
+TypeId
+MpTcpFastIncreases::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpFastIncreases")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpFastIncreases>();
+  return tid;
+}
+
+std::string
+MpTcpFastIncreases::GetName(void) const
+{
+  return "Fast_Increases";
+}
+
+void
+MpTcpFastIncreases::CongestionAvoidance(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx,
+    uint32_t ackedBytes)
+{
+  double adder = ((1 - sFlow->dctcp_last_fraction) * sFlow->MSS * sFlow->MSS) / GetTotalCwnd(sock);
+  adder = std::max(1.0, adder);
+  sFlow->cwnd += static_cast<double>(adder);
+}
+
+/*
+ * XCA
+ */
+TypeId
+MpTcpXca::GetTypeId(void)
+{
+  static TypeId tid = TypeId("ns3::MpTcpXca")
+      .SetParent<MpTcpCongestionOps>()
+      .AddConstructor<MpTcpXca>();
+  return tid;
+}
+
+std::string
+MpTcpXca::GetName(void) const
+{
+  return "XCA";
+}
+
+void
+MpTcpXca::CongestionAvoidance(MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes)
+{
+  double adder = static_cast<double>(sFlow->MSS * sFlow->MSS) / GetTotalCwnd(sock);
+  adder = std::max(1.0, adder);
+  sFlow->cwnd += static_cast<double>(adder);
+}
+
+}
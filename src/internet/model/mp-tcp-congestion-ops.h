@@ -0,0 +1,271 @@
+/*
+ * MultiPath-TCP (MPTCP) implementation.
+ * Programmed by Morteza Kheirkhah from University of Sussex.
+ * Some codes here are modeled from ns3::TCPNewReno implementation.
+ * Email: m.kheirkhah@sussex.ac.uk
+ */
+#ifndef MP_TCP_CONGESTION_OPS_H
+#define MP_TCP_CONGESTION_OPS_H
+
+#include <string>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/mp-tcp-socket-base.h"
+
+namespace ns3
+{
+
+/**
+ * \brief Congestion control of the subflows of an MPTCP connection.
+ *
+ * MpTcpSocketBase calls the hooks of its MpTcpCongestionOps (attribute
+ * "CongestionOps", or the one matching "CongestionControl") on each event:
+ * IncreaseWindow on each new ACK, GetSsThresh on a fast retransmit,
+ * ReduceWindowOnEce on an ECN echo while DCTCP is enabled, PktsAcked on
+ * each RTT sample and WindowChanged after a retransmit timeout.
+ *
+ * Algorithms derive from MpTcpCongestionOpsImpl, which runs slow start and
+ * calls their CongestionAvoidance without a virtual call. The protected
+ * helpers give them the connection level state of the socket. One object
+ * may serve several sockets (Fork copies the pointer, and so does a
+ * CongestionOps default value), so connection state belongs to the socket
+ * or its subflows.
+ */
+class MpTcpCongestionOps : public Object
+{
+public:
+  static TypeId GetTypeId (void);
+
+  /**
+   * \returns the congestion control matching a CongestionControl value
+   */
+  static Ptr<MpTcpCongestionOps> CreateFor (CongestionCtrl_t algo);
+
+  virtual std::string GetName (void) const = 0;
+
+  /**
+   * \brief Open the window of subflow sFlowIdx on a new ACK
+   * \returns true if the subflow was in slow start
+   */
+  virtual bool IncreaseWindow (MpTcpSocketBase *sock, uint8_t sFlowIdx, uint32_t ackedBytes) = 0;
+
+  /**
+   * \returns the slow start threshold of subflow sFlowIdx after a fast retransmit
+   *
+   * The default halves the flight size, with a floor of two segments.
+   */
+  virtual uint32_t GetSsThresh (MpTcpSocketBase *sock, uint8_t sFlowIdx, uint32_t flightSize);
+
+  /**
+   * \brief Reduce the window of subflow sFlowIdx on an ECN echo
+   * \returns false to leave the reduction to the DCTCP code of the socket (default)
+   */
+  virtual bool ReduceWindowOnEce (MpTcpSocketBase *sock, uint8_t sFlowIdx);
+
+  /**
+   * \brief New RTT sample of subflow sFlowIdx, zero if the ACK gave none. Does nothing by default.
+   */
+  virtual void PktsAcked (MpTcpSocketBase *sock, uint8_t sFlowIdx, Time rtt);
+
+  /**
+   * \brief A retransmit timeout has cut a window. Does nothing by default.
+   */
+  virtual void WindowChanged (MpTcpSocketBase *sock);
+
+protected:
+  // Connection level state of the socket, for the algorithms
+  static Ptr<MpTcpSubFlow> GetSubflow (MpTcpSocketBase *sock, uint8_t sFlowIdx);
+  static uint32_t GetNSubflows (MpTcpSocketBase *sock);
+  static uint32_t GetTotalCwnd (MpTcpSocketBase *sock);      // As of the last UpdateTotalCwnd
+  static void UpdateTotalCwnd (MpTcpSocketBase *sock);
+  static uint32_t ComputeTotalWindow (MpTcpSocketBase *sock); // Sum of the windows, whatever the incast state
+  static double ComputeLinkedAlpha (MpTcpSocketBase *sock);   // RFC 6356 alpha
+  static uint32_t ComputeScaledA (MpTcpSocketBase *sock);     // COUPLED_INC's a
+  static double ComputeEpsilonAlpha (MpTcpSocketBase *sock);  // COUPLED_EPSILON's alpha
+  static uint32_t &ScaledA (MpTcpSocketBase *sock);
+  static double &Alpha (MpTcpSocketBase *sock);
+  static double GetEpsilon (MpTcpSocketBase *sock);
+  static bool IsAlphaPerAck (MpTcpSocketBase *sock);
+  static double Drand (MpTcpSocketBase *sock);
+};
+
+/**
+ * \brief Base of the congestion control algorithms.
+ *
+ * Algo derives from MpTcpCongestionOpsImpl<Algo> and defines
+ *
+ *   void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+ *
+ * It may also hide AckReceived, which sees every ACK before the slow start
+ * test and may clamp ackedBytes. Both are called on Algo itself, so the
+ * only virtual call per ACK is IncreaseWindow.
+ */
+template <class Algo>
+class MpTcpCongestionOpsImpl : public MpTcpCongestionOps
+{
+public:
+  virtual bool
+  IncreaseWindow (MpTcpSocketBase *sock, uint8_t sFlowIdx, uint32_t ackedBytes)
+  {
+    Algo *algo = static_cast<Algo *> (this);
+    Ptr<MpTcpSubFlow> sFlow = GetSubflow (sock, sFlowIdx);
+    algo->AckReceived (sock, sFlow, ackedBytes);
+    UpdateTotalCwnd (sock);
+    if (sFlow->cwnd.Get () < sFlow->ssthresh)
+      {
+        sFlow->cwnd += sFlow->MSS;
+        return true;
+      }
+    algo->CongestionAvoidance (sock, sFlow, sFlowIdx, ackedBytes);
+    return false;
+  }
+
+  void
+  AckReceived (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint32_t &ackedBytes)
+  {
+  }
+};
+
+/**
+ * \brief Base of the scalable and coupled algorithms of the COUPLED_* family.
+ *
+ * ackedBytes is capped to one segment, and Increase () gives the uncoupled
+ * increase the coupled ones are capped to.
+ */
+template <class Algo>
+class MpTcpScalableOpsImpl : public MpTcpCongestionOpsImpl<Algo>
+{
+public:
+  void
+  AckReceived (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint32_t &ackedBytes)
+  {
+    if (ackedBytes > sFlow->MSS)
+      ackedBytes = sFlow->MSS;
+  }
+
+protected:
+  static int
+  Increase (Ptr<MpTcpSubFlow> sFlow, uint32_t ackedBytes)
+  {
+    return (ackedBytes * sFlow->MSS) / sFlow->cwnd.Get ();
+  }
+};
+
+// Uncoupled_TCPs: one NewReno per subflow
+class MpTcpUncoupledTcps : public MpTcpCongestionOpsImpl<MpTcpUncoupledTcps>
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual std::string GetName (void) const;
+  void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+};
+
+// Linked_Increases: RFC 6356
+class MpTcpLinkedIncreases : public MpTcpCongestionOpsImpl<MpTcpLinkedIncreases>
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual std::string GetName (void) const;
+  void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+};
+
+// RTT_Compensator: RFC 6356, no more aggressive than NewReno on each subflow
+class MpTcpRttCompensator : public MpTcpCongestionOpsImpl<MpTcpRttCompensator>
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual std::string GetName (void) const;
+  void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+};
+
+// Fully_Coupled: one NewReno over the total window
+class MpTcpFullyCoupled : public MpTcpCongestionOpsImpl<MpTcpFullyCoupled>
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual std::string GetName (void) const;
+  void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+  virtual uint32_t GetSsThresh (MpTcpSocketBase *sock, uint8_t sFlowIdx, uint32_t flightSize);
+};
+
+// COUPLED_SCALABLE_TCP
+class MpTcpCoupledScalable : public MpTcpScalableOpsImpl<MpTcpCoupledScalable>
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual std::string GetName (void) const;
+  void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+  virtual uint32_t GetSsThresh (MpTcpSocketBase *sock, uint8_t sFlowIdx, uint32_t flightSize);
+};
+
+// UNCOUPLED
+class MpTcpUncoupled : public MpTcpScalableOpsImpl<MpTcpUncoupled>
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual std::string GetName (void) const;
+  void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+};
+
+// COUPLED_EPSILON
+class MpTcpCoupledEpsilon : public MpTcpScalableOpsImpl<MpTcpCoupledEpsilon>
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual std::string GetName (void) const;
+  void AckReceived (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint32_t &ackedBytes);
+  void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+  virtual void WindowChanged (MpTcpSocketBase *sock);
+};
+
+// COUPLED_INC
+class MpTcpCoupledInc : public MpTcpScalableOpsImpl<MpTcpCoupledInc>
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual std::string GetName (void) const;
+  void AckReceived (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint32_t &ackedBytes);
+  void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+  virtual void WindowChanged (MpTcpSocketBase *sock);
+};
+
+// COUPLED_FULLY
+class MpTcpCoupledFully : public MpTcpScalableOpsImpl<MpTcpCoupledFully>
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual std::string GetName (void) const;
+  void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+  virtual uint32_t GetSsThresh (MpTcpSocketBase *sock, uint8_t sFlowIdx, uint32_t flightSize);
+};
+
+// Fast_Uncoupled: uncoupled increase, slowed down by the fraction of ECN marks
+class MpTcpFastUncoupled : public MpTcpCongestionOpsImpl<MpTcpFastUncoupled>
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual std::string GetName (void) const;
+  void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+};
+
+// Fast_Increases: coupled increase, slowed down by the fraction of ECN marks
+class MpTcpFastIncreases : public MpTcpCongestionOpsImpl<MpTcpFastIncreases>
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual std::string GetName (void) const;
+  void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+};
+
+// XCA
+class MpTcpXca : public MpTcpCongestionOpsImpl<MpTcpXca>
+{
+public:
+  static TypeId GetTypeId (void);
+  virtual std::string GetName (void) const;
+  void CongestionAvoidance (MpTcpSocketBase *sock, Ptr<MpTcpSubFlow> sFlow, uint8_t sFlowIdx, uint32_t ackedBytes);
+};
+
+} // namespace ns3
+
+#endif /* MP_TCP_CONGESTION_OPS_H */
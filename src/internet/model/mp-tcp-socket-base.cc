@@ -16,6 +16,7 @@
 #include "ns3/log.h"
 #include "ns3/string.h"
 #include "ns3/mp-tcp-socket-base.h"
+#include "ns3/mp-tcp-congestion-ops.h"
 #include "ns3/tcp-l4-protocol.h"
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/error-model.h"
@@ -25,14 +26,9 @@
 #include "ns3/drop-tail-queue.h"
 #include "ns3/object-vector.h"
 #include "ns3/flow-id-tag.h"
-#include "ns3/ce-tag.h"
-#include "ns3/ece-tag.h"
-#include "ns3/ect-tag.h"
-#include "ns3/control-tag.h"
-#include "ns3/ecmp-tag.h"
-
-#define PLOT
-#define PLOT_DCTCP
+#include "ns3/dc-tag.h"
+#include "ns3/flow-results-sink.h"
+
 //#define MANUAL_DROP
 
 #define RAND_GAP
@@ -57,11 +53,16 @@ MpTcpSocketBase::GetTypeId (void)
                      MakeEnumChecker (Uncoupled_TCPs, "Uncoupled_TCPs", Fully_Coupled, "Fully_Coupled", RTT_Compensator, "RTT_Compensator",
                            Linked_Increases, "Linked_Increases", COUPLED_INC, "COUPLED_INC", COUPLED_EPSILON, "COUPLED_EPSILON",
                            COUPLED_SCALABLE_TCP, "COUPLED_SCALABLE_TCP", COUPLED_FULLY, "COUPLED_FULLY", UNCOUPLED, "UNCOUPLED",  Fast_Uncoupled, "Fast_Uncoupled", Fast_Increases, "Fast_Increases", XCA, "XCA"))
+      .AddAttribute ("CongestionOps",
+                     "Congestion control object, replaces the one chosen by CongestionControl",
+                     PointerValue (),
+                     MakePointerAccessor (&MpTcpSocketBase::GetCongestionOps, &MpTcpSocketBase::SetCongestionOps),
+                     MakePointerChecker<MpTcpCongestionOps> ())
       .AddAttribute ("SchedulingAlgorithm",
                      "Algorithm for data distribution between sub-flows",
                      EnumValue (Round_Robin),
                      MakeEnumAccessor (&MpTcpSocketBase::SetDataDistribAlgo),
-                     MakeEnumChecker (Round_Robin, "Round_Robin"))
+                     MakeEnumChecker (Round_Robin, "Round_Robin", Min_Rtt, "Min_Rtt", Rate_Weighted, "Rate_Weighted", Ecn_Aware, "Ecn_Aware"))
       .AddAttribute ("PathManagement",
                      "Mechanism for establishing new sub-flows",
                      EnumValue (NdiffPorts),
@@ -98,6 +99,18 @@ MpTcpSocketBase::GetTypeId (void)
                      BooleanValue (false),
                      MakeBooleanAccessor (&MpTcpSocketBase::m_dctcpAlphaPerAck),
                      MakeBooleanChecker ())
+      .AddAttribute ("DctcpFixedPoint",
+                     "Update DCTCP alpha in fixed-point from the bytes acknowledged, with and without ECN echo, "
+                     "like Linux tcp_dctcp.c. DCTCPWeight must be a power of two from 2^-10 to 1",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&MpTcpSocketBase::m_dctcpFixedPoint),
+                     MakeBooleanChecker ())
+      .AddAttribute ("LazyRto",
+                     "Keep one retransmission timer event per subflow and move its deadline on new ACKs, "
+                     "re-arming the event when it fires early, instead of cancelling and rescheduling it per ACK",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&MpTcpSocketBase::m_lazyRto),
+                     MakeBooleanChecker ())
       .AddAttribute ("DctcpFastReTxRecord", " Recording Fraction/Alpha at FastReTx point ",
                      BooleanValue (false),
                      MakeBooleanAccessor (&MpTcpSocketBase::m_dctcpFastReTxRecord),
@@ -118,6 +131,17 @@ MpTcpSocketBase::GetTypeId (void)
                      BooleanValue (false),
                      MakeBooleanAccessor (&MpTcpSocketBase::m_ratePlotCl),
                      MakeBooleanChecker ())
+      .AddAttribute ("PlotSeries",
+                     "Plot series recorded for flows selected by LargePlotting/ShortPlotting, as PlotSeriesGroup flags",
+                     UintegerValue (PLOT_ALL),
+                     MakeUintegerAccessor (&MpTcpSocketBase::m_plotSeries),
+                     MakeUintegerChecker<uint32_t> (0, PLOT_ALL))
+      .AddAttribute ("PlotBufferSize",
+                     "Maximum number of samples kept per plot series, older samples are overwritten",
+                     UintegerValue (65536),
+                     MakeUintegerAccessor (&MpTcpSocketBase::SetPlotBufferSize,
+                                           &MpTcpSocketBase::GetPlotBufferSize),
+                     MakeUintegerChecker<uint32_t> ())
       .AddAttribute ("RateInterval",
                      "Sample rate interval for rate plotting, default is 0.1 seconds",
                      DoubleValue (0.1),
@@ -152,11 +176,46 @@ MpTcpSocketBase::GetTypeId (void)
                      UintegerValue (1),
                      MakeUintegerAccessor (&MpTcpSocketBase::m_rwndScale),
                      MakeUintegerChecker<uint32_t> ())
+      .AddAttribute ("FlowControl",
+                     "Advertise the free space of the receive buffer (RcvBufSize) as receive window, with the "
+                     "window scale option, instead of a constant 65535 that the sender multiplies by RwndScale",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&MpTcpSocketBase::m_flowControl),
+                     MakeBooleanChecker ())
+      .AddAttribute ("RcvBufAutoTuning",
+                     "With FlowControl, grow the receive buffer up to RcvBufMax to twice what the application "
+                     "reads per RTT, as Linux does",
+                     BooleanValue (true),
+                     MakeBooleanAccessor (&MpTcpSocketBase::m_rcvBufAutoTuning),
+                     MakeBooleanChecker ())
+      .AddAttribute ("RcvBufMax",
+                     "Largest receive buffer autotuning may grow to, in bytes",
+                     UintegerValue (6291456),
+                     MakeUintegerAccessor (&MpTcpSocketBase::m_rcvBufMax),
+                     MakeUintegerChecker<uint32_t> ())
       .AddAttribute ("ECN",
                      "ECN flavored socket",
                      BooleanValue (false),
                      MakeBooleanAccessor (&MpTcpSocketBase::m_ecn),
                      MakeBooleanChecker ())
+      .AddAttribute ("AckCoalesceTime",
+                     "Acknowledge back to back data segments of a subflow with one ACK, sent once no segment has "
+                     "arrived for this long (0 uses DelAckCount and DelAckTimeout instead)",
+                     TimeValue (Seconds (0)),
+                     MakeTimeAccessor (&MpTcpSocketBase::m_ackCoalesceTime),
+                     MakeTimeChecker ())
+      .AddAttribute ("TimestampRtt",
+                     "Measure the RTT of subflows from echoed TCP timestamps (RFC 7323) rather than from a "
+                     "history of the segments sent, which DctcpAlphaPerAck needs",
+                     BooleanValue (false),
+                     MakeBooleanAccessor (&MpTcpSocketBase::m_timestampRtt),
+                     MakeBooleanChecker ())
+      .AddAttribute ("SuperSegment",
+                     "Send up to this many MSS of a subflow as one packet, which queues and links handle as back to "
+                     "back segments (1 sends every segment on its own)",
+                     UintegerValue (1),
+                     MakeUintegerAccessor (&MpTcpSocketBase::m_superSegment),
+                     MakeUintegerChecker<uint32_t> (1, 64))
      .AddAttribute ("DisjoinedPath",
                     "Long Flows use disjointed path at the aggregation layer only",
                     BooleanValue (false),
@@ -196,7 +255,19 @@ MpTcpSocketBase::GetTypeId (void)
                    "ADCT switching threshold",
                    UintegerValue (10000000), // 10MB
                    MakeUintegerAccessor (&MpTcpSocketBase::m_ADCTthresh),
-                   MakeUintegerChecker<uint32_t> ());
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("RcvBuf",
+                     "Receive buffer the window is advertised from, with FlowControl",
+                     MakeTraceSourceAccessor (&MpTcpSocketBase::m_rcvBuf))
+    .AddTraceSource ("ReorderDepth",
+                     "Number of out-of-order segments held at connection level",
+                     MakeTraceSourceAccessor (&MpTcpSocketBase::m_reorderDepth))
+    .AddTraceSource ("DrainBatch",
+                     "Number of segments delivered in-order by one drain of the reassembly queue",
+                     MakeTraceSourceAccessor (&MpTcpSocketBase::m_drainBatchTrace))
+    .AddTraceSource ("PlotSample",
+                     "Sample recorded in one of the enabled plot series (subflow, series name, value)",
+                     MakeTraceSourceAccessor (&MpTcpSocketBase::m_plotSampleTrace));
   return tid;
 }
 
@@ -258,6 +329,21 @@ MpTcpSocketBase::MpTcpSocketBase () :
   m_CongestionExitHits = 0;
   m_ADCTcontrol = true;
   m_capacity = "100Mbps";
+  m_reorderDepth = 0;
+  m_maxReorderDepth = 0;
+  m_maxDrainBatch = 0;
+  m_plotMask = 0;
+  m_rcvBuf = 0;
+  m_rcvWnd = 0;
+  m_rcvWndEdge = 0;
+  m_wndScaling = false;
+  m_rcvWndShift = 0;
+  m_sndWndShift = 0;
+  m_rwndUpdated = false;
+  m_rcvRttSeq = 0;
+  m_rcvCopied = 0;
+  m_rcvSpace = 0;
+  m_rcvSpaceCopied = 0;
   Callback<void, Ptr<Socket> > vPS = MakeNullCallback<void, Ptr<Socket> > ();
   Callback<void, Ptr<Socket>, const Address &> vPSA = MakeNullCallback<void, Ptr<Socket>, const Address &> ();
   Callback<void, Ptr<Socket>, uint32_t> vPSUI = MakeNullCallback<void, Ptr<Socket>, uint32_t> ();
@@ -286,6 +372,11 @@ MpTcpSocketBase::~MpTcpSocketBase (void)
     }
   m_tcp = 0;
   CancelAllSubflowTimers ();
+  // ~MpTcpSubFlow resets cwnd, which must not reach m_coupled once this socket is gone
+  for (uint32_t i = 0; i < subflows.size (); i++)
+    {
+      subflows[i]->cwnd.DisconnectWithoutContext (MakeCallback (&MpTcpSocketBase::CwndChanged, this).Bind ((uint8_t) i));
+    }
   NS_LOG_INFO(Simulator::Now().GetSeconds() << " ["<< this << "] ~MpTcpSocketBase -> m_node: " << m_node << " m_tcp: " << m_tcp << " m_endPoint: " << m_endPoint);
 }
 
@@ -340,8 +431,18 @@ MpTcpSocketBase::EstimateRtt (uint8_t sFlowIdx, const TcpHeader& mptcpHeader)
   NS_LOG_FUNCTION(this << (int)sFlowIdx);
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
 
-  bool isECNEcho = (mptcpHeader.GetFlags () == (TcpHeader::ACK) && (m_eceBit > 0));
-  Time nextRtt = sFlow->rtt->AckSeq (mptcpHeader.GetAckNumber (), isECNEcho);
+  Time nextRtt;
+  if (m_timestampRtt)
+    {
+      nextRtt = EchoedRtt (sFlowIdx, mptcpHeader);
+    }
+  else
+    {
+      bool isECNEcho = (mptcpHeader.GetFlags () == (TcpHeader::ACK) && (m_eceBit > 0));
+      nextRtt = sFlow->rtt->AckSeq (mptcpHeader.GetAckNumber (), isECNEcho);
+    }
+  SubflowWindowChanged (sFlowIdx);
+  m_congestionOps->PktsAcked (this, sFlowIdx, nextRtt);
 
   sFlow->lastMeasuredRtt = nextRtt;
   if (sFlow->lastMeasuredRtt != Seconds (0.0))
@@ -351,16 +452,45 @@ MpTcpSocketBase::EstimateRtt (uint8_t sFlowIdx, const TcpHeader& mptcpHeader)
     }
 
   // Plotting
-#ifdef PLOT
-  sFlow->_RTT.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->lastMeasuredRtt.GetMilliSeconds ()));
-  sFlow->_AvgRTT.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->rtt->GetCurrentEstimate ().GetMilliSeconds ()));
-  sFlow->_RTO.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->rtt->RetransmitTimeout ().GetMilliSeconds ()));
-#endif
+  if (IsPlotting (PLOT_RTT))
+    {
+      RecordPlot (sFlow->_RTT, "_RTT", sFlowIdx, sFlow->lastMeasuredRtt.GetMilliSeconds ());
+      RecordPlot (sFlow->_AvgRTT, "_AvgRTT", sFlowIdx, sFlow->rtt->GetCurrentEstimate ().GetMilliSeconds ());
+      RecordPlot (sFlow->_RTO, "_RTO", sFlowIdx, sFlow->rtt->RetransmitTimeout ().GetMilliSeconds ());
+    }
 
-#ifdef PLOT_DCTCP
-  sFlow->DCTCP_ALPHA_RTT.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->rtt->m_alpha));
-  sFlow->DCTCP_FRACTION_RTT.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->rtt->m_fracMarkPkt));
-#endif
+  if (IsPlotting (PLOT_DCTCP))
+    {
+      RecordPlot (sFlow->DCTCP_ALPHA_RTT, "DCTCP_ALPHA_RTT", sFlowIdx, sFlow->rtt->m_alpha);
+      RecordPlot (sFlow->DCTCP_FRACTION_RTT, "DCTCP_FRACTION_RTT", sFlowIdx, sFlow->rtt->m_fracMarkPkt);
+    }
+}
+
+/** Measures the RTT from the TSecr of a new ACK, RFC 7323 */
+Time
+MpTcpSocketBase::EchoedRtt (uint8_t sFlowIdx, const TcpHeader& mptcpHeader)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  NS_ABORT_MSG_IF (m_dctcpAlphaPerAck, "DctcpAlphaPerAck needs the RTT history, which TimestampRtt does not keep");
+  if (mptcpHeader.GetAckNumber ().GetValue () <= sFlow->highestAck + 1)
+    return Seconds (0.0); // Duplicate ACKs may echo an older segment
+  for (uint32_t j = 0; j < mptcpHeader.GetNOptions (); j++)
+    {
+      const TcpOptions &opt = mptcpHeader.GetOption (j);
+      if (opt.optName == OPT_TT && opt.tt.TSecr != 0)
+        return sFlow->rtt->AckTimestamp (NanoSeconds (opt.tt.TSecr));
+    }
+  return Seconds (0.0);
+}
+
+/** Adds the timestamp option to a segment, returns its length */
+uint8_t
+MpTcpSocketBase::AddTimestamp (uint8_t sFlowIdx, TcpHeader& header)
+{
+  if (!m_timestampRtt)
+    return 0;
+  header.AddOptTT (OPT_TT, Simulator::Now ().GetNanoSeconds (), subflows[sFlowIdx]->m_tsRecent);
+  return 17;
 }
 
 /* Read options from incoming packets */
@@ -369,18 +499,16 @@ MpTcpSocketBase::ReadOptions (Ptr<Packet> pkt, const TcpHeader& mptcpHeader)
 { // Any packet without SYN and MP_CAPABLE is not being processed!
   NS_LOG_FUNCTION(this << mptcpHeader);
   NS_ASSERT(remoteToken == 0 && mpEnabled == false);
-  vector<TcpOptions*> mp_options = mptcpHeader.GetOptions ();
   uint8_t flags = mptcpHeader.GetFlags ();
-  TcpOptions *opt;
   bool hasSyn = flags & TcpHeader::SYN;
-  for (uint32_t j = 0; j < mp_options.size (); j++)
+  for (uint32_t j = 0; j < mptcpHeader.GetNOptions (); j++)
     {
-      opt = mp_options[j];
-      if ((opt->optName == OPT_MPC) && hasSyn && (mpRecvState == MP_NONE))
+      const TcpOptions &opt = mptcpHeader.GetOption (j);
+      if ((opt.optName == OPT_MPC) && hasSyn && (mpRecvState == MP_NONE))
         { // SYN+ACK would be send later on by ProcessSynRcvd(...)
           mpRecvState = MP_MPC;
           mpEnabled = true;
-          remoteToken = ((OptMultipathCapable *) opt)->senderToken;
+          remoteToken = opt.mpc.senderToken;
           if (remoteToken == 0)
             NS_ASSERT(remoteToken != 0); // Correct condition
           return true;
@@ -399,49 +527,56 @@ MpTcpSocketBase::ReadOptions (uint8_t sFlowIdx, Ptr<Packet> pkt, const TcpHeader
 {
   NS_LOG_FUNCTION(this << (int)sFlowIdx << mptcpHeader);
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-  vector<TcpOptions*> options = mptcpHeader.GetOptions ();
   uint8_t flags = mptcpHeader.GetFlags ();
-  TcpOptions *opt;
   bool hasSyn = flags & TcpHeader::SYN;
   bool TxAddr = false;
-  for (uint32_t j = 0; j < options.size (); j++)
+  for (uint32_t j = 0; j < mptcpHeader.GetNOptions (); j++)
     {
-      opt = options[j];
-      if ((opt->optName == OPT_MPC) && hasSyn && (mpRecvState == MP_NONE))
+      const TcpOptions &opt = mptcpHeader.GetOption (j);
+      if ((opt.optName == OPT_MPC) && hasSyn && (mpRecvState == MP_NONE))
         { // SYN+ACK would be send later on by ProcessSynRcvd(...)
           mpRecvState = MP_MPC;
           mpEnabled = true;
-          remoteToken = ((OptMultipathCapable *) opt)->senderToken;
+          remoteToken = opt.mpc.senderToken;
           NS_ASSERT(remoteToken != 0);
           NS_ASSERT(client);
         }
-      else if ((opt->optName == OPT_JOIN) && hasSyn)
+      else if ((opt.optName == OPT_JOIN) && hasSyn)
         {
-          OptJoinConnection * optJoin = (OptJoinConnection *) opt;
-          if ((mpSendState == MP_ADDR) && (localToken == optJoin->receiverToken))
+          const OptJoinConnection &optJoin = opt.join;
+          if ((mpSendState == MP_ADDR) && (localToken == optJoin.receiverToken))
             { // SYN+ACK would be send later on by ProcessSynRcvd(...)
               // Join option is sent over the path (couple of addresses) not already in use
               NS_LOG_UNCOND("Server receive new subflow!");
             }
         }
-      else if ((opt->optName == OPT_ADDR) && (mpRecvState == MP_MPC))
+      else if ((opt.optName == OPT_ADDR) && (mpRecvState == MP_MPC))
         {
           // Receiver store sender's addresses information and send back its addresses.
           // If there are several addresses to advertise then multiple OPT_ADDR would be attached to the TCP Options.
           MpTcpAddressInfo * addrInfo = new MpTcpAddressInfo ();
-          addrInfo->addrID = ((OptAddAddress *) opt)->addrID;
-          addrInfo->ipv4Addr = ((OptAddAddress *) opt)->addr;
+          addrInfo->addrID = opt.addAddr.addrID;
+          addrInfo->ipv4Addr = opt.addAddr.GetAddress ();
           remoteAddrs.insert (remoteAddrs.end (), addrInfo);
           TxAddr = true;
         }
-      else if (opt->optName == OPT_REMADR)
+      else if (opt.optName == OPT_REMADR)
         { // not implemented yet
           NS_LOG_WARN(this << "ReadOption-> OPT_REMADR is not implemented yet");
         }
-      else if (opt->optName == OPT_DSN)
+      else if (opt.optName == OPT_DSN)
         { // not implemented yet
           NS_LOG_LOGIC(this << " ReadOption-> OPT_DSN -> we'll deal with it later on");
         }
+      else if (opt.optName == OPT_WS && hasSyn && sFlow->routeId == 0)
+        { // SYN+ACK of the master subflow
+          SetPeerWindowShift (opt.ws.shift);
+        }
+      else if (opt.optName == OPT_TT)
+        { // Echo the TSval of the first segment that the next ACK covers, RFC 7323
+          if (mptcpHeader.GetSequenceNumber ().GetValue () <= sFlow->m_tsLastAck && opt.tt.TSval >= sFlow->m_tsRecent)
+            sFlow->m_tsRecent = opt.tt.TSval;
+        }
       else if (hasSyn)
         { // incoming packet has syn but without proper mptcp option
           // TODO Should send RST here as remoteToken is not received...
@@ -575,6 +710,7 @@ MpTcpSocketBase::CompleteFork (Ptr<Packet> p, const TcpHeader& mptcpHeader, cons
 
   // Create new master subflow (master subsock) and assign its endpoint to the connection endpoint
   Ptr<MpTcpSubFlow> sFlow = CreateObject<MpTcpSubFlow> ();
+  sFlow->SetPlotBufferSize (m_plotBufferSize);
   sFlow->routeId = (subflows.size () == 0 ? 0 : subflows[subflows.size () - 1]->routeId + 1);
   sFlow->sAddr = m_localAddress; //m_endPoint->GetLocalAddress();
   sFlow->sPort = m_localPort;    //m_endPoint->GetLocalPort();
@@ -588,9 +724,14 @@ MpTcpSocketBase::CompleteFork (Ptr<Packet> p, const TcpHeader& mptcpHeader, cons
   sFlow->rtt->SetG (m_g);
   sFlow->m_endPoint = m_endPoint; // This is master subsock, its endpoint is the same as connection endpoint.
   NS_LOG_INFO ("("<< (int)sFlow->routeId<<") LISTEN -> SYN_RCVD");
-  subflows.insert (subflows.end (), sFlow);
+  AddSubflow (sFlow);
   sFlow->RxSeqNumber = (mptcpHeader.GetSequenceNumber ()).GetValue () + 1; //Set the subflow sequence number and send SYN+ACK
   NS_LOG_DEBUG("CompleteFork -> RxSeqNb: " << sFlow->RxSeqNumber << " highestAck: " << sFlow->highestAck);
+  for (uint32_t j = 0; j < mptcpHeader.GetNOptions (); j++)
+    { // The listening socket stops reading options at MP_CAPABLE
+      if (mptcpHeader.GetOption (j).optName == OPT_WS)
+        SetPeerWindowShift (mptcpHeader.GetOption (j).ws.shift);
+    }
   SendEmptyPacket (sFlow->routeId, TcpHeader::SYN | TcpHeader::ACK);
 
   // Update currentSubflow in case close just after 3WHS.
@@ -675,6 +816,7 @@ MpTcpSocketBase::ProcessSynSent (uint8_t sFlowIdx, Ptr<Packet> packet, const Tcp
       sFlow->RxSeqNumber = (mptcpHeader.GetSequenceNumber ()).GetValue () + 1;
       sFlow->highestAck = std::max (sFlow->highestAck, mptcpHeader.GetAckNumber ().GetValue () - 1);
       sFlow->TxSeqNumber = mptcpHeader.GetAckNumber ().GetValue ();
+      m_readySubflows.MarkReady (sFlowIdx);
       sFlow->maxSeqNb = sFlow->TxSeqNumber - 1;
       sFlow->m_highTxMark = sFlow->TxSeqNumber - 1;
       if ((m_ratePlotSf && (flowType.compare ("Short") != 0)) || (m_largePlotting && (flowType.compare ("Short") != 0)))
@@ -684,6 +826,7 @@ MpTcpSocketBase::ProcessSynSent (uint8_t sFlowIdx, Ptr<Packet> packet, const Tcp
       Time estimate;
       estimate = Seconds (1.5);
       sFlow->rtt->SetCurrentEstimate (estimate);
+      SubflowWindowChanged (sFlowIdx);
 
       SendEmptyPacket (sFlowIdx, TcpHeader::ACK);
 
@@ -748,6 +891,7 @@ MpTcpSocketBase::ProcessSynRcvd (uint8_t sFlowIdx, Ptr<Packet> packet, const Tcp
     { // handshake is completed nicely in the receiver.
       NS_LOG_INFO (" ("<< sFlow->routeId << ") " << TcpStateName[sFlow->state]<<" -> ESTABLISHED");
       sFlow->state = ESTABLISHED; // Subflow state is ESTABLISHED
+      m_readySubflows.MarkReady (sFlowIdx);
       m_state = ESTABLISHED;      // NEED TO CONSIDER IT AGAIN....
       sFlow->connected = true;    // This means subflow is established
       sFlow->retxEvent.Cancel ();  // This would cancel ReTxTimer where it being setup when SYN is sent.
@@ -896,6 +1040,7 @@ MpTcpSocketBase::CancelAllTimers (uint8_t sFlowIdx)
   sFlow->retxEvent.Cancel ();
   sFlow->m_lastAckEvent.Cancel ();
   sFlow->m_timewaitEvent.Cancel ();
+  sFlow->m_delAckEvent.Cancel ();
   NS_LOG_LOGIC( "(" << (int)sFlow->routeId<<")" << "CancelAllTimers");
 }
 
@@ -911,6 +1056,7 @@ MpTcpSocketBase::CancelAllSubflowTimers (void)
           sFlow->retxEvent.Cancel ();
           sFlow->m_lastAckEvent.Cancel ();
           sFlow->m_timewaitEvent.Cancel ();
+          sFlow->m_delAckEvent.Cancel ();
           NS_LOG_INFO("CancelAllSubflowTimers() -> Subflow:" << sFlow->routeId);
         }
     }
@@ -965,30 +1111,30 @@ MpTcpSocketBase::ReceivedData (uint8_t sFlowIdx, Ptr<Packet> p, const TcpHeader&
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
   uint32_t expectedSeq = sFlow->RxSeqNumber;
   uint32_t Seq = mptcpHeader.GetSequenceNumber ().GetValue ();
-  vector<TcpOptions*> options = mptcpHeader.GetOptions ();
-  TcpOptions* opt;
   bool stored = true;
-  for (uint32_t i = 0; i < options.size (); i++)
+  UpdateCeState (sFlowIdx);
+  for (uint32_t i = 0; i < mptcpHeader.GetNOptions (); i++)
     {
-      opt = options[i];
-      if (opt->optName == OPT_DSN)
+      const TcpOptions &opt = mptcpHeader.GetOption (i);
+      if (opt.optName == OPT_DSN)
         {
-          OptDataSeqMapping* optDSN = (OptDataSeqMapping*) opt;
-          NS_ASSERT(optDSN->subflowSeqNumber == Seq);
-          if (optDSN->subflowSeqNumber == sFlow->RxSeqNumber)
+          const OptDataSeqMapping &optDSN = opt.dsn;
+          NS_ASSERT(optDSN.subflowSeqNumber == Seq);
+          if (optDSN.subflowSeqNumber == sFlow->RxSeqNumber)
             { /* Received packet is in-sequence at sub-flow level. Now check connection level? */
-              if (optDSN->dataSeqNumber == nextRxSequence)
+              if (optDSN.dataSeqNumber == nextRxSequence)
                 {/** Received packet is in-sequence at connection level but in-order at sub-flow level **/
-                  uint32_t amountRead = recvingBuffer.ReadPacket (p, optDSN->dataLevelLength);
+                  uint32_t amountRead = recvingBuffer.ReadPacket (p, optDSN.dataLevelLength);
                   if (amountRead == 0)
                     {
                       NS_FATAL_ERROR("I don't see any reason to trigger this condition, at least in current implementation");
                       return;
                     }
-                  NS_ASSERT(amountRead == optDSN->dataLevelLength && optDSN->dataLevelLength == p->GetSize ());
+                  NS_ASSERT(amountRead == optDSN.dataLevelLength && optDSN.dataLevelLength == p->GetSize ());
                   sFlow->RxSeqNumber += amountRead;
                   // Increasing it would not hurt but it is essential for MMPTCP
                   sFlow->highestAck = std::max (sFlow->highestAck, (mptcpHeader.GetAckNumber ()).GetValue () - 1);
+                  m_readySubflows.MarkReady (sFlowIdx);
                   nextRxSequence += amountRead;
                   ReadUnOrderedData ();
                   //SendAccumulativeAck(sFlowIdx);
@@ -996,7 +1142,7 @@ MpTcpSocketBase::ReceivedData (uint8_t sFlowIdx, Ptr<Packet> p, const TcpHeader&
                     {
                       NotifyDataRecv ();
                     }
-                  SendEmptyPacket (sFlowIdx, TcpHeader::ACK);
+                  AckReceivedData (sFlowIdx);
 
                   if (sFlow->Finished () && (mptcpHeader.GetFlags () & TcpHeader::FIN) == 0)
                     { // If we received FIN before and now completed all "holes" in RX buffer, invoke peer close
@@ -1005,53 +1151,137 @@ MpTcpSocketBase::ReceivedData (uint8_t sFlowIdx, Ptr<Packet> p, const TcpHeader&
                       return;
                     }
                 }
-              else if (optDSN->dataSeqNumber > nextRxSequence) // there is a gap in dataSeqNumber
+              else if (optDSN.dataSeqNumber > nextRxSequence) // there is a gap in dataSeqNumber
                 { /** Received packet is out of sequence at connection level but in-order at sub-flow level **/
                   stored = StoreUnOrderedData (
-                      new DSNMapping (sFlowIdx, optDSN->dataSeqNumber, optDSN->dataLevelLength, optDSN->subflowSeqNumber,
+                      new DSNMapping (sFlowIdx, optDSN.dataSeqNumber, optDSN.dataLevelLength, optDSN.subflowSeqNumber,
                                       mptcpHeader.GetAckNumber ().GetValue ()/*, p*/));
                   // For allowing sub-flow to progress, RxSeqNb should be advanced even though packet is not in-order of connection level.
                   if (stored)
                     {
-                      NS_ASSERT(optDSN->subflowSeqNumber == sFlow->RxSeqNumber);
-                      sFlow->RxSeqNumber += optDSN->dataLevelLength;
+                      NS_ASSERT(optDSN.subflowSeqNumber == sFlow->RxSeqNumber);
+                      sFlow->RxSeqNumber += optDSN.dataLevelLength;
                       sFlow->highestAck = std::max (sFlow->highestAck, (mptcpHeader.GetAckNumber ()).GetValue () - 1);
+                      m_readySubflows.MarkReady (sFlowIdx);
 
                     }
                   // We need to send ACK here to indicate that a packet leaves a network and signaling to sender that which sequence number is expected to receive at sub-flow level.
-                  SendEmptyPacket (sFlowIdx, TcpHeader::ACK);
+                  AckReceivedData (sFlowIdx);
                 }
               else
                 { /** Received packet is duplicated in connection level! */
-                  NS_ASSERT(optDSN->dataSeqNumber < nextRxSequence);
+                  NS_ASSERT(optDSN.dataSeqNumber < nextRxSequence);
                   NS_FATAL_ERROR("This functionality is not yet implemented!"); NS_LOG_WARN(this << "Duplicated segment received at connection level so it should be rejected!");
                   SendEmptyPacket (sFlowIdx, TcpHeader::ACK);
                 }
             }
-          else if (optDSN->subflowSeqNumber > sFlow->RxSeqNumber)
+          else if (optDSN.subflowSeqNumber > sFlow->RxSeqNumber)
             { /* Received packet is out of order at sub-flow level */
               // This condition might occurs when a packet get drop...Does this condition mean that packet should be out of order at connection level? YES
-              NS_ASSERT(optDSN->dataSeqNumber > nextRxSequence);
+              NS_ASSERT(optDSN.dataSeqNumber > nextRxSequence);
               StoreUnOrderedData (
-                  new DSNMapping (sFlowIdx, optDSN->dataSeqNumber, optDSN->dataLevelLength, optDSN->subflowSeqNumber,
+                  new DSNMapping (sFlowIdx, optDSN.dataSeqNumber, optDSN.dataLevelLength, optDSN.subflowSeqNumber,
                                   mptcpHeader.GetAckNumber ().GetValue ()/*, p*/));
+              sFlow->m_rxGap = true;
+              EchoSegments (sFlowIdx);
               SendEmptyPacket (sFlowIdx, TcpHeader::ACK); // We need to send ACK regardless of whether segment has already stored in unOrdered or not!
             }
-          else if (optDSN->subflowSeqNumber < sFlow->RxSeqNumber)
+          else if (optDSN.subflowSeqNumber < sFlow->RxSeqNumber)
             { /* Received packet is duplicated at sub-flow level. It should be rejected!*/
-              NS_LOG_INFO("Data received is duplicated in Subflow Layer so it has been rejected! subflowSeq: " << optDSN->subflowSeqNumber << " dataSeq: " << optDSN->dataSeqNumber);
+              NS_LOG_INFO("Data received is duplicated in Subflow Layer so it has been rejected! subflowSeq: " << optDSN.subflowSeqNumber << " dataSeq: " << optDSN.dataSeqNumber);
               SendEmptyPacket (sFlowIdx, TcpHeader::ACK);  // Ask for next expected sub-flow sequence number to receive.
             }
           else
             NS_FATAL_ERROR_NO_MSG()
             ; // There should not be any other condition!
         } // end of if clause
-      else
+      else if (opt.optName != OPT_TT)
         NS_FATAL_ERROR(
             "ReceivedData() has called when there is no DSN option in the packet - Currently only DSN option is sent in each data packet!");
     } // end of for loop over TCP options
 }
 
+/*
+ * RFC 1122 delayed ACKs: an ACK is sent for every DelAckCount in-order segments, or DelAckTimeout after
+ * the first one still unacknowledged. Segments that are out of order, fill a hole or carry a FIN are
+ * acknowledged at once. With AckCoalesceTime set, a burst of back to back segments is acknowledged by a
+ * single ACK once the subflow has been idle for that long, as GRO would do, or once 64KB are pending.
+ * A super-segment counts as one segment here, the ACK echoes how many segments it covers instead.
+ */
+void
+MpTcpSocketBase::AckReceivedData (uint8_t sFlowIdx)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  EchoSegments (sFlowIdx);
+  if (sFlow->m_rxGap || sFlow->m_gotFin)
+    {
+      sFlow->m_rxGap = false;
+      SendEmptyPacket (sFlowIdx, TcpHeader::ACK);
+      return;
+    }
+  sFlow->m_delAckCount++;
+  if (m_ackCoalesceTime.IsStrictlyPositive ())
+    {
+      sFlow->m_lastRxTime = Simulator::Now ();
+      if (sFlow->m_delAckCount * sFlow->MSS >= 65535)
+        SendEmptyPacket (sFlowIdx, TcpHeader::ACK);
+      else if (sFlow->m_delAckEvent.IsExpired ())
+        sFlow->m_delAckEvent = Simulator::Schedule (m_ackCoalesceTime, &MpTcpSocketBase::DelAckTimeout, this, sFlowIdx);
+    }
+  else if (sFlow->m_delAckCount >= m_delAckMaxCount)
+    SendEmptyPacket (sFlowIdx, TcpHeader::ACK);
+  else if (sFlow->m_delAckEvent.IsExpired ())
+    sFlow->m_delAckEvent = Simulator::Schedule (m_delAckTimeout, &MpTcpSocketBase::DelAckTimeout, this, sFlowIdx);
+}
+
+/*
+ * The ACK of a super-segment tells the sender how many segments it covers and how many of them were
+ * marked, so that DCTCP and duplicate ACK counting see what they would have seen with one ACK per segment.
+ */
+void
+MpTcpSocketBase::EchoSegments (uint8_t sFlowIdx)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  if (sFlow->m_echoSuper && sFlow->m_echoSegments + m_rxSegments > 64)
+    SendEmptyPacket (sFlowIdx, TcpHeader::ACK); // An ACK echoes at most 64 segments
+  sFlow->m_echoSegments += m_rxSegments;
+  sFlow->m_echoMarked += m_rxMarkedSegments;
+  sFlow->m_echoSuper = sFlow->m_echoSuper || m_rxSegments > 1;
+}
+
+void
+MpTcpSocketBase::DelAckTimeout (uint8_t sFlowIdx)
+{
+  NS_LOG_FUNCTION (this << (int) sFlowIdx);
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  if (sFlow->m_endPoint == 0 || sFlow->state == CLOSED)
+    return;
+  Time idle = Simulator::Now () - sFlow->m_lastRxTime;
+  if (m_ackCoalesceTime.IsStrictlyPositive () && idle < m_ackCoalesceTime)
+    { // More segments arrived since the timer was set, wait until the burst is over
+      sFlow->m_delAckEvent = Simulator::Schedule (m_ackCoalesceTime - idle, &MpTcpSocketBase::DelAckTimeout, this, sFlowIdx);
+      return;
+    }
+  SendEmptyPacket (sFlowIdx, TcpHeader::ACK);
+}
+
+/*
+ * DCTCP receiver: when the CE mark of the incoming segment differs from the previous one, the segments
+ * received so far are acknowledged at once with the old ECE value, so that delaying ACKs does not
+ * change the fraction of marked bytes the sender sees.
+ */
+void
+MpTcpSocketBase::UpdateCeState (uint8_t sFlowIdx)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  bool ce = m_ceBit > 0;
+  if (ce == sFlow->m_ceState)
+    return;
+  if (sFlow->m_delAckCount > 0)
+    SendEmptyPacket (sFlowIdx, TcpHeader::ACK);
+  sFlow->m_ceState = ce;
+}
+
 void
 MpTcpSocketBase::SendAccumulativeAck (uint8_t sFlowIdx)
 {
@@ -1085,56 +1315,52 @@ MpTcpSocketBase::ReceivedAck (uint8_t sFlowIdx, Ptr<Packet> packet, const TcpHea
           m_g = m_ADCTg;
           m_ADCTcontrol = false;
         }
-      CalculateDCTCPAlpha (sFlowIdx, ack);
+      if (m_dctcpFixedPoint)
+        CalculateDctcpAlphaFixed (sFlowIdx, ack);
+      else
+        CalculateDCTCPAlpha (sFlowIdx, ack);
     }
 
-#ifdef PLOT
-  uint32_t tmp = ((ack - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-  sFlow->ACK.push_back (make_pair (Simulator::Now ().GetSeconds (), tmp));
-#endif
+  if (IsPlotting (PLOT_SEQUENCE))
+    {
+      uint32_t tmp = ((ack - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
+      RecordPlot (sFlow->ACK, "ACK", sFlowIdx, tmp);
+    }
 
   // Stop execution if TCPheader is not ACK at all.
   if (0 == (mptcpHeader.GetFlags () & TcpHeader::ACK))
     { // Ignore if no ACK flag
       //NS_ASSERT(3!=3);
     }
+  else if (ack == sFlow->highestAck + 1 && m_wndScaling && m_rwndUpdated)
+    { // A window update is not a duplicate ACK (RFC 5681), the window may have opened
+      SendPendingData (sFlowIdx);
+    }
   // Received ACK. Compare the ACK number against highest unacked seqno.
   else if (ack <= sFlow->highestAck + 1)
     {
       NS_LOG_LOGIC ("This acknowlegment" << mptcpHeader.GetAckNumber () << "do not ack the latest data in subflow level");
-      list<DSNMapping *>::iterator current = sFlow->mapDSN.begin ();
-      list<DSNMapping *>::iterator next = sFlow->mapDSN.begin ();
-      while (current != sFlow->mapDSN.end ())
-        {
-          ++next;
-          DSNMapping *ptrDSN = *current;
-          // All segments before ackSeqNum should be removed from the mapDSN list.
-          if (ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength <= ack)
-            { // Optional task ...
-              //next = sFlow->mapDSN.erase(current);
-              //delete ptrDSN;
-            }
-          // There is a sent segment with subflowSN equal to ack but the ack is smaller than already receveid acked!
-          else if ((ptrDSN->subflowSeqNumber == ack) && (ack < sFlow->highestAck + 1))
-            { // Case 1: Old ACK, ignored.
-              NS_LOG_WARN ("Ignored ack of " << mptcpHeader.GetAckNumber());
-              NS_ASSERT(3 != 3);
-              break;
-            }
-          // There is a sent segment with requested SequenceNumber and ack is for first unacked byte!!
-          else if ((ptrDSN->subflowSeqNumber == ack) && (ack == sFlow->highestAck + 1))
-            { // Case 2: Potentially a duplicated ACK, so ack should be smaller than nextExpectedSN to send.
-              if (ack < sFlow->TxSeqNumber)
-                {
-                  //NS_LOG_ERROR(Simulator::Now().GetSeconds()<< " [" << m_node->GetId()<< "] Duplicated ack received for SeqgNb: " << ack << " DUPACKs: " << sFlow->m_dupAckCount + 1);
-                  DupAck (sFlowIdx, ptrDSN);
-                  break;
-                }
-              // otherwise, the ACK is precisely equal to the nextTxSequence
-              NS_ASSERT(ack <= sFlow->TxSeqNumber);
-              break;
-            }
-          current = next;
+      // Only the segment starting at ack can be duplicately acked; older segments are fully acked already.
+      DSNMapping *ptrDSN = sFlow->mapDSN.Find (ack);
+      if (ptrDSN == 0)
+        { // Nothing unacked starts at ack
+        }
+      // There is a sent segment with subflowSN equal to ack but the ack is smaller than already receveid acked!
+      else if (ack < sFlow->highestAck + 1)
+        { // Case 1: Old ACK, ignored.
+          NS_LOG_WARN ("Ignored ack of " << mptcpHeader.GetAckNumber ());
+          NS_ASSERT(3 != 3);
+        }
+      // There is a sent segment with requested SequenceNumber and ack is for first unacked byte!!
+      else if (ack < sFlow->TxSeqNumber)
+        { // Case 2: Potentially a duplicated ACK, so ack should be smaller than nextExpectedSN to send.
+          // The ACK of an out of order super-segment stands for one duplicated ACK per segment
+          for (uint32_t i = 0; i < std::max<uint32_t> (m_rxEchoedSegments, 1); i++)
+            DupAck (sFlowIdx, ptrDSN);
+        }
+      else
+        { // otherwise, the ACK is precisely equal to the nextTxSequence
+          NS_ASSERT(ack <= sFlow->TxSeqNumber);
         }
     }
   else if (ack > sFlow->highestAck + 1)
@@ -1156,42 +1382,29 @@ MpTcpSocketBase::ReceivedAck (uint8_t sFlowIdx, Ptr<Packet> packet, const TcpHea
 }
 
 void
-MpTcpSocketBase::AddPacketTag (Ptr<Packet> p, PacketTag_t pt)
+MpTcpSocketBase::AddDcTag (Ptr<Packet> p, const DcTag &tag)
 {
-  EctTag ect;
-  CeTag ce;
-  EceTag ece;
-  ControlTag ct;
-  switch (pt)
+  if (tag.GetFlags () != 0)
     {
-  case ECT_TAG:
-    ect.SetEct(1);
-    p->AddPacketTag(ect);
-    break;
-  case CE_TAG:
-    ce.SetCe(1);
-    p->AddPacketTag(ce);
-  break;
-  case ECE_TAG:
-    ece.SetEce (1);
-    p->AddPacketTag (ece);
-  break;
-  case CP_TAG:
-    ct.SetControlPkt(1);
-    p->AddPacketTag(ct);
-    break;
-  default:
-    break;
+      p->AddPacketTag (tag);
     }
 }
 
 void
-MpTcpSocketBase::AddEcmpTag (Ptr<Packet> p, uint8_t sFlowIdx)
+MpTcpSocketBase::SetEcmpIndex (DcTag &tag, uint8_t sFlowIdx)
 {
-  EcmpTag ecmp;
-  ecmp.SetEcmp(m_initialRand + sFlowIdx);
-  p->AddPacketTag(ecmp);
-  //cout << "Rand(" << (int)m_initialRand << ") sFlowIdx(" << (int)sFlowIdx << ") EcmpIdx(" << (int)ecmp.GetEcmp() << ")" << endl;
+  tag.SetEcmp (m_initialRand + sFlowIdx);
+  //cout << "Rand(" << (int)m_initialRand << ") sFlowIdx(" << (int)sFlowIdx << ") EcmpIdx(" << (int)tag.GetEcmp() << ")" << endl;
+}
+
+void
+MpTcpSocketBase::SetSegments (DcTag &tag, uint8_t sFlowIdx, uint32_t size)
+{
+  uint32_t mss = subflows[sFlowIdx]->MSS;
+  if (size > mss)
+    { // Each segment would carry the IPv4 header and the TCP header with its options
+      tag.SetSegments ((size + mss - 1) / mss, SegmentOverhead ());
+    }
 }
 
 bool 
@@ -1247,16 +1460,26 @@ MpTcpSocketBase::CalculateDCTCPAlpha (uint8_t sFlowIdx, uint32_t ack)
 {
   NS_LOG_FUNCTION((int) sFlowIdx << ack);
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-  // Tracking total and marked ACK packets
-  sFlow->dctcp_total++;
+  // Tracking total and marked ACK packets, or the segments echoed by an ACK of super-segments
+  if (m_rxEchoedSegments > 0)
+    {
+      sFlow->dctcp_total += m_rxEchoedSegments;
+      sFlow->dctcp_marked += m_rxMarkedSegments;
+    }
+  else
+    {
+      sFlow->dctcp_total++;
+      if (m_eceBit > 0)
+        sFlow->dctcp_marked++;
+    }
   if (m_eceBit > 0)
     {
-      sFlow->dctcp_marked++;
       sFlow->curEcnState = true;
-#ifdef PLOT_DCTCP
-      uint32_t tmp = ((ack - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-      sFlow->ECN_ECHO.push_back (make_pair (Simulator::Now ().GetSeconds (), tmp));
-#endif
+      if (IsPlotting (PLOT_DCTCP))
+        {
+          uint32_t tmp = ((ack - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
+          RecordPlot (sFlow->ECN_ECHO, "ECN_ECHO", sFlowIdx, tmp);
+        }
     }
 
   if (ack > sFlow->dctcp_alpha_update_seq)
@@ -1286,15 +1509,83 @@ MpTcpSocketBase::CalculateDCTCPAlpha (uint8_t sFlowIdx, uint32_t ack)
       sFlow->dctcp_total = 0;
       sFlow->dctcp_alpha_update_seq = sFlow->TxSeqNumber;
       sFlow->curEcnState = m_eceBit > 0 ? true : false;
-#ifdef PLOT_DCTCP
-      sFlow->DCTCP_ALPHA.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->dctcp_alpha));
-      sFlow->DCTCP_FRACTION.push_back (make_pair (Simulator::Now ().GetSeconds (), temp_alpha));
-      uint32_t pktNumber = ((ack - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-      sFlow->BEG.push_back (make_pair (Simulator::Now ().GetSeconds (), pktNumber)); // ROUND for ECN and DCTCP
-#endif
+      if (IsPlotting (PLOT_DCTCP))
+        {
+          RecordPlot (sFlow->DCTCP_ALPHA, "DCTCP_ALPHA", sFlowIdx, sFlow->dctcp_alpha);
+          RecordPlot (sFlow->DCTCP_FRACTION, "DCTCP_FRACTION", sFlowIdx, temp_alpha);
+          uint32_t pktNumber = ((ack - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
+          RecordPlot (sFlow->BEG, "BEG", sFlowIdx, pktNumber); // ROUND for ECN and DCTCP
+        }
     }
 }
 
+/**
+ * Fixed-point CalculateDCTCPAlpha: an ACK adds the bytes it acknowledges, or one MSS for a duplicate ACK as
+ * Linux does, to the delivered and CE delivered counters, and alpha is only updated once per observation window.
+ */
+void
+MpTcpSocketBase::CalculateDctcpAlphaFixed (uint8_t sFlowIdx, uint32_t ack)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  uint32_t bytes = ack > sFlow->highestAck + 1 ? ack - (sFlow->highestAck + 1) : sFlow->MSS;
+  uint32_t ceBytes = 0;
+  if (m_rxEchoedSegments > 0)
+    ceBytes = (uint64_t) bytes * m_rxMarkedSegments / m_rxEchoedSegments;
+  else if (m_eceBit > 0)
+    ceBytes = bytes;
+  sFlow->dctcp_fixed.Ack (bytes, ceBytes);
+  if (m_eceBit > 0)
+    {
+      sFlow->curEcnState = true;
+      if (IsPlotting (PLOT_DCTCP))
+        {
+          uint32_t tmp = ((ack - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
+          RecordPlot (sFlow->ECN_ECHO, "ECN_ECHO", sFlowIdx, tmp);
+        }
+    }
+
+  if (ack > sFlow->dctcp_alpha_update_seq)
+    {
+      sFlow->dctcp_last_fraction = sFlow->dctcp_fixed.GetFraction ();
+      if (m_dctcpFastAlpha)
+        sFlow->dctcp_fixed.SetAlphaToFraction ();
+      else
+        {
+          uint32_t shiftG = 0;
+          NS_ABORT_MSG_IF (!DctcpFixedPoint::ShiftFromWeight (m_g, shiftG),
+                           "DctcpFixedPoint needs a power of two DCTCPWeight, not " << m_g);
+          sFlow->dctcp_fixed.UpdateAlpha (shiftG);
+        }
+      sFlow->dctcp_alpha = (double) sFlow->dctcp_fixed.GetAlpha () / DctcpFixedPoint::MAX_ALPHA;
+
+      if (m_isAdaptiveSubflow && (int)sFlowIdx == 0 && maxSubflows >= 2)
+        ShouldSuppressSubflows(sFlowIdx);
+
+      sFlow->dctcp_alpha_update_seq = sFlow->TxSeqNumber;
+      sFlow->curEcnState = m_eceBit > 0 ? true : false;
+      if (IsPlotting (PLOT_DCTCP))
+        {
+          RecordPlot (sFlow->DCTCP_ALPHA, "DCTCP_ALPHA", sFlowIdx, sFlow->dctcp_alpha);
+          RecordPlot (sFlow->DCTCP_FRACTION, "DCTCP_FRACTION", sFlowIdx, sFlow->dctcp_last_fraction);
+          uint32_t pktNumber = ((ack - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
+          RecordPlot (sFlow->BEG, "BEG", sFlowIdx, pktNumber); // ROUND for ECN and DCTCP
+        }
+    }
+}
+
+uint32_t
+MpTcpSocketBase::DctcpReduceWindow (uint8_t sFlowIdx) const
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  if (m_dctcpFixedPoint && !m_dctcpAlphaPerAck)
+    return sFlow->dctcp_fixed.ReduceWindow (sFlow->cwnd.Get ());
+
+  double alpha = m_dctcpAlphaPerAck ? sFlow->rtt->GetAlpha () : sFlow->dctcp_alpha;
+  double tmp = sFlow->cwnd.Get () * (1 - alpha / 2);
+  if (tmp < 0) tmp = 0;
+  return (uint32_t) tmp;
+}
+
 void
 MpTcpSocketBase::SetSegSize (uint32_t size)
 {
@@ -1328,21 +1619,15 @@ MpTcpSocketBase::SendDataPacket (uint8_t sFlowIdx, uint32_t size, bool withAck)
    */
   if (sFlow->maxSeqNb > sFlow->TxSeqNumber - 1)
     {
-      uint32_t IterNumber = 0;
-      for (list<DSNMapping *>::iterator it = sFlow->mapDSN.begin (); (it != sFlow->mapDSN.end () && guard == false); ++it)
-        { // Look for match a segment from subflow's buffer where it is matched with TxSeqNumber
-          IterNumber++;
-          DSNMapping * ptr = *it;
-          if (ptr->subflowSeqNumber == sFlow->TxSeqNumber)
-            {
-              ptrDSN = ptr;
-              //p = Create<Packet>(ptrDSN->packet, ptrDSN->dataLevelLength);
-              p = Create<Packet> (ptrDSN->dataLevelLength);
-              packetSize = ptrDSN->dataLevelLength;
-              guard = true;
-              NS_LOG_LOGIC(Simulator::Now().GetSeconds() <<" A segment matched from subflow buffer. Its size is "<< packetSize << " IterNumInMapDSN: " << IterNumber <<" maxSeqNb: " << sFlow->maxSeqNb << " TxSeqNb: " << sFlow->TxSeqNumber << " FastRecovery: " << sFlow->m_inFastRec << " SegNb: " << ptrDSN->subflowSeqNumber); //
-              break;
-            }
+      // Look for match a segment from subflow's buffer where it is matched with TxSeqNumber
+      ptrDSN = sFlow->mapDSN.Find (sFlow->TxSeqNumber);
+      if (ptrDSN != 0)
+        {
+          //p = Create<Packet>(ptrDSN->packet, ptrDSN->dataLevelLength);
+          p = Create<Packet> (ptrDSN->dataLevelLength);
+          packetSize = ptrDSN->dataLevelLength;
+          guard = true;
+          NS_LOG_LOGIC(Simulator::Now().GetSeconds() <<" A segment matched from subflow buffer. Its size is "<< packetSize <<" maxSeqNb: " << sFlow->maxSeqNb << " TxSeqNb: " << sFlow->TxSeqNumber << " FastRecovery: " << sFlow->m_inFastRec << " SegNb: " << ptrDSN->subflowSeqNumber); //
         }
       if (p == 0)
         {
@@ -1373,12 +1658,15 @@ MpTcpSocketBase::SendDataPacket (uint8_t sFlowIdx, uint32_t size, bool withAck)
   NS_ASSERT(packetSize <= size);
   NS_ASSERT(packetSize == p->GetSize ());
 
-  // @SendDataPacket -> Add ECT Tag on every data packet... We do this for ack packets as well
+  // @SendDataPacket -> ECT on every data packet... We do this for ack packets as well
+  DcTag dcTag;
   if (m_isDCTCPEnabled ||  m_ecn)
-    AddPacketTag(p, ECT_TAG); //AddEctTag(p);
+    dcTag.SetEct ();
   // @SendDataPacket
   if (m_disjoinPath && flowType.compare ("Large") == 0)
-    AddEcmpTag(p, sFlow->routeId);
+    SetEcmpIndex (dcTag, sFlow->routeId);
+  SetSegments (dcTag, sFlowIdx, packetSize);
+  AddDcTag (p, dcTag);
 
   // This is data packet, so its TCP_Flag should be 0
   uint8_t flags = withAck ? TcpHeader::ACK : 0;
@@ -1407,7 +1695,7 @@ MpTcpSocketBase::SendDataPacket (uint8_t sFlowIdx, uint32_t size, bool withAck)
 
   uint8_t hlen = 5;   // 5 --> 32-bit words = 20 Bytes == TcpHeader Size with out any option
   //uint8_t olen = 15;  // 15 because packet size is 2 bytes in size. 1 + 8 + 2+ 4 = 15
-  uint8_t olen = 20;
+  uint8_t olen = 20 + AddTimestamp (sFlowIdx, header);
   uint8_t plen = 0;
   plen = (4 - (olen % 4)) % 4; // (4 - (15 % 4)) 4 => 1
   olen = (olen + plen) / 4;    // (15 + 1) / 4 = 4
@@ -1436,15 +1724,17 @@ MpTcpSocketBase::SendDataPacket (uint8_t sFlowIdx, uint32_t size, bool withAck)
   if (!guard)
     sFlow->PktCount++;
 
-#ifdef PLOT
-  uint32_t tmp = (((sFlow->TxSeqNumber + packetSize) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-  sFlow->DATA.push_back (make_pair (Simulator::Now ().GetSeconds (), tmp));
-#endif
+  if (IsPlotting (PLOT_SEQUENCE))
+    {
+      uint32_t tmp = (((sFlow->TxSeqNumber + packetSize) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
+      RecordPlot (sFlow->DATA, "DATA", sFlowIdx, tmp);
+    }
 
   NS_LOG_LOGIC(Simulator::Now().GetSeconds() << " ["<< m_node->GetId()<< "] SendDataPacket->  " << header <<" dSize: " << packetSize<< " sFlow: " << sFlow->routeId);
 
   // Do some updates.....
-  sFlow->rtt->SentSeq (SequenceNumber32 (sFlow->TxSeqNumber), packetSize); // Notify the RTT of a data packet sent
+  if (!m_timestampRtt)
+    sFlow->rtt->SentSeq (SequenceNumber32 (sFlow->TxSeqNumber), packetSize); // Notify the RTT of a data packet sent
   sFlow->TxSeqNumber += packetSize; // Update subflow's nextSeqNum to send.
   sFlow->maxSeqNb = std::max (sFlow->maxSeqNb, sFlow->TxSeqNumber - 1);
   sFlow->m_highTxMark = std::max (sFlow->m_highTxMark, sFlow->TxSeqNumber - 1);
@@ -1497,7 +1787,7 @@ MpTcpSocketBase::ManualPacketDrop (uint8_t sFlowIdx, Ptr<Packet> p, uint32_t pac
       if (std::find (sampleList.begin (), sampleList.end (), pktNumber) != sampleList.end ())
         {
           uint32_t tmp = (((sFlow->TxSeqNumber + packetSize) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-          sFlow->DROP.push_back (make_pair (Simulator::Now ().GetSeconds (), tmp));
+          sFlow->DROP.Add (Simulator::Now ().GetSeconds (), tmp);
           sampleList.remove (pktNumber);
           return false;
         }
@@ -1609,7 +1899,7 @@ MpTcpSocketBase::DoRetransmit (uint8_t sFlowIdx)
   header.AddOptDSN (OPT_DSN, ptrDSN->dataSeqNumber, ptrDSN->dataLevelLength, ptrDSN->subflowSeqNumber);
 
   uint8_t hlen = 5;
-  uint8_t olen = 20; //uint8_t olen = 15;
+  uint8_t olen = 20 + AddTimestamp (sFlowIdx, header); //uint8_t olen = 15;
   uint8_t plen = 0;
   plen = (4 - (olen % 4)) % 4;
   olen = (olen + plen) / 4;
@@ -1618,31 +1908,36 @@ MpTcpSocketBase::DoRetransmit (uint8_t sFlowIdx)
   header.SetOptionsLength (olen);
   header.SetPaddingLength (plen);
 
-  // @DoRetransmit -> Add ECT Tag on every data packet... We do this for ack packets as well
+  // @DoRetransmit -> ECT on every data packet... We do this for ack packets as well
+  DcTag dcTag;
   if (m_isDCTCPEnabled ||  m_ecn)
-    AddPacketTag(pkt, ECT_TAG);
+    dcTag.SetEct ();
   // @DoRetransmit
   if (m_disjoinPath && flowType.compare ("Large") == 0)
-    AddEcmpTag (pkt, sFlow->routeId);
+    SetEcmpIndex (dcTag, sFlow->routeId);
+  SetSegments (dcTag, sFlowIdx, ptrDSN->dataLevelLength);
+  AddDcTag (pkt, dcTag);
 
   m_tcp->SendPacket (pkt, header, sFlow->sAddr, sFlow->dAddr, FindOutputNetDevice (sFlow->sAddr));
 
   //reset RTO
   SetReTxTimeout (sFlowIdx);
 
-#ifdef PLOT
-  uint32_t tmp = (((ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-  sFlow->RETRANSMIT.push_back (make_pair (Simulator::Now ().GetSeconds (), tmp));
-  if (!sFlow->m_inFastRec)
+  if (IsPlotting (PLOT_SEQUENCE))
     {
-      timeOutTrack.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->cwnd));
+      uint32_t tmp = (((ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
+      RecordPlot (sFlow->RETRANSMIT, "RETRANSMIT", sFlowIdx, tmp);
+    }
+  if (IsPlotting (PLOT_WINDOW) && !sFlow->m_inFastRec)
+    {
+      RecordPlot (timeOutTrack, "timeOutTrack", sFlowIdx, sFlow->cwnd);
     }
-#endif
 
   //TxBytes += ptrDSN->dataLevelLength + 62;
 
   // Update Rtt
-  sFlow->rtt->SentSeq (SequenceNumber32 (ptrDSN->subflowSeqNumber), ptrDSN->dataLevelLength);
+  if (!m_timestampRtt)
+    sFlow->rtt->SentSeq (SequenceNumber32 (ptrDSN->subflowSeqNumber), ptrDSN->dataLevelLength);
 
   // In case of RTO, advance m_nextTxSequence
   sFlow->TxSeqNumber = std::max (sFlow->TxSeqNumber, ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength);
@@ -1679,7 +1974,7 @@ MpTcpSocketBase::DoRetransmit (uint8_t sFlowIdx, DSNMapping* ptrDSN)
 
   NS_LOG_WARN (Simulator::Now().GetSeconds() <<" RetransmitSegment -> "<< " localToken "<< localToken<<" Subflow "<<(int) sFlowIdx<<" DataSeq "<< ptrDSN->dataSeqNumber <<" SubflowSeq " << ptrDSN->subflowSeqNumber <<" dataLength " << ptrDSN->dataLevelLength << " packet size " << pkt->GetSize() << " 3DupACK");
   uint8_t hlen = 5;
-  uint8_t olen = 20; //uint8_t olen = 15;
+  uint8_t olen = 20 + AddTimestamp (sFlowIdx, header); //uint8_t olen = 15;
   uint8_t plen = 0;
   plen = (4 - (olen % 4)) % 4;
   olen = (olen + plen) / 4;
@@ -1688,24 +1983,29 @@ MpTcpSocketBase::DoRetransmit (uint8_t sFlowIdx, DSNMapping* ptrDSN)
   header.SetOptionsLength (olen);
   header.SetPaddingLength (plen);
 
-  // @DoRetransmit -> Add ECT Tag on every data packet... We do this for ack packets as well
+  // @DoRetransmit -> ECT on every data packet... We do this for ack packets as well
+  DcTag dcTag;
   if (m_isDCTCPEnabled ||  m_ecn)
-    AddPacketTag (pkt, ECT_TAG);
+    dcTag.SetEct ();
   // @DoRetransmit
   if (m_disjoinPath && flowType.compare ("Large") == 0)
-    AddEcmpTag(pkt, sFlow->routeId);
+    SetEcmpIndex (dcTag, sFlow->routeId);
+  SetSegments (dcTag, sFlowIdx, ptrDSN->dataLevelLength);
+  AddDcTag (pkt, dcTag);
 
   // Send Segment to lower layer
   m_tcp->SendPacket (pkt, header, sFlow->sAddr, sFlow->dAddr, FindOutputNetDevice (sFlow->sAddr));
-#ifdef PLOT
-  uint32_t tmp = (((ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-  sFlow->RETRANSMIT.push_back (make_pair (Simulator::Now ().GetSeconds (), tmp));
-#endif
+  if (IsPlotting (PLOT_SEQUENCE))
+    {
+      uint32_t tmp = (((ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
+      RecordPlot (sFlow->RETRANSMIT, "RETRANSMIT", sFlowIdx, tmp);
+    }
 
   //TxBytes += ptrDSN->dataLevelLength + 62;
 
   // Notify RTT
-  sFlow->rtt->SentSeq (SequenceNumber32 (ptrDSN->subflowSeqNumber), ptrDSN->dataLevelLength);
+  if (!m_timestampRtt)
+    sFlow->rtt->SentSeq (SequenceNumber32 (ptrDSN->subflowSeqNumber), ptrDSN->dataLevelLength);
 
   // In case of RTO, advance m_nextTxSequence
   sFlow->TxSeqNumber = std::max (sFlow->TxSeqNumber, ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength);
@@ -1720,20 +2020,8 @@ void
 MpTcpSocketBase::DiscardUpTo (uint8_t sFlowIdx, uint32_t ack)
 {
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-  list<DSNMapping *>::iterator current = sFlow->mapDSN.begin ();
-  list<DSNMapping *>::iterator next = sFlow->mapDSN.begin ();
-  while (current != sFlow->mapDSN.end ())
-    {
-      ++next;
-      DSNMapping *ptrDSN = *current;
-      // All segments before ackSeqNum should be removed from the mapDSN list. Maybe equal part never run due to if condition above.
-      if (ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength <= ack)
-        {
-          next = sFlow->mapDSN.erase (current);
-          delete ptrDSN;
-        }
-      current = next;
-    }
+  // All segments before ackSeqNum should be removed from the mapDSN, they are always a prefix of it.
+  sFlow->mapDSN.DiscardUpTo (ack);
 }
 
 // .....................................................................................................
@@ -1813,6 +2101,7 @@ MpTcpSocketBase::Connect (Ipv4Address servAddr, uint16_t servPort)
 {
   NS_LOG_FUNCTION(this << servAddr << servPort);  //
   Ptr<MpTcpSubFlow> sFlow = CreateObject<MpTcpSubFlow> ();
+  sFlow->SetPlotBufferSize (m_plotBufferSize);
   sFlow->routeId = (subflows.size () == 0 ? 0 : subflows[subflows.size () - 1]->routeId + 1);
   sFlow->dAddr = servAddr;    // Assigned subflow destination address
   sFlow->dPort = servPort;    // Assigned subflow destination port
@@ -1849,6 +2138,8 @@ MpTcpSocketBase::Connect (Ipv4Address servAddr, uint16_t servPort)
           return -1;
         }
     }
+  // Bind() stored the endpoint's address before SetupEndpoint() picked one
+  m_localAddress = m_endPoint->GetLocalAddress ();
 
   // Set up subflow local addrs:port from endpoint
   sFlow->sAddr = m_endPoint->GetLocalAddress ();
@@ -1859,7 +2150,7 @@ MpTcpSocketBase::Connect (Ipv4Address servAddr, uint16_t servPort)
 
   // This is master subsocket (master subflow) then its endpoint is the same as connection endpoint.
   sFlow->m_endPoint = m_endPoint;
-  subflows.insert (subflows.end (), sFlow);
+  AddSubflow (sFlow);
 //  m_tcp->m_sockets.push_back(this); //TMP REMOVE
 
   sFlow->rtt->Reset (); // Dangerous ?!?!?! Not really?
@@ -2004,7 +2295,9 @@ MpTcpSocketBase::SendPendingData (uint8_t sFlowIdx)
     {
       NS_LOG_INFO ("Halving CWND because we've received ECN Echo.");
       NS_ASSERT(client);
-      if (m_slowDownEcnLike)
+      if (m_congestionOps->ReduceWindowOnEce (this, sFlowIdx))
+        SubflowWindowChanged (sFlowIdx);
+      else if (m_slowDownEcnLike)
         SlowDownEcnLike (sFlowIdx);
       else
         SlowDown (sFlowIdx);
@@ -2023,7 +2316,7 @@ MpTcpSocketBase::SendPendingData (uint8_t sFlowIdx)
             { // In case case more than one packet can be sent, if subflow's window allow
               whileCounter++;
               NS_LOG_UNCOND("["<< m_node->GetId() <<"] MainBuffer is empty - subflowBuffer(" << sF->mapDSN.size()<< ") sFlow("<< (int)sFlowIdx << ") AvailableWindow: " << window << " CWND: " << sF->cwnd << " subflow is in timoutRecovery{" << (sF->mapDSN.size() > 0) << "} LoopIter: " << whileCounter);
-              int ret = SendDataPacket (sF->routeId, window, false);
+              int ret = SendDataPacket (sF->routeId, std::max (window, SegmentLimit (sFlowIdx)), false); // Entries are resent whole
               if (ret < 0)
                 {
                   NS_LOG_UNCOND(this <<" [" << m_node->GetId() << "]("<< sF->routeId << ")" << " SendDataPacket return -1 -> Return false from SendPendingData()!?");
@@ -2064,22 +2357,12 @@ MpTcpSocketBase::SendPendingData (uint8_t sFlowIdx)
           window = std::min (AvailableWindow (lastUsedsFlowIdx), sendingBuffer.PendingData ()); // Get available window size
         }
       else
-        { // Normal operation
-          for (uint32_t i = 0; i < subflows.size (); i++)
+        { // Normal operation, subflows found without window are not looked at again until their window opens
+          uint8_t idx;
+          if (SelectSubflow (idx, window))
             {
-              if (subflows[lastUsedsFlowIdx]->state != ESTABLISHED)
-                continue;
-              window = std::min (AvailableWindow (lastUsedsFlowIdx), sendingBuffer.PendingData ()); // Get available window size
-              if (window == 0)
-                {  // No more available window in the current subflow, try with another one
-                  NS_LOG_LOGIC("SendPendingData -> No window available on (" << (int)lastUsedsFlowIdx << ") Try next one!");
-                  lastUsedsFlowIdx = getSubflowToUse ();
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("SendPendingData -> Find subflow with spare window PendingData (" << sendingBuffer.PendingData() << ") Available window ("<<AvailableWindow (lastUsedsFlowIdx)<<")");
-                  break;
-                }
+              NS_LOG_LOGIC ("SendPendingData -> Find subflow with spare window PendingData (" << sendingBuffer.PendingData() << ") Available window ("<< window <<")");
+              lastUsedsFlowIdx = idx;
             }
         }
 
@@ -2093,10 +2376,11 @@ MpTcpSocketBase::SendPendingData (uint8_t sFlowIdx)
       if (sFlow->state == ESTABLISHED)
         {
           currentSublow = sFlow->routeId;
-          uint32_t s = std::min (window, sFlow->MSS);  // Send no more than window
-          if (sFlow->maxSeqNb > sFlow->TxSeqNumber - 1 && sendingBuffer.PendingData () <= sFlow->MSS)
-            { // When subflow is in timeout recovery and the last segment is not reached yet then segment size should be equal to MSS
-              s = sFlow->MSS;
+          uint32_t limit = SegmentLimit (sFlow->routeId);
+          uint32_t s = std::min (window, limit);  // Send no more than window
+          if (sFlow->maxSeqNb > sFlow->TxSeqNumber - 1)
+            { // When subflow is in timeout recovery the segment is resent whole from mapDSN, the window holds at least an MSS
+              s = limit;
             }
           int amountSent = SendDataPacket (sFlow->routeId, s, false);
           if (amountSent < 0)
@@ -2115,6 +2399,108 @@ MpTcpSocketBase::SendPendingData (uint8_t sFlowIdx)
   return (nOctetsSent > 0);
 }
 
+bool
+MpTcpSocketBase::UsableWindow (uint8_t sFlowIdx, uint32_t &window)
+{
+  if (subflows[sFlowIdx]->state != ESTABLISHED)
+    {
+      m_readySubflows.MarkBusy (sFlowIdx, false);
+      return false;
+    }
+  window = std::min (AvailableWindow (sFlowIdx), sendingBuffer.PendingData ()); // Get available window size
+  if (window == 0)
+    {
+      NS_LOG_LOGIC("SendPendingData -> No window available on (" << (int)sFlowIdx << ") Try next one!");
+      m_readySubflows.MarkBusy (sFlowIdx, FreeWindow (sFlowIdx) > 0);
+      return false;
+    }
+  if (DeferSuperSegment (sFlowIdx, window))
+    {
+      NS_LOG_LOGIC("SendPendingData -> Waiting for a larger window on (" << (int)sFlowIdx << ")");
+      m_readySubflows.MarkBusy (sFlowIdx, false);
+      return false;
+    }
+  return true;
+}
+
+/*
+ * As Linux does with TSO, a subflow sending super-segments waits for ACKs to open a larger window rather than
+ * sending whatever an ACK frees, unless a third of its cwnd is free, the rest of the data fits or it is recovering.
+ */
+bool
+MpTcpSocketBase::DeferSuperSegment (uint8_t sFlowIdx, uint32_t window)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  uint32_t limit = SegmentLimit (sFlowIdx);
+  if (limit == sFlow->MSS || window >= limit || window >= sendingBuffer.PendingData ())
+    return false;
+  if (sFlow->m_inFastRec || sFlow->maxSeqNb > sFlow->TxSeqNumber - 1 || BytesInFlight (sFlowIdx) == 0)
+    return false;
+  return window < sFlow->cwnd.Get () / 3;
+}
+
+bool
+MpTcpSocketBase::SelectSubflow (uint8_t &sFlowIdx, uint32_t &window)
+{
+  uint32_t nSubflows = subflows.size ();
+  uint32_t from = lastUsedsFlowIdx % nSubflows;
+  bool withTail = sendingBuffer.PendingData () < segmentSize; // Less than a segment of window is enough for the tail
+  bool found = false;
+  double best = 0;
+  double totalRate = 0;
+  uint32_t w;
+
+  // Ready subflows are visited in round robin order from lastUsedsFlowIdx, which also breaks ties
+  for (uint32_t k = 0; k < nSubflows;)
+    {
+      int next = m_readySubflows.Next ((from + k) % nSubflows, nSubflows, withTail);
+      if (next < 0)
+        break;
+      uint32_t dist = (next + nSubflows - from) % nSubflows;
+      if (dist < k)
+        break; // Wrapped around to a subflow already visited
+      k = dist + 1;
+      if (!UsableWindow (next, w))
+        continue;
+
+      Ptr<MpTcpSubFlow> sFlow = subflows[next];
+      double key = 0;
+      switch (distribAlgo)
+        {
+      case Round_Robin:
+        sFlowIdx = next;
+        window = w;
+        return true;
+      case Min_Rtt:
+        key = -sFlow->rtt->GetCurrentEstimate ().GetSeconds ();
+        break;
+      case Rate_Weighted:
+        { // Smooth weighted round robin, each candidate's credit grows by its rate cwnd / RTT
+          double rate = (double) sFlow->cwnd.Get () / std::max ((int64_t) 1, sFlow->rtt->GetCurrentEstimate ().GetMicroSeconds ());
+          sFlow->m_schedCredit += rate;
+          totalRate += rate;
+          key = sFlow->m_schedCredit;
+        }
+        break;
+      case Ecn_Aware:
+        key = -sFlow->dctcp_last_fraction;
+        break;
+      default:
+        break;
+        }
+      if (!found || key > best)
+        {
+          found = true;
+          best = key;
+          sFlowIdx = next;
+          window = w;
+        }
+    }
+  if (found && distribAlgo == Rate_Weighted)
+    subflows[sFlowIdx]->m_schedCredit -= totalRate;
+  return found;
+}
+
 uint8_t
 MpTcpSocketBase::getSubflowToUse ()
 {
@@ -2172,67 +2558,26 @@ MpTcpSocketBase::ReduceCWND (uint8_t sFlowIdx, DSNMapping* ptrDSN)
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
   uint32_t mss = sFlow->MSS;
   uint32_t flightSize = std::min(BytesInFlight (sFlowIdx), sFlow->cwnd.Get()); //To avoid we need to take the min of flight size and c_wnd
-  int d = 0;
   calculateTotalCWND ();
 
-  switch (AlgoCC)
-    {
-  case Uncoupled_TCPs:
-  case Linked_Increases:
-  case RTT_Compensator:
-  case Fast_Uncoupled:
-  case Fast_Increases:
-  case COUPLED_INC:
-  case COUPLED_EPSILON:
-  case UNCOUPLED:
-  case XCA:
-  //sFlow->ssthresh = std::max (2 * mss, BytesInFlight (sFlowIdx) / 2);
-    sFlow->ssthresh = std::max (2 * mss, flightSize/2);
-    sFlow->cwnd = sFlow->ssthresh + 3 * mss;
-    break;
-
-  case COUPLED_SCALABLE_TCP:
-    d = (int) sFlow->cwnd.Get () - (compute_total_window () >> 3);
-    if (d < 0)
-      d = 0;
-    sFlow->ssthresh = max (2 * mss, (uint32_t) d);
-    sFlow->cwnd = sFlow->ssthresh + 3 * mss;
-    break;
-
-  case COUPLED_FULLY:
-    d = (int) sFlow->cwnd.Get () - compute_total_window () / B;
-    if (d < 0)
-      d = 0;
-    sFlow->ssthresh = max (2 * mss, (uint32_t) d);
-    sFlow->cwnd = sFlow->ssthresh + 3 * mss;
-    break;
-
-  case Fully_Coupled:
-    d = sFlow->cwnd.Get () - totalCwnd / 2;
-    if (d < 0)
-      d = 0;
-    sFlow->ssthresh = std::max (2 * mss, (uint32_t) d);
-    sFlow->cwnd = sFlow->ssthresh + 3 * mss;
-    break;
-
-  default:
-    NS_ASSERT(3 != 3);
-    break;
-    }
+  sFlow->ssthresh = m_congestionOps->GetSsThresh (this, sFlowIdx, flightSize);
+  sFlow->cwnd = sFlow->ssthresh + 3 * mss;
   // update
 //  sFlow->m_recover = SequenceNumber32 (sFlow->maxSeqNb + 1);
   sFlow->m_recover = SequenceNumber32 (sFlow->m_highTxMark + 1);
   sFlow->m_inFastRec = true;
+  SubflowWindowChanged (sFlowIdx);
   //We have inflated the window by 3 segment sizes, record it
   sFlow->m_duplicatesSize = 3 * mss;
 //  sFlow->m_ssThreshLastChange = Simulator::Now (); // DCTCP
 
   // Retrasnmit a specific packet (lost segment)
   DoRetransmit (sFlowIdx, ptrDSN);
-#ifdef PLOT
-  reTxTrack.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->cwnd));
-  sFlow->ssthreshtrack.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->ssthresh));
-#endif
+  if (IsPlotting (PLOT_WINDOW))
+    {
+      RecordPlot (reTxTrack, "reTxTrack", sFlowIdx, sFlow->cwnd);
+      RecordPlot (sFlow->ssthreshtrack, "ssthreshtrack", sFlowIdx, sFlow->ssthresh);
+    }
 }
 
 /** Retransmit timeout */
@@ -2250,9 +2595,11 @@ MpTcpSocketBase::Retransmit (uint8_t sFlowIdx)
       sFlow->m_duplicatesSize = 0;
     }
   sFlow->m_inFastRec = false;
+  SubflowWindowChanged (sFlowIdx);
 //sFlow->m_ssThreshLastChange = Simulator::Now (); // DCTCP
   sFlow->cwnd = sFlow->MSS; //  sFlow->cwnd = 1.0;
   sFlow->TxSeqNumber = sFlow->highestAck + 1; // m_nextTxSequence = m_txBuffer.HeadSequence(); // Restart from highest Ack
+  m_readySubflows.MarkReady (sFlowIdx);
   sFlow->m_highTxMark = sFlow->TxSeqNumber - 1; //m_highTxMark = m_nextTxSequence - m_segmentSize;
 
   //DCTCP update duing Timeout
@@ -2265,13 +2612,13 @@ MpTcpSocketBase::Retransmit (uint8_t sFlowIdx)
   //if (!(sendingBuffer->Empty() && sFlow->mapDSN.size() > 0))
   sFlow->rtt->IncreaseMultiplier ();  // Double the next RTO
 
-  if (AlgoCC >= COUPLED_EPSILON && AlgoCC < Fast_Uncoupled)
-    window_changed ();
+  window_changed ();
 
   DoRetransmit (sFlowIdx);  // Retransmit the packet
-#ifdef PLOT
-  sFlow->_TimeOut.push_back (make_pair (Simulator::Now ().GetSeconds (), TimeScale));
-#endif
+  if (IsPlotting (PLOT_STATE))
+    {
+      RecordPlot (sFlow->_TimeOut, "_TimeOut", sFlowIdx, TimeScale);
+    }
   TimeOuts++;
   // rfc 3782 - Recovering from timeOut
   //sFlow->m_recover = SequenceNumber32(sFlow->maxSeqNb + 1);
@@ -2283,43 +2630,66 @@ MpTcpSocketBase::SetReTxTimeout (uint8_t sFlowIdx)
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
   if (sFlow->retxEvent.IsExpired ())
     {
-      Time rto = sFlow->rtt->RetransmitTimeout ();
-      sFlow->retxEvent = Simulator::Schedule (rto, &MpTcpSocketBase::ReTxTimeout, this, sFlowIdx);
+      RestartReTxTimeout (sFlowIdx);
     }
 }
 
-DSNMapping*
-MpTcpSocketBase::getAckedSegment (uint8_t sFlowIdx, uint32_t ack)
+/*
+ * Like Linux sk_reset_timer on the RTO timer, a lazy timer only records the new deadline when its
+ * pending event fires no later than it; the event then re-arms itself for the remaining time. A
+ * subflow sending continuously so schedules about one event per RTO instead of one per ACK.
+ */
+void
+MpTcpSocketBase::RestartReTxTimeout (uint8_t sFlowIdx)
 {
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-  DSNMapping* ptrDSN = 0;
-  for (list<DSNMapping *>::iterator it = sFlow->mapDSN.begin (); it != sFlow->mapDSN.end (); ++it)
+  Time rto = sFlow->rtt->RetransmitTimeout ();
+  if (m_lazyRto)
     {
-      DSNMapping* dsn = *it;
-      if (dsn->subflowSeqNumber + dsn->dataLevelLength == ack)
+      sFlow->retxDeadline = Simulator::Now () + rto;
+      if (sFlow->retxLazy && sFlow->retxEvent.IsRunning () && Simulator::GetDelayLeft (sFlow->retxEvent) <= rto)
         {
-          ptrDSN = dsn;
-          break;
+          return;
         }
     }
-  return ptrDSN;
+  sFlow->retxEvent.Cancel ();
+  sFlow->retxLazy = m_lazyRto;
+  NS_LOG_LOGIC (this << " Schedule ReTxTimeout at time> " <<Simulator::Now ().GetSeconds () << " to expire at time " <<(Simulator::Now () + rto).GetSeconds ());
+  if (m_lazyRto)
+    {
+      sFlow->retxEvent = Simulator::Schedule (rto, &MpTcpSocketBase::LazyReTxTimeout, this, sFlowIdx);
+    }
+  else
+    {
+      sFlow->retxEvent = Simulator::Schedule (rto, &MpTcpSocketBase::ReTxTimeout, this, sFlowIdx);
+    }
 }
 
-DSNMapping*
-MpTcpSocketBase::getSegmentOfACK (uint8_t sFlowIdx, uint32_t ack)
+void
+MpTcpSocketBase::LazyReTxTimeout (uint8_t sFlowIdx)
 {
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-  DSNMapping* ptrDSN = 0;
-  for (list<DSNMapping *>::iterator it = sFlow->mapDSN.begin (); it != sFlow->mapDSN.end (); ++it)
+  Time now = Simulator::Now ();
+  if (now < sFlow->retxDeadline)
     {
-      DSNMapping* dsn = *it;
-      if (dsn->subflowSeqNumber == ack)
-        {
-          ptrDSN = dsn;
-          break;
-        }
+      sFlow->retxEvent = Simulator::Schedule (sFlow->retxDeadline - now, &MpTcpSocketBase::LazyReTxTimeout, this, sFlowIdx);
+      return;
     }
-  return ptrDSN;
+  ReTxTimeout (sFlowIdx);
+}
+
+DSNMapping*
+MpTcpSocketBase::getAckedSegment (uint8_t sFlowIdx, uint32_t ack)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  return sFlow->mapDSN.FindEndingAt (ack);
+}
+
+DSNMapping*
+MpTcpSocketBase::getSegmentOfACK (uint8_t sFlowIdx, uint32_t ack)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  return sFlow->mapDSN.Find (ack);
 }
 void
 MpTcpSocketBase::NewAckNewReno (uint8_t sFlowIdx, const TcpHeader& mptcpHeader, TcpOptions* opt)
@@ -2347,12 +2717,16 @@ MpTcpSocketBase::NewAckNewReno (uint8_t sFlowIdx, const TcpHeader& mptcpHeader,
       sFlow->m_duplicatesSize += m_segmentSize;
       // RFC3782 sec.5, partialAck condition for inflating.
 //      sFlow->cwnd += sFlow->MSS; // increase cwnd
-#ifdef PLOT
       NS_LOG_LOGIC ("Partial ACK in fast recovery: cwnd set to " << sFlow->cwnd.Get());
-      PartialAck.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->cwnd.Get ()));
-      sFlow->ssthreshtrack.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->ssthresh));
-      sFlow->_FR_PA.push_back (make_pair (Simulator::Now ().GetSeconds (), TimeScale));
-#endif
+      if (IsPlotting (PLOT_WINDOW))
+        {
+          RecordPlot (PartialAck, "PartialAck", sFlowIdx, sFlow->cwnd.Get ());
+          RecordPlot (sFlow->ssthreshtrack, "ssthreshtrack", sFlowIdx, sFlow->ssthresh);
+        }
+      if (IsPlotting (PLOT_STATE))
+        {
+          RecordPlot (sFlow->_FR_PA, "_FR_PA", sFlowIdx, TimeScale);
+        }
       DiscardUpTo (sFlowIdx, ack.GetValue ());
       DSNMapping* ptrDSN = getSegmentOfACK (sFlowIdx, ack.GetValue ());
       NS_ASSERT(ptrDSN != 0);
@@ -2370,12 +2744,17 @@ MpTcpSocketBase::NewAckNewReno (uint8_t sFlowIdx, const TcpHeader& mptcpHeader,
       sFlow->m_duplicatesSize= 0; //Reset the duplicate size since we're leaving fast recovery
       // Exit from Fast recovery
       sFlow->m_inFastRec = false;
+      SubflowWindowChanged (sFlowIdx);
       FullAcks++;
-#ifdef PLOT
-      FullAck.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->cwnd.Get ()));
-      sFlow->ssthreshtrack.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->ssthresh));
-      sFlow->_FR_FA.push_back (make_pair (Simulator::Now ().GetSeconds (), TimeScale));
-#endif
+      if (IsPlotting (PLOT_WINDOW))
+        {
+          RecordPlot (FullAck, "FullAck", sFlowIdx, sFlow->cwnd.Get ());
+          RecordPlot (sFlow->ssthreshtrack, "ssthreshtrack", sFlowIdx, sFlow->ssthresh);
+        }
+      if (IsPlotting (PLOT_STATE))
+        {
+          RecordPlot (sFlow->_FR_FA, "_FR_FA", sFlowIdx, TimeScale);
+        }
     }
 
   if (!(sFlow->mapDSN.size () == 0 && sendingBuffer.Empty () && sFlow->state == FIN_WAIT_1))
@@ -2395,10 +2774,7 @@ MpTcpSocketBase::NewACK (uint8_t sFlowIdx, const TcpHeader& mptcpHeader, TcpOpti
   NS_LOG_LOGIC ("[" << m_node->GetId()<< "]" << " Cancelled ReTxTimeout event which was set to expire at " << (Simulator::Now () + Simulator::GetDelayLeft (sFlow->retxEvent)).GetSeconds ());
 
   // On recieving a "New" ack we restart retransmission timer .. RFC 2988
-  sFlow->retxEvent.Cancel ();
-  Time rto = sFlow->rtt->RetransmitTimeout ();
-  NS_LOG_LOGIC (this << " Schedule ReTxTimeout at time> " <<Simulator::Now ().GetSeconds () << " to expire at time " <<(Simulator::Now () + rto).GetSeconds ());
-  sFlow->retxEvent = Simulator::Schedule (rto, &MpTcpSocketBase::ReTxTimeout, this, sFlowIdx);
+  RestartReTxTimeout (sFlowIdx);
 
   // Note the highest ACK and tell app to send more
   DiscardUpTo (sFlowIdx, ack);
@@ -2420,6 +2796,7 @@ MpTcpSocketBase::NewACK (uint8_t sFlowIdx, const TcpHeader& mptcpHeader, TcpOpti
     }
 
   sFlow->highestAck = std::max (sFlow->highestAck, ack - 1);
+  m_readySubflows.MarkReady (sFlowIdx);
   NS_LOG_WARN("NewACK-> sFlow->highestAck: " << sFlow->highestAck);
 
   currentSublow = sFlow->routeId;
@@ -2524,6 +2901,18 @@ MpTcpSocketBase::SendEmptyPacket (uint8_t sFlowIdx, uint8_t flags)
       header.AddOptJOIN (OPT_JOIN, remoteToken, 0); // addID should be zero?
       olen += 6;
     }
+  if (hasSyn && sFlow->routeId == 0 && m_flowControl && (client || m_wndScaling))
+    { // Window scale on the SYN of the master subflow, and on the SYN+ACK if the SYN had it
+      m_rcvWndShift = WindowShift ();
+      header.AddOptWS (OPT_WS, m_rcvWndShift);
+      olen += 2;
+    }
+  if (hasSyn && m_flowControl)
+    { // Windows of SYN segments are never scaled
+      header.SetWindowSize (std::min<uint32_t> (ReceiveWindow (), 65535));
+    }
+  if (!hasSyn)
+    olen += AddTimestamp (sFlowIdx, header);
 
   uint8_t plen = (4 - (olen % 4)) % 4;
   olen = (olen + plen) / 4;
@@ -2532,23 +2921,37 @@ MpTcpSocketBase::SendEmptyPacket (uint8_t sFlowIdx, uint8_t flags)
   header.SetOptionsLength (olen);
   header.SetPaddingLength (plen);
   // @SendEmptyPacket
-  if (m_ceBit > 0 && isAck && sFlow->state == ESTABLISHED && server)
-    AddPacketTag (p, ECE_TAG);
+  DcTag dcTag;
+  if (sFlow->m_ceState && isAck && sFlow->state == ESTABLISHED && server)
+    dcTag.SetEce ();
+  if (sFlow->m_echoSuper && isAck)
+    dcTag.SetEcho (sFlow->m_echoSegments, sFlow->m_echoMarked);
 
-  // @SendEmptyPacket -> Add control packet tag
+  // @SendEmptyPacket -> Mark control packets
   if (hasSyn || hasFin || (isAck && client))
-    AddPacketTag (p, CP_TAG); //AddContPktTag(p);
+    dcTag.SetControl ();
 
   if (m_isDCTCPEnabled || m_ecn)
-    AddPacketTag (p, ECT_TAG); //AddEctTag(p);
+    dcTag.SetEct ();
+  AddDcTag (p, dcTag);
 
   m_tcp->SendPacket (p, header, sFlow->sAddr, sFlow->dAddr, FindOutputNetDevice (sFlow->sAddr));
   //sFlow->rtt->SentSeq (sFlow->TxSeqNumber, 1);           // notify the RTT
+  if (flags & TcpHeader::ACK)
+    { // Acknowledges everything received so far, a pending delayed ACK has nothing left to do
+      sFlow->m_delAckEvent.Cancel ();
+      sFlow->m_delAckCount = 0;
+      sFlow->m_echoSegments = 0;
+      sFlow->m_echoMarked = 0;
+      sFlow->m_echoSuper = false;
+      sFlow->m_tsLastAck = sFlow->RxSeqNumber;
+    }
 
   if (sFlow->retxEvent.IsExpired () && (hasFin || hasSyn) && !isAck)
     { // Retransmit SYN / SYN+ACK / FIN / FIN+ACK to guard against lost
       //RTO = sFlow->rtt->RetransmitTimeout();
       sFlow->retxEvent = Simulator::Schedule (RTO, &MpTcpSocketBase::SendEmptyPacket, this, sFlowIdx, flags);
+      sFlow->retxLazy = false;
       if (hasSyn)
         {
           //cout << this << " ["<< m_node->GetId() << "]("<<(int)sFlowIdx <<") SendEmptyPacket -> "<< TcpFlagPrinter(flags)<< " ReTxTimer set for SYN / SYN+ACK now " << Simulator::Now ().GetSeconds () << " Expire at " << (Simulator::Now () + RTO).GetSeconds () << " RTO: " << RTO.GetSeconds() << " FlowType: " << flowType << " Header: "<< header << endl;
@@ -2605,12 +3008,41 @@ MpTcpSocketBase::SetRcvBufSize (uint32_t size)
   //recvingBuffer = new DataBuffer(size);
   // Size of recving buffer does not allocate any memory instantly but allows node to store to this bound.
   recvingBuffer.SetBufferSize (50000000);
+  m_rcvBuf = size;  // The window is advertised from this one, see FlowControl
+}
+void
+MpTcpSocketBase::SetPlotBufferSize (uint32_t size)
+{
+  m_plotBufferSize = size;
+  rateTracerCl.SetMaxSize (size);
+  totalCWNDtrack.SetMaxSize (size);
+  reTxTrack.SetMaxSize (size);
+  timeOutTrack.SetMaxSize (size);
+  PartialAck.SetMaxSize (size);
+  FullAck.SetMaxSize (size);
+  DupAcks.SetMaxSize (size);
+  PacketDrop.SetMaxSize (size);
+  TxQueue.SetMaxSize (size);
+  for (uint32_t i = 0; i < subflows.size (); i++)
+    subflows[i]->SetPlotBufferSize (size);
+}
+uint32_t
+MpTcpSocketBase::GetPlotBufferSize (void) const
+{
+  return m_plotBufferSize;
+}
+template <typename T>
+void
+MpTcpSocketBase::RecordPlot (PlotSeries<T> &series, const char *name, uint8_t sFlowIdx, typename PlotSeries<T>::value_type value)
+{
+  series.Add (Simulator::Now ().GetSeconds (), value);
+  m_plotSampleTrace (sFlowIdx, name, value);
 }
 uint32_t
 MpTcpSocketBase::GetRcvBufSize (void) const
 {
   //return m_rxBuffer.MaxBufferSize();
-  return 0;
+  return m_rcvBuf;
 }
 
 uint32_t
@@ -2619,41 +3051,49 @@ MpTcpSocketBase::Recv (uint32_t size)
   NS_LOG_FUNCTION (this);
   //Null packet means no data to read, and an empty packet indicates EOF
   uint32_t toRead = std::min (recvingBuffer.PendingData (), size);
-  return recvingBuffer.Retrieve (toRead);
+  uint32_t read = recvingBuffer.Retrieve (toRead);
+  if (m_flowControl)
+    {
+      m_rcvCopied += read;
+      RcvSpaceAdjust ();
+      if (m_rcvWnd < segmentSize && ReceiveWindow () >= segmentSize)
+        Simulator::ScheduleNow (&MpTcpSocketBase::SendWindowUpdate, this);
+    }
+  return read;
 }
 void
 MpTcpSocketBase::ForwardUp (Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface)
 {
 
   NS_LOG_FUNCTION_NOARGS();
-  DoForwardUp (p, header, port, interface);
+  DoForwardUp (p, header, port, interface, -1);
+}
+void
+MpTcpSocketBase::ForwardUpSubflow (uint8_t sFlowIdx, Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface)
+{
+  NS_LOG_FUNCTION (this << (int) sFlowIdx);
+  DoForwardUp (p, header, port, interface, sFlowIdx);
 }
 void
 MpTcpSocketBase::ExtractPacketTags (Ptr<Packet> p)
 {
   m_ceBit = 0;
   m_eceBit = 0;
-  CeTag tag;
-  bool done = p->RemovePacketTag (tag);
-  if (done)
-    {
-      m_ceBit = tag.GetCe ();
-    }
-  EceTag ece;
-  done = p->RemovePacketTag (ece);
-  if (done)
+  m_rxSegments = 1;
+  m_rxEchoedSegments = 0;
+  m_rxMarkedSegments = 0;
+  DcTag dcTag;
+  if (p->RemovePacketTag (dcTag))
     {
-      m_eceBit = ece.GetEce ();
+      m_ceBit = dcTag.IsCe ();
+      m_eceBit = dcTag.IsEce ();
+      m_rxSegments = dcTag.GetSegments ();
+      m_rxEchoedSegments = dcTag.GetEchoedSegments ();
+      m_rxMarkedSegments = dcTag.GetMarkedSegments ();
     }
-  ControlTag ct; // Just remove it from packet.
-  p->RemovePacketTag (ct);
-  EctTag ect;
-  p->RemovePacketTag(ect);
-  EcmpTag ecmp;
-  p->RemovePacketTag(ecmp);
 }
 void
-MpTcpSocketBase::DoForwardUp (Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface)
+MpTcpSocketBase::DoForwardUp (Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface, int sFlowIdx)
 {
   if (m_endPoint == 0)
     {
@@ -2663,9 +3103,6 @@ MpTcpSocketBase::DoForwardUp (Ptr<Packet> p, Ipv4Header header, uint16_t port, P
   Address fromAddress = InetSocketAddress (header.GetSource (), port);
   Address toAddress = InetSocketAddress (header.GetDestination (), m_endPoint->GetLocalPort ());
 
-  m_localAddress = header.GetDestination ();
-  m_remoteAddress = header.GetSource ();
-
   // Peel off TCP header and do validity checking
   TcpHeader mptcpHeader;
   p->RemoveHeader (mptcpHeader);
@@ -2673,9 +3110,6 @@ MpTcpSocketBase::DoForwardUp (Ptr<Packet> p, Ipv4Header header, uint16_t port, P
   // DCTCP
   ExtractPacketTags(p);
 
-  m_remotePort = port;
-  m_localPort = mptcpHeader.GetDestinationPort ();
-
   // This is make sense as subSock' local port might be different from metaSocket's localport!!
   // NS_ASSERT_MSG(m_localPort == m_endPoint->GetLocalPort(), " localPort: " << m_localPort << " ePointLocal: " << m_endPoint->GetLocalPort());
 
@@ -2683,8 +3117,14 @@ MpTcpSocketBase::DoForwardUp (Ptr<Packet> p, Ipv4Header header, uint16_t port, P
   if (subflows.size () == 0 && m_state == LISTEN)
     {
       NS_ASSERT(server && m_state == LISTEN); NS_LOG_UNCOND("Listening socket receives SYN packet, it need to be CLONED... " << mptcpHeader);
+      // The clone takes its connection 4-tuple from these
+      m_localAddress = header.GetDestination ();
+      m_remoteAddress = header.GetSource ();
+      m_remotePort = port;
+      m_localPort = mptcpHeader.GetDestinationPort ();
       // Update the flow control window
       remoteRecvWnd = (uint32_t) mptcpHeader.GetWindowSize ();
+      m_readySubflows.MarkAllReady (subflows.size ());
       // We need to define another ReadOption with no subflow in it
       if (ReadOptions (p, mptcpHeader) == false)
         return;
@@ -2699,7 +3139,10 @@ MpTcpSocketBase::DoForwardUp (Ptr<Packet> p, Ipv4Header header, uint16_t port, P
       remoteRecvWnd = 1;
       return;
     }
-   int sFlowIdx = LookupSubflow (m_localAddress, m_localPort, m_remoteAddress, m_remotePort);
+  // Subflow endpoints pass their index; the connection endpoint carries the
+  // master subflow, and MP_JOIN SYNs that open new subflows.
+  if (sFlowIdx < 0)
+    sFlowIdx = LookupSubflow (header.GetDestination (), mptcpHeader.GetDestinationPort (), header.GetSource (), port);
 
   if (client && sFlowIdx > maxSubflows)
     exit (20);
@@ -2711,7 +3154,13 @@ MpTcpSocketBase::DoForwardUp (Ptr<Packet> p, Ipv4Header header, uint16_t port, P
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
 
   //uint32_t dataLen;   // packet's payload length
-  remoteRecvWnd = (uint32_t) mptcpHeader.GetWindowSize (); //update the flow control window
+  uint32_t rwnd = PeerWindow (mptcpHeader); //update the flow control window
+  // Subflows advertise the shared window at different times, so a window update is judged
+  // against the last window seen on the same subflow
+  m_rwndUpdated = (rwnd != sFlow->m_peerWnd);
+  sFlow->m_peerWnd = rwnd;
+  remoteRecvWnd = rwnd;
+  m_readySubflows.MarkAllReady (subflows.size ());
 
   if (mptcpHeader.GetFlags () & TcpHeader::ACK)
     { // This function update subflow's lastMeasureRtt variable.
@@ -2803,6 +3252,7 @@ MpTcpSocketBase::InitiateSubflows ()
 
         // Create new subflow
         Ptr<MpTcpSubFlow> sFlow = CreateObject<MpTcpSubFlow> ();
+        sFlow->SetPlotBufferSize (m_plotBufferSize);
         sFlow->routeId = (subflows.size () == 0 ? 0 : subflows[subflows.size () - 1]->routeId + 1);
 
         // Set up subflow local addrs:port from its endpoint
@@ -2819,8 +3269,8 @@ MpTcpSocketBase::InitiateSubflows ()
         sFlow->m_endPoint = m_tcp->Allocate (sFlow->sAddr, sFlow->sPort, sFlow->dAddr, sFlow->dPort); // Insert New Subflow to the list
         if (sFlow->m_endPoint == 0)
           return -1;
-        sFlow->m_endPoint->SetRxCallback (MakeCallback (&MpTcpSocketBase::ForwardUp, Ptr<MpTcpSocketBase> (this)));
-        subflows.insert (subflows.end (), sFlow);
+        sFlow->m_endPoint->SetRxCallback (MakeCallback (&MpTcpSocketBase::ForwardUpSubflow, Ptr<MpTcpSocketBase> (this)).Bind<uint8_t> (subflows.size ()));
+        AddSubflow (sFlow);
 
         // Create packet and add MP_JOIN option to it.
         Ptr<Packet> pkt = Create<Packet> ();
@@ -2860,6 +3310,7 @@ MpTcpSocketBase::InitiateSingleSubflows (uint16_t randomPort)
   //randomPort = ((rand() * rand()) % 65536);
   //NS_LOG_UNCOND(m_node->GetId() << " randomPort: " << randomPort);
   Ptr<MpTcpSubFlow> sFlow = CreateObject<MpTcpSubFlow> ();
+  sFlow->SetPlotBufferSize (m_plotBufferSize);
   sFlow->routeId = (subflows.size () == 0 ? 0 : subflows[subflows.size () - 1]->routeId + 1);
   // Set up subflow based on different source ports
   sFlow->sAddr = m_endPoint->GetLocalAddress ();
@@ -2875,8 +3326,8 @@ MpTcpSocketBase::InitiateSingleSubflows (uint16_t randomPort)
   sFlow->m_endPoint = m_tcp->Allocate (sFlow->sAddr, sFlow->sPort, sFlow->dAddr, sFlow->dPort);
   if (sFlow->m_endPoint == 0)
     return -1;
-  sFlow->m_endPoint->SetRxCallback (MakeCallback (&MpTcpSocketBase::ForwardUp, Ptr<MpTcpSocketBase> (this)));
-  subflows.insert (subflows.end (), sFlow);
+  sFlow->m_endPoint->SetRxCallback (MakeCallback (&MpTcpSocketBase::ForwardUpSubflow, Ptr<MpTcpSocketBase> (this)).Bind<uint8_t> (subflows.size ()));
+  AddSubflow (sFlow);
 
   // Create packet and add MP_JOIN option to it.
   Ptr<Packet> pkt = Create<Packet> ();
@@ -2899,7 +3350,9 @@ MpTcpSocketBase::InitiateSingleSubflows (uint16_t randomPort)
   NS_LOG_UNCOND(this << " => "<< Simulator::Now().GetSeconds() <<" [" << m_node->GetId() <<"] (" <<sFlow->routeId << ") InitiateSingleSubflow -> 4-Tuple: " << sFlow->sAddr<< ":"<< sFlow->sPort << " , "<< sFlow->dAddr << ":" << sFlow->dPort);
   // cout << Simulator::Now().GetSeconds() <<" [" << m_node->GetId() <<"] (" <<sFlow->routeId << ") InitiateSingleSubflow -> 4-Tuple: " << sFlow->sAddr<< ":"<< sFlow->sPort << " , "<< sFlow->dAddr << ":" << sFlow->dPort << endl;
   // @InitiateSingleSubflows -> Add control packet
-  AddPacketTag(pkt, CP_TAG); //AddContPktTag(pkt);
+  DcTag dcTag;
+  dcTag.SetControl ();
+  pkt->AddPacketTag (dcTag);
   // Send packet lower down the networking stack
   m_tcp->SendPacket (pkt, header, sFlow->sAddr, sFlow->dAddr, FindOutputNetDevice (sFlow->sAddr));
 //    }
@@ -2974,42 +3427,65 @@ MpTcpSocketBase::InitiateMultipleSubflows()
 void
 MpTcpSocketBase::calculateTotalCWND ()
 {
-  totalCwnd = 0;
   if (m_isAdaptiveSubflow && IncastDetected())
     { // Look at subflow zero only as it should only be activated now...
       assert(maxSubflows >= 2);
       if (subflows[0]->m_inFastRec)
-        totalCwnd += subflows[0]->ssthresh;
+        totalCwnd = subflows[0]->ssthresh;
       else
-        totalCwnd += subflows[0]->cwnd.Get ();  // Should be this all the time
+        totalCwnd = subflows[0]->cwnd.Get ();  // Should be this all the time
     }
   else
     {
-      for (uint32_t i = 0; i < subflows.size (); i++)
-        {
-          if (subflows[i]->m_inFastRec)
-            totalCwnd += subflows[i]->ssthresh;
-          else
-            totalCwnd += subflows[i]->cwnd.Get ();  // Should be this all the time
-        }
+      UpdateCoupledAggregate ();
+      totalCwnd = m_coupled.GetTotalWindow ();
     }
 }
 
 uint32_t
 MpTcpSocketBase::compute_total_window ()
 {
-  if (AlgoCC < COUPLED_SCALABLE_TCP)
-    exit (10);
+  UpdateCoupledAggregate ();
+  totalCwnd = m_coupled.GetTotalWindow ();
+  return totalCwnd;
+}
 
-  totalCwnd = 0;
-  for (uint32_t i = 0; i < subflows.size (); i++)
+uint8_t
+MpTcpSocketBase::AddSubflow (Ptr<MpTcpSubFlow> sFlow)
+{
+  uint8_t sFlowIdx = subflows.size ();
+  subflows.insert (subflows.end (), sFlow);
+  m_coupled.AddSubflow ();
+  m_readySubflows.MarkReady (sFlowIdx);
+  sFlow->cwnd.ConnectWithoutContext (MakeCallback (&MpTcpSocketBase::CwndChanged, this).Bind (sFlowIdx));
+  return sFlowIdx;
+}
+
+void
+MpTcpSocketBase::SubflowWindowChanged (uint8_t sFlowIdx)
+{
+  m_coupled.MarkDirty (sFlowIdx);
+}
+
+void
+MpTcpSocketBase::CwndChanged (uint8_t sFlowIdx, uint32_t oldCwnd, uint32_t newCwnd)
+{
+  m_coupled.MarkDirty (sFlowIdx);
+  if (newCwnd > oldCwnd)
+    m_readySubflows.MarkReady (sFlowIdx);
+}
+
+void
+MpTcpSocketBase::UpdateCoupledAggregate ()
+{
+  m_coupled.SetEpsilon (_e);
+  uint8_t sFlowIdx;
+  while (m_coupled.PopDirty (sFlowIdx))
     {
-      if (subflows[i]->m_inFastRec)
-        totalCwnd += subflows[i]->ssthresh;
-      else
-        totalCwnd += subflows[i]->cwnd.Get ();
+      Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+      uint32_t window = sFlow->m_inFastRec ? sFlow->ssthresh : sFlow->cwnd.Get ();
+      m_coupled.Update (sFlowIdx, sFlow->cwnd.Get (), window, sFlow->MSS, sFlow->rtt->GetCurrentEstimate ());
     }
-  return totalCwnd;
 }
 
 void
@@ -3017,56 +3493,67 @@ MpTcpSocketBase::ReadUnOrderedData ()
 {
   NS_LOG_FUNCTION (this);
   //NS_LOG_WARN("ReadUnOrderedData()-> Size: " << unOrdered.size());
-  list<DSNMapping *>::iterator current = unOrdered.begin ();
-  list<DSNMapping *>::iterator next = unOrdered.begin ();
-
-  // I changed this method, now whenever a segment is readed it get dropped from that list
-  while (next != unOrdered.end ())
-    {
-      ++next;
-      DSNMapping *ptrDSN = *current;
-      uint32_t sFlowIdx = ptrDSN->subflowIndex;
-      Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-      if ((ptrDSN->dataSeqNumber <= nextRxSequence) /*&& (ptrDSN->subflowSeqNumber == sFlow->RxSeqNumber)*/)
-        { /* Stored segment is in-order at connection level */
-          NS_ASSERT(ptrDSN->dataSeqNumber == nextRxSequence);
-
-          //uint32_t amount = recvingBuffer->Add(ptrDSN->packet, ptrDSN->dataLevelLength);
-          uint32_t amount = recvingBuffer.Add (ptrDSN->dataLevelLength);
-          if (amount == 0)
-            { // Receive buffer is full.
-              NS_FATAL_ERROR("In our model receive buffer never get full");
-              break;
-            }
-          NS_ASSERT(amount == ptrDSN->dataLevelLength);
-          nextRxSequence += amount;
-
-          if (ptrDSN->subflowSeqNumber == sFlow->RxSeqNumber)
-            { /** Stored segment is also in-order at sub-flow level */
-              sFlow->RxSeqNumber += amount;
-              sFlow->highestAck = std::max (sFlow->highestAck, ptrDSN->acknowledgement - 1);
-              //SendEmptyPacket(sFlowIdx, TcpHeader::ACK);
-              sFlow->AccumulativeAck = true; //TODO TEMP
-            }
-          else
-            NS_ASSERT(ptrDSN->subflowSeqNumber < sFlow->RxSeqNumber);
+  // Stored segments which are in-order at connection level form a prefix of unOrdered, so drain them first.
+  uint32_t batch = 0;
+  while (!unOrdered.empty () && unOrdered.Front ()->dataSeqNumber <= nextRxSequence)
+    { /* Stored segment is in-order at connection level */
+      DSNMapping *ptrDSN = unOrdered.Front ();
+      Ptr<MpTcpSubFlow> sFlow = subflows[ptrDSN->subflowIndex];
+      NS_ASSERT(ptrDSN->dataSeqNumber == nextRxSequence);
+
+      //uint32_t amount = recvingBuffer->Add(ptrDSN->packet, ptrDSN->dataLevelLength);
+      uint32_t amount = recvingBuffer.Add (ptrDSN->dataLevelLength);
+      if (amount == 0)
+        { // Receive buffer is full.
+          NS_FATAL_ERROR("In our model receive buffer never get full");
+          break;
+        }
+      NS_ASSERT(amount == ptrDSN->dataLevelLength);
+      nextRxSequence += amount;
 
-          NotifyDataRecv ();
-          unOrdered.erase (current);
-          delete ptrDSN;
+      if (ptrDSN->subflowSeqNumber == sFlow->RxSeqNumber)
+        { /** Stored segment is also in-order at sub-flow level */
+          sFlow->RxSeqNumber += amount;
+          sFlow->highestAck = std::max (sFlow->highestAck, ptrDSN->acknowledgement - 1);
+          m_readySubflows.MarkReady (sFlow->routeId);
+          //SendEmptyPacket(sFlowIdx, TcpHeader::ACK);
+          sFlow->AccumulativeAck = true; //TODO TEMP
         }
-      else if (ptrDSN->subflowSeqNumber == sFlow->RxSeqNumber)
+      else
+        NS_ASSERT(ptrDSN->subflowSeqNumber < sFlow->RxSeqNumber);
+
+      NotifyDataRecv ();
+      unOrdered.PopFront ();
+      batch++;
+    }
+
+  // Remaining segments are out of order at connection level, but some might now be in-order at sub-flow level!
+  for (uint8_t i = 0; i < subflows.size (); i++)
+    {
+      if (!unOrdered.HasSubflow (i))
+        continue;
+      Ptr<MpTcpSubFlow> sFlow = subflows[i];
+      DSNMapping *ptrDSN = unOrdered.FindSubflowSeq (i, sFlow->RxSeqNumber);
+      while (ptrDSN != 0)
         { /* Stored segment is in-order only at sub-flow level! */
           NS_ASSERT((ptrDSN->dataSeqNumber > nextRxSequence));
           //NS_LOG_UNCOND("ReadUnOrderedData()-> sub-flow is in-order but connection is out of order " << (int)sFlow->routeId);
           sFlow->RxSeqNumber += ptrDSN->dataLevelLength;
           sFlow->highestAck = std::max (sFlow->highestAck, ptrDSN->acknowledgement - 1);
+          m_readySubflows.MarkReady (sFlow->routeId);
           // TODO Should let sender know about this update ?!?!
           // ACK should be sent per packet basis! If we send any ACK here it would break this rule? Could we solve this via DATA-ACK?
           sFlow->AccumulativeAck = true;  // TODO TEMP
           //SendEmptyPacket(sFlowIdx, TcpHeader::ACK);
+          ptrDSN = unOrdered.FindSubflowSeq (i, sFlow->RxSeqNumber);
         }
-      current = next;
+    }
+
+  m_reorderDepth = unOrdered.size ();
+  if (batch > 0)
+    {
+      m_maxDrainBatch = std::max (m_maxDrainBatch, batch);
+      m_drainBatchTrace (batch);
     }
 }
 
@@ -3093,10 +3580,11 @@ MpTcpSocketBase::DupAck (uint8_t sFlowIdx, DSNMapping* ptrDSN)
   uint32_t segmentSize = sFlow->MSS;
   //calculateTotalCWND();
 
-#ifdef PLOT
-  uint32_t tmp = (((ptrDSN->subflowSeqNumber) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-  sFlow->DUPACK.push_back (make_pair (Simulator::Now ().GetSeconds (), tmp));
-#endif
+  if (IsPlotting (PLOT_SEQUENCE))
+    {
+      uint32_t tmp = (((ptrDSN->subflowSeqNumber) - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
+      RecordPlot (sFlow->DUPACK, "DUPACK", sFlowIdx, tmp);
+    }
 
   // Congestion control algorithms
   if (sFlow->m_dupAckCount == 3 && !sFlow->m_inFastRec)
@@ -3112,9 +3600,10 @@ MpTcpSocketBase::DupAck (uint8_t sFlowIdx, DSNMapping* ptrDSN)
       // Cut the window to the half
       ReduceCWND (sFlowIdx, ptrDSN);
 
-#ifdef PLOT
-      sFlow->_FReTx.push_back (make_pair (Simulator::Now ().GetSeconds (), TimeScale));
-#endif
+      if (IsPlotting (PLOT_STATE))
+        {
+          RecordPlot (sFlow->_FReTx, "_FReTx", sFlowIdx, TimeScale);
+        }
       FastReTxs++;
     }
   else if (sFlow->m_inFastRec)
@@ -3123,10 +3612,11 @@ MpTcpSocketBase::DupAck (uint8_t sFlowIdx, DSNMapping* ptrDSN)
       sFlow->cwnd += segmentSize;
       sFlow->m_duplicatesSize += m_segmentSize;
 
-#ifdef PLOT
-      DupAcks.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->cwnd));
-      sFlow->ssthreshtrack.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->ssthresh));
-#endif
+      if (IsPlotting (PLOT_WINDOW))
+        {
+          RecordPlot (DupAcks, "DupAcks", sFlowIdx, sFlow->cwnd);
+          RecordPlot (sFlow->ssthreshtrack, "ssthreshtrack", sFlowIdx, sFlow->ssthresh);
+        }
       NS_LOG_WARN ("DupAck-> FastRecovery. Increase cwnd by one MSS, from " << sFlow->cwnd.Get() <<" -> " << sFlow->cwnd << " AvailableWindow: " << AvailableWindow(sFlowIdx));
       FastRecoveries++;
       // Send more data into pipe if possible to get ACK clock going
@@ -3262,7 +3752,7 @@ MpTcpSocketBase::GenerateRateTracerSf()
       Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (fileName, std::ios::out);
       ostream* os = stream->GetStream ();
 
-      vector<pair<double, double> >::iterator it = subflows[i]->rateTracerSf.begin ();
+      PlotSeries<double>::iterator it = subflows[i]->rateTracerSf.begin ();
       for (uint32_t j = 0; j < 30 && it != subflows[i]->rateTracerSf.end (); j++)
         *os << it->first << "\t" << 0.0 << endl;
 
@@ -3301,7 +3791,7 @@ MpTcpSocketBase::GenerateRateTracerCl ()
   Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (fileName, std::ios::out);
   ostream* os = stream->GetStream ();
 
-  vector<pair<double, double> >::iterator it = rateTracerCl.begin ();
+  PlotSeries<double>::iterator it = rateTracerCl.begin ();
   for (uint32_t j = 0; j < 30 && it != rateTracerCl.end (); j++)
     *os << it->first << "\t" << 0.0 << endl;
 
@@ -3337,7 +3827,7 @@ MpTcpSocketBase::GenerateTotalCwnd ()
   Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (fileName, std::ios::out);
   ostream* os = stream->GetStream ();
 
-  vector<pair<double, double> >::iterator it = totalCWNDtrack.begin ();
+  PlotSeries<double>::iterator it = totalCWNDtrack.begin ();
   it = totalCWNDtrack.begin ();
   while (it != totalCWNDtrack.end ())
     {
@@ -3373,7 +3863,7 @@ MpTcpSocketBase::GenerateCwnd ()
       Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (fileName, std::ios::out);
       ostream* os = stream->GetStream ();
 
-      vector<pair<double, uint32_t> >::iterator it = subflows[i]->cwndTracer.begin ();
+      PlotSeries<uint32_t>::iterator it = subflows[i]->cwndTracer.begin ();
       it = subflows[i]->cwndTracer.begin ();
       while (it != subflows[i]->cwndTracer.end ())
         {
@@ -3411,7 +3901,7 @@ MpTcpSocketBase::GenerateAlpha ()
       Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (fileName, std::ios::out);
       ostream* os = stream->GetStream ();
 
-      vector<pair<double, double> >::iterator it = subflows[i]->DCTCP_ALPHA.begin ();
+      PlotSeries<double>::iterator it = subflows[i]->DCTCP_ALPHA.begin ();
       it = subflows[i]->DCTCP_ALPHA.begin ();
       while (it != subflows[i]->DCTCP_ALPHA.end ())
         {
@@ -3459,43 +3949,43 @@ void
 MpTcpSocketBase::DoDoGenerateOutPutFile(TypeId tid)
 {
   goodput = ((nextTxSequence * 8) / (Simulator::Now ().GetSeconds () - fLowStartTime));
-  Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper> (outputFileName, std::ios::out | std::ios::app);
-  ostream* os = stream->GetStream ();
-    *os << "[:"  << m_node->GetId ()   << ":]"
-        << "[+"  << flowId             << "+]"
-        << "[="  << flowType           << "=]"
-        << "[?"  << flowLayer          << "?]"
-        << "[|"  << socketModel        << "|]"
-      //<< "[."  << IsActive(m_isDCTCPEnabled)  << ".]"
-        << "[#"  << goodput / 1000000  << "#]"
-        << "[*"  << (Simulator::Now ().GetSeconds () - fLowStartTime)       << "*]"
-        << "[$"  << TimeOuts           << "$]"
-        << "[!"  << FastReTxs          << "!]"
-        << "[("  << pAck               << ")]"
-        << "[@"  << FullAcks           << "@]"
-        << "[^"  << FastRecoveries     << "^]"
-        << "[&"  << subflows.size ()   << "&]"
-        << "[_"  << GetEstSubflows ()  << "_]"
-        << "[%"  << tid.GetName ()     << "%]"
-        << "[~"  << subflows[0]->m_retxThresh << "~]"
-        << "[>"  << flowSize << "<]"
-        << "[<"  << nextTxSequence 	  << ">]"
-        << "[;"  << GetTotalPktSent()  << ";]"
-        << "[/"  << subflows[currentSublow]->lastMeasuredRtt.GetMicroSeconds()  << "/]"
-        << "[,"  << subflows[currentSublow]->rtt->GetCurrentEstimate().GetMicroSeconds()  << ",]"
-        << "[{"  << GetSocketModel()   << "}]"
-        << "[�"  << PrintCC(AlgoCC)    << "�]"
-        << "[-"  << SlowDownHits       << "-]"
-        << "[{DS"<< m_isAdaptiveSubflow   << "}]"
-        << "[{IT"<< m_CongestionThreshold  << "}]"
-        << "[{ET"<< m_CongestionExitThreshold << "}]"
-        << "[{IC"<< m_CongestionRound    << "}]"
-        << "[."  << m_CongestionEnterHits  << ".]"
-        << "[�"  << m_CongestionExitHits   << "�]"
-        << "[{CM"<< m_cwndMin          << "}]"
-        << "[{RS"<< m_rwndScale        << "}]"
-        << "[{B" << m_backoffBeta      << "_G" << m_initGamma << "}]"
-        << endl;
+  FlowResult r;
+  r.node = m_node->GetId ();
+  r.flowId = flowId;
+  r.flowType = flowType;
+  r.flowLayer = flowLayer;
+  r.socket = socketModel;
+  r.goodput = goodput / 1000000;
+  r.fct = Simulator::Now ().GetSeconds () - fLowStartTime;
+  r.timeOuts = TimeOuts;
+  r.fastReTxs = FastReTxs;
+  r.partialAcks = pAck;
+  r.fullAcks = FullAcks;
+  r.fastRecoveries = FastRecoveries;
+  r.subflows = subflows.size ();
+  r.estSubflows = GetEstSubflows ();
+  r.typeId = tid.GetName ();
+  r.retxThresh = subflows[0]->m_retxThresh;
+  r.flowSize = flowSize;
+  r.bytesSent = nextTxSequence;
+  r.pktsSent = GetTotalPktSent ();
+  r.lastRtt = subflows[currentSublow]->lastMeasuredRtt.GetMicroSeconds ();
+  r.rtt = subflows[currentSublow]->rtt->GetCurrentEstimate ().GetMicroSeconds ();
+  r.model = GetSocketModel ();
+  r.cc = PrintCC (AlgoCC);
+  r.slowDownHits = SlowDownHits;
+  r.adaptiveSubflows = m_isAdaptiveSubflow;
+  r.congestionThreshold = m_CongestionThreshold;
+  r.congestionExitThreshold = m_CongestionExitThreshold;
+  r.congestionRound = m_CongestionRound;
+  r.congestionEnterHits = m_CongestionEnterHits;
+  r.congestionExitHits = m_CongestionExitHits;
+  r.cwndMin = m_cwndMin;
+  r.rwndScale = m_rwndScale;
+  r.backoffBeta = m_backoffBeta;
+  r.initGamma = m_initGamma;
+  // One sink per output file for the whole simulation, see FlowResultsSink
+  FlowResultsSink::Get (outputFileName)->Write (r);
 
     NS_LOG_UNCOND(Simulator::Now().GetSeconds() << " ["<< m_node->GetId()<< "] Goodput -> " << goodput / 1000000 << " Mbps");
 }
@@ -3564,7 +4054,7 @@ MpTcpSocketBase::GenerateCwndTracer ()
       std::stringstream title;
       title << "SF " << idx;
       dataSet.SetTitle (title.str ());
-      vector<pair<double, uint32_t> >::iterator it = sFlow->cwndTracer.begin ();
+      PlotSeries<uint32_t>::iterator it = sFlow->cwndTracer.begin ();
       while (it != sFlow->cwndTracer.end ())
         {
           dataSet.Add (it->first, it->second / sFlow->MSS);
@@ -3599,7 +4089,7 @@ MpTcpSocketBase::GenerateCwndTracer ()
       std::stringstream title;
       title << "SST " << idx;
       dataSet.SetTitle (title.str ());
-      vector<pair<double, uint32_t> >::iterator it = sFlow->sstTracer.begin ();
+      PlotSeries<uint32_t>::iterator it = sFlow->sstTracer.begin ();
       while (it != sFlow->sstTracer.end ())
         {
           dataSet.Add (it->first, it->second);
@@ -3645,7 +4135,7 @@ MpTcpSocketBase::GenerateRTT ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->rttTracer.begin ();
+      PlotSeries<double>::iterator it = sFlow->rttTracer.begin ();
 
       while (it != sFlow->rttTracer.end ())
         {
@@ -3684,7 +4174,7 @@ MpTcpSocketBase::GenerateRTT ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->rtoTracer.begin ();
+      PlotSeries<double>::iterator it = sFlow->rtoTracer.begin ();
 
       while (it != sFlow->rtoTracer.end ())
         {
@@ -3709,7 +4199,7 @@ MpTcpSocketBase::GenerateRTT ()
 
    dataSet.SetTitle(title.str());
 
-   vector<pair<double, double> >::iterator it = TxQueue.begin();
+   PlotSeries<double>::iterator it = TxQueue.begin();
 
    while (it != TxQueue.end())
    {
@@ -3754,7 +4244,7 @@ MpTcpSocketBase::GenerateRate()
       title << "Rate " << idx;
       dataSet.SetTitle(title.str());
 
-      vector<pair<double, double> >::iterator it = sFlow->rateTracerSf.begin();
+      PlotSeries<double>::iterator it = sFlow->rateTracerSf.begin();
 
       for (uint32_t j = 0; j < 30 && it != sFlow->rateTracerSf.end(); j++)
         dataSet.Add(it->first, 0.0);
@@ -3801,7 +4291,7 @@ MpTcpSocketBase::GenerateRate()
 //title << "Rate ";
 //dataSet.SetTitle(title.str());
 
-  vector<pair<double, double> >::iterator it = rateTracerCl.begin();
+  PlotSeries<double>::iterator it = rateTracerCl.begin();
 
   for (uint32_t j = 0; j < 30 && it != rateTracerCl.end(); j++)
     dataSet.Add(it->first, 0.0);
@@ -3872,7 +4362,7 @@ MpTcpSocketBase::GenerateSendvsACK ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, uint32_t> >::iterator it = sFlow->DATA.begin ();
+      PlotSeries<uint32_t>::iterator it = sFlow->DATA.begin ();
 
       while (it != sFlow->DATA.end ())
         {
@@ -3895,7 +4385,7 @@ MpTcpSocketBase::GenerateSendvsACK ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, uint32_t> >::iterator it = sFlow->ACK.begin ();
+      PlotSeries<uint32_t>::iterator it = sFlow->ACK.begin ();
 
       while (it != sFlow->ACK.end ())
         {
@@ -3918,7 +4408,7 @@ MpTcpSocketBase::GenerateSendvsACK ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->ECN_ECHO.begin ();
+      PlotSeries<double>::iterator it = sFlow->ECN_ECHO.begin ();
 
       while (it != sFlow->ECN_ECHO.end ())
         {
@@ -3942,7 +4432,7 @@ MpTcpSocketBase::GenerateSendvsACK ()
       dataSet.SetTitle (title.str ());
       dataSet.SetExtra(" pt 4 lc rgb '#A0522D'");
 
-      vector<pair<double, double> >::iterator it = sFlow->ECN_CWND_CUT_POINT.begin ();
+      PlotSeries<double>::iterator it = sFlow->ECN_CWND_CUT_POINT.begin ();
 
       while (it != sFlow->ECN_CWND_CUT_POINT.end ())
         {
@@ -3966,7 +4456,7 @@ MpTcpSocketBase::GenerateSendvsACK ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->BEG.begin ();
+      PlotSeries<double>::iterator it = sFlow->BEG.begin ();
 
       while (it != sFlow->BEG.end ())
         {
@@ -3990,7 +4480,7 @@ MpTcpSocketBase::GenerateSendvsACK ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, uint32_t> >::iterator it = sFlow->RETRANSMIT.begin ();
+      PlotSeries<uint32_t>::iterator it = sFlow->RETRANSMIT.begin ();
 
       while (it != sFlow->RETRANSMIT.end ())
         {
@@ -4013,7 +4503,7 @@ MpTcpSocketBase::GenerateSendvsACK ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->_ss.begin ();
+      PlotSeries<double>::iterator it = sFlow->_ss.begin ();
 
       while (it != sFlow->_ss.end ())
         {
@@ -4036,7 +4526,7 @@ MpTcpSocketBase::GenerateSendvsACK ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->_ca.begin ();
+      PlotSeries<double>::iterator it = sFlow->_ca.begin ();
 
       while (it != sFlow->_ca.end ())
         {
@@ -4059,7 +4549,7 @@ MpTcpSocketBase::GenerateSendvsACK ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->_FR_FA.begin ();
+      PlotSeries<double>::iterator it = sFlow->_FR_FA.begin ();
 
       while (it != sFlow->_FR_FA.end ())
         {
@@ -4082,7 +4572,7 @@ MpTcpSocketBase::GenerateSendvsACK ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->_FR_PA.begin ();
+      PlotSeries<double>::iterator it = sFlow->_FR_PA.begin ();
 
       while (it != sFlow->_FR_PA.end ())
         {
@@ -4105,7 +4595,7 @@ MpTcpSocketBase::GenerateSendvsACK ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->_FReTx.begin ();
+      PlotSeries<double>::iterator it = sFlow->_FReTx.begin ();
 
       while (it != sFlow->_FReTx.end ())
         {
@@ -4128,7 +4618,7 @@ MpTcpSocketBase::GenerateSendvsACK ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->_TimeOut.begin ();
+      PlotSeries<double>::iterator it = sFlow->_TimeOut.begin ();
 
       while (it != sFlow->_TimeOut.end ())
         {
@@ -4176,7 +4666,7 @@ MpTcpSocketBase::GenerateDctcpAlpha ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->DCTCP_ALPHA.begin ();
+      PlotSeries<double>::iterator it = sFlow->DCTCP_ALPHA.begin ();
 
       while (it != sFlow->DCTCP_ALPHA.end ())
         {
@@ -4199,7 +4689,7 @@ MpTcpSocketBase::GenerateDctcpAlpha ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->DCTCP_FRACTION.begin ();
+      PlotSeries<double>::iterator it = sFlow->DCTCP_FRACTION.begin ();
 
       while (it != sFlow->DCTCP_FRACTION.end ())
         {
@@ -4245,7 +4735,7 @@ MpTcpSocketBase::GenerateDctcpAlphaRtt ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->DCTCP_ALPHA_RTT.begin ();
+      PlotSeries<double>::iterator it = sFlow->DCTCP_ALPHA_RTT.begin ();
 
       while (it != sFlow->DCTCP_ALPHA_RTT.end ())
         {
@@ -4268,7 +4758,7 @@ MpTcpSocketBase::GenerateDctcpAlphaRtt ()
 
       dataSet.SetTitle (title.str ());
 
-      vector<pair<double, double> >::iterator it = sFlow->DCTCP_FRACTION_RTT.begin ();
+      PlotSeries<double>::iterator it = sFlow->DCTCP_FRACTION_RTT.begin ();
 
       while (it != sFlow->DCTCP_FRACTION_RTT.end ())
         {
@@ -4290,24 +4780,13 @@ bool
 MpTcpSocketBase::StoreUnOrderedData (DSNMapping *toStore)
 {
   NS_LOG_FUNCTION (this);
-  for (list<DSNMapping *>::iterator it = unOrdered.begin (); it != unOrdered.end (); ++it)
-    {
-      DSNMapping *stored = *it;
-      if (toStore->dataSeqNumber == stored->dataSeqNumber)
-        {
-          return false;
-        }
-      else if (toStore->dataSeqNumber < stored->dataSeqNumber)
-        {
-          // This assertion is to make sure un-ordered segments are stored in-order of subflow & connection level.
-          if (toStore->subflowIndex == stored->subflowIndex)
-            NS_ASSERT(toStore->subflowSeqNumber < stored->subflowSeqNumber);
-
-          unOrdered.insert (it, toStore);
-          return true;
-        }
+  if (!unOrdered.Insert (toStore))
+    { // Already stored
+      delete toStore;
+      return false;
     }
-  unOrdered.insert (unOrdered.end (), toStore);
+  m_reorderDepth = unOrdered.size ();
+  m_maxReorderDepth = std::max (m_maxReorderDepth, unOrdered.size ());
   return true;
 }
 
@@ -4402,20 +4881,7 @@ bool
 MpTcpSocketBase::FindPacketFromUnOrdered (uint8_t sFlowIdx)
 {
   NS_LOG_FUNCTION((int)sFlowIdx);
-  bool reValue = false;
-  list<DSNMapping *>::iterator current = unOrdered.begin ();
-  while (current != unOrdered.end ())
-    {
-      DSNMapping* ptrDSN = *current;
-      if (ptrDSN->subflowIndex == sFlowIdx)
-        {
-          reValue = true;
-          NS_LOG_LOGIC("(" << (int)sFlowIdx << ") FindPacketFromUnOrdered -> SeqNb" << ptrDSN->subflowSeqNumber << " pSize: " << ptrDSN->dataLevelLength);
-          break;
-        }
-      current++;
-    }
-  return reValue;
+  return unOrdered.HasSubflow (sFlowIdx);
 }
 
 /** This function closes the endpoint completely. Called upon RST_TX action. */
@@ -4690,7 +5156,11 @@ MpTcpSocketBase::AdvertiseAvailableAddresses ()
           addrInfo->addrID = i;
           addrInfo->ipv4Addr = interfaceAddr.GetLocal ();
           addrInfo->mask = interfaceAddr.GetMask ();
-          header.AddOptADDR (OPT_ADDR, addrInfo->addrID, addrInfo->ipv4Addr);
+          if (!header.AddOptADDR (OPT_ADDR, addrInfo->addrID, addrInfo->ipv4Addr))
+            {
+              delete addrInfo;
+              break;
+            }
           olen += 6;
           localAddrs.insert (localAddrs.end (), addrInfo);
         }
@@ -4703,7 +5173,9 @@ MpTcpSocketBase::AdvertiseAvailableAddresses ()
       header.SetPaddingLength (plen);
 
       // @AdvertiseAvailableAddresses -> Add Control packet
-      AddPacketTag(pkt, CP_TAG);
+      DcTag dcTag;
+      dcTag.SetControl ();
+      pkt->AddPacketTag (dcTag);
 
       //m_tcp->SendPacket(pkt, header, m_endPoint->GetLocalAddress(), m_remoteAddress);
       m_tcp->SendPacket (pkt, header, m_localAddress, m_remoteAddress, FindOutputNetDevice (m_localAddress));
@@ -4826,8 +5298,143 @@ MpTcpSocketBase::BytesInFlight (uint8_t sFlowIdx)
 uint16_t
 MpTcpSocketBase::AdvertisedWindowSize ()
 {
+  if (!m_flowControl)
+    return (uint16_t) 65535;
+  uint8_t shift = m_wndScaling ? m_rcvWndShift : 0;
+  uint32_t window = ReceiveWindow ();
+  if (m_rcvWndEdge > nextRxSequence)
+    { // The window does not shrink (RFC 7323 2.4), out of order data fills what was offered already
+      window = std::max<uint64_t> (window, m_rcvWndEdge - nextRxSequence);
+    }
+  window = std::min<uint32_t> (window >> shift, 65535);
+  m_rcvWnd = window << shift;
+  m_rcvWndEdge = nextRxSequence + m_rcvWnd;
+  return (uint16_t) window;
+}
+
+uint32_t
+MpTcpSocketBase::ReceiveWindow ()
+{ // Data the application did not read yet and out of order data both hold receive buffer
+  uint32_t rcvBuf = m_rcvBuf;
+  uint32_t used = recvingBuffer.PendingData () + unOrdered.bytes ();
+  return (rcvBuf > used) ? rcvBuf - used : 0;
+}
+
+uint32_t
+MpTcpSocketBase::PeerWindow (const TcpHeader& mptcpHeader) const
+{
+  uint32_t window = mptcpHeader.GetWindowSize ();
+  if (m_wndScaling && (mptcpHeader.GetFlags () & TcpHeader::SYN) == 0)
+    window <<= m_sndWndShift;
+  return window;
+}
+
+uint8_t
+MpTcpSocketBase::WindowShift () const
+{
+  uint32_t largest = m_rcvBufAutoTuning ? std::max (m_rcvBufMax, m_rcvBuf.Get ()) : m_rcvBuf.Get ();
+  uint8_t shift = 0;
+  while (shift < 14 && (largest >> shift) > 65535)
+    shift++;
+  return shift;
+}
+
+void
+MpTcpSocketBase::SetPeerWindowShift (uint8_t shift)
+{
+  if (!m_flowControl)
+    return; // Without our own option in the SYN windows are not scaled either way
+  m_wndScaling = true;
+  m_sndWndShift = std::min<uint8_t> (shift, 14); // RFC 7323 caps the shift at 14
+}
+
+/*
+ * Linux receive buffer autotuning (tcp_rcv_rtt_measure and tcp_rcv_space_adjust): once per receiver side RTT,
+ * if the application read more than ever in one RTT, the buffer grows to twice that, plus more while the
+ * sender is still speeding up.
+ */
+void
+MpTcpSocketBase::RcvSpaceAdjust ()
+{
+  Time now = Simulator::Now ();
+  if (nextRxSequence >= m_rcvRttSeq)
+    {
+      if (m_rcvRttSeq != 0 && now > m_rcvRttTime && (m_rcvRtt.IsZero () || now - m_rcvRttTime < m_rcvRtt))
+        m_rcvRtt = now - m_rcvRttTime;
+      m_rcvRttSeq = nextRxSequence + std::max (m_rcvWnd, segmentSize);
+      m_rcvRttTime = now;
+    }
+  if (m_rcvSpace == 0)
+    {
+      m_rcvSpace = std::min<uint64_t> (m_rcvBuf, 10 * segmentSize);
+      m_rcvSpaceTime = now;
+    }
+  if (m_rcvRtt.IsZero () || now - m_rcvSpaceTime < m_rcvRtt)
+    return;
+  uint64_t copied = m_rcvCopied - m_rcvSpaceCopied;
+  if (copied > m_rcvSpace)
+    {
+      if (m_rcvBufAutoTuning)
+        {
+          uint64_t rcvWin = 2 * copied + 16 * segmentSize;
+          rcvWin += 2 * rcvWin * (copied - m_rcvSpace) / m_rcvSpace;
+          if (rcvWin > m_rcvBuf)
+            m_rcvBuf = std::min<uint64_t> (rcvWin, std::max (m_rcvBufMax, m_rcvBuf.Get ()));
+        }
+      m_rcvSpace = copied;
+    }
+  m_rcvSpaceCopied = m_rcvCopied;
+  m_rcvSpaceTime = now;
+}
+
+void
+MpTcpSocketBase::SendWindowUpdate ()
+{
+  if (m_rcvWnd >= segmentSize || ReceiveWindow () < segmentSize)
+    return; // An ACK sent meanwhile carried the window
+  for (uint32_t i = 0; i < subflows.size (); i++)
+    {
+      if (subflows[i]->state == ESTABLISHED)
+        {
+          SendEmptyPacket (i, TcpHeader::ACK);
+          return;
+        }
+    }
+}
+
+uint32_t
+MpTcpSocketBase::FreeWindow (uint8_t sFlowIdx)
+{
+  Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
+  uint32_t unAcked = (sFlow->TxSeqNumber - (sFlow->highestAck + 1));
+  uint32_t window;
+  if (m_wndScaling)
+    { // The peer advertises its free receive buffer, which the data in flight on all subflows shares
+      uint32_t inFlight = 0;
+      for (uint32_t i = 0; i < subflows.size (); i++)
+        inFlight += subflows[i]->TxSeqNumber - (subflows[i]->highestAck + 1);
+      window = std::min (unAcked + (remoteRecvWnd > inFlight ? remoteRecvWnd - inFlight : 0), sFlow->cwnd.Get ());
+    }
+  else
+    window = std::min ((m_rwndScale*remoteRecvWnd), sFlow->cwnd.Get ());
+  return (window < unAcked) ? 0 : (window - unAcked);
+}
 
-  return (uint16_t) 65535;
+uint8_t
+MpTcpSocketBase::SegmentOverhead (void) const
+{ // IPv4 header and TCP header with the DSN option, 40 bytes, or with timestamps as well, 60 bytes
+  return m_timestampRtt ? 80 : 60;
+}
+
+uint32_t
+MpTcpSocketBase::SegmentLimit (uint8_t sFlowIdx)
+{
+  uint32_t mss = subflows[sFlowIdx]->MSS;
+  if (m_superSegment <= 1)
+    return mss;
+  // The DSN option length and the IPv4 total length are 16 bits
+  uint32_t segments = std::min (m_superSegment, (65535 - SegmentOverhead ()) / mss);
+  return std::max (segments, 1u) * mss;
 }
 
 uint32_t
@@ -4836,9 +5443,7 @@ MpTcpSocketBase::AvailableWindow (uint8_t sFlowIdx)
   NS_LOG_FUNCTION(this << (int)sFlowIdx);
 
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-  uint32_t window = std::min ((m_rwndScale*remoteRecvWnd), sFlow->cwnd.Get ());
-  uint32_t unAcked = (sFlow->TxSeqNumber - (sFlow->highestAck + 1));
-  uint32_t freeCWND = (window < unAcked) ? 0 : (window - unAcked);
+  uint32_t freeCWND = FreeWindow (sFlowIdx);
   if (freeCWND < sFlow->MSS && sendingBuffer.PendingData () >= sFlow->MSS)
     {
       NS_LOG_WARN("AvailableWindow: ("<< (int)sFlowIdx <<") -> " << freeCWND << " => 0" << " MSS: " << sFlow->MSS);
@@ -4880,15 +5485,11 @@ MpTcpSocketBase::LookupSubflow (Ipv4Address src, uint32_t srcPort, Ipv4Address d
 {
   NS_LOG_FUNCTION(this);
 
-  NS_ASSERT(m_localAddress == src);
-  NS_ASSERT(m_remoteAddress == dst);
-  NS_ASSERT(m_localPort == srcPort);
-  NS_ASSERT(m_remotePort == dstPort);
-
   Ptr<MpTcpSubFlow> sFlow = 0;
   uint8_t sFlowIdx = maxSubflows;
 
   // Walk through the existing subflow container and try to find one with 4-tuple match!
+  // Only packets of the connection endpoint come here, so the master subflow matches first.
   for (uint32_t i = 0; i < subflows.size (); i++)
     {
       sFlow = subflows[i];
@@ -4909,6 +5510,7 @@ MpTcpSocketBase::LookupSubflow (Ipv4Address src, uint32_t srcPort, Ipv4Address d
 // Recevier would create its new subflow when SYN with MP_JOIN being sent.
   sFlowIdx = subflows.size ();
   sFlow = CreateObject<MpTcpSubFlow> ();
+  sFlow->SetPlotBufferSize (m_plotBufferSize);
   sFlow->routeId = subflows[subflows.size () - 1]->routeId + 1;
   sFlow->dAddr = dst;
   sFlow->dPort = dstPort;
@@ -4924,8 +5526,8 @@ MpTcpSocketBase::LookupSubflow (Ipv4Address src, uint32_t srcPort, Ipv4Address d
   sFlow->m_endPoint = m_tcp->Allocate (sFlow->sAddr, sFlow->sPort, sFlow->dAddr, sFlow->dPort);
   if (sFlow->m_endPoint == 0)
     return -1;
-  sFlow->m_endPoint->SetRxCallback (MakeCallback (&MpTcpSocketBase::ForwardUp, Ptr<MpTcpSocketBase> (this)));
-  subflows.insert (subflows.end (), sFlow);
+  sFlow->m_endPoint->SetRxCallback (MakeCallback (&MpTcpSocketBase::ForwardUpSubflow, Ptr<MpTcpSocketBase> (this)).Bind (sFlowIdx));
+  AddSubflow (sFlow);
   NS_LOG_UNCOND(this << " LookupSubflow -> Subflow(" << (int) sFlowIdx <<") has created its (src,dst) = (" << sFlow->sAddr << ":" << sFlow->sPort << " , "<< sFlow->dAddr << ":" << sFlow->dPort<< ")" );
 
   return sFlowIdx;
@@ -4934,78 +5536,30 @@ MpTcpSocketBase::LookupSubflow (Ipv4Address src, uint32_t srcPort, Ipv4Address d
 uint32_t
 MpTcpSocketBase::compute_a_scaled ()
 {
-  if (AlgoCC < COUPLED_EPSILON)
-    exit (1);
-
-  uint32_t sum_denominator = 0;
-  uint64_t t = 0;
-  uint64_t cwndSum = 0;
-
-  for (uint32_t i = 0; i < subflows.size (); i++)
-    {
-      Ptr<MpTcpSubFlow> sFlow = subflows[i];
-      Time time = sFlow->rtt->GetCurrentEstimate ();
-      uint32_t rtt = time.GetMicroSeconds () / 10;
-      if (rtt == 0)
-        rtt = 1;
-
-      uint32_t cwnd = sFlow->m_inFastRec ? sFlow->ssthresh : sFlow->cwnd.Get ();
-      uint32_t mss = sFlow->MSS;
-
-      t = max (t, (uint64_t) cwnd * mss * mss / rtt / rtt);
-      sum_denominator += cwnd * mss / rtt;
-      cwndSum += cwnd;
-    }
-  return (uint32_t) (A_SCALE * (uint64_t) cwndSum * t / sum_denominator / sum_denominator);
+  UpdateCoupledAggregate ();
+  uint32_t sum_denominator = m_coupled.GetScaledSum ();
+  return (uint32_t) (A_SCALE * m_coupled.GetTotalWindow () * m_coupled.GetScaledMax () / sum_denominator / sum_denominator);
 }
 
 double
 MpTcpSocketBase::compute_alfa ()
 {
-  if (AlgoCC < COUPLED_EPSILON)
-    exit (300);
-
   if (subflows.size () == 1)
     {
       return 1;
     }
   else
     {
-      double maxt = 0, sum_denominator = 0;
-      for (uint32_t i = 0; i < subflows.size (); i++)
-        {
-          Ptr<MpTcpSubFlow> sFlow = subflows[i];
-          uint32_t cwnd = sFlow->m_inFastRec ? sFlow->ssthresh : sFlow->cwnd.Get ();
-          Time time = sFlow->rtt->GetCurrentEstimate ();
-          uint32_t rtt = time.GetMilliSeconds ();
-
-          if (rtt == 0)
-            rtt = 1;
-
-          double t = pow (cwnd, _e / 2) / rtt;
-          if (t > maxt)
-            maxt = t;
-          sum_denominator += ((double) cwnd / rtt);
-        }
-      return (double) compute_total_window () * pow (maxt, 1 / (1 - _e / 2)) / pow (sum_denominator, 1 / (1 - _e / 2));
+      UpdateCoupledAggregate ();
+      return (double) compute_total_window () * pow (m_coupled.GetEpsilonMax (), 1 / (1 - _e / 2))
+          / pow (m_coupled.GetEpsilonSum (), 1 / (1 - _e / 2));
     }
 }
 
 void
 MpTcpSocketBase::window_changed ()
 {
-  switch (AlgoCC)
-    {
-  case COUPLED_EPSILON:
-    if (_e > 0 && _e < 2)
-      alpha = compute_alfa ();
-    return;
-  case COUPLED_INC:
-    a = compute_a_scaled ();
-    return;
-  default:
-    break;
-    }
+  m_congestionOps->WindowChanged (this);
 }
 
 void
@@ -5014,156 +5568,43 @@ MpTcpSocketBase::OpenCWND (uint8_t sFlowIdx, uint32_t ackedBytes)
   NS_LOG_FUNCTION(this << (int) sFlowIdx << ackedBytes);
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
 
-  double adder = 0;
-  uint32_t cwnd = sFlow->cwnd.Get ();
-  uint32_t ssthresh = sFlow->ssthresh;
-  uint32_t mss = sFlow->MSS;
-
-  // params used only for COUPLED_INC and COUPLED_EPS only
-  int tcp_inc = 0, tt = 0;
-  int tmp, total_cwnd, tmp2;
-  double tmp_float;
+  // An ACK of super-segments opens the window as one ACK per segment would
+  uint32_t chunk = SegmentLimit (sFlowIdx) > sFlow->MSS ? sFlow->MSS : ackedBytes;
+  bool slowStart;
+  do
+    {
+      uint32_t bytes = std::min (chunk, ackedBytes);
+      slowStart = m_congestionOps->IncreaseWindow (this, sFlowIdx, bytes);
+      ackedBytes -= bytes;
+    }
+  while (ackedBytes > 0);
 
-  if (AlgoCC >= COUPLED_SCALABLE_TCP)
+  if (slowStart)
     {
-      if (ackedBytes > mss)
-        ackedBytes = mss;
-      if (ackedBytes < 0)
+      if (IsPlotting (PLOT_WINDOW))
         {
-          exit (200);
-          return;
+          RecordPlot (sFlow->ssthreshtrack, "ssthreshtrack", sFlowIdx, sFlow->ssthresh);
+          RecordPlot (sFlow->CWNDtrack, "CWNDtrack", sFlowIdx, sFlow->cwnd);
+          RecordPlot (totalCWNDtrack, "totalCWNDtrack", sFlowIdx, totalCwnd);
         }
-      tcp_inc = (ackedBytes * mss) / cwnd;
-      tt = (ackedBytes * mss) % cwnd;
-      if (m_alphaPerAck)
+      if (IsPlotting (PLOT_STATE))
         {
-          a = compute_a_scaled (); // Per ACK for COUPLED_INC
-          alpha = compute_alfa (); // Per ACK for COUPLED_EPSILON
+          RecordPlot (sFlow->_ss, "_ss", sFlowIdx, TimeScale);
         }
-    }
-
-  calculateTotalCWND ();
-  if (cwnd < ssthresh)
-    {
-      sFlow->cwnd += sFlow->MSS;
-#ifdef PLOT
-      sFlow->ssthreshtrack.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->ssthresh));
-      sFlow->CWNDtrack.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->cwnd));
-      totalCWNDtrack.push_back (make_pair (Simulator::Now ().GetSeconds (), totalCwnd));
-      sFlow->_ss.push_back (make_pair (Simulator::Now ().GetSeconds (), TimeScale));
-#endif
       NS_LOG_WARN ("Congestion Control (Slow Start) increment by one segmentSize");
     }
   else
     {
-      switch (AlgoCC)
+      if (IsPlotting (PLOT_WINDOW))
         {
-      case Fast_Uncoupled:
-        //calculateFastAlpha(sFlowIdx);
-        adder = ((1 - sFlow->dctcp_last_fraction) * sFlow->MSS * sFlow->MSS) / cwnd;
-        adder = std::max (1.0, adder);
-        sFlow->cwnd += static_cast<double> (adder);
-        break;
-      case Fast_Increases:
-        adder = ((1 - sFlow->dctcp_last_fraction) * sFlow->MSS * sFlow->MSS) / totalCwnd;
-        adder = std::max(1.0, adder);
-        sFlow->cwnd += static_cast<double>(adder);
-        break;
-      case XCA:
-        adder = static_cast<double> (sFlow->MSS * sFlow->MSS) / totalCwnd;
-        adder = std::max (1.0, adder);
-        sFlow->cwnd += static_cast<double> (adder);
-        break;
-      case RTT_Compensator:
-        calculateAlpha (); // Calculate alpha per drop or RTT...RFC 6356 (Section 4.1)
-        adder = std::min (alpha * sFlow->MSS * sFlow->MSS / totalCwnd, static_cast<double> (sFlow->MSS * sFlow->MSS) / cwnd);
-        adder = std::max (1.0, adder);
-        sFlow->cwnd += static_cast<double> (adder);
-        NS_LOG_ERROR ("Congestion Control (RTT_Compensator): alpha "<<alpha<<" ackedBytes (" << ackedBytes << ") totalCwnd ("<< totalCwnd / sFlow->MSS<<" packets) -> increment is "<<adder << " cwnd: " << sFlow->cwnd);
-        break;
-      case Linked_Increases:
-        calculateAlpha ();
-        adder = alpha * sFlow->MSS * sFlow->MSS / totalCwnd;
-        adder = std::max (1.0, adder);
-        sFlow->cwnd += static_cast<double> (adder);
-        NS_LOG_ERROR ("Subflow "<<(int)sFlowIdx<<" Congestion Control (Linked_Increases): alpha "<<alpha<<" increment is "<<adder<<" ssthresh "<< ssthresh << " cwnd "<<cwnd );
-        break;
-      case Uncoupled_TCPs:
-        adder = static_cast<double> (sFlow->MSS * sFlow->MSS) / cwnd;
-        adder = std::max (1.0, adder);
-        sFlow->cwnd += static_cast<double> (adder);
-        NS_LOG_WARN ("Subflow "<<(int)sFlowIdx<<" Congestion Control (Uncoupled_TCPs) increment is "<<adder<<" ssthresh "<< ssthresh << " cwnd "<<cwnd);
-        break;
-      case UNCOUPLED:
-        sFlow->cwnd += tcp_inc;
-        break;
-      case Fully_Coupled:
-        adder = static_cast<double> (sFlow->MSS * sFlow->MSS) / totalCwnd;
-        adder = std::max (1.0, adder);
-        sFlow->cwnd += static_cast<double> (adder);
-        NS_LOG_ERROR ("Subflow "<<(int)sFlowIdx<<" Congestion Control (Fully_Coupled) increment is "<<adder<<" ssthresh "<< ssthresh << " cwnd "<<cwnd);
-        break;
-      case COUPLED_INC:
-        total_cwnd = compute_total_window ();
-        tmp2 = (ackedBytes * mss * a) / total_cwnd;
-
-        tmp = tmp2 / A_SCALE;
-
-        if (tmp < 0)
-          {
-            printf ("Negative increase!");
-            tmp = 0;
-          }
-
-        if (rand () % A_SCALE < tmp2 % A_SCALE)
-          tmp++;
-
-        if (tmp > tcp_inc)    //capping
-          tmp = tcp_inc;
-
-        if ((cwnd + tmp) / mss != cwnd / mss)
-          a = compute_a_scaled ();
-
-        sFlow->cwnd = cwnd + tmp;
-        break;
-      case COUPLED_EPSILON: // RTT_Compensator
-        total_cwnd = compute_total_window ();
-        tmp_float = ((double) ackedBytes * mss * alpha * pow (alpha * cwnd, 1 - _e)) / pow (total_cwnd, 2 - _e);
-        tmp = (int) floor (tmp_float);
-
-        if (drand () < tmp_float - tmp)
-          tmp++;
-
-        if (tmp > tcp_inc)    //capping
-          tmp = tcp_inc;
-
-        if ((cwnd + tmp) / mss != cwnd / mss)
-          {
-            if (_e > 0 && _e < 2)
-              alpha = compute_alfa ();
-          }
-        sFlow->cwnd = cwnd + tmp;
-        break;
-      case COUPLED_SCALABLE_TCP:
-        sFlow->cwnd = cwnd + ackedBytes * 0.01;
-        break;
-      case COUPLED_FULLY:
-        total_cwnd = compute_total_window ();
-        tt = (int) (ackedBytes * mss * A);
-        tmp = tt / total_cwnd;
-        if (tmp > tcp_inc)
-          tmp = tcp_inc;
-        sFlow->cwnd = cwnd + tmp;
-        break;
-      default:
-        break;
+          RecordPlot (sFlow->ssthreshtrack, "ssthreshtrack", sFlowIdx, sFlow->ssthresh);
+          RecordPlot (sFlow->CWNDtrack, "CWNDtrack", sFlowIdx, sFlow->cwnd);
+          RecordPlot (totalCWNDtrack, "totalCWNDtrack", sFlowIdx, totalCwnd);
+        }
+      if (IsPlotting (PLOT_STATE))
+        {
+          RecordPlot (sFlow->_ca, "_ca", sFlowIdx, TimeScale);
         }
-#ifdef PLOT
-      sFlow->ssthreshtrack.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->ssthresh));
-      sFlow->CWNDtrack.push_back (make_pair (Simulator::Now ().GetSeconds (), sFlow->cwnd));
-      totalCWNDtrack.push_back (make_pair (Simulator::Now ().GetSeconds (), totalCwnd));
-      sFlow->_ca.push_back (make_pair (Simulator::Now ().GetSeconds (), TimeScale));
-#endif
     }
 }
 
@@ -5174,23 +5615,9 @@ MpTcpSocketBase::calculateAlpha ()
   // alpha = cwnd_total * MAX(cwnd_i / rtt_i^2) / {SUM(cwnd_i / rtt_i))^2}   //RFC 6356 formula (2)
 
   NS_LOG_FUNCTION_NOARGS ();
-  alpha = 0;
-  double maxi = 0;
-  double sumi = 0;
-
-  for (uint32_t i = 0; i < subflows.size (); i++)
-    {
-      Ptr<MpTcpSubFlow> sFlow = subflows[i];
-      Time time = sFlow->rtt->GetCurrentEstimate ();
-      double rtt = time.GetMicroSeconds(); //double rtt = time.GetSeconds ();
-      if (rtt == 0)
-        rtt = 1;
-      double tmpi = sFlow->cwnd.Get () / (rtt * rtt);
-      if (maxi < tmpi)
-        maxi = tmpi;
-
-      sumi += sFlow->cwnd.Get () / rtt;
-    }
+  UpdateCoupledAggregate ();
+  double maxi = m_coupled.GetLinkedMax ();
+  double sumi = m_coupled.GetLinkedSum ();
   alpha = (totalCwnd * maxi) / (sumi * sumi);
 }
 
@@ -5213,10 +5640,6 @@ MpTcpSocketBase::DestroySubflowMapDSN ()
   for (uint32_t i = 0; i < subflows.size (); i++)
     {
       Ptr<MpTcpSubFlow> sFlow = subflows[i];
-      for (std::list<DSNMapping *>::iterator i = sFlow->mapDSN.begin (); i != sFlow->mapDSN.end (); i++)
-        {
-          i = sFlow->mapDSN.erase (i);
-        }
       sFlow->mapDSN.clear ();
     }
 }
@@ -5225,11 +5648,8 @@ void
 MpTcpSocketBase::DestroyUnOrdered ()
 {
   NS_LOG_FUNCTION_NOARGS();
-  for (std::list<DSNMapping*>::iterator i = unOrdered.begin (); i != unOrdered.end (); i++)
-    {
-      i = unOrdered.erase (i);
-    }
   unOrdered.clear ();
+  m_reorderDepth = 0;
 }
 
 /** Kill this socket. This is a callback function configured to m_endpoint in
@@ -5283,35 +5703,49 @@ void
 MpTcpSocketBase::SetCCAlgo (string cc)
 {
   if (cc == "Uncoupled_TCPs")
-    AlgoCC = Uncoupled_TCPs;
+    SetCongestionCtrlAlgo (Uncoupled_TCPs);
   else if (cc == "Linked_Increases")
-    AlgoCC = Linked_Increases;
+    SetCongestionCtrlAlgo (Linked_Increases);
   else if (cc == "RTT_Compensator")
-    AlgoCC = RTT_Compensator;
+    SetCongestionCtrlAlgo (RTT_Compensator);
   else if (cc == "Fully_Coupled")
-    AlgoCC = Fully_Coupled;
+    SetCongestionCtrlAlgo (Fully_Coupled);
   else if (cc == "COUPLED_SCALABLE_TCP")
-    AlgoCC = COUPLED_SCALABLE_TCP;
+    SetCongestionCtrlAlgo (COUPLED_SCALABLE_TCP);
   else if (cc == "UNCOUPLED")
-    AlgoCC = UNCOUPLED;
+    SetCongestionCtrlAlgo (UNCOUPLED);
   else if (cc == "COUPLED_EPSILON")
-    AlgoCC = COUPLED_EPSILON;
+    SetCongestionCtrlAlgo (COUPLED_EPSILON);
   else if (cc == "COUPLED_INC")
-    AlgoCC = COUPLED_INC;
+    SetCongestionCtrlAlgo (COUPLED_INC);
   else if (cc == "COUPLED_FULLY")
-    AlgoCC = COUPLED_FULLY;
+    SetCongestionCtrlAlgo (COUPLED_FULLY);
   else if (cc == "Fast_Uncoupled")
-    AlgoCC = Fast_Uncoupled;
+    SetCongestionCtrlAlgo (Fast_Uncoupled);
   else if (cc == "Fast_Increases")
-    AlgoCC = Fast_Increases;
+    SetCongestionCtrlAlgo (Fast_Increases);
   else if (cc == "XCA")
-    AlgoCC = XCA;
+    SetCongestionCtrlAlgo (XCA);
 }
 
 void
 MpTcpSocketBase::SetCongestionCtrlAlgo (CongestionCtrl_t ccalgo)
 {
   AlgoCC = ccalgo;
+  m_congestionOps = MpTcpCongestionOps::CreateFor (ccalgo);
+}
+
+void
+MpTcpSocketBase::SetCongestionOps (Ptr<MpTcpCongestionOps> ops)
+{
+  if (ops != 0)
+    m_congestionOps = ops;
+}
+
+Ptr<MpTcpCongestionOps>
+MpTcpSocketBase::GetCongestionOps () const
+{
+  return m_congestionOps;
 }
 
 void
@@ -5342,6 +5776,11 @@ void
 MpTcpSocketBase::SetFlowType (string input)
 {
   flowType = input;
+  // Only flows that GeneratePlots() will output record plot series
+  if ((m_largePlotting && flowType.compare ("Large") == 0) || (m_shortPlotting && flowType.compare ("Short") == 0))
+    m_plotMask = m_plotSeries;
+  else
+    m_plotMask = 0;
 }
 
 void
@@ -5396,7 +5835,7 @@ MpTcpSocketBase::getQueuePkt (Ipv4Address addr)
   PointerValue ptr;
   net0->GetAttribute ("TxQueue", ptr);
   Ptr<Queue> txQueue = ptr.Get<Queue> ();
-  TxQueue.push_back (make_pair (Simulator::Now ().GetSeconds (), txQueue->GetNPackets ()));
+  TxQueue.Add (Simulator::Now ().GetSeconds (), txQueue->GetNPackets ());
 }
 
 string
@@ -5543,11 +5982,9 @@ MpTcpSocketBase::GeneratePlots ()
       GenerateCwnd();
       GenerateTotalCwnd();
       GenerateAlpha();
-#ifdef PLOT_DCTCP
       GenerateSendvsACK ();
       GenerateDctcpAlpha ();
       GenerateDctcpAlphaRtt ();
-#endif
     //GeneratePktCount ();
       GeneratePlotsOutput ();
     }
@@ -5635,16 +6072,24 @@ MpTcpSocketBase::SlowDownEcnLike (uint8_t sFlowIdx)
   SlowDownHits++;
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
 
-  double tmp = sFlow->cwnd.Get () * (1 - m_initGamma / (float) m_backoffBeta);
-  if (tmp < 0) tmp = 0;
-  sFlow->cwnd = std::max ((uint32_t) tmp, (m_cwndMin * sFlow->MSS));
+  uint32_t tmp;
+  if (m_dctcpFixedPoint)
+    tmp = (uint64_t) sFlow->cwnd.Get () * (m_backoffBeta - m_initGamma) / m_backoffBeta;
+  else
+    {
+      double cut = sFlow->cwnd.Get () * (1 - m_initGamma / (float) m_backoffBeta);
+      tmp = cut < 0 ? 0 : (uint32_t) cut;
+    }
+  sFlow->cwnd = std::max (tmp, (m_cwndMin * sFlow->MSS));
   sFlow->ssthresh = std::max (sFlow->MSS, sFlow->cwnd.Get ());
+  SubflowWindowChanged (sFlowIdx);
   sFlow->dctcp_maxseq = sFlow->TxSeqNumber;
 
-#ifdef PLOT_DCTCP
-  uint32_t pkt_tmp = ((sFlow->g_AckSeqNumber - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-  sFlow->ECN_CWND_CUT_POINT.push_back (make_pair (Simulator::Now ().GetSeconds (), pkt_tmp));
-#endif
+  if (IsPlotting (PLOT_DCTCP))
+    {
+      uint32_t pkt_tmp = ((sFlow->g_AckSeqNumber - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
+      RecordPlot (sFlow->ECN_CWND_CUT_POINT, "ECN_CWND_CUT_POINT", sFlowIdx, pkt_tmp);
+    }
 }
 
 void
@@ -5654,25 +6099,17 @@ MpTcpSocketBase::SlowDown (uint8_t sFlowIdx)
   SlowDownHits++;
 
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-
-  double alpha = sFlow->dctcp_alpha;
-
-  if (m_dctcpAlphaPerAck)
-    {
-      alpha = sFlow->rtt->GetAlpha ();
-    }
-
-  double tmp = sFlow->cwnd.Get () * (1 - alpha / 2);
-  if (tmp < 0) tmp = 0;
-  sFlow->cwnd = std::max ((uint32_t) tmp, (m_cwndMin * sFlow->MSS));
+  sFlow->cwnd = std::max (DctcpReduceWindow (sFlowIdx), (m_cwndMin * sFlow->MSS));
   sFlow->ssthresh = std::max (sFlow->MSS, sFlow->cwnd.Get ());
+  SubflowWindowChanged (sFlowIdx);
   sFlow->dctcp_maxseq = sFlow->TxSeqNumber;
 
 
-#ifdef PLOT_DCTCP
-  uint32_t pkt_tmp = ((sFlow->g_AckSeqNumber - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
-  sFlow->ECN_CWND_CUT_POINT.push_back (make_pair (Simulator::Now ().GetSeconds (), pkt_tmp));
-#endif
+  if (IsPlotting (PLOT_DCTCP))
+    {
+      uint32_t pkt_tmp = ((sFlow->g_AckSeqNumber - sFlow->initialSequnceNumber) / sFlow->MSS) % mod;
+      RecordPlot (sFlow->ECN_CWND_CUT_POINT, "ECN_CWND_CUT_POINT", sFlowIdx, pkt_tmp);
+    }
 }
 
 void
@@ -5681,13 +6118,18 @@ MpTcpSocketBase::SlowDownFastReTx(uint8_t sFlowIdx, DSNMapping* ptrDSN, string s
   NS_LOG_FUNCTION_NOARGS();
   SlowDownHits++;
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
-  double tmpCwnd = sFlow->cwnd.Get() * (1 - sFlow->dctcp_alpha / 2);
-  sFlow->ssthresh = std::max(2 * sFlow->MSS, (uint32_t) tmpCwnd);
+  uint32_t tmpCwnd;
+  if (m_dctcpFixedPoint)
+    tmpCwnd = sFlow->dctcp_fixed.ReduceWindow (sFlow->cwnd.Get ());
+  else
+    tmpCwnd = (uint32_t) (sFlow->cwnd.Get() * (1 - sFlow->dctcp_alpha / 2));
+  sFlow->ssthresh = std::max(2 * sFlow->MSS, tmpCwnd);
   sFlow->cwnd = sFlow->ssthresh + 3 * sFlow->MSS;
   DoRetransmit(sFlowIdx, ptrDSN);
 //sFlow->m_recover = SequenceNumber32(sFlow->maxSeqNb + 1);
   sFlow->m_recover = SequenceNumber32(sFlow->m_highTxMark + 1);
   sFlow->m_inFastRec = true;
+  SubflowWindowChanged (sFlowIdx);
 }
 
 void
@@ -5722,7 +6164,7 @@ MpTcpSocketBase::RateTracerCl ()
   //double sampledGoodput = (((nextTxSequence - lastNextTxSequence) * 8) / m_rateInterval);
   double sampledGoodput = (m_totalSentBytes * 8)/m_rateInterval;
   sampledGoodput = sampledGoodput/1000000;
-  rateTracerCl.push_back(make_pair(Simulator::Now().GetSeconds(), sampledGoodput));
+  rateTracerCl.Add(Simulator::Now().GetSeconds(), sampledGoodput);
   //lastNextTxSequence = nextTxSequence;
   m_totalSentBytes = 0;
   if (flowCompletionTime)
@@ -5738,7 +6180,9 @@ MpTcpSocketBase::RecordDctcpFastRetx(uint8_t sFlowIdx, uint32_t oldCwnd)
   double lastF = sFlow->dctcp_last_fraction;
   double lastAlpha = sFlow->dctcp_alpha;
 
-  if (sFlow->dctcp_total > 0)
+  if (m_dctcpFixedPoint)
+    currentF = sFlow->dctcp_fixed.GetFraction ();
+  else if (sFlow->dctcp_total > 0)
     currentF = (double)sFlow->dctcp_marked / sFlow->dctcp_total;
   else
     currentF = 0.0;
@@ -5760,6 +6204,7 @@ MpTcpSocketBase::SetCapacity (string capacity)
   uint32_t bdp = (cap * subflows[0]->rtt->GetCurrentEstimate ().GetSeconds ()) / 8; // BDP bytes
   if (tmp > m_capacity)
     subflows[0]->ssthresh = subflows[0]->ssthresh * 2;
+  SubflowWindowChanged (0);
 
   cout << "current cap: " << tmp << "\tnew cap: " << cap << "\tdelay: "
       << subflows[0]->rtt->GetCurrentEstimate ().GetSeconds () << "\tBDP: "
@@ -12,6 +12,7 @@
 #include "ns3/gnuplot.h"
 #include "mp-tcp-subflow.h"
 #include "ns3/output-stream-wrapper.h"
+#include "ns3/dc-tag.h"
 
 #define A 1
 #define B 2
@@ -24,6 +25,7 @@ class Ipv4EndPoint;
 class Node;
 class Packet;
 class TcpL4Protocol;
+class MpTcpCongestionOps;
 
 class MpTcpSocketBase : public TcpSocketBase
 {
@@ -68,9 +70,13 @@ public: // public methods
   bool GetDctcp();
   void SetSlowDownEcnLike(bool);
   void SetDctcpFastAlpha(bool);
+  void SetPlotBufferSize(uint32_t);           // Max samples kept per plot series
+  uint32_t GetPlotBufferSize() const;
   // Setter for congestion Control and data distribution algorithm
   void SetCongestionCtrlAlgo(CongestionCtrl_t ccalgo);  // This would be used by attribute system for setting congestion control
   void SetCCAlgo(string ccAlgo);
+  void SetCongestionOps(Ptr<MpTcpCongestionOps> ops);   // Replaces the algorithm set by CongestionControl, ignores 0
+  Ptr<MpTcpCongestionOps> GetCongestionOps() const;
   void SetDataDistribAlgo(DataDistribAlgo_t ddalgo);    // Round Robin is only algorithms used.
   void SetPathManager (PathManager_t);
   uint32_t GetTotalPktSent();
@@ -88,6 +94,17 @@ public: // public methods
   uint32_t m_cwndMin;
   string  m_capacity;
   
+  // Groups of plot series recorded for plotted flows, combined in the PlotSeries attribute
+  enum PlotSeriesGroup
+  {
+    PLOT_SEQUENCE = 1,  // DATA, ACK, RETRANSMIT and DUPACK sequence numbers
+    PLOT_WINDOW   = 2,  // cwnd and ssthresh tracks, cwnd at loss and recovery events
+    PLOT_STATE    = 4,  // Congestion control state markers (_ss, _ca, _FReTx, _FR_PA, _FR_FA, _TimeOut)
+    PLOT_RTT      = 8,  // _RTT, _AvgRTT and _RTO
+    PLOT_DCTCP    = 16, // DCTCP alpha and marked fraction, ECN echoes and window cuts
+    PLOT_ALL      = 31
+  };
+
 public: // public variables
   // Evaluation & plotting parameters and containers
   EventId nextRateEvent;
@@ -120,11 +137,15 @@ public: // public variables
   bool m_shortPlotting;
   bool m_ratePlotSf;
   bool m_ratePlotCl;
+  uint32_t m_plotSeries;     // PlotSeriesGroup flags recorded when this flow is plotted
+  uint32_t m_plotMask;       // m_plotSeries if this flow is plotted, 0 otherwise (see SetFlowType)
+  uint32_t m_plotBufferSize; // Max samples kept per plot series
+  TracedCallback<uint8_t, const char*, double> m_plotSampleTrace; // Subflow, series name and value of each recorded sample
   uint32_t m_totalSentBytes;
 
   double m_rateInterval;
   //uint64_t lastNextTxSequence;
-  vector<pair<double, double> > rateTracerCl;
+  PlotSeries<double> rateTracerCl;
   EventId m_nextRateEvent;
   bool m_alphaPerAck;
   uint32_t m_rGap;
@@ -135,19 +156,20 @@ public: // public variables
   std::list<uint32_t> sampleList;
   bool hasSampleListDone;
 
-  vector<pair<double, double> > totalCWNDtrack;
-  vector<pair<double, double> > reTxTrack;
-  vector<pair<double, double> > timeOutTrack;
-  vector<pair<double, double> > PartialAck;
-  vector<pair<double, double> > FullAck;
-  vector<pair<double, double> > DupAcks;
-  vector<pair<double, double> > PacketDrop;
-  vector<pair<double, double> > TxQueue;
+  PlotSeries<double> totalCWNDtrack;
+  PlotSeries<double> reTxTrack;
+  PlotSeries<double> timeOutTrack;
+  PlotSeries<double> PartialAck;
+  PlotSeries<double> FullAck;
+  PlotSeries<double> DupAcks;
+  PlotSeries<double> PacketDrop;
+  PlotSeries<double> TxQueue;
 
 
 protected: // protected methods
 
   friend class Tcp;
+  friend class MpTcpCongestionOps;
 
   // Implementing some inherited methods from ns3::TcpSocket. No need to comment them!
   virtual void SetSndBufSize (uint32_t size);
@@ -170,10 +192,15 @@ protected: // protected methods
   bool InitiateSingleSubflows(uint16_t); // Initiate new subflows when nDiffPorts is active
   virtual void InitiateMultipleSubflows();
   // Transfer operations
-  void ForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface);
-  virtual void DoForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface);
+  void ForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface); // Rx callback of the connection endpoint
+  void ForwardUpSubflow(uint8_t sFlowIdx, Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface); // Rx callback of a subflow endpoint, sFlowIdx is bound at setup
+  virtual void DoForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface, int sFlowIdx); // sFlowIdx is -1 when the subflow has to be looked up
   virtual bool SendPendingData(uint8_t sFlowId = -1);
   void SendEmptyPacket(uint8_t sFlowId, uint8_t flags);
+  void AckReceivedData(uint8_t sFlowIdx);     // ACK an in-order data segment now, or delay/coalesce the ACK
+  void DelAckTimeout(uint8_t sFlowIdx);       // Send the delayed or coalesced ACK of a subflow
+  void UpdateCeState(uint8_t sFlowIdx);       // DCTCP receiver state machine, called before a data segment is processed
+  void EchoSegments(uint8_t sFlowIdx);        // Count the segments of a received super-segment for the next ACK
   void SendRST(uint8_t sFlowIdx);
   virtual int SendDataPacket (uint8_t sFlowIdx, uint32_t pktSize, bool withAck);
   // Connection closing operations
@@ -205,7 +232,16 @@ protected: // protected methods
   // Window Management
   virtual uint32_t BytesInFlight(uint8_t sFlowIdx);  // Return total bytes in flight of a subflow
   uint16_t AdvertisedWindowSize();
+  uint32_t ReceiveWindow();                    // Free space of the receive buffer, in bytes
+  uint32_t PeerWindow(const TcpHeader&) const; // Window field of a received segment, scaled
+  uint8_t WindowShift() const;                 // Smallest window scale that can advertise the largest receive buffer
+  void SetPeerWindowShift(uint8_t shift);      // The peer sent the window scale option
+  void RcvSpaceAdjust();                       // Receive buffer autotuning, after the application read data
+  void SendWindowUpdate();                     // ACK on a window that opened since it was advertised
   uint32_t AvailableWindow(uint8_t sFlowIdx);
+  uint32_t FreeWindow(uint8_t sFlowIdx);       // min(rwnd, cwnd) minus the bytes in flight of a subflow
+  uint32_t SegmentLimit(uint8_t sFlowIdx);     // Largest data packet of a subflow, MSS unless SuperSegment is set
+  uint8_t SegmentOverhead(void) const;         // Header bytes each segment of a super-segment would carry
 
   // Manage data Tx/Rx
   virtual Ptr<TcpSocketBase> Fork(void);
@@ -213,6 +249,8 @@ protected: // protected methods
   virtual void ReceivedData (uint8_t sFlowIdx, Ptr<Packet>, const TcpHeader&); // Recv of a data, put into buffer, call L7 to get it if necessary
   virtual void EstimateRtt (uint8_t sFlowIdx, const TcpHeader&);
   virtual void EstimateRtt (const TcpHeader&);
+  Time EchoedRtt (uint8_t sFlowIdx, const TcpHeader&);  // RTT sample from the timestamp echoed by a new ACK
+  uint8_t AddTimestamp (uint8_t sFlowIdx, TcpHeader&);   // Adds the timestamp option if TimestampRtt is set, returns its length
   virtual bool ReadOptions (uint8_t sFlowIdx, Ptr<Packet> pkt, const TcpHeader&); // Read option from incoming packets
   virtual bool ReadOptions (Ptr<Packet> pkt, const TcpHeader&); // Read option from incoming packets (Listening Socket only)
   virtual void DupAck(const TcpHeader& t, uint32_t count);  // Not in operation, it's pure virtual function from TcpSocketBase
@@ -222,6 +260,8 @@ protected: // protected methods
   virtual void DoRetransmit (uint8_t sFlowIdx);
   virtual void DoRetransmit (uint8_t sFlowIdx, DSNMapping* ptrDSN);
   void SetReTxTimeout(uint8_t sFlowIdx);
+  void RestartReTxTimeout(uint8_t sFlowIdx);   // Push the retransmission timer one RTO ahead
+  void LazyReTxTimeout(uint8_t sFlowIdx);      // Lazy timer event: re-arm if the deadline moved, else time out
   void ReTxTimeout(uint8_t sFlowIdx);
   virtual void Retransmit(uint8_t sFlowIdx);
   void LastAckTimeout(uint8_t sFlowIdx);
@@ -242,12 +282,19 @@ protected: // protected methods
   uint32_t compute_a_scaled();
   double compute_alfa();
   void window_changed();
+  void SubflowWindowChanged(uint8_t sFlowIdx);  // cwnd, ssthresh, fast recovery or RTT estimate of a subflow has changed
+  void CwndChanged(uint8_t sFlowIdx, uint32_t oldCwnd, uint32_t newCwnd); // Trace sink of each subflow's cwnd
+  void UpdateCoupledAggregate();                // Refresh m_coupled from the subflows marked as changed
 
   // Helper functions -> main operations
   uint8_t LookupByAddrs(Ipv4Address src, Ipv4Address dst); // Called by Forwardup() to find the right subflow for incoing packet
   virtual int LookupSubflow(Ipv4Address src, uint32_t sPort, Ipv4Address dst , uint32_t dPort); // LookupBy4-Tuple
+  uint8_t AddSubflow(Ptr<MpTcpSubFlow> sFlow);  // Append sFlow to subflows and return its index
 
   virtual uint8_t getSubflowToUse();  // Called by SendPendingData() to get a subflow based on round robin algorithm
+  bool SelectSubflow(uint8_t &sFlowIdx, uint32_t &window); // Called by SendPendingData() to pick a ready subflow by distribAlgo
+  bool UsableWindow(uint8_t sFlowIdx, uint32_t &window);   // Window of a ready candidate, marks it busy if there is none
+  bool DeferSuperSegment(uint8_t sFlowIdx, uint32_t window); // Wait for a larger window before sending a super-segment
   bool IsThereRoute(Ipv4Address src, Ipv4Address dst);     // Called by InitiateSubflow & LookupByAddrs and Connect to check whether there is route between a pair of addresses.
   bool IsLocalAddress(Ipv4Address addr);
   bool IsRemoteAddress(Ipv4Address addr);
@@ -262,6 +309,9 @@ protected: // protected methods
 
 
   // Helper functions -> plotting
+  bool IsPlotting(uint32_t group) const { return (m_plotMask & group) != 0; }
+  template <typename T>
+  void RecordPlot(PlotSeries<T> &series, const char *name, uint8_t sFlowIdx, typename PlotSeries<T>::value_type value);
   std::string GeneratePlotDetail();
   std::string PlotFileNameGenerator(string s);
   void GenerateCWNDPlot();
@@ -298,11 +348,12 @@ protected: // protected methods
   void SlowDownEcnLike (uint8_t sFlowIdx); // DCTCP
   void SlowDownFastReTx (uint8_t sFlowIdx, DSNMapping* ptrDSN, string sockName); // DCTCP
   void CalculateDCTCPAlpha(uint8_t sFlowIdx, uint32_t); // Calculating fraction of Marked pkt and alpha once per rtt
+  void CalculateDctcpAlphaFixed(uint8_t sFlowIdx, uint32_t ack); // Same, in fixed-point from the bytes acked
+  uint32_t DctcpReduceWindow(uint8_t sFlowIdx) const; // cwnd * (1 - alpha / 2)
   void ExtractPacketTags(Ptr<Packet> p);
-  void AddPacketTag (Ptr<Packet> p, PacketTag_t pt);
-//  virtual void AddEctTag(Ptr<Packet> p);
-//  virtual void AddContPktTag(Ptr<Packet> p);
-  void AddEcmpTag(Ptr<Packet> p, uint8_t sFlowIdx);
+  void AddDcTag (Ptr<Packet> p, const DcTag &tag);  // Adds the tag once all its flags are set, if any
+  void SetEcmpIndex (DcTag &tag, uint8_t sFlowIdx);
+  void SetSegments (DcTag &tag, uint8_t sFlowIdx, uint32_t size);  // Tags a data packet larger than MSS as a super-segment
   void GenerateDctcpAlpha();    //DCTCP Debugging
   void GenerateDctcpAlphaRtt(); //DCTCP Debugging
   void RecordDctcpFastRetx(uint8_t, uint32_t);   //DCTCP Debugging
@@ -331,12 +382,23 @@ protected: // protected variables
   uint8_t            currentSublow;
   uint8_t			m_ceBit;
   uint8_t			m_eceBit;
+  uint8_t           m_rxSegments;          // Segments of the last packet received, more than 1 for a super-segment
+  uint8_t           m_rxEchoedSegments;    // Segments acknowledged by the last ACK of super-segments, 0 otherwise
+  uint8_t           m_rxMarkedSegments;    // CE segments among them
   bool              m_isDCTCPEnabled;      		//< Socket DCTCP capability
   double            m_g;
   bool              m_dctcpAlphaPerAck;
   bool              m_dctcpFastReTxRecord;
+  bool              m_dctcpFixedPoint;     // Linux style fixed-point alpha from byte counters
+  bool              m_lazyRto;             // Move the retransmission deadline on ACKs without rescheduling its event
   bool              m_ecn;
+  Time              m_ackCoalesceTime;     // ACK a burst once the subflow has been idle for this long, 0 disables
+  uint32_t          m_superSegment;        // Data packets carry up to this many MSS, 1 disables super-segments
+  bool              m_timestampRtt;        // Measure RTT from echoed timestamps instead of the sent segment history
   uint32_t          m_rwndScale;
+  bool              m_flowControl;         // Advertise the free receive buffer as window, with window scaling
+  bool              m_rcvBufAutoTuning;    // Grow the receive buffer to what the application reads per RTT
+  uint32_t          m_rcvBufMax;           // Autotuning limit of the receive buffer
   uint8_t           m_initialRand;
   bool              m_disjoinPath;
 
@@ -356,7 +418,29 @@ protected: // protected variables
   vector<Ptr<MpTcpSubFlow> > subflows;
   vector<MpTcpAddressInfo *> localAddrs;
   vector<MpTcpAddressInfo *> remoteAddrs;
-  list<DSNMapping *> unOrdered;  // buffer that hold the out of sequence received packet
+  DSNReassemblyQueue unOrdered;  // buffer that hold the out of sequence received packet
+
+  // Reassembly statistics (receiver side)
+  TracedValue<uint32_t> m_reorderDepth;        // Segments currently held in unOrdered
+  TracedCallback<uint32_t> m_drainBatchTrace;  // Segments delivered by one ReadUnOrderedData call
+  uint32_t m_maxReorderDepth;
+  uint32_t m_maxDrainBatch;
+
+  // Flow control (receiver side unless noted), see FlowControl
+  TracedValue<uint32_t> m_rcvBuf;  // Receive buffer the window is advertised from, in bytes
+  uint32_t m_rcvWnd;               // Window advertised last, in bytes
+  uint64_t m_rcvWndEdge;           // Right edge of that window, at connection level
+  bool m_wndScaling;               // Both ends sent the window scale option on the SYN of the master subflow
+  uint8_t m_rcvWndShift;           // Shift of the windows we advertise
+  uint8_t m_sndWndShift;           // Shift of the peer's windows (sender side)
+  bool m_rwndUpdated;              // The last segment received changed the window its subflow advertised (sender side)
+  Time m_rcvRtt;                   // RTT estimate from the time one window takes to arrive, as Linux measures it
+  uint64_t m_rcvRttSeq;            // nextRxSequence that ends the current window
+  Time m_rcvRttTime;               // When the current window started
+  uint64_t m_rcvCopied;            // Bytes read by the application
+  uint64_t m_rcvSpace;             // Most bytes read in one RTT so far
+  uint64_t m_rcvSpaceCopied;       // m_rcvCopied when the current RTT started
+  Time m_rcvSpaceTime;             // When the current RTT started
 
   // Congestion control
   double alpha;
@@ -364,8 +448,11 @@ protected: // protected variables
   double _e;
 
   uint32_t totalCwnd;
+  CoupledWindowAggregate m_coupled; // Per connection sums and max of the coupled increase formulas
   CongestionCtrl_t AlgoCC;       // Algorithm for Congestion Control
+  Ptr<MpTcpCongestionOps> m_congestionOps; // Its implementation, unless replaced by the CongestionOps attribute
   DataDistribAlgo_t distribAlgo; // Algorithm for Data Distribution
+  ReadySubflowSet m_readySubflows; // Subflows that may have spare window for SendPendingData
   PathManager_t pathManager;        // Mechanism for subflow establishement
 
   // Window management variables
@@ -36,7 +36,6 @@ MpTcpSubFlow::MpTcpSubFlow() :
     dAddr(Ipv4Address::GetZero()),
     dPort(0),
     oif(0),
-    mapDSN(0),
     lastMeasuredRtt(Seconds(0.0))
 {
   connected = false;
@@ -74,6 +73,16 @@ MpTcpSubFlow::MpTcpSubFlow() :
   m_ssThreshLastChange = Simulator::Now(); // means zero somehow...
 //  m_EcnState = NO_ECN;
   m_EcnEchoSeq = 0;
+  m_delAckCount = 0;
+  m_rxGap = false;
+  m_ceState = false;
+  m_echoSegments = 0;
+  m_echoMarked = 0;
+  m_echoSuper = false;
+  m_tsRecent = 0;
+  m_tsLastAck = 0;
+  m_peerWnd = 0;
+  retxLazy = false;
 //  m_EcnTransition = false;
   dctcp_last_fraction = 0;
   dctcp_total = 0;
@@ -102,6 +111,7 @@ MpTcpSubFlow::MpTcpSubFlow() :
   m_incCum = 0.0;
   m_nECE = 0;
   m_cwrHighSeq = 0;
+  m_schedCredit = 0.0;
   totalSentByte = 0;
 
 //  DATA.push_back (make_pair (Simulator::Now ().GetSeconds (), 0));
@@ -133,11 +143,6 @@ MpTcpSubFlow::~MpTcpSubFlow()
   maxSeqNb = 0;
   m_highTxMark = 0;
   highestAck = 0;
-  for (list<DSNMapping *>::iterator it = mapDSN.begin(); it != mapDSN.end(); ++it)
-    {
-      DSNMapping * ptrDSN = *it;
-      delete ptrDSN;
-    }
   mapDSN.clear();
 }
 
@@ -158,10 +163,10 @@ void
 MpTcpSubFlow::CwndTracer(uint32_t oldval, uint32_t newval)
 {
   //NS_LOG_UNCOND("Subflow "<< routeId <<": Moving cwnd from " << oldval << " to " << newval);
-  cwndTracer.push_back(make_pair(Simulator::Now().GetSeconds(), newval));
-  sstTracer.push_back(make_pair(Simulator::Now().GetSeconds(), ssthresh));
-  rttTracer.push_back(make_pair(Simulator::Now().GetSeconds(), rtt->GetCurrentEstimate().GetMicroSeconds()));
-  rtoTracer.push_back(make_pair(Simulator::Now().GetSeconds(), rtt->RetransmitTimeout().GetMilliSeconds()));
+  cwndTracer.Add(Simulator::Now().GetSeconds(), newval);
+  sstTracer.Add(Simulator::Now().GetSeconds(), ssthresh);
+  rttTracer.Add(Simulator::Now().GetSeconds(), rtt->GetCurrentEstimate().GetMicroSeconds());
+  rtoTracer.Add(Simulator::Now().GetSeconds(), rtt->RetransmitTimeout().GetMilliSeconds());
 }
 
 void
@@ -171,19 +176,54 @@ MpTcpSubFlow::RateTracerSf(double &interval, bool &flowCompletionTime)
 //  sampledGoodput = sampledGoodput/1000000;
   double sampledGoodput = ((totalSentByte * 8) / interval);
   sampledGoodput = sampledGoodput/1000000;
-  rateTracerSf.push_back(make_pair(Simulator::Now().GetSeconds(), sampledGoodput));
+  rateTracerSf.Add(Simulator::Now().GetSeconds(), sampledGoodput);
 //  lastTxSeqNumer = TxSeqNumber;
   totalSentByte = 0;
   if (flowCompletionTime)
     nextRateEvent = Simulator::Schedule (Seconds (interval), &MpTcpSubFlow::RateTracerSf, this, interval, flowCompletionTime);
 }
 
+void
+MpTcpSubFlow::SetPlotBufferSize(uint32_t size)
+{
+  cwndTracer.SetMaxSize(size);
+  sstTracer.SetMaxSize(size);
+  rtoTracer.SetMaxSize(size);
+  rttTracer.SetMaxSize(size);
+  rateTracerSf.SetMaxSize(size);
+  ECN_ECHO.SetMaxSize(size);
+  ECN_CWND_CUT_POINT.SetMaxSize(size);
+  XMP_CWR1.SetMaxSize(size);
+  XMP_CWR2.SetMaxSize(size);
+  BEG.SetMaxSize(size);
+  DCTCP_ALPHA.SetMaxSize(size);
+  DCTCP_FRACTION.SetMaxSize(size);
+  DCTCP_ALPHA_RTT.SetMaxSize(size);
+  DCTCP_FRACTION_RTT.SetMaxSize(size);
+  ssthreshtrack.SetMaxSize(size);
+  CWNDtrack.SetMaxSize(size);
+  DATA.SetMaxSize(size);
+  ACK.SetMaxSize(size);
+  DROP.SetMaxSize(size);
+  RETRANSMIT.SetMaxSize(size);
+  DUPACK.SetMaxSize(size);
+  _ss.SetMaxSize(size);
+  _ca.SetMaxSize(size);
+  _FR_FA.SetMaxSize(size);
+  _FR_PA.SetMaxSize(size);
+  _FReTx.SetMaxSize(size);
+  _TimeOut.SetMaxSize(size);
+  _RTT.SetMaxSize(size);
+  _AvgRTT.SetMaxSize(size);
+  _RTO.SetMaxSize(size);
+}
+
 void
 MpTcpSubFlow::AddDSNMapping(uint8_t sFlowIdx, uint64_t dSeqNum, uint16_t dLvlLen, uint32_t sflowSeqNum, uint32_t ack/*,
     Ptr<Packet> pkt*/)
 {
   NS_LOG_FUNCTION_NOARGS();
-  mapDSN.push_back(new DSNMapping(sFlowIdx, dSeqNum, dLvlLen, sflowSeqNum, ack/*, pkt*/));
+  mapDSN.Add(sFlowIdx, dSeqNum, dLvlLen, sflowSeqNum, ack/*, pkt*/);
 }
 
 void
@@ -200,16 +240,6 @@ DSNMapping *
 MpTcpSubFlow::GetunAckPkt()
 {
   NS_LOG_FUNCTION(this);
-  DSNMapping * ptrDSN = 0;
-  for (list<DSNMapping *>::iterator it = mapDSN.begin(); it != mapDSN.end(); ++it)
-    {
-      DSNMapping * ptr = *it;
-      if (ptr->subflowSeqNumber == highestAck + 1)
-        {
-          ptrDSN = ptr;
-          break;
-        }
-    }
-  return ptrDSN;
+  return mapDSN.Find(highestAck + 1);
 }
 }
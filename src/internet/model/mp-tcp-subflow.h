@@ -45,6 +45,7 @@ public:
   bool Finished();
   DSNMapping *GetunAckPkt();
   void RateTracerSf(double &interval, bool &flowCompletionTime);
+  void SetPlotBufferSize(uint32_t size); // Bound every plot series to size samples
 
   uint16_t routeId;           // Subflow's ID
   bool connected;             // Subflow's connection status
@@ -55,9 +56,22 @@ public:
   uint16_t dPort;             // Destination port
   uint32_t oif;               // interface related to the subflow's sAddr
   EventId retxEvent;          // Retransmission timer
+  bool retxLazy;              // retxEvent is a lazy timer, which re-arms itself until retxDeadline
+  Time retxDeadline;          // Expiry of the lazy retransmission timer
   EventId m_lastAckEvent;     // Timer for last ACK
   EventId m_timewaitEvent;    // Timer for closing connection at sender side
   EventId nextRateEvent;
+  EventId m_delAckEvent;      // Delayed ACK / ACK coalescing timer
+  uint32_t m_delAckCount;     // In-order segments received since the last ACK
+  Time m_lastRxTime;          // Arrival of the last data segment, for ACK coalescing
+  bool m_rxGap;               // An out of order segment was received, ACK as soon as the hole is filled
+  bool m_ceState;             // CE mark of the last data segment received (DCTCP receiver state)
+  uint32_t m_echoSegments;    // Segments received since the last ACK, echoed once a super-segment is among them
+  uint32_t m_echoMarked;      // How many of them were marked CE
+  bool m_echoSuper;           // A super-segment was received since the last ACK
+  uint64_t m_tsRecent;        // TSval to echo in the next ACK (RFC 7323 TS.Recent), 0 if none
+  uint32_t m_tsLastAck;       // Ack number of the last ACK sent (RFC 7323 Last.ACK.sent)
+  uint32_t m_peerWnd;         // Last receive window advertised by the peer on this subflow
   uint32_t MSS;               // Maximum Segment Size
   uint32_t cnCount;           // Count of remaining connection retries
   uint32_t cnRetries;         // Number of connection retries before giving up
@@ -74,7 +88,7 @@ public:
   bool m_limitedTx;           // perform limited transmit
   uint32_t m_dupAckCount;     // DupACK counter
   Ipv4EndPoint* m_endPoint;   // L4 stack object
-  list<DSNMapping *> mapDSN;  // List of all sent packets
+  DSNMappingQueue mapDSN;     // All sent but unacked packets, ordered by subflow sequence number
   multiset<double> measuredRTT;
   Ptr<RttMeanDeviation> rtt;  // RTT calculator
   Time lastMeasuredRtt;       // Last measured RTT, used for plotting
@@ -104,6 +118,7 @@ public:
   bool curEcnState;
   uint32_t g_AckSeqNumber;
   double dctcp_last_fraction;
+  DctcpFixedPoint dctcp_fixed; // Used instead of the counters and alpha above with DctcpFixedPoint
   //XMP parameters
   uint32_t m_begSeq;
   Time     m_baseRTT; // min sample rtt observed
@@ -122,39 +137,41 @@ public:
   double   m_incCum;
   uint32_t m_nECE;
   SequenceNumber32 m_cwrHighSeq; // used to determine when to quit from cwr
+  // Rate_Weighted scheduler
+  double   m_schedCredit; // smooth weighted round robin credit, in bytes per us
 
-  //plotting
-  vector<pair<double, uint32_t> > cwndTracer;
-  vector<pair<double, uint32_t> > sstTracer;
-  vector<pair<double, double> > rtoTracer;
-  vector<pair<double, double> > rttTracer;
-  vector<pair<double, double> > rateTracerSf;
+  //plotting, each series is a bounded ring buffer (see PlotSeries)
+  PlotSeries<uint32_t> cwndTracer;
+  PlotSeries<uint32_t> sstTracer;
+  PlotSeries<double> rtoTracer;
+  PlotSeries<double> rttTracer;
+  PlotSeries<double> rateTracerSf;
 
-  vector<pair<double, double> > ECN_ECHO;
-  vector<pair<double, double> > ECN_CWND_CUT_POINT;
-  vector<pair<double, double> > XMP_CWR1;
-  vector<pair<double, double> > XMP_CWR2;
-  vector<pair<double, double> > BEG;
-  vector<pair<double, double> > DCTCP_ALPHA;
-  vector<pair<double, double> > DCTCP_FRACTION;
-  vector<pair<double, double> > DCTCP_ALPHA_RTT;
-  vector<pair<double, double> > DCTCP_FRACTION_RTT;
-  vector<pair<double, double> > ssthreshtrack;
-  vector<pair<double, double> > CWNDtrack;
-  vector<pair<double, uint32_t> > DATA;
-  vector<pair<double, uint32_t> > ACK;
-  vector<pair<double, uint32_t> > DROP;
-  vector<pair<double, uint32_t> > RETRANSMIT;
-  vector<pair<double, uint32_t> > DUPACK;
-  vector<pair<double, double> > _ss;
-  vector<pair<double, double> > _ca;
-  vector<pair<double, double> > _FR_FA;
-  vector<pair<double, double> > _FR_PA;
-  vector<pair<double, double> > _FReTx;
-  vector<pair<double, double> > _TimeOut;
-  vector<pair<double, double> > _RTT;
-  vector<pair<double, double> > _AvgRTT;
-  vector<pair<double, double> > _RTO;
+  PlotSeries<double> ECN_ECHO;
+  PlotSeries<double> ECN_CWND_CUT_POINT;
+  PlotSeries<double> XMP_CWR1;
+  PlotSeries<double> XMP_CWR2;
+  PlotSeries<double> BEG;
+  PlotSeries<double> DCTCP_ALPHA;
+  PlotSeries<double> DCTCP_FRACTION;
+  PlotSeries<double> DCTCP_ALPHA_RTT;
+  PlotSeries<double> DCTCP_FRACTION_RTT;
+  PlotSeries<double> ssthreshtrack;
+  PlotSeries<double> CWNDtrack;
+  PlotSeries<uint32_t> DATA;
+  PlotSeries<uint32_t> ACK;
+  PlotSeries<uint32_t> DROP;
+  PlotSeries<uint32_t> RETRANSMIT;
+  PlotSeries<uint32_t> DUPACK;
+  PlotSeries<double> _ss;
+  PlotSeries<double> _ca;
+  PlotSeries<double> _FR_FA;
+  PlotSeries<double> _FR_PA;
+  PlotSeries<double> _FReTx;
+  PlotSeries<double> _TimeOut;
+  PlotSeries<double> _RTT;
+  PlotSeries<double> _AvgRTT;
+  PlotSeries<double> _RTO;
 };
 
 }
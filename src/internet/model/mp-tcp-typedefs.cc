@@ -1,4 +1,5 @@
 #include <iostream>
+#include <cmath>
 #include "ns3/mp-tcp-typedefs.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
@@ -60,201 +61,335 @@ DSNMapping::operator <(const DSNMapping& rhs) const
   return this->dataSeqNumber < rhs.dataSeqNumber;
 }
 
-DataBuffer::DataBuffer()
+static const uint32_t DSN_POOL_BLOCK = 64;
+
+DSNMappingQueue::DSNMappingQueue() :
+    m_ring(DSN_POOL_BLOCK, (DSNMapping*) 0), m_head(0), m_count(0)
 {
-  bufMaxSize = 0;
 }
 
-DataBuffer::DataBuffer(uint32_t size)
+DSNMappingQueue::~DSNMappingQueue()
 {
-  bufMaxSize = size;
+  m_count = 0;
+  m_free.clear();
+  for (uint32_t i = 0; i < m_blocks.size(); i++)
+    delete[] m_blocks[i];
+  m_blocks.clear();
 }
 
-DataBuffer::~DataBuffer()
+DSNMapping*
+DSNMappingQueue::Add(uint8_t sFlowIdx, uint64_t dSeqNum, uint16_t dLvlLen, uint32_t sflowSeqNum, uint32_t ack)
 {
-  bufMaxSize = 0;
+  NS_ASSERT_MSG(m_count == 0 || Get(m_count - 1)->subflowSeqNumber < sflowSeqNum,
+      "DSNMappingQueue::Add -> mappings should be added in subflow sequence order");
+  if (m_free.empty())
+    {
+      DSNMapping *block = new DSNMapping[DSN_POOL_BLOCK];
+      m_blocks.push_back(block);
+      for (uint32_t i = 0; i < DSN_POOL_BLOCK; i++)
+        m_free.push_back(&block[i]);
+    }
+  if (m_count == m_ring.size())
+    Grow();
+  DSNMapping *ptrDSN = m_free.back();
+  m_free.pop_back();
+  *ptrDSN = DSNMapping(sFlowIdx, dSeqNum, dLvlLen, sflowSeqNum, ack);
+  m_ring[(m_head + m_count) & (m_ring.size() - 1)] = ptrDSN;
+  m_count++;
+  return ptrDSN;
+}
+
+void
+DSNMappingQueue::Grow()
+{
+  vector<DSNMapping*> ring(m_ring.size() * 2, (DSNMapping*) 0);
+  for (uint32_t i = 0; i < m_count; i++)
+    ring[i] = Get(i);
+  m_ring.swap(ring);
+  m_head = 0;
+}
+
+DSNMapping*
+DSNMappingQueue::Get(uint32_t index) const
+{
+  NS_ASSERT(index < m_count);
+  return m_ring[(m_head + index) & (m_ring.size() - 1)];
 }
+
 uint32_t
-DataBuffer::Add(uint32_t size)
+DSNMappingQueue::LowerBound(uint32_t sflowSeqNum) const
 {
-  // read data from buf and insert it into the DataBuffer instance
-  NS_LOG_FUNCTION (this << (int) size << (int) (bufMaxSize - (uint32_t) buffer.size()) );
-  uint32_t toWrite = std::min(size, (bufMaxSize - (uint32_t) buffer.size()));
-  if (buffer.empty() == true)
+  uint32_t low = 0;
+  uint32_t high = m_count;
+  while (low < high)
     {
-      NS_LOG_INFO("DataBuffer::Add -> buffer is empty !");
+      uint32_t mid = low + (high - low) / 2;
+      if (Get(mid)->subflowSeqNumber < sflowSeqNum)
+        low = mid + 1;
+      else
+        high = mid;
     }
-  else
+  return low;
+}
+
+DSNMapping*
+DSNMappingQueue::Find(uint32_t sflowSeqNum) const
+{
+  uint32_t index = LowerBound(sflowSeqNum);
+  if (index < m_count && Get(index)->subflowSeqNumber == sflowSeqNum)
+    return Get(index);
+  return 0;
+}
+
+DSNMapping*
+DSNMappingQueue::FindEndingAt(uint32_t sflowSeqNum) const
+{ // Mappings do not overlap, so the candidate is the last one starting before sflowSeqNum
+  uint32_t index = LowerBound(sflowSeqNum);
+  if (index == 0)
+    return 0;
+  DSNMapping *ptrDSN = Get(index - 1);
+  if (ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength == sflowSeqNum)
+    return ptrDSN;
+  return 0;
+}
+
+uint32_t
+DSNMappingQueue::DiscardUpTo(uint32_t ack)
+{
+  uint32_t discarded = 0;
+  while (m_count > 0)
     {
-      NS_LOG_INFO("DataBuffer::Add -> buffer was not empty !");
+      DSNMapping *ptrDSN = m_ring[m_head];
+      if (ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength > ack)
+        break;
+      m_free.push_back(ptrDSN);
+      m_ring[m_head] = 0;
+      m_head = (m_head + 1) & (m_ring.size() - 1);
+      m_count--;
+      discarded++;
     }
+  return discarded;
+}
 
-  uint32_t qty = 0;
+uint32_t
+DSNMappingQueue::size() const
+{
+  return m_count;
+}
 
-  while (qty < toWrite)
-    {
-      //buffer.push(buf[qty]);
-      buffer.push((uint8_t)qty);
-      qty++;
-    }NS_LOG_INFO("DataBuffer::Add -> amount of data = "<< qty);NS_LOG_INFO("DataBuffer::Add -> freeSpace Size = "<< (bufMaxSize - (uint32_t) buffer.size()) );
-  return qty;
+bool
+DSNMappingQueue::empty() const
+{
+  return (m_count == 0);
+}
+
+void
+DSNMappingQueue::clear()
+{
+  for (uint32_t i = 0; i < m_count; i++)
+    m_free.push_back(Get(i));
+  m_head = 0;
+  m_count = 0;
+}
+
+DSNReassemblyQueue::DSNReassemblyQueue() :
+    m_bytes(0)
+{
+}
+
+DSNReassemblyQueue::DSNReassemblyQueue(const DSNReassemblyQueue &queue) :
+    m_bytes(0)
+{
+  for (map<uint64_t, DSNMapping*>::const_iterator it = queue.m_byDsn.begin(); it != queue.m_byDsn.end(); ++it)
+    Insert(new DSNMapping(*it->second));
+}
+
+DSNReassemblyQueue::~DSNReassemblyQueue()
+{
+  clear();
+}
+
+bool
+DSNReassemblyQueue::Insert(DSNMapping *ptrDSN)
+{
+  NS_LOG_FUNCTION(this << ptrDSN->dataSeqNumber);
+  // Both indexes are checked first, so that a rejected mapping is left in neither
+  if (m_byDsn.count(ptrDSN->dataSeqNumber) > 0 || FindSubflowSeq(ptrDSN->subflowIndex, ptrDSN->subflowSeqNumber) != 0)
+    return false;
+  if (ptrDSN->subflowIndex >= m_bySubflow.size())
+    m_bySubflow.resize(ptrDSN->subflowIndex + 1);
+  m_byDsn[ptrDSN->dataSeqNumber] = ptrDSN;
+  m_bySubflow[ptrDSN->subflowIndex][ptrDSN->subflowSeqNumber] = ptrDSN;
+  m_bytes += ptrDSN->dataLevelLength;
+  return true;
+}
+
+DSNMapping*
+DSNReassemblyQueue::Front() const
+{
+  if (m_byDsn.empty())
+    return 0;
+  return m_byDsn.begin()->second;
+}
+
+void
+DSNReassemblyQueue::PopFront()
+{
+  NS_ASSERT(!m_byDsn.empty());
+  DSNMapping *ptrDSN = m_byDsn.begin()->second;
+  m_bySubflow[ptrDSN->subflowIndex].erase(ptrDSN->subflowSeqNumber);
+  m_byDsn.erase(m_byDsn.begin());
+  m_bytes -= ptrDSN->dataLevelLength;
+  delete ptrDSN;
+}
+
+DSNMapping*
+DSNReassemblyQueue::FindSubflowSeq(uint8_t sFlowIdx, uint32_t sflowSeqNum) const
+{
+  if (sFlowIdx >= m_bySubflow.size())
+    return 0;
+  map<uint32_t, DSNMapping*>::const_iterator it = m_bySubflow[sFlowIdx].find(sflowSeqNum);
+  if (it == m_bySubflow[sFlowIdx].end())
+    return 0;
+  return it->second;
+}
+
+bool
+DSNReassemblyQueue::HasSubflow(uint8_t sFlowIdx) const
+{
+  return (sFlowIdx < m_bySubflow.size() && !m_bySubflow[sFlowIdx].empty());
 }
 
-#ifdef OLD
 uint32_t
-DataBuffer::Add(uint8_t* buf, uint32_t size)
-{
-  // read data from buf and insert it into the DataBuffer instance
-  NS_LOG_FUNCTION (this << (int) size << (int) (bufMaxSize - (uint32_t) buffer.size()) );
-  uint32_t toWrite = std::min(size, (bufMaxSize - (uint32_t) buffer.size()));
-    if (buffer.empty() == true)
-      {
-        NS_LOG_INFO("DataBuffer::Add -> buffer is empty !");
-      }
-    else
-      {
-        NS_LOG_INFO("DataBuffer::Add -> buffer was not empty !");
-      }
-
-  uint32_t qty = 0;
-
-  while (qty < toWrite)
-    {
-      //buffer.push(buf[qty]);
-      buffer.push((uint8_t)qty);
-      qty++;
-    }NS_LOG_INFO("DataBuffer::Add -> amount of data = "<< qty);NS_LOG_INFO("DataBuffer::Add -> freeSpace Size = "<< (bufMaxSize - (uint32_t) buffer.size()) );
-  return qty;
+DSNReassemblyQueue::size() const
+{
+  return m_byDsn.size();
+}
+
+uint32_t
+DSNReassemblyQueue::bytes() const
+{
+  return m_bytes;
+}
+
+bool
+DSNReassemblyQueue::empty() const
+{
+  return m_byDsn.empty();
+}
+
+void
+DSNReassemblyQueue::clear()
+{
+  for (map<uint64_t, DSNMapping*>::iterator it = m_byDsn.begin(); it != m_byDsn.end(); ++it)
+    delete it->second;
+  m_byDsn.clear();
+  m_bySubflow.clear();
+  m_bytes = 0;
+}
+
+DataBuffer::DataBuffer() :
+    bufMaxSize(0), bufSize(0)
+{
 }
-#endif
 
+DataBuffer::DataBuffer(uint32_t size) :
+    bufMaxSize(size), bufSize(0)
+{
+}
+
+DataBuffer::~DataBuffer()
+{
+  bufMaxSize = 0;
+  bufSize = 0;
+}
 
 uint32_t
-DataBuffer::Retrieve(uint32_t size)
+DataBuffer::Add(uint32_t size)
 {
-  NS_LOG_FUNCTION (this << (int) size << (int) (bufMaxSize - (uint32_t) buffer.size()) );
-  uint32_t quantity = std::min(size, (uint32_t) buffer.size());
-  if (quantity == 0)
+  NS_LOG_FUNCTION (this << (int) size << (int) (bufMaxSize - bufSize) );
+  uint32_t toWrite = std::min(size, (bufMaxSize - bufSize));
+  if (toWrite == 0)
     {
-      NS_LOG_INFO("DataBuffer::Retrieve -> No data to read from buffer reception !");
+      NS_LOG_INFO("DataBuffer::Add -> buffer is full !");
       return 0;
     }
+  bufSize += toWrite;
+  NS_LOG_INFO("DataBuffer::Add -> amount of data = "<< toWrite);NS_LOG_INFO("DataBuffer::Add -> freeSpace Size = "<< (bufMaxSize - bufSize) );
+  return toWrite;
+}
 
-  for (uint32_t i = 0; i < quantity; i++)
+uint32_t
+DataBuffer::Retrieve(uint32_t size)
+{
+  NS_LOG_FUNCTION (this << (int) size << (int) (bufMaxSize - bufSize) );
+  uint32_t quantity = std::min(size, bufSize);
+  if (quantity == 0)
     {
-      //buf[i] = buffer.front();
-      buffer.pop();
+      NS_LOG_INFO("DataBuffer::Retrieve -> No data to read from buffer reception !");
+      return 0;
     }
-
-  NS_LOG_INFO("DataBuffer::Retrieve -> freeSpaceSize == "<< bufMaxSize - (uint32_t) buffer.size() );
+  bufSize -= quantity;
+  NS_LOG_INFO("DataBuffer::Retrieve -> freeSpaceSize == "<< bufMaxSize - bufSize );
   return quantity;
 }
 
-
-//uint32_t
-//DataBuffer::Retrieve(uint8_t* buf, uint32_t size)
-//{
-//  NS_LOG_FUNCTION (this << (int) size << (int) (bufMaxSize - (uint32_t) buffer.size()) );
-//  uint32_t quantity = std::min(size, (uint32_t) buffer.size());
-//  if (quantity == 0)
-//    {
-//      NS_LOG_INFO("DataBuffer::Retrieve -> No data to read from buffer reception !");
-//      return 0;
-//    }
-//
-//  for (uint32_t i = 0; i < quantity; i++)
-//    {
-//      buf[i] = buffer.front();
-//      buffer.pop();
-//    }
-//
-//  NS_LOG_INFO("DataBuffer::Retrieve -> freeSpaceSize == "<< bufMaxSize - (uint32_t) buffer.size() );
-//  return quantity;
-//}
-
 Ptr<Packet>
 DataBuffer::CreatePacket(uint32_t size)
 {
-  NS_LOG_FUNCTION (this << (int) size << (int) ( bufMaxSize - (uint32_t) buffer.size()) );
-  uint32_t quantity = std::min(size, (uint32_t) buffer.size());
+  NS_LOG_FUNCTION (this << (int) size << (int) ( bufMaxSize - bufSize) );
+  uint32_t quantity = std::min(size, bufSize);
   if (quantity == 0)
     {
       NS_LOG_INFO("DataBuffer::CreatePacket -> No data ready for sending !");
       return 0;
     }
-  // Copy from front of Buffer to a new uint8_t array pointer
-  //uint8_t *ptrBuffer = new uint8_t[quantity];
-  for (uint32_t i = 0; i < quantity; i++)
-    {
-      //ptrBuffer[i] = buffer.front();
-      buffer.pop();
-    }
-  // Create packet from a data pointer and its size
-  //Ptr<Packet> pkt = new Packet(ptrBuffer, quantity);
-  //Ptr<Packet> pkt = Create<Packet>(ptrBuffer, quantity);
   Ptr<Packet> pkt = Create<Packet>(quantity);
-  //delete[] ptrBuffer;
-  //ptrBuffer = 0; // MKS
-
-  NS_LOG_INFO("DataBuffer::CreatePacket -> freeSpaceSize == "<< bufMaxSize - (uint32_t) buffer.size() );
+  bufSize -= quantity;
+  NS_LOG_INFO("DataBuffer::CreatePacket -> freeSpaceSize == "<< bufMaxSize - bufSize );
   return pkt;
 }
 
 uint32_t
 DataBuffer::ReadPacket(Ptr<Packet> pkt, uint32_t dataLen)
 {
-  NS_LOG_FUNCTION (this << (int) (bufMaxSize - (uint32_t) buffer.size()) );
-
-  uint32_t toWrite = std::min(dataLen, (bufMaxSize - (uint32_t) buffer.size()));
-
-  //uint8_t *ptrBuffer = new uint8_t[toWrite];
-  //pkt->CopyData(ptrBuffer, toWrite);
-
-  for (uint32_t i = 0; i < toWrite; i++)
-    buffer.push(0);
-    //buffer.push(ptrBuffer[i]);
-
-  //delete[] ptrBuffer;
-  //ptrBuffer = 0; // MKS
-
+  NS_LOG_FUNCTION (this << (int) (bufMaxSize - bufSize) );
+  uint32_t toWrite = std::min(dataLen, (bufMaxSize - bufSize));
+  bufSize += toWrite;
   NS_LOG_INFO("DataBuffer::ReadPacket -> data   readed == "<< toWrite );
-  NS_LOG_INFO("DataBuffer::ReadPacket -> freeSpaceSize == "<< bufMaxSize - (uint32_t) buffer.size() );
+  NS_LOG_INFO("DataBuffer::ReadPacket -> freeSpaceSize == "<< bufMaxSize - bufSize );
   return toWrite;
 }
 
 uint32_t
 DataBuffer::PendingData()
 {
-  return ((uint32_t) buffer.size());
+  return bufSize;
 }
 
 bool
 DataBuffer::ClearBuffer()
 {
-  while (!buffer.empty())
-    {
-      buffer.pop();
-    }
-  NS_ASSERT(buffer.empty());
+  bufSize = 0;
   return true;
 }
 
 uint32_t
 DataBuffer::FreeSpaceSize()
 {
-  return (bufMaxSize - (uint32_t) buffer.size());
+  return (bufMaxSize - bufSize);
 }
 
 bool
 DataBuffer::Empty()
 {
-  return buffer.empty(); // ( freeSpaceSize == bufMaxSize );
+  return (bufSize == 0);
 }
 
 bool
 DataBuffer::Full()
 {
-  return (bufMaxSize == (uint32_t) buffer.size()); //( freeSpaceSize == 0 );
+  return (bufMaxSize == bufSize);
 }
 
 void
@@ -263,6 +398,313 @@ DataBuffer::SetBufferSize(uint32_t size)
   bufMaxSize = size;
 }
 
+ReadySubflowSet::ReadySubflowSet()
+{
+  for (uint32_t w = 0; w < WORDS; w++)
+    {
+      m_ready[w] = 0;
+      m_partial[w] = 0;
+    }
+}
+
+void
+ReadySubflowSet::MarkReady(uint8_t sFlowIdx)
+{
+  m_ready[sFlowIdx / 64] |= (uint64_t) 1 << (sFlowIdx % 64);
+  m_partial[sFlowIdx / 64] &= ~((uint64_t) 1 << (sFlowIdx % 64));
+}
+
+void
+ReadySubflowSet::MarkAllReady(uint32_t nSubflows)
+{
+  for (uint32_t i = 0; i < nSubflows; i++)
+    MarkReady(i);
+}
+
+void
+ReadySubflowSet::MarkBusy(uint8_t sFlowIdx, bool partial)
+{
+  uint64_t bit = (uint64_t) 1 << (sFlowIdx % 64);
+  m_ready[sFlowIdx / 64] &= ~bit;
+  if (partial)
+    m_partial[sFlowIdx / 64] |= bit;
+  else
+    m_partial[sFlowIdx / 64] &= ~bit;
+}
+
+bool
+ReadySubflowSet::IsReady(uint8_t sFlowIdx, bool withTail) const
+{
+  uint64_t word = m_ready[sFlowIdx / 64] | (withTail ? m_partial[sFlowIdx / 64] : 0);
+  return (word >> (sFlowIdx % 64)) & 1;
+}
+
+int
+ReadySubflowSet::FirstReady(uint32_t begin, uint32_t end, bool withTail) const
+{
+  while (begin < end)
+    {
+      uint32_t w = begin / 64;
+      uint64_t word = m_ready[w] | (withTail ? m_partial[w] : 0);
+      word &= ~(uint64_t) 0 << (begin % 64);
+      if (word != 0)
+        {
+          uint32_t i = w * 64 + __builtin_ctzll(word);
+          return i < end ? (int) i : -1;
+        }
+      begin = (w + 1) * 64;
+    }
+  return -1;
+}
+
+int
+ReadySubflowSet::Next(uint32_t from, uint32_t nSubflows, bool withTail) const
+{
+  int i = FirstReady(from, nSubflows, withTail);
+  if (i < 0)
+    i = FirstReady(0, from, withTail);
+  return i;
+}
+
+CoupledWindowAggregate::CoupledWindowAggregate() :
+    m_e(1), m_totalWindow(0), m_linkedSum(0), m_scaledSum(0), m_epsilonSum(0), m_linkedMax(0), m_scaledMax(0),
+    m_epsilonMax(0), m_linkedArgMax(0), m_scaledArgMax(0), m_epsilonArgMax(0)
+{
+}
+
+void
+CoupledWindowAggregate::AddSubflow()
+{
+  Terms terms = Terms();
+  m_terms.push_back(terms);
+  m_isDirty.push_back(0);
+  MarkDirty(m_terms.size() - 1);
+}
+
+uint32_t
+CoupledWindowAggregate::GetNSubflows() const
+{
+  return m_terms.size();
+}
+
+void
+CoupledWindowAggregate::MarkDirty(uint8_t sFlowIdx)
+{
+  NS_ASSERT(sFlowIdx < m_terms.size());
+  if (!m_isDirty[sFlowIdx])
+    {
+      m_isDirty[sFlowIdx] = 1;
+      m_dirty.push_back(sFlowIdx);
+    }
+}
+
+bool
+CoupledWindowAggregate::PopDirty(uint8_t &sFlowIdx)
+{
+  if (m_dirty.empty())
+    return false;
+  sFlowIdx = m_dirty.back();
+  m_dirty.pop_back();
+  m_isDirty[sFlowIdx] = 0;
+  return true;
+}
+
+void
+CoupledWindowAggregate::Update(uint8_t sFlowIdx, uint32_t cwnd, uint32_t window, uint32_t mss, Time rtt)
+{
+  NS_ASSERT(sFlowIdx < m_terms.size());
+  // Same terms, with the same integer truncations, as the loops these aggregates replace
+  double rttUs = rtt.GetMicroSeconds();
+  if (rttUs == 0)
+    rttUs = 1;
+  uint32_t rtt10Us = rtt.GetMicroSeconds() / 10;
+  if (rtt10Us == 0)
+    rtt10Us = 1;
+  uint32_t rttMs = rtt.GetMilliSeconds();
+  if (rttMs == 0)
+    rttMs = 1;
+
+  Terms &terms = m_terms[sFlowIdx];
+  Terms old = terms;
+  terms.window = window;
+  terms.linkedMax = cwnd / (rttUs * rttUs);
+  terms.linkedSum = cwnd / rttUs;
+  terms.scaledMax = (uint64_t) window * mss * mss / rtt10Us / rtt10Us;
+  terms.scaledSum = window * mss / rtt10Us;
+  terms.epsilonMax = pow(window, m_e / 2) / rttMs;
+  terms.epsilonSum = (double) window / rttMs;
+
+  m_totalWindow += (uint64_t) terms.window - old.window;
+  m_linkedSum += terms.linkedSum - old.linkedSum;
+  m_scaledSum += terms.scaledSum - old.scaledSum;
+  m_epsilonSum += terms.epsilonSum - old.epsilonSum;
+
+  bool rescan = false;
+  if (terms.linkedMax >= m_linkedMax)
+    {
+      m_linkedMax = terms.linkedMax;
+      m_linkedArgMax = sFlowIdx;
+    }
+  else if (m_linkedArgMax == sFlowIdx)
+    rescan = true;
+  if (terms.scaledMax >= m_scaledMax)
+    {
+      m_scaledMax = terms.scaledMax;
+      m_scaledArgMax = sFlowIdx;
+    }
+  else if (m_scaledArgMax == sFlowIdx)
+    rescan = true;
+  if (terms.epsilonMax >= m_epsilonMax)
+    {
+      m_epsilonMax = terms.epsilonMax;
+      m_epsilonArgMax = sFlowIdx;
+    }
+  else if (m_epsilonArgMax == sFlowIdx)
+    rescan = true;
+  if (rescan)
+    RescanMax();
+}
+
+void
+CoupledWindowAggregate::RescanMax()
+{
+  m_linkedMax = 0;
+  m_scaledMax = 0;
+  m_epsilonMax = 0;
+  for (uint32_t i = 0; i < m_terms.size(); i++)
+    {
+      if (m_terms[i].linkedMax >= m_linkedMax)
+        {
+          m_linkedMax = m_terms[i].linkedMax;
+          m_linkedArgMax = i;
+        }
+      if (m_terms[i].scaledMax >= m_scaledMax)
+        {
+          m_scaledMax = m_terms[i].scaledMax;
+          m_scaledArgMax = i;
+        }
+      if (m_terms[i].epsilonMax >= m_epsilonMax)
+        {
+          m_epsilonMax = m_terms[i].epsilonMax;
+          m_epsilonArgMax = i;
+        }
+    }
+}
+
+void
+CoupledWindowAggregate::SetEpsilon(double e)
+{
+  if (e == m_e)
+    return;
+  m_e = e;
+  for (uint32_t i = 0; i < m_terms.size(); i++)
+    MarkDirty(i);
+}
+
+uint64_t
+CoupledWindowAggregate::GetTotalWindow() const
+{
+  return m_totalWindow;
+}
+
+double
+CoupledWindowAggregate::GetLinkedMax() const
+{
+  return m_linkedMax;
+}
+
+double
+CoupledWindowAggregate::GetLinkedSum() const
+{
+  return m_linkedSum;
+}
+
+uint64_t
+CoupledWindowAggregate::GetScaledMax() const
+{
+  return m_scaledMax;
+}
+
+uint32_t
+CoupledWindowAggregate::GetScaledSum() const
+{
+  return m_scaledSum;
+}
+
+double
+CoupledWindowAggregate::GetEpsilonMax() const
+{
+  return m_epsilonMax;
+}
+
+double
+CoupledWindowAggregate::GetEpsilonSum() const
+{
+  return m_epsilonSum;
+}
+
+DctcpFixedPoint::DctcpFixedPoint() :
+    m_alpha(0), m_delivered(0), m_deliveredCe(0)
+{
+}
+
+void
+DctcpFixedPoint::Ack(uint32_t bytes, uint32_t ceBytes)
+{
+  m_delivered += bytes;
+  m_deliveredCe += ceBytes;
+}
+
+void
+DctcpFixedPoint::UpdateAlpha(uint32_t shiftG)
+{
+  uint32_t decay = m_alpha >> shiftG;
+  m_alpha -= (decay == 0 ? m_alpha : decay);
+  if (m_deliveredCe > 0)
+    {
+      uint64_t ce = (m_deliveredCe << (ALPHA_SHIFT - shiftG)) / std::max<uint64_t>(m_delivered, 1);
+      m_alpha = (uint32_t) std::min<uint64_t>(m_alpha + ce, MAX_ALPHA);
+    }
+  m_delivered = 0;
+  m_deliveredCe = 0;
+}
+
+void
+DctcpFixedPoint::SetAlphaToFraction()
+{
+  m_alpha = (uint32_t) std::min<uint64_t>((m_deliveredCe << ALPHA_SHIFT) / std::max<uint64_t>(m_delivered, 1), MAX_ALPHA);
+  m_delivered = 0;
+  m_deliveredCe = 0;
+}
+
+uint32_t
+DctcpFixedPoint::ReduceWindow(uint32_t cwnd) const
+{
+  return cwnd - (uint32_t)(((uint64_t) cwnd * m_alpha) >> (ALPHA_SHIFT + 1));
+}
+
+uint32_t
+DctcpFixedPoint::GetAlpha() const
+{
+  return m_alpha;
+}
+
+double
+DctcpFixedPoint::GetFraction() const
+{
+  return m_delivered > 0 ? (double) m_deliveredCe / m_delivered : 0.0;
+}
+
+bool
+DctcpFixedPoint::ShiftFromWeight(double g, uint32_t &shift)
+{
+  int exp;
+  if (std::frexp(g, &exp) != 0.5 || exp > 1 || exp < 1 - ALPHA_SHIFT)
+    return false;
+  shift = 1 - exp;
+  return true;
+}
+
 MpTcpAddressInfo::MpTcpAddressInfo() :
     addrID(0), ipv4Addr(Ipv4Address::GetZero()), mask(Ipv4Mask::GetZero())
 {
@@ -50,7 +50,10 @@ typedef enum
 
 typedef enum
 {
-  Round_Robin
+  Round_Robin,    // 0
+  Min_Rtt,        // 1 Lowest RTT estimate first
+  Rate_Weighted,  // 2 Segments in proportion to cwnd / RTT
+  Ecn_Aware       // 3 Least ECN marked subflow first, then round robin
 } DataDistribAlgo_t;
 
 typedef enum
@@ -60,15 +63,6 @@ typedef enum
   NdiffPorts
 } PathManager_t;
 
-typedef enum
-{
-  ECT_TAG,
-  CE_TAG,
-  ECE_TAG,
-  CP_TAG,
-  ECMP_TAG
-} PacketTag_t;
-
 //typedef enum
 //{
 //  NoPR_Algo,
@@ -104,6 +98,65 @@ public:
   //uint8_t *packet;
 };
 
+/*
+ * Subflow retransmission queue (mapDSN).
+ * Mappings are appended in subflow sequence order, so they are kept in a ring buffer sorted by subflowSeqNumber:
+ * lookups are binary searches and acknowledged mappings are discarded as a prefix. DSNMapping objects are taken
+ * from a free list, so a long-lived subflow stops allocating once its window has been reached.
+ */
+class DSNMappingQueue
+{
+public:
+  DSNMappingQueue();
+  ~DSNMappingQueue();
+  DSNMapping* Add(uint8_t sFlowIdx, uint64_t dSeqNum, uint16_t dLvlLen, uint32_t sflowSeqNum, uint32_t ack);
+  DSNMapping* Find(uint32_t sflowSeqNum) const;       // Mapping which starts at sflowSeqNum
+  DSNMapping* FindEndingAt(uint32_t sflowSeqNum) const; // Mapping which ends just before sflowSeqNum
+  DSNMapping* Get(uint32_t index) const;              // index 0 is the oldest unacked mapping
+  uint32_t DiscardUpTo(uint32_t ack);                 // Release mappings fully covered by ack
+  uint32_t size() const;
+  bool empty() const;
+  void clear();
+private:
+  DSNMappingQueue(const DSNMappingQueue &);
+  DSNMappingQueue& operator=(const DSNMappingQueue &);
+  uint32_t LowerBound(uint32_t sflowSeqNum) const;    // Index of first mapping with subflowSeqNumber >= sflowSeqNum
+  void Grow();
+  vector<DSNMapping*> m_ring;     // Capacity is always a power of two
+  uint32_t m_head;
+  uint32_t m_count;
+  vector<DSNMapping*> m_free;     // Recycled mappings
+  vector<DSNMapping*> m_blocks;   // Blocks of mappings owned by this queue
+};
+
+/*
+ * Connection level reassembly queue (unOrdered) for segments received out of order.
+ * Segments are indexed by data sequence number, which gives in-order drain and duplicate detection in O(log n),
+ * and by subflow sequence number per subflow, so a subflow's RxSeqNumber can be advanced without walking the queue.
+ * The queue owns the stored mappings.
+ */
+class DSNReassemblyQueue
+{
+public:
+  DSNReassemblyQueue();
+  DSNReassemblyQueue(const DSNReassemblyQueue &queue); // Deep copy, used when a listening socket is forked
+  ~DSNReassemblyQueue();
+  bool Insert(DSNMapping *ptrDSN);                  // Returns false if dataSeqNumber, or subflowSeqNumber on its subflow, is already stored
+  DSNMapping* Front() const;                        // Stored segment with the lowest dataSeqNumber
+  void PopFront();
+  DSNMapping* FindSubflowSeq(uint8_t sFlowIdx, uint32_t sflowSeqNum) const;
+  bool HasSubflow(uint8_t sFlowIdx) const;          // Is any segment of this subflow stored?
+  uint32_t size() const;
+  uint32_t bytes() const;                           // Data level bytes of the stored segments
+  bool empty() const;
+  void clear();
+private:
+  DSNReassemblyQueue& operator=(const DSNReassemblyQueue &);
+  uint32_t m_bytes;
+  map<uint64_t, DSNMapping*> m_byDsn;
+  vector<map<uint32_t, DSNMapping*> > m_bySubflow;  // Indexed by subflowIndex
+};
+
 class MpTcpAddressInfo
 {
 public:
@@ -114,14 +167,19 @@ public:
   Ipv4Mask mask;
 };
 
+/*
+ * Connection level send/receive buffer.
+ * The buffer is virtual: it only counts bytes, since packets carry zero-filled payload in our model,
+ * so every operation is O(1) regardless of segment size.
+ */
 class DataBuffer
 {
 public:
   DataBuffer();
   DataBuffer(uint32_t size);
   ~DataBuffer();
-  queue<uint8_t> buffer;
   uint32_t bufMaxSize;
+  uint32_t bufSize;               // Number of bytes currently held in the buffer
   //uint32_t Add(uint8_t* buf, uint32_t size);
   uint32_t Add(uint32_t size);
   //uint32_t Retrieve(uint8_t* buf, uint32_t size);
@@ -136,5 +194,161 @@ public:
   void SetBufferSize(uint32_t size);
 };
 
+/*
+ * Subflows SendPendingData may pick from. A subflow is marked ready when its window may have opened (new ACK,
+ * cwnd change, peer window update, retransmit timeout) and busy when the scheduler finds it without room for a
+ * segment, so subflows that stay cwnd limited are not polled again until something changes for them.
+ * A busy subflow with room for less than one segment is kept aside: it is still usable for the tail of the
+ * sending buffer (withTail), as AvailableWindow allows.
+ */
+class ReadySubflowSet
+{
+public:
+  ReadySubflowSet();
+  void MarkReady(uint8_t sFlowIdx);
+  void MarkAllReady(uint32_t nSubflows);
+  void MarkBusy(uint8_t sFlowIdx, bool partial); // partial: room for less than one segment
+  bool IsReady(uint8_t sFlowIdx, bool withTail) const;
+  int Next(uint32_t from, uint32_t nSubflows, bool withTail) const; // First ready at or after from, cyclically, -1 if none
+private:
+  int FirstReady(uint32_t begin, uint32_t end, bool withTail) const;
+  enum { WORDS = 4 };                 // 256 subflows, as many as a uint8_t index
+  uint64_t m_ready[WORDS];
+  uint64_t m_partial[WORDS];
+};
+
+/*
+ * Connection level aggregates of the coupled congestion controls: total window, and the max and sum terms of
+ * the RFC 6356 alpha (Linked_Increases, RTT_Compensator), of COUPLED_INC's a and of COUPLED_EPSILON's alpha.
+ * Each subflow contributes one set of terms computed from its cwnd, its window (ssthresh while in fast recovery)
+ * and its RTT estimate. Updating a subflow replaces its terms in the sums, so it costs O(1) whatever the number of
+ * subflows; a max is only rescanned when the subflow holding it shrinks.
+ * Updates are lazy: the socket marks a subflow dirty when one of its inputs changes, and updates the dirty
+ * subflows (PopDirty) before reading the aggregates.
+ */
+class CoupledWindowAggregate
+{
+public:
+  CoupledWindowAggregate();
+  void AddSubflow();                  // Next subflow index, dirty until its first Update
+  uint32_t GetNSubflows() const;
+  void MarkDirty(uint8_t sFlowIdx);
+  bool PopDirty(uint8_t &sFlowIdx);   // Returns false once every subflow is up to date
+  void Update(uint8_t sFlowIdx, uint32_t cwnd, uint32_t window, uint32_t mss, Time rtt);
+  void SetEpsilon(double e);          // Exponent of COUPLED_EPSILON, all subflows are dirty when it changes
+  uint64_t GetTotalWindow() const;    // Sum of window
+  double GetLinkedMax() const;        // Max of cwnd / rtt^2, rtt in us
+  double GetLinkedSum() const;        // Sum of cwnd / rtt, rtt in us
+  uint64_t GetScaledMax() const;      // Max of window * mss^2 / rtt^2, rtt in 10 us units
+  uint32_t GetScaledSum() const;      // Sum of window * mss / rtt, rtt in 10 us units
+  double GetEpsilonMax() const;       // Max of window^(e/2) / rtt, rtt in ms
+  double GetEpsilonSum() const;       // Sum of window / rtt, rtt in ms
+private:
+  struct Terms
+  {
+    uint32_t window;
+    double linkedMax;
+    double linkedSum;
+    uint64_t scaledMax;
+    uint32_t scaledSum;
+    double epsilonMax;
+    double epsilonSum;
+  };
+  void RescanMax();
+  vector<Terms> m_terms;              // Indexed by subflow index
+  vector<uint8_t> m_isDirty;          // Indexed by subflow index
+  vector<uint8_t> m_dirty;            // Dirty subflow indexes
+  double m_e;
+  uint64_t m_totalWindow;
+  double m_linkedSum;
+  uint32_t m_scaledSum;               // Wraps like the uint32_t sum it replaces
+  double m_epsilonSum;
+  double m_linkedMax;
+  uint64_t m_scaledMax;
+  double m_epsilonMax;
+  uint32_t m_linkedArgMax;            // Subflow holding each max
+  uint32_t m_scaledArgMax;
+  uint32_t m_epsilonArgMax;
+};
+
+/*
+ * Fixed-point DCTCP state of a subflow, as Linux tcp_dctcp.c keeps it: alpha scaled by 2^10, and the bytes
+ * delivered, and delivered with ECN echo, since the start of the observation window. Each ACK only adds to the
+ * two counters; alpha is updated once per window with the kernel rule
+ *   alpha -= min_not_zero(alpha, alpha >> g); alpha = min(alpha + (ce << (10 - g)) / delivered, 1024)
+ * where g is the shift of the EWMA weight (4 for 1/16). Alpha starts at 0, like the double version.
+ */
+class DctcpFixedPoint
+{
+public:
+  enum { ALPHA_SHIFT = 10, MAX_ALPHA = 1 << ALPHA_SHIFT };
+  DctcpFixedPoint();
+  void Ack(uint32_t bytes, uint32_t ceBytes);
+  void UpdateAlpha(uint32_t shiftG);  // Ends the observation window
+  void SetAlphaToFraction();          // Alpha becomes the marked fraction of the window, then ends it
+  uint32_t ReduceWindow(uint32_t cwnd) const; // cwnd * (1 - alpha / 2), rounded up like the kernel
+  uint32_t GetAlpha() const;          // Scaled by 2^10
+  double GetFraction() const;         // Marked fraction of the current window
+  static bool ShiftFromWeight(double g, uint32_t &shift); // Shift of a weight of 2^-shift, false if g is not one
+private:
+  uint32_t m_alpha;
+  uint64_t m_delivered;
+  uint64_t m_deliveredCe;
+};
+
+/*
+ * Time series of (time, value) samples used for plotting.
+ * Samples are kept in a ring buffer bounded to maxSize entries: once it is full every new sample overwrites
+ * the oldest one, so a long run only keeps the tail of each series. Iteration goes from oldest to newest.
+ */
+template <typename T>
+class PlotSeries
+{
+public:
+  typedef T value_type;
+  typedef pair<double, T> Sample;
+
+  class iterator
+  {
+  public:
+    iterator() : m_series(0), m_index(0) {}
+    const Sample& operator*() const { return m_series->Get(m_index); }
+    const Sample* operator->() const { return &m_series->Get(m_index); }
+    iterator& operator++() { m_index++; return *this; }
+    iterator operator++(int) { iterator tmp = *this; m_index++; return tmp; }
+    bool operator==(const iterator &it) const { return m_index == it.m_index; }
+    bool operator!=(const iterator &it) const { return m_index != it.m_index; }
+  private:
+    friend class PlotSeries<T>;
+    iterator(const PlotSeries<T> *series, uint32_t index) : m_series(series), m_index(index) {}
+    const PlotSeries<T> *m_series;
+    uint32_t m_index;
+  };
+
+  PlotSeries() : m_head(0), m_maxSize(65536) {}
+  void Add(double time, T value)
+  {
+    if (m_samples.size() < m_maxSize)
+      m_samples.push_back(Sample(time, value));
+    else if (m_maxSize > 0)
+      {
+        m_samples[m_head] = Sample(time, value);
+        m_head = (m_head + 1) % m_maxSize;
+      }
+  }
+  const Sample& Get(uint32_t i) const { return m_samples[(m_head + i) % m_samples.size()]; } // i-th oldest sample
+  void SetMaxSize(uint32_t maxSize) { clear(); m_maxSize = maxSize; } // Drops the stored samples
+  uint32_t GetMaxSize() const { return m_maxSize; }
+  iterator begin() const { return iterator(this, 0); }
+  iterator end() const { return iterator(this, m_samples.size()); }
+  uint32_t size() const { return m_samples.size(); }
+  bool empty() const { return m_samples.empty(); }
+  void clear() { m_samples.clear(); m_head = 0; }
+private:
+  vector<Sample> m_samples;
+  uint32_t m_head;      // Index of the oldest sample once the buffer has wrapped
+  uint32_t m_maxSize;
+};
+
 } //namespace ns3
 #endif //MP_TCP_TYPEDEFS_H
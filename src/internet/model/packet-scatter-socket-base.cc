@@ -8,6 +8,7 @@
   if (m_node) { std::clog << Simulator::Now ().GetSeconds () << " [node " << m_node->GetId () << "] "; }
 
 #include "ns3/packet-scatter-socket-base.h"
+#include "ns3/mp-tcp-congestion-ops.h"
 #include "tcp-l4-protocol.h"
 #include "ns3/log.h"
 #include "ns3/error-model.h"
@@ -62,7 +63,7 @@ PacketScatterSocketBase::~PacketScatterSocketBase()
 }
 
 void
-PacketScatterSocketBase::DoForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface)
+PacketScatterSocketBase::DoForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface, int sFlowIdx)
 {
   NS_LOG_FUNCTION(this); //
 
@@ -75,10 +76,6 @@ PacketScatterSocketBase::DoForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t
   Address fromAddress = InetSocketAddress(header.GetSource(), port);
   Address toAddress = InetSocketAddress(header.GetDestination(), m_endPoint->GetLocalPort());
 
-  m_localAddress = header.GetDestination();
-  m_remoteAddress = header.GetSource();
-  m_remotePort = port;
-
   // Peel off TCP header and do validity checking
   TcpHeader mptcpHeader;
   p->RemoveHeader(mptcpHeader);
@@ -86,14 +83,18 @@ PacketScatterSocketBase::DoForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t
   //DCTCP
   ExtractPacketTags(p);
 
-  m_localPort = mptcpHeader.GetDestinationPort();
-
   // Listening socket being dealt with here......
   if (subflows.size() == 0 && m_state == LISTEN)
     {
       NS_ASSERT(server && m_state == LISTEN);
       NS_LOG_UNCOND( this<< " Listening socket, it seems it need to be CLONED... " << mptcpHeader << " LocalTOken: " << localToken);
 
+      // The clone takes its connection 4-tuple from these
+      m_localAddress = header.GetDestination();
+      m_remoteAddress = header.GetSource();
+      m_remotePort = port;
+      m_localPort = mptcpHeader.GetDestinationPort();
+
       // Update the flow control window
       remoteRecvWnd = (uint32_t) mptcpHeader.GetWindowSize();
 
@@ -113,23 +114,21 @@ PacketScatterSocketBase::DoForwardUp(Ptr<Packet> p, Ipv4Header header, uint16_t
       return;
     }
 
-  int sFlowIdx;
-
   // PS: Re-directing PACKET-SCATTER to subflow[0] of receiver based on pScatter flag in OPT_DSN.
   if (IsPktScattered(mptcpHeader))
     {
       sFlowIdx = 0;
       NS_ASSERT(server);
       NS_ASSERT(subflows.size() >= 1);
-      NS_ASSERT(subflows[0]->sAddr == m_localAddress);
-      NS_ASSERT(subflows[0]->dAddr == m_remoteAddress);
-      NS_ASSERT(subflows[0]->sPort == m_localPort);
+      NS_ASSERT(subflows[0]->sAddr == header.GetDestination());
+      NS_ASSERT(subflows[0]->dAddr == header.GetSource());
+      NS_ASSERT(subflows[0]->sPort == mptcpHeader.GetDestinationPort());
       //NS_LOG_UNCOND("DoForwardUp() -> Incoming packet is packet-scatter! - this condition only executed in receiver side!");
     }
-  else
-    { // pScatter param of incoming packet is false (i.e., zero).
+  else if (sFlowIdx < 0)
+    { // pScatter param of incoming packet is false (i.e., zero), and the packet came through the connection endpoint.
       //NS_LOG_UNCOND("DoForwardUp() -> Packet seems MP-TCP and pScatter: " << m_packetScatter);
-      sFlowIdx = LookupSubflow(m_localAddress, m_localPort, m_remoteAddress, m_remotePort);
+      sFlowIdx = LookupSubflow(header.GetDestination(), mptcpHeader.GetDestinationPort(), header.GetSource(), port);
     }
 
   if (sFlowIdx != 0)
@@ -245,6 +244,7 @@ PacketScatterSocketBase::ProcessSynSent(uint8_t sFlowIdx, Ptr<Packet> packet, co
       Time estimate;
       estimate = Seconds(1.5);
       sFlow->rtt->SetCurrentEstimate(estimate);
+      SubflowWindowChanged(sFlowIdx);
 
       SendEmptyPacket(sFlowIdx, TcpHeader::ACK);
 
@@ -328,39 +328,25 @@ PacketScatterSocketBase::ReceivedAck(uint8_t sFlowIdx, Ptr<Packet> packet, const
   else if (ack <= sFlow->highestAck + 1)
     {
       NS_LOG_LOGIC ("This acknowlegment" << mptcpHeader.GetAckNumber () << "do not ack the latest data in subflow level");
-      list<DSNMapping *>::iterator current = sFlow->mapDSN.begin();
-      list<DSNMapping *>::iterator next = sFlow->mapDSN.begin();
-      while (current != sFlow->mapDSN.end())
-        {
-          ++next;
-          DSNMapping *ptrDSN = *current;
-          // All segments before ackSeqNum should be removed from the mapDSN list.
-          if (ptrDSN->subflowSeqNumber + ptrDSN->dataLevelLength <= ack)
-            { // Optional task ...
-              //next = sFlow->mapDSN.erase(current);
-              //delete ptrDSN;
-            }
-          // There is a sent segment with subflowSN equal to ack but the ack is smaller than already receveid acked!
-          else if ((ptrDSN->subflowSeqNumber == ack) && (ack < sFlow->highestAck + 1))
-            { // Case 1: Old ACK, ignored.
-              NS_LOG_WARN ("Ignored ack of " << mptcpHeader.GetAckNumber());
-              NS_ASSERT(3!=3);
-              break;
-            }
-          // There is a sent segment with requested SequenceNumber and ack is for first unacked byte!!
-          else if ((ptrDSN->subflowSeqNumber == ack) && (ack == sFlow->highestAck + 1))
-            { // Case 2: Potentially a duplicated ACK, so ack should be smaller than nextExpectedSN to send.
-              if (ack < sFlow->TxSeqNumber)
-                {
-                  //NS_LOG_ERROR(Simulator::Now().GetSeconds()<< " [" << m_node->GetId()<< "] Duplicated ack received for SeqgNb: " << ack << " DUPACKs: " << sFlow->m_dupAckCount + 1);
-                  DupAck(sFlowIdx, ptrDSN);
-                  break;
-                }
-              // otherwise, the ACK is precisely equal to the nextTxSequence
-              NS_ASSERT(ack <= sFlow->TxSeqNumber);
-              break;
-            }
-          current = next;
+      // Only the segment starting at ack can be duplicately acked; older segments are fully acked already.
+      DSNMapping *ptrDSN = sFlow->mapDSN.Find(ack);
+      if (ptrDSN == 0)
+        { // Nothing unacked starts at ack
+        }
+      // There is a sent segment with subflowSN equal to ack but the ack is smaller than already receveid acked!
+      else if (ack < sFlow->highestAck + 1)
+        { // Case 1: Old ACK, ignored.
+          NS_LOG_WARN ("Ignored ack of " << mptcpHeader.GetAckNumber());
+          NS_ASSERT(3 != 3);
+        }
+      // There is a sent segment with requested SequenceNumber and ack is for first unacked byte!!
+      else if (ack < sFlow->TxSeqNumber)
+        { // Case 2: Potentially a duplicated ACK, so ack should be smaller than nextExpectedSN to send.
+          DupAck(sFlowIdx, ptrDSN);
+        }
+      else
+        { // otherwise, the ACK is precisely equal to the nextTxSequence
+          NS_ASSERT(ack <= sFlow->TxSeqNumber);
         }
     }
   else if (ack > sFlow->highestAck + 1)
@@ -414,17 +400,15 @@ bool
 PacketScatterSocketBase::IsPktScattered(const TcpHeader &mptcpHeader)
 {
   NS_LOG_FUNCTION(this << mptcpHeader);
-  vector<TcpOptions*> mp_options = mptcpHeader.GetOptions();
-  TcpOptions *opt;
-  for (uint32_t j = 0; j < mp_options.size(); j++)
+  for (uint32_t j = 0; j < mptcpHeader.GetNOptions(); j++)
     {
-      opt = mp_options[j];
-      if ((opt->optName == OPT_DSN))
+      const TcpOptions &opt = mptcpHeader.GetOption(j);
+      if ((opt.optName == OPT_DSN))
         {
-          uint8_t pScatter = ((OptDataSeqMapping *) opt)->pScatter;
+          uint8_t pScatter = opt.dsn.pScatter;
           if (pScatter > 0)
             {
-              uint32_t token = ((OptDataSeqMapping *) opt)->receiverToken;
+              uint32_t token = opt.dsn.receiverToken;
               NS_ASSERT(token == localToken);
               return true;
             }
@@ -530,21 +514,15 @@ PacketScatterSocketBase::SendDataPacket(uint8_t sFlowIdx, uint32_t size, bool wi
 
   if (sFlow->maxSeqNb > sFlow->TxSeqNumber - 1)
     {
-      uint32_t IterNumber = 0;
-      for (list<DSNMapping *>::iterator it = sFlow->mapDSN.begin(); (it != sFlow->mapDSN.end() && guard == false); ++it)
-        { // Look for match a segment from subflow's buffer where it is matched with TxSeqNumber
-          IterNumber++;
-          DSNMapping * ptr = *it;
-          if (ptr->subflowSeqNumber == sFlow->TxSeqNumber)
-            {
-              ptrDSN = ptr;
-              //p = Create<Packet>(ptrDSN->packet, ptrDSN->dataLevelLength);
-              p = Create<Packet>(ptrDSN->dataLevelLength);
-              packetSize = ptrDSN->dataLevelLength;
-              guard = true;
-              NS_LOG_LOGIC(Simulator::Now().GetSeconds() <<" A segment matched from subflow buffer. Its size is "<< packetSize << " IterNumInMapDSN: " << IterNumber <<" maxSeqNb: " << sFlow->maxSeqNb << " TxSeqNb: " << sFlow->TxSeqNumber << " FastRecovery: " << sFlow->m_inFastRec << " SegNb: " << ptrDSN->subflowSeqNumber); //
-              break;
-            }
+      // Look for match a segment from subflow's buffer where it is matched with TxSeqNumber
+      ptrDSN = sFlow->mapDSN.Find(sFlow->TxSeqNumber);
+      if (ptrDSN != 0)
+        {
+          //p = Create<Packet>(ptrDSN->packet, ptrDSN->dataLevelLength);
+          p = Create<Packet>(ptrDSN->dataLevelLength);
+          packetSize = ptrDSN->dataLevelLength;
+          guard = true;
+          NS_LOG_LOGIC(Simulator::Now().GetSeconds() <<" A segment matched from subflow buffer. Its size is "<< packetSize <<" maxSeqNb: " << sFlow->maxSeqNb << " TxSeqNb: " << sFlow->TxSeqNumber << " FastRecovery: " << sFlow->m_inFastRec << " SegNb: " << ptrDSN->subflowSeqNumber); //
         }
       if (p == 0)
         {
@@ -942,6 +920,7 @@ PacketScatterSocketBase::Retransmit(uint8_t sFlowIdx)
   Ptr<MpTcpSubFlow> sFlow = subflows[sFlowIdx];
   sFlow->m_inFastRec = false;
   sFlow->ssthresh = std::max(2 * sFlow->MSS, BytesInFlight(sFlowIdx) / 2);
+  SubflowWindowChanged(sFlowIdx);
   sFlow->cwnd = sFlow->MSS;
   sFlow->TxSeqNumber = sFlow->highestAck + 1; // m_nextTxSequence = m_txBuffer.HeadSequence(); // Restart from highest Ack
 
@@ -26,6 +26,7 @@
 // Implements several variations of round trip time estimators
 
 #include <iostream>
+#include <algorithm>
 
 #include "rtt-estimator.h"
 #include "ns3/simulator.h"
@@ -125,7 +126,8 @@ RttHistory::RttHistory (const RttHistory& h)
 // Base class methods
 
 RttEstimator::RttEstimator ()
-  : m_next (1), m_history (),
+  : m_next (1), m_history (), m_historyHead (0), m_historySize (0),
+    m_historyOverlap (false),
     m_nSamples (0),
     m_multiplier (1),
 	m_g(0), m_marked(0), m_nonMarked(0), m_alpha(0)
@@ -144,7 +146,9 @@ RttEstimator::RttEstimator ()
 }
 
 RttEstimator::RttEstimator (const RttEstimator& c)
-  : Object (c), m_next (c.m_next), m_history (c.m_history), 
+  : Object (c), m_next (c.m_next), m_history (c.m_history),
+    m_historyHead (c.m_historyHead), m_historySize (c.m_historySize),
+    m_historyOverlap (c.m_historyOverlap),
     m_maxMultiplier (c.m_maxMultiplier), 
     m_initialEstimatedRtt (c.m_initialEstimatedRtt),
     m_currentEstimatedRtt (c.m_currentEstimatedRtt), m_minRto (c.m_minRto),
@@ -174,28 +178,83 @@ void RttEstimator::SentSeq (SequenceNumber32 seq, uint32_t size)
   // Note that a particular sequence has been sent
   if (seq == m_next)
     { // This is the next expected one, just log at end
-      m_history.push_back (RttHistory (seq, size, Simulator::Now (), m_marked, m_nonMarked));
+      if (m_historySize == m_history.size ())
+        { // Full, double the ring and unwrap it so the oldest entry comes first
+          RttHistory_t history;
+          history.reserve (std::max<size_t> (16, 2 * m_history.size ()));
+          for (uint32_t i = 0; i < m_historySize; ++i)
+            {
+              history.push_back (HistoryAt (i));
+            }
+          history.resize (std::max<size_t> (16, 2 * m_history.size ()), RttHistory (seq, 0, Time (), 0, 0));
+          m_history.swap (history);
+          m_historyHead = 0;
+        }
+      HistoryAt (m_historySize++) = RttHistory (seq, size, Simulator::Now (), m_marked, m_nonMarked);
       m_next = seq + SequenceNumber32 (size); // Update next expected
     }
   else
     { // This is a retransmit, find in list and mark as re-tx
-      for (RttHistory_t::iterator i = m_history.begin (); i != m_history.end (); ++i)
+      uint32_t idx = FindHistory (seq);
+      if (idx < m_historySize)
         {
-          if ((seq >= i->seq) && (seq < (i->seq + SequenceNumber32 (i->count))))
-            { // Found it
-              i->retx = true;
-              i->marked = m_marked;
-              i->nonMarked = m_nonMarked;
-              // One final test..be sure this re-tx does not extend "next"
-              if ((seq + SequenceNumber32 (size)) > m_next)
-                {
-                  m_next = seq + SequenceNumber32 (size);
-                  i->count = ((seq + SequenceNumber32 (size)) - i->seq); // And update count in hist
-                }
-              break;
+          RttHistory& h = HistoryAt (idx);
+          h.retx = true;
+          h.marked = m_marked;
+          h.nonMarked = m_nonMarked;
+          // One final test..be sure this re-tx does not extend "next"
+          if ((seq + SequenceNumber32 (size)) > m_next)
+            {
+              m_next = seq + SequenceNumber32 (size);
+              h.count = ((seq + SequenceNumber32 (size)) - h.seq); // And update count in hist
+              m_historyOverlap = m_historyOverlap || idx + 1 < m_historySize;
+            }
+        }
+    }
+}
+
+uint32_t
+RttEstimator::FindHistory (SequenceNumber32 seq)
+{
+  if (m_historySize == 0 || seq < HistoryAt (0).seq)
+    {
+      return m_historySize;
+    }
+  uint32_t idx = 0;
+  if (m_historyOverlap)
+    { // Entries may hold each other's sequence numbers, the first one wins
+      while (idx < m_historySize && seq >= HistoryAt (idx).seq + SequenceNumber32 (HistoryAt (idx).count))
+        {
+          ++idx;
+        }
+      return idx;
+    }
+  // Entries are back to back and mostly of one size, so the first guess usually holds
+  uint32_t count = HistoryAt (0).count;
+  idx = count ? std::min<uint32_t> ((uint32_t) (seq - HistoryAt (0).seq) / count, m_historySize - 1) : 0;
+  if (HistoryAt (idx).seq > seq || (idx + 1 < m_historySize && HistoryAt (idx + 1).seq <= seq))
+    { // Binary search for the last entry starting at or before seq
+      uint32_t lo = 0;
+      uint32_t hi = m_historySize;
+      while (hi - lo > 1)
+        {
+          uint32_t mid = lo + (hi - lo) / 2;
+          if (HistoryAt (mid).seq <= seq)
+            {
+              lo = mid;
+            }
+          else
+            {
+              hi = mid;
             }
         }
+      idx = lo;
     }
+  if (seq >= HistoryAt (idx).seq + SequenceNumber32 (HistoryAt (idx).count))
+    {
+      return m_historySize;
+    }
+  return idx;
 }
 
 /*
@@ -229,19 +288,18 @@ Time RttEstimator::AckSeq (SequenceNumber32 ackSeq, bool markedFlag)
 { 
   NS_LOG_FUNCTION (this << ackSeq);
   // An ack has been received, calculate rtt and log this measurement
-  // Note we use a linear search (O(n)) for this since for the common
-  // case the ack'ed packet will be at the head of the list
+  // The ack'ed packets are at the head of the ring, which is advanced
+  // once past all of them
   Time m = Seconds (0.0);
-  if (m_history.size () == 0) return (m);    // No pending history, just exit
+  if (m_historySize == 0) return (m);    // No pending history, just exit
 
-  bool updatedRtt = false;
   double delta_marked;
   double delta_unmarked;
   double f;
-  // Now delete all ack history with seq <= ack
-  while(m_history.size () > 0)
+  uint32_t acked = 0;
+  for (; acked < m_historySize; ++acked)
     {
-      RttHistory& h = m_history.front ();
+      RttHistory& h = HistoryAt (acked);
       if ((h.seq + SequenceNumber32 (h.count)) > ackSeq) break;               // Done removing
 
       if (markedFlag)
@@ -253,15 +311,11 @@ Time RttEstimator::AckSeq (SequenceNumber32 ackSeq, bool markedFlag)
           m_nonMarked++;
         }
 
-      if (!updatedRtt)
+      if (acked == 0 && !h.retx)
         { // Ok to use this sample
-          updatedRtt = true;
-          if (!h.retx)
-            {
-              m = Simulator::Now () - h.time; // Elapsed time
-              Measurement (m);                // Log the measurement
-              ResetMultiplier ();             // Reset multiplier on valid measurement
-            }
+          m = Simulator::Now () - h.time; // Elapsed time
+          Measurement (m);                // Log the measurement
+          ResetMultiplier ();             // Reset multiplier on valid measurement
         }
       delta_marked = m_marked - h.marked;
       delta_unmarked = m_nonMarked - h.nonMarked;
@@ -270,8 +324,23 @@ Time RttEstimator::AckSeq (SequenceNumber32 ackSeq, bool markedFlag)
       f = delta_marked ? delta_marked / (delta_unmarked + delta_marked) : 0;
       m_fracMarkPkt = f;	 // Just for debugging
       m_alpha = (1 - m_g) * m_alpha + m_g * f;
-      m_history.pop_front (); // Remove
     }
+  // Now delete all ack history with seq <= ack
+  m_historyHead = (m_historyHead + acked) & (m_history.size () - 1);
+  m_historySize -= acked;
+  if (m_historySize == 0)
+    {
+      m_historyOverlap = false;
+    }
+  return m;
+}
+
+Time RttEstimator::AckTimestamp (Time echoed)
+{
+  NS_LOG_FUNCTION (this << echoed);
+  Time m = Simulator::Now () - echoed;
+  Measurement (m);
+  ResetMultiplier ();
   return m;
 }
 
@@ -280,7 +349,9 @@ void RttEstimator::ClearSent ()
   NS_LOG_FUNCTION (this);
   // Clear all history entries
   m_next = 1;
-  m_history.clear ();
+  m_historyHead = 0;
+  m_historySize = 0;
+  m_historyOverlap = false;
 }
 
 void RttEstimator::IncreaseMultiplier ()
@@ -302,7 +373,9 @@ void RttEstimator::Reset ()
   // Reset to initial state
   m_next = 1;
   m_currentEstimatedRtt = m_initialEstimatedRtt;
-  m_history.clear ();         // Remove all info from the history
+  m_historyHead = 0;          // Remove all info from the history
+  m_historySize = 0;
+  m_historyOverlap = false;
   m_nSamples = 0;
   ResetMultiplier ();
 }
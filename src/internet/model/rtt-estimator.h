@@ -25,7 +25,7 @@
 #ifndef RTT_ESTIMATOR_H
 #define RTT_ESTIMATOR_H
 
-#include <deque>
+#include <vector>
 #include "ns3/sequence-number.h"
 #include "ns3/nstime.h"
 #include "ns3/object.h"
@@ -60,8 +60,8 @@ public:
   bool            retx;   //!< True if this has been retransmitted
 };
 
-/// Container for RttHistory objects
-typedef std::deque<RttHistory> RttHistory_t;
+/// Container for RttHistory objects, used as a ring buffer by RttEstimator
+typedef std::vector<RttHistory> RttHistory_t;
 
 /**
  * \ingroup tcp
@@ -101,6 +101,15 @@ public:
    */
   virtual Time AckSeq (SequenceNumber32 ackSeq, bool markedFlag = false);
 
+  /**
+   * \brief Note that an ack echoed the timestamp of a segment (RFC 7323)
+   *
+   * Needs no history, so it may be used instead of SentSeq and AckSeq.
+   * \param echoed the send time echoed back in the TSecr field.
+   * \return The measured RTT.
+   */
+  virtual Time AckTimestamp (Time echoed);
+
   /**
    * \brief Clear all history entries
    */
@@ -182,8 +191,27 @@ public:
   
   void Init(SequenceNumber32 s) {m_next = s;} // It will be used by mptcp module
 private:
+  /**
+   * \brief Get a history entry
+   * \param i the entry position, 0 being the oldest one
+   * \return the entry
+   */
+  RttHistory& HistoryAt (uint32_t i)
+  {
+    return m_history[(m_historyHead + i) & (m_history.size () - 1)];
+  }
+  /**
+   * \brief Find the first history entry holding a sequence number
+   * \param seq the sequence number
+   * \return the entry position, or the number of entries if none holds seq
+   */
+  uint32_t FindHistory (SequenceNumber32 seq);
+
   SequenceNumber32 m_next;    //!< Next expected sequence to be sent
-  RttHistory_t m_history;     //!< List of sent packet
+  RttHistory_t m_history;     //!< Sent packets, a ring buffer whose size is a power of two
+  uint32_t m_historyHead;     //!< Position of the oldest entry in m_history
+  uint32_t m_historySize;     //!< Number of entries in m_history
+  bool m_historyOverlap;      //!< A retransmission extended an entry over the ones after it
   uint16_t m_maxMultiplier;   //!< Maximum RTO Multiplier
   Time m_initialEstimatedRtt; //!< Initial RTT estimation
 
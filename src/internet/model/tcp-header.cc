@@ -33,9 +33,11 @@ namespace ns3
 
 NS_OBJECT_ENSURE_REGISTERED(TcpHeader);
 
+const uint32_t TcpHeader::MAX_OPTIONS;
+
 TcpHeader::TcpHeader() :
     m_sourcePort(0), m_destinationPort(0), m_sequenceNumber(0), m_ackNumber(0), m_length(5), m_flags(0), m_windowSize(0xffff), m_urgentPointer(
-        0), m_calcChecksum(false), m_goodChecksum(true), m_option(0), oLen(0), pLen(0), original(true)
+        0), m_calcChecksum(false), m_goodChecksum(true), m_nOptions(0), oLen(0), pLen(0)
 {
 }
 
@@ -306,72 +308,61 @@ TcpHeader::Print(std::ostream &os) const
     }
   os << " Seq=" << GetSequenceNumber() << " Ack=" << GetAckNumber() << " Win=" << GetWindowSize();
 
-  for (uint32_t j = 0; j < m_option.size(); j++)
+  for (uint32_t j = 0; j < m_nOptions; j++)
     {
       os << " {";
-      TcpOptions *opt = m_option[j];
-      OptMultipathCapable *optMPC;
-      //OptJoinConnection *optJOIN;
-      //OptAddAddress *optADDR;
-      //OptRemoveAddress *optREMADR;
-      OptDataSeqMapping *optDSN;
-      //OptTimesTamp *optTT;
-
-      //os << opt->optName;
+      const TcpOptions &opt = m_option[j];
 
-      if (opt->optName == OPT_MPC)
+      if (opt.optName == OPT_MPC)
         {
           os << "OPT_MPC(";
-          optMPC = (OptMultipathCapable *) opt;
-          os << optMPC->senderToken << ")";
+          os << opt.mpc.senderToken << ")";
         }
-      else if (opt->optName == OPT_JOIN)
+      else if (opt.optName == OPT_JOIN)
         {
           os << "OPT_JOIN";
-//          optJOIN = (OptJoinConnection *) opt;
-//          os << optJOIN->receiverToken;
-//          os << optJOIN->addrID;
+//          os << opt.join.receiverToken;
+//          os << opt.join.addrID;
         }
-      else if (opt->optName == OPT_ADDR)
+      else if (opt.optName == OPT_ADDR)
         {
           os << "OPT_ADDR";
-//          optADDR = (OptAddAddress *) opt;
-//          os << optADDR->addrID;
-//          optADDR->addr.Print(os);
+//          os << opt.addAddr.addrID;
+//          opt.addAddr.GetAddress().Print(os);
         }
-      else if (opt->optName == OPT_REMADR)
+      else if (opt.optName == OPT_REMADR)
         {
           os << "OPT_REMADR";
-//          optREMADR = (OptRemoveAddress *) opt;
-//          os << optREMADR->addrID;
+//          os << opt.remAddr.addrID;
         }
-      else if (opt->optName == OPT_DSN)
+      else if (opt.optName == OPT_DSN)
         {
           os << "OPT_DSN";
-          optDSN = (OptDataSeqMapping *) opt;
-          //os << optDSN->dataSeqNumber;
-          //os << optDSN->dataLevelLength;
-          //os << optDSN->subflowSeqNumber;
+          //os << opt.dsn.dataSeqNumber;
+          //os << opt.dsn.dataLevelLength;
+          //os << opt.dsn.subflowSeqNumber;
           os << " => ";
-          os << optDSN->receiverToken;
+          os << opt.dsn.receiverToken;
           os << " ";
-          os << (int)optDSN->pScatter;
+          os << (int)opt.dsn.pScatter;
         }
-      else if (opt->optName == OPT_TT)
+      else if (opt.optName == OPT_WS)
+        {
+          os << "OPT_WS(" << (int) opt.ws.shift << ")";
+        }
+      else if (opt.optName == OPT_TT)
         {
           os << "OPT_TT";
-//          optTT = (OptTimesTamp *) opt;
-//          os << optTT->TSval;
-//          os << optTT->TSecr;
+//          os << opt.tt.TSval;
+//          os << opt.tt.TSecr;
         }
-      else if (opt->optName == OPT_DSACK)
+      else if (opt.optName == OPT_DSACK)
         {
           os << "OPT_DSACK";
-//          OptDSACK* optDSACK = (OptDSACK *) opt;
-//          os << optDSACK->blocks[0]; // left Edge  of the first block
-//          os << optDSACK->blocks[1]; // right Edge of the first block
-//          os << optDSACK->blocks[2]; // left Edge  of the second block
-//          os << optDSACK->blocks[3]; // right Edge of the second block
+//          os << opt.dsack.blocks[0]; // left Edge  of the first block
+//          os << opt.dsack.blocks[1]; // right Edge of the first block
+//          os << opt.dsack.blocks[2]; // left Edge  of the second block
+//          os << opt.dsack.blocks[3]; // right Edge of the second block
         }
       os << "}";
     }
@@ -431,64 +422,52 @@ TcpHeader::Serialize(Buffer::Iterator start) const
     }
 
   // write options in head
-  for (uint32_t j = 0; j < m_option.size(); j++)
+  for (uint32_t j = 0; j < m_nOptions; j++)
     {
-      TcpOptions *opt = m_option[j];
-      OptMultipathCapable *optMPC;
-      OptJoinConnection *optJOIN;
-      OptAddAddress *optADDR;
-      OptRemoveAddress *optREMADR;
-      OptDataSeqMapping *optDSN;
-      OptTimesTamp *optTT;
-      i.WriteU8(TcpOptionToUint(opt->optName));
+      const TcpOptions &opt = m_option[j];
+      i.WriteU8(TcpOptionToUint(opt.optName));
 
-      if (opt->optName == OPT_MPC)
+      if (opt.optName == OPT_MPC)
+        {
+          i.WriteHtonU32(opt.mpc.senderToken);
+        }
+      else if (opt.optName == OPT_JOIN)
         {
-          optMPC = (OptMultipathCapable *) opt;
-          i.WriteHtonU32(optMPC->senderToken);
+          i.WriteHtonU32(opt.join.receiverToken);
+          i.WriteU8(opt.join.addrID);
         }
-      else if (opt->optName == OPT_JOIN)
+      else if (opt.optName == OPT_ADDR)
         {
-          optJOIN = (OptJoinConnection *) opt;
-          i.WriteHtonU32(optJOIN->receiverToken);
-          i.WriteU8(optJOIN->addrID);
+          i.WriteU8(opt.addAddr.addrID);
+          i.WriteHtonU32(opt.addAddr.addr);
         }
-      else if (opt->optName == OPT_ADDR)
+      else if (opt.optName == OPT_REMADR)
         {
-          optADDR = (OptAddAddress *) opt;
-          i.WriteU8(optADDR->addrID);
-          i.WriteHtonU32(optADDR->addr.Get());
+          i.WriteU8(opt.remAddr.addrID);
         }
-      else if (opt->optName == OPT_REMADR)
+      else if (opt.optName == OPT_DSN)
         {
-          optREMADR = (OptRemoveAddress *) opt;
-          i.WriteU8(optREMADR->addrID);
+          i.WriteU64(opt.dsn.dataSeqNumber);
+          i.WriteHtonU16(opt.dsn.dataLevelLength);
+          i.WriteHtonU32(opt.dsn.subflowSeqNumber);
+          i.WriteHtonU32(opt.dsn.receiverToken);
+          i.WriteU8(opt.dsn.pScatter);
         }
-      else if (opt->optName == OPT_DSN)
+      else if (opt.optName == OPT_WS) // Option Window Scale
         {
-          optDSN = (OptDataSeqMapping *) opt;
-          i.WriteU64(optDSN->dataSeqNumber);
-          i.WriteHtonU16(optDSN->dataLevelLength);
-          i.WriteHtonU32(optDSN->subflowSeqNumber);
-          i.WriteHtonU32(optDSN->receiverToken);
-          i.WriteU8(optDSN->pScatter);
+          i.WriteU8(opt.ws.shift);
         }
-      else if (opt->optName == OPT_TT) // Option TCP TimesTamp
+      else if (opt.optName == OPT_TT) // Option TCP TimesTamp
         {
-          optTT = (OptTimesTamp *) opt;
-          i.WriteU64(optTT->TSval);
-          i.WriteU64(optTT->TSecr);
+          i.WriteU64(opt.tt.TSval);
+          i.WriteU64(opt.tt.TSecr);
         }
-      else if (opt->optName == OPT_DSACK) // Option Duplicate SACK
+      else if (opt.optName == OPT_DSACK) // Option Duplicate SACK
         {
-          OptDSACK *dsak = (OptDSACK *) opt;
-          i.WriteU64(dsak->blocks[0]);  // left Edge  of the first block
-          i.WriteU64(dsak->blocks[1]);  // right Edge  of the first block
-          i.WriteU64(dsak->blocks[2]);  // left Edge  of the second block
-          i.WriteU64(dsak->blocks[3]);  // right Edge  of the second block
-//          NS_LOG_LOGIC(
-//              "Serialize -> fstLeft (" << dsak->blocks[0] << ") fstRight (" << dsak->blocks[1] << ") sndLeft (" << dsak->blocks[2]
-//                  << ") sndRight (" << dsak->blocks[3] << ")");
+          i.WriteU64(opt.dsack.blocks[0]);  // left Edge  of the first block
+          i.WriteU64(opt.dsack.blocks[1]);  // right Edge  of the first block
+          i.WriteU64(opt.dsack.blocks[2]);  // left Edge  of the second block
+          i.WriteU64(opt.dsack.blocks[3]);  // right Edge  of the second block
         }
     }
   for (int j = 0; j < (int) pLen; j++)
@@ -555,66 +534,68 @@ TcpHeader::Deserialize(Buffer::Iterator start)
     }
 
   // handle options field
+  m_nOptions = 0;
   while (!i.IsEnd() && hlen > 0)
     {
-      TcpOptions *opt;
       TcpOption_t kind = (TcpOption_t) i.ReadU8(); //TcpOption_t kind = UintToTcpOption(i.ReadU8());
+      if (kind != OPT_MPC && kind != OPT_JOIN && kind != OPT_ADDR && kind != OPT_REMADR && kind != OPT_DSN
+          && kind != OPT_WS && kind != OPT_TT && kind != OPT_DSACK)
+        {
+          // the rest are pending octets, so leave
+          hlen = 0;
+          break;
+        }
+      TcpOptions *added = AppendOption(kind);
+      if (added == 0)
+        {
+          // more options than a valid header can hold, leave the rest
+          break;
+        }
+      TcpOptions &opt = *added;
       if (kind == OPT_MPC)
         {
-          opt = new OptMultipathCapable(kind, i.ReadNtohU32());
-          plen = (plen + 5) % 4;
-          hlen -= 5;
+          opt.mpc.senderToken = i.ReadNtohU32();
         }
       else if (kind == OPT_JOIN)
         {
-          opt = new OptJoinConnection(kind, i.ReadNtohU32(), i.ReadU8());
-          plen = (plen + 6) % 4;
-          hlen -= 6;
+          opt.join.receiverToken = i.ReadNtohU32();
+          opt.join.addrID = i.ReadU8();
         }
       else if (kind == OPT_ADDR)
         {
-          opt = new OptAddAddress(kind, i.ReadU8(), Ipv4Address(i.ReadNtohU32()));
-          plen = (plen + 6) % 4;
-          hlen -= 6;
+          opt.addAddr.addrID = i.ReadU8();
+          opt.addAddr.addr = i.ReadNtohU32();
         }
       else if (kind == OPT_REMADR)
         {
-          opt = new OptRemoveAddress(kind, i.ReadU8());
-          plen = (plen + 2) % 4;
-          hlen -= 2;
+          opt.remAddr.addrID = i.ReadU8();
         }
       else if (kind == OPT_DSN)
         {
-          opt = new OptDataSeqMapping(kind, i.ReadU64(), i.ReadNtohU16(), i.ReadNtohU32(), i.ReadNtohU32(), i.ReadU8());
-          plen = (plen + 20) % 4; // plen = (plen + 15) % 4;
-          hlen -= 20; //hlen -= 15;
+          opt.dsn.dataSeqNumber = i.ReadU64();
+          opt.dsn.dataLevelLength = i.ReadNtohU16();
+          opt.dsn.subflowSeqNumber = i.ReadNtohU32();
+          opt.dsn.receiverToken = i.ReadNtohU32();
+          opt.dsn.pScatter = i.ReadU8();
         }
-      else if (kind == OPT_TT)
+      else if (kind == OPT_WS)
         {
-          opt = new OptTimesTamp(kind, i.ReadU64(), i.ReadU64());
-          plen = (plen + 17) % 4;
-          hlen -= 17;
+          opt.ws.shift = i.ReadU8();
         }
-      else if (kind == OPT_DSACK)
+      else if (kind == OPT_TT)
         {
-          OptDSACK *dsak = new OptDSACK(kind);
-          uint64_t fstLeft = i.ReadU64(), fstRight = i.ReadU64();
-          uint64_t sndLeft = i.ReadU64(), sndRight = i.ReadU64();
-          dsak->AddfstBlock(fstLeft, fstRight);
-          dsak->AddBlock(sndLeft, sndRight);
-          opt = dsak;
-          plen = (plen + 33) % 4;
-          hlen -= 33;
+          opt.tt.TSval = i.ReadU64();
+          opt.tt.TSecr = i.ReadU64();
         }
-      else
+      else if (kind == OPT_DSACK)
         {
-          // the rest are pending octets, so leave
-          hlen = 0;
-          break;
+          for (uint32_t k = 0; k < 4; k++)
+            {
+              opt.dsack.blocks[k] = i.ReadU64();
+            }
         }
-
-      m_option.insert(m_option.end(), opt);
-
+      plen = (plen + opt.GetSerializedSize()) % 4;
+      hlen -= opt.GetSerializedSize();
     }
   //i.Next(plen);
   NS_LOG_INFO("TcpHeader::Deserialize leaving this method plen" << plen);
@@ -629,51 +610,40 @@ TcpHeader::SetOptionsLength(uint8_t length)
   oLen = length;
 }
 
-vector<TcpOptions*>
-TcpHeader::GetOptions(void) const
+uint32_t
+TcpHeader::GetNOptions(void) const
 {
-  return m_option;
+  return m_nOptions;
 }
 
-void
-TcpHeader::SetOptions(vector<TcpOptions*> opt)
+const TcpOptions &
+TcpHeader::GetOption(uint32_t i) const
 {
-  m_option = opt;
+  NS_ASSERT(i < m_nOptions);
+  return m_option[i];
+}
+
+TcpOptions *
+TcpHeader::AppendOption(TcpOption_t kind)
+{
+  if (m_nOptions == MAX_OPTIONS)
+    {
+      NS_LOG_WARN("TcpHeader holds at most " << MAX_OPTIONS << " options, option " << kind << " dropped");
+      return 0;
+    }
+  TcpOptions *opt = &m_option[m_nOptions++];
+  opt->optName = kind;
+  return opt;
 }
 
 uint8_t
 TcpHeader::GetOptionsLength() const
 {
   uint8_t length = 0;
-  TcpOptions *opt;
-
-  for (uint32_t j = 0; j < m_option.size(); j++)
+  for (uint32_t j = 0; j < m_nOptions; j++)
     {
-      opt = m_option[j];
-
-      if (opt->optName == OPT_MPC)
-        {
-          length += 5;
-        }
-      else if (opt->optName == OPT_JOIN)
-        {
-          length += 6;
-        }
-      else if (opt->optName == OPT_ADDR)
-        {
-          length += 6;
-        }
-      else if (opt->optName == OPT_REMADR)
-        {
-          length += 2;
-        }
-      else if (opt->optName == OPT_DSN)
-        {
-          //length += 15;
-          length += 20;
-        }
+      length += m_option[j].GetSerializedSize();
     }
-  //return oLen;
   return length;
 }
 
@@ -707,6 +677,8 @@ TcpHeader::TcpOptionToUint(TcpOption_t opt) const
     i = 34;
   else if (opt == OPT_DSACK)
     i = 5;
+  else if (opt == OPT_WS)
+    i = 3;
   else if (opt == OPT_NONE)
     i = 0;
   else if (opt == OPT_TT)
@@ -732,6 +704,8 @@ TcpHeader::UintToTcpOption(uint8_t kind) const
     i = OPT_DSN;
   else if (kind == 5)
     i = OPT_DSACK;
+  else if (kind == 3)
+    i = OPT_WS;
   else if (kind == 0)
     i = OPT_NONE;
   else if (kind == 8)
@@ -741,75 +715,22 @@ TcpHeader::UintToTcpOption(uint8_t kind) const
 }
 
 
-TcpHeader::TcpHeader(const TcpHeader &res)
+TcpHeader::TcpHeader(const TcpHeader &res) :
+    Header(res), m_sourcePort(res.m_sourcePort), m_destinationPort(res.m_destinationPort), m_sequenceNumber(
+        res.m_sequenceNumber), m_ackNumber(res.m_ackNumber), m_length(res.m_length), m_flags(res.m_flags), m_windowSize(
+        res.m_windowSize), m_urgentPointer(res.m_urgentPointer), m_source(res.m_source), m_destination(res.m_destination), m_protocol(
+        res.m_protocol), m_calcChecksum(res.m_calcChecksum), m_goodChecksum(res.m_goodChecksum), m_nOptions(res.m_nOptions), oLen(
+        res.GetOptionsLength()), pLen(res.pLen)
 {
-  //NS_LOG_FUNCTION_NOARGS();
-  SetSourcePort(res.GetSourcePort());
-  SetDestinationPort(res.GetDestinationPort());
-  SetFlags(res.GetFlags());
-  SetSequenceNumber(res.GetSequenceNumber());
-  SetAckNumber(res.GetAckNumber());
-  SetWindowSize(res.GetWindowSize());
-  //SetOptions         ( res.GetOptions () );
-  SetLength(res.GetLength());
-  SetOptionsLength(res.GetOptionsLength());
-  SetPaddingLength(res.GetPaddingLength());
-  SetOptions(res.GetOptions());
-  original = false;
+  // Only the options in use are copied
+  for (uint32_t i = 0; i < m_nOptions; i++)
+    {
+      m_option[i] = res.m_option[i];
+    }
 }
-/*
- TcpHeader
- TcpHeader::Copy()
- {
- TcpHeader l4Header;
- //NS_LOG_FUNCTION_NOARGS();
- l4Header.SetSourcePort(GetSourcePort());
- l4Header.SetDestinationPort(GetDestinationPort());
- l4Header.SetFlags(GetFlags());
- l4Header.SetSequenceNumber(GetSequenceNumber());
- l4Header.SetAckNumber(GetAckNumber());
- l4Header.SetWindowSize(GetWindowSize());
- l4Header.SetOptions(GetOptions());
- l4Header.SetLength(GetLength());
- l4Header.SetOptionsLength(GetOptionsLength());
- l4Header.SetPaddingLength(GetPaddingLength());
- return l4Header;
- }
- */
+
 TcpHeader::~TcpHeader()
 {
-  if (original == false)
-    return;
-  //NS_LOG_FUNCTION_NOARGS();
-  for (uint32_t i = 0; i < m_option.size(); i++)
-    {
-      if (m_option[i] != 0)
-        switch (m_option[i]->optName)
-          {
-        case OPT_MPC:
-          delete (OptMultipathCapable*) m_option[i];
-          break;
-        case OPT_JOIN:
-          delete (OptJoinConnection*) m_option[i];
-          break;
-        case OPT_ADDR:
-          delete (OptAddAddress*) m_option[i];
-          break;
-        case OPT_REMADR:
-          delete (OptRemoveAddress*) m_option[i];
-          break;
-        case OPT_DSN:
-          delete (OptDataSeqMapping*) m_option[i];
-          break;
-        case OPT_TT:
-          delete (OptTimesTamp*) m_option[i];
-          break;
-        default:
-          break;
-          }
-    }
-  m_option.clear();
-  oLen = 0;
 }
 
 bool
@@ -818,10 +739,10 @@ TcpHeader::AddOptMPC(TcpOption_t optName, uint32_t TxToken)
 //  NS_LOG_FUNCTION(this);
   if (optName == OPT_MPC)
     {
-      OptMultipathCapable* opt = new OptMultipathCapable(optName, TxToken);
-
-      m_option.insert(m_option.end(), opt);
-
+      TcpOptions *opt = AppendOption(optName);
+      if (opt == 0)
+        return false;
+      opt->mpc.senderToken = TxToken;
       return true;
     }
   return false;
@@ -833,9 +754,11 @@ TcpHeader::AddOptJOIN(TcpOption_t optName, uint32_t RxToken, uint8_t addrID)
 //  NS_LOG_FUNCTION(this);
   if (optName == OPT_JOIN)
     {
-      OptJoinConnection* opt = new OptJoinConnection(optName, RxToken, addrID);
-
-      m_option.insert(m_option.end(), opt);
+      TcpOptions *opt = AppendOption(optName);
+      if (opt == 0)
+        return false;
+      opt->join.receiverToken = RxToken;
+      opt->join.addrID = addrID;
       return true;
     }
   return false;
@@ -847,9 +770,11 @@ TcpHeader::AddOptADDR(TcpOption_t optName, uint8_t addrID, Ipv4Address addr)
 //  NS_LOG_FUNCTION(this);
   if (optName == OPT_ADDR)
     {
-      OptAddAddress* opt = new OptAddAddress(optName, addrID, addr);
-
-      m_option.insert(m_option.end(), opt);
+      TcpOptions *opt = AppendOption(optName);
+      if (opt == 0)
+        return false;
+      opt->addAddr.addrID = addrID;
+      opt->addAddr.addr = addr.Get();
       return true;
     }
   return false;
@@ -861,9 +786,10 @@ TcpHeader::AddOptREMADR(TcpOption_t optName, uint8_t addrID)
 //  NS_LOG_FUNCTION(this);
   if (optName == OPT_REMADR)
     {
-      OptRemoveAddress* opt = new OptRemoveAddress(optName, addrID);
-
-      m_option.insert(m_option.end(), opt);
+      TcpOptions *opt = AppendOption(optName);
+      if (opt == 0)
+        return false;
+      opt->remAddr.addrID = addrID;
       return true;
     }
   return false;
@@ -875,9 +801,14 @@ TcpHeader::AddOptDSN(TcpOption_t optName, uint64_t dSeqNum, uint16_t dLevelLengt
 //  NS_LOG_FUNCTION(this);
   if (optName == OPT_DSN)
     {
-      OptDataSeqMapping* opt = new OptDataSeqMapping(optName, dSeqNum, dLevelLength, sfSeqNum, rToken, pS);
-
-      m_option.insert(m_option.end(), opt);
+      TcpOptions *opt = AppendOption(optName);
+      if (opt == 0)
+        return false;
+      opt->dsn.dataSeqNumber = dSeqNum;
+      opt->dsn.dataLevelLength = dLevelLength;
+      opt->dsn.subflowSeqNumber = sfSeqNum;
+      opt->dsn.receiverToken = rToken;
+      opt->dsn.pScatter = pS;
       return true;
     }
   else
@@ -885,27 +816,47 @@ TcpHeader::AddOptDSN(TcpOption_t optName, uint64_t dSeqNum, uint16_t dLevelLengt
   return false;
 }
 
+bool
+TcpHeader::AddOptWS(TcpOption_t optName, uint8_t shift)
+{
+//  NS_LOG_FUNCTION(this);
+  if (optName == OPT_WS)
+    {
+      TcpOptions *opt = AppendOption(optName);
+      if (opt == 0)
+        return false;
+      opt->ws.shift = shift;
+      return true;
+    }
+  return false;
+}
+
 bool
 TcpHeader::AddOptTT(TcpOption_t optName, uint64_t tsval, uint64_t tsecr)
 {
 //  NS_LOG_FUNCTION(this);
   if (optName == OPT_TT)
     {
-      OptTimesTamp* opt = new OptTimesTamp(optName, tsval, tsecr);
-
-      m_option.insert(m_option.end(), opt);
+      TcpOptions *opt = AppendOption(optName);
+      if (opt == 0)
+        return false;
+      opt->tt.TSval = tsval;
+      opt->tt.TSecr = tsecr;
       return true;
     }
   return false;
 }
 
 bool
-TcpHeader::AddOptDSACK(TcpOption_t optName, OptDSACK *ptrDSAK)
+TcpHeader::AddOptDSACK(TcpOption_t optName, const OptDSACK &dsack)
 {
 //  NS_LOG_FUNCTION(this);
   if (optName == OPT_DSACK)
     {
-      m_option.insert(m_option.end(), ptrDSAK);
+      TcpOptions *opt = AppendOption(optName);
+      if (opt == 0)
+        return false;
+      opt->dsack = dsack;
       return true;
     }
   return false;
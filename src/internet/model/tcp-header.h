@@ -59,16 +59,30 @@ public:
   bool AddOptADDR(TcpOption_t optName, uint8_t addrID, Ipv4Address addr);// Add address Option
   bool AddOptDSN(TcpOption_t optName, uint64_t dSeqNum, uint16_t dLevelLength, uint32_t sfSeqNum , uint32_t rToken = 0, uint8_t pS = 0); // Data Sequence Mapping Option
   bool AddOptREMADR(TcpOption_t optName, uint8_t addrID);   // Remove address Option
+  bool AddOptWS(TcpOption_t optName, uint8_t shift); // Window Scale Option
   bool AddOptTT(TcpOption_t optName, uint64_t tsval, uint64_t tsecr); // TCP TimesTamp Option
-  bool AddOptDSACK(TcpOption_t optName, OptDSACK *opt); // DSACK Option
+  bool AddOptDSACK(TcpOption_t optName, const OptDSACK &opt); // DSACK Option
   void SetOptionsLength(uint8_t length);
   void SetPaddingLength(uint8_t length);
   uint8_t GetOptionsLength() const;
   uint8_t GetPaddingLength() const;
   uint8_t TcpOptionToUint(TcpOption_t opt) const;
   TcpOption_t UintToTcpOption(uint8_t kind) const;
-  vector<TcpOptions*> GetOptions(void) const;
-  void SetOptions(vector<TcpOptions*> opt);
+  /**
+   * \returns the number of options of this header
+   */
+  uint32_t GetNOptions(void) const;
+  /**
+   * \param i index of the option, lower than GetNOptions ()
+   * \returns the i-th option of this header, in header order
+   */
+  const TcpOptions & GetOption(uint32_t i) const;
+
+  /**
+   * Options a header can carry: 40 bytes of TCP options, the smallest
+   * options taking 2 bytes
+   */
+  static const uint32_t MAX_OPTIONS = 20;
   //--------------------------------------------
   /**
    * \brief Enable checksum calculation for TCP
@@ -252,6 +266,13 @@ private:
    */
   uint16_t
   CalculateHeaderChecksum(uint16_t size) const;
+  /**
+   * \param kind kind of the new option
+   * \returns the new option, appended to the options of this header, or
+   *          0 if the header already holds MAX_OPTIONS options
+   */
+  TcpOptions *
+  AppendOption(TcpOption_t kind);
   uint16_t m_sourcePort;        //!< Source port
   uint16_t m_destinationPort;   //!< Destination port
   SequenceNumber32 m_sequenceNumber;  //!< Sequence number
@@ -269,10 +290,10 @@ private:
   bool m_goodChecksum;    //!< Flag to indicate that checksum is correct
 
   // MPTCP related variables------------
-  vector<TcpOptions*> m_option;
+  TcpOptions m_option[MAX_OPTIONS]; //!< Options, the first m_nOptions are valid
+  uint8_t m_nOptions;
   uint8_t oLen;
   uint8_t pLen;
-  bool original;
   //------------------------------------
 };
 
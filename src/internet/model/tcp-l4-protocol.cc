@@ -358,21 +358,19 @@ TcpL4Protocol::Receive(Ptr<Packet> packet, Ipv4Header const &ipHeader, Ptr<Ipv4I
   //
   // MPTCP related modification----------------------------
   // Extract MPTCP options if there is any
-  vector<TcpOptions*> options = tcpHeader.GetOptions();
   uint8_t flags = tcpHeader.GetFlags();
   bool hasSyn = flags & TcpHeader::SYN;
-  TcpOptions *opt;
   uint32_t Token;
-  for (uint32_t j = 0; j < options.size(); j++)
+  for (uint32_t j = 0; j < tcpHeader.GetNOptions(); j++)
     {
-      opt = options[j];
-      if ((opt->optName == OPT_MPC) && hasSyn)
+      const TcpOptions &opt = tcpHeader.GetOption(j);
+      if ((opt.optName == OPT_MPC) && hasSyn)
         { // In this case the endpoint with destination port and token value of zero need to be find.
           NS_LOG_INFO("TcpL4Protocol::Receive -> OPT_MPC -> Do NOTTING");
         }
-      else if ((opt->optName == OPT_JOIN) && hasSyn)
+      else if ((opt.optName == OPT_JOIN) && hasSyn)
         { // In this case there should be endPoint with this token, so look for a match on all endpoints.
-          Token = ((OptJoinConnection *) opt)->receiverToken;
+          Token = opt.join.receiverToken;
           TokenMaps::iterator it;
           it = m_TokenMap.find(Token);
           if (it != m_TokenMap.end())
@@ -390,13 +388,13 @@ TcpL4Protocol::Receive(Ptr<Packet> packet, Ipv4Header const &ipHeader, Ptr<Ipv4I
                 }
             }
         }
-      else if (opt->optName == OPT_DSN)
+      else if (opt.optName == OPT_DSN)
         {
-          uint8_t pScatter = ((OptDataSeqMapping*) opt)->pScatter;
+          uint8_t pScatter = opt.dsn.pScatter;
           //NS_LOG_UNCOND("TcpL4Protocol received DSS! pScatter: " << (int)pScatter);
           if (pScatter > 0)
             {
-              Token = ((OptDataSeqMapping*) opt)->receiverToken;
+              Token = opt.dsn.receiverToken;
               if (Token == 0)
                 {
                   NS_LOG_UNCOND("*** ["<< m_node->GetId() << "] Token: " << Token << " pScatter: " << (int)pScatter);
@@ -422,7 +420,7 @@ TcpL4Protocol::Receive(Ptr<Packet> packet, Ipv4Header const &ipHeader, Ptr<Ipv4I
             }
           else
             { // If packet-scatter is disabled then Token should be zero too!
-              NS_ASSERT_MSG(((OptDataSeqMapping*) opt)->receiverToken == 0, "remoteToken: " << ((OptDataSeqMapping*) opt)->receiverToken << " pScatter: " << pScatter << " Header: " << tcpHeader);
+              NS_ASSERT_MSG(opt.dsn.receiverToken == 0, "remoteToken: " << opt.dsn.receiverToken << " pScatter: " << pScatter << " Header: " << tcpHeader);
             }
 
         }
@@ -2,7 +2,6 @@
 #define TCP_OPTIONS_H
 
 #include <stdint.h>
-#include <vector>
 #include "ns3/ipv4-address.h"
 
 
@@ -14,6 +13,7 @@ namespace ns3
 typedef enum
 {
   OPT_NONE = 0,
+  OPT_WS = 3,      // Window Scale
   OPT_DSACK = 5,
   OPT_TT = 8,      // Time Stamp
   OPT_MPC = 30,
@@ -23,91 +23,88 @@ typedef enum
   OPT_DSN = 34
 } TcpOption_t;
 
-class TcpOptions
-{
-public:
-  TcpOptions();
-  virtual
-  ~TcpOptions();
-
-  TcpOption_t optName;
-  uint8_t Length;
-};
+// Option payloads, stored by value in TcpOptions
 
-class OptMultipathCapable : public TcpOptions
+struct OptMultipathCapable
 {
-public:
-  virtual
-  ~OptMultipathCapable();
   uint32_t senderToken;
-  OptMultipathCapable(TcpOption_t oName, uint32_t TxToken);
 };
 
-class OptJoinConnection : public TcpOptions
+struct OptJoinConnection
 {
-public:
-  virtual
-  ~OptJoinConnection();
   uint32_t receiverToken;
   uint8_t addrID;
-  OptJoinConnection(TcpOption_t oName, uint32_t RxToken, uint8_t aID);
 };
 
-class OptAddAddress : public TcpOptions
+struct OptAddAddress
 {
-public:
-  virtual
-  ~OptAddAddress();
   uint8_t addrID;
-  Ipv4Address addr;
-  OptAddAddress(TcpOption_t oName, uint8_t aID, Ipv4Address address);
+  uint32_t addr;      // Ipv4Address in host order, see GetAddress ()
+
+  Ipv4Address
+  GetAddress() const;
 };
 
-class OptRemoveAddress : public TcpOptions
+struct OptRemoveAddress
 {
-public:
-  virtual
-  ~OptRemoveAddress();
   uint8_t addrID;
-  OptRemoveAddress(TcpOption_t oName, uint8_t aID);
 };
 
-class OptDataSeqMapping : public TcpOptions
+struct OptDataSeqMapping
 {
-public:
-  virtual
-  ~OptDataSeqMapping();
   uint64_t dataSeqNumber;
   uint16_t dataLevelLength;
   uint32_t subflowSeqNumber;
   uint32_t receiverToken;
   uint8_t pScatter;
-  OptDataSeqMapping(TcpOption_t oName, uint64_t dSeqNum, uint16_t dLevelLength, uint32_t sfSeqNum, uint32_t receiverToken, uint8_t pScatter);
 };
 
-class OptTimesTamp : public TcpOptions
+struct OptWindowScale
 {
-public:
-  virtual
-  ~OptTimesTamp();
-  uint64_t TSval;     // TS Value      in milliseconds
-  uint64_t TSecr;     // TS Echo Reply in milliseconds
+  uint8_t shift;      // The sender of the option shifts its windows by this many bits, RFC 7323
+};
+
+struct OptTimesTamp
+{
+  uint64_t TSval;     // TS Value      in nanoseconds
+  uint64_t TSecr;     // TS Echo Reply in nanoseconds
+};
 
-  OptTimesTamp(TcpOption_t oName, uint64_t tsval, uint64_t tsecr);
+struct OptDSACK
+{
+  // Edges of the two DSACK blocks: left and right edge of the first block,
+  // then of the second one
+  uint64_t blocks[4];
 };
 
-class OptDSACK : public TcpOptions
+/**
+ * \brief A TCP option, with the payload of its kind.
+ *
+ * optName tells which member of the union is valid. TcpHeader keeps its
+ * options by value in a fixed array of TcpOptions, so that building and
+ * parsing an MPTCP header does not allocate.
+ */
+class TcpOptions
 {
 public:
-  virtual
-  ~OptDSACK();
-  std::vector<uint64_t> blocks;     // a vector of 4-bytes fields, representing the DSACK block's edge
-  // the size of the vector is a multiple of 2 (a block has to limits, upper and lower) representing the length of the table
-  OptDSACK(TcpOption_t oName);
-  void
-  AddBlock(uint64_t leftEdge, uint64_t rightEdge);
-  void
-  AddfstBlock(uint64_t leftEdge, uint64_t rightEdge);
+  /**
+   * \returns the number of bytes of this option in the TCP header, kind included
+   */
+  uint8_t
+  GetSerializedSize() const;
+
+  TcpOption_t optName;
+  union
+  {
+    OptMultipathCapable mpc;
+    OptJoinConnection join;
+    OptAddAddress addAddr;
+    OptRemoveAddress remAddr;
+    OptDataSeqMapping dsn;
+    OptWindowScale ws;
+    OptTimesTamp tt;
+    OptDSACK dsack;
+  };
 };
 
 }
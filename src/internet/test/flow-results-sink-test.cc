@@ -0,0 +1,201 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/flow-results-sink.h"
+#include "ns3/log.h"
+#include <sstream>
+#include <fstream>
+#include <stdio.h>
+
+NS_LOG_COMPONENT_DEFINE ("FlowResultsSinkTestSuite");
+
+using namespace ns3;
+
+/**
+ * Rows written by a sink, possibly by several runs appending to the same
+ * file, should be read back in order with all their columns.
+ */
+class FlowResultsSinkTestCase : public TestCase
+{
+public:
+  FlowResultsSinkTestCase (FlowResultsSink::Format format, std::string name);
+
+private:
+  virtual void DoRun (void);
+  static FlowResult MakeResult (uint32_t i);
+
+  FlowResultsSink::Format m_format;
+};
+
+FlowResultsSinkTestCase::FlowResultsSinkTestCase (FlowResultsSink::Format format, std::string name)
+  : TestCase ("Flow results write and read back, " + name),
+    m_format (format)
+{
+}
+
+FlowResult
+FlowResultsSinkTestCase::MakeResult (uint32_t i)
+{
+  FlowResult r;
+  r.node = i % 16;
+  r.flowId = i;
+  r.flowType = (i % 3) ? "Short" : "Large";
+  r.flowLayer = "Foreground";
+  r.socket = (i % 5) ? "MPTCP" : "TCP, \"legacy\"";
+  r.goodput = 812.5 + i;
+  r.fct = 0.000125 * (i + 1);
+  r.timeOuts = i % 7;
+  r.subflows = 8;
+  r.typeId = "ns3::MpTcpSocketBase";
+  r.bytesSent = 5000000000ULL + i;
+  r.lastRtt = -1;
+  r.rtt = 250 + i;
+  r.cc = "XMP";
+  r.congestionExitHits = 1ULL << 40;
+  r.initGamma = 10;
+  return r;
+}
+
+void
+FlowResultsSinkTestCase::DoRun (void)
+{
+  std::ostringstream oss;
+  oss << "flow-results-" << m_format << ".data";
+  std::string fileName = CreateTempDirFilename (oss.str ());
+  remove (fileName.c_str ());
+
+  // Two runs appending to the same file, the first one with several row groups
+  const uint32_t rows[] = { 2500, 10 };
+  uint32_t total = 0;
+  for (uint32_t run = 0; run < 2; run++)
+    {
+      Ptr<FlowResultsSink> sink = CreateObject<FlowResultsSink> ();
+      sink->SetAttribute ("Format", EnumValue (m_format));
+      sink->SetAttribute ("RowGroupSize", UintegerValue (1000));
+      sink->Open (fileName);
+      for (uint32_t i = 0; i < rows[run]; i++)
+        {
+          sink->Write (MakeResult (total++));
+        }
+      sink->Flush ();
+      NS_TEST_ASSERT_MSG_EQ (sink->GetRowsWritten (), rows[run], "Flush should write every queued row");
+      sink->Close ();
+    }
+
+  FlowResultsReader reader;
+  NS_TEST_ASSERT_MSG_EQ (reader.Open (fileName), true, "Cannot open the results file");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetFormat (), m_format, "Wrong format detected");
+  NS_TEST_ASSERT_MSG_EQ (reader.GetColumnNames ().size (), FlowResultsSink::GetSchema ().size (), "Wrong number of columns");
+  FlowResult r;
+  for (uint32_t i = 0; i < total; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (reader.Read (r), true, "Missing row " << i);
+      FlowResult e = MakeResult (i);
+      NS_TEST_ASSERT_MSG_EQ (r.flowId, e.flowId, "Rows out of order");
+      NS_TEST_ASSERT_MSG_EQ (r.node, e.node, "Wrong node");
+      NS_TEST_ASSERT_MSG_EQ (r.flowType, e.flowType, "Wrong flow type");
+      NS_TEST_ASSERT_MSG_EQ (r.socket, e.socket, "Quoted string not read back");
+      NS_TEST_ASSERT_MSG_EQ_TOL (r.goodput, e.goodput, 1e-9, "Wrong goodput");
+      NS_TEST_ASSERT_MSG_EQ_TOL (r.fct, e.fct, 1e-12, "Wrong FCT");
+      NS_TEST_ASSERT_MSG_EQ (r.timeOuts, e.timeOuts, "Wrong timeouts");
+      NS_TEST_ASSERT_MSG_EQ (r.bytesSent, e.bytesSent, "Wrong 64 bit column");
+      NS_TEST_ASSERT_MSG_EQ (r.lastRtt, e.lastRtt, "Wrong signed column");
+      NS_TEST_ASSERT_MSG_EQ (r.rtt, e.rtt, "Wrong RTT");
+      NS_TEST_ASSERT_MSG_EQ (r.cc, e.cc, "Wrong congestion control");
+      NS_TEST_ASSERT_MSG_EQ (r.congestionExitHits, e.congestionExitHits, "Wrong 64 bit column");
+      NS_TEST_ASSERT_MSG_EQ (r.initGamma, e.initGamma, "Wrong last column");
+    }
+  NS_TEST_ASSERT_MSG_EQ (reader.Read (r), false, "Unexpected extra row");
+
+  // A row group cut short by a killed simulation ends the file cleanly
+  if (m_format == FlowResultsSink::BINARY)
+    {
+      std::ifstream in (fileName.c_str (), std::ios::in | std::ios::binary);
+      std::string data ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+      in.close ();
+      std::ofstream out (fileName.c_str (), std::ios::out | std::ios::trunc | std::ios::binary);
+      out.write (data.data (), data.size () - 10);
+      out.close ();
+      NS_TEST_ASSERT_MSG_EQ (reader.Open (fileName), true, "Cannot open the truncated file");
+      uint32_t n = 0;
+      while (reader.Read (r))
+        {
+          n++;
+        }
+      NS_TEST_ASSERT_MSG_EQ (n, 2500, "Only the complete row groups should be read");
+    }
+  remove (fileName.c_str ());
+}
+
+/**
+ * The text format should keep the bracket delimited records of the
+ * previous per flow writer.
+ */
+class FlowResultsSinkTextTestCase : public TestCase
+{
+public:
+  FlowResultsSinkTextTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FlowResultsSinkTextTestCase::FlowResultsSinkTextTestCase ()
+  : TestCase ("Flow results legacy text records")
+{
+}
+
+void
+FlowResultsSinkTextTestCase::DoRun (void)
+{
+  std::string fileName = CreateTempDirFilename ("flow-results-text.data");
+  remove (fileName.c_str ());
+  Ptr<FlowResultsSink> sink = CreateObject<FlowResultsSink> ();
+  sink->Open (fileName);
+  FlowResult r;
+  r.node = 3;
+  r.flowId = 7;
+  r.flowType = "Large";
+  r.goodput = 941.25;
+  r.cc = "XMP";
+  sink->Write (r);
+  sink->Close ();
+
+  std::ifstream in (fileName.c_str ());
+  std::string line;
+  NS_TEST_ASSERT_MSG_EQ (std::getline (in, line).good (), true, "Missing record");
+  NS_TEST_ASSERT_MSG_EQ (line.substr (0, 25), "[:3:][+7+][=Large=][??][|", "Wrong record prefix");
+  NS_TEST_ASSERT_MSG_NE (line.find ("[#941.25#]"), std::string::npos, "Wrong goodput field");
+  NS_TEST_ASSERT_MSG_NE (line.find ("[\xef\xbf\xbdXMP\xef\xbf\xbd]"), std::string::npos, "Wrong congestion control field");
+  NS_TEST_ASSERT_MSG_EQ (std::getline (in, line).good (), false, "Unexpected extra record");
+  remove (fileName.c_str ());
+}
+
+static class FlowResultsSinkTestSuite : public TestSuite
+{
+public:
+  FlowResultsSinkTestSuite ()
+    : TestSuite ("flow-results-sink", UNIT)
+  {
+    AddTestCase (new FlowResultsSinkTestCase (FlowResultsSink::CSV, "Csv"), TestCase::QUICK);
+    AddTestCase (new FlowResultsSinkTestCase (FlowResultsSink::BINARY, "Binary"), TestCase::QUICK);
+    AddTestCase (new FlowResultsSinkTextTestCase, TestCase::QUICK);
+  }
+} g_flowResultsSinkTestSuite;
@@ -0,0 +1,119 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-end-point-demux.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemuxTestSuite");
+
+using namespace ns3;
+
+/**
+ * The hashed demux should pick the same endpoints as the best-match rules
+ * it implements: full four-tuple, then any local address, then local
+ * address only, then local port only.
+ */
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Ipv4EndPointDemux best match through the hash indexes")
+{
+}
+
+void
+Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  Ipv4EndPointDemux demux;
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  Ipv4Address local ("10.0.0.1");
+  Ipv4Address peer ("10.0.0.2");
+
+  Ipv4EndPoint *listener = demux.Allocate (80);
+  Ipv4EndPoint *bound = demux.Allocate (local, 80);
+  Ipv4EndPoint *connected = demux.Allocate (local, 80, peer, 5000);
+  NS_TEST_ASSERT_MSG_NE (listener, 0, "Listener allocation failed");
+  NS_TEST_ASSERT_MSG_NE (bound, 0, "Bound listener allocation failed");
+  NS_TEST_ASSERT_MSG_NE (connected, 0, "Connected endpoint allocation failed");
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate (local, 80), 0, "Duplicate local address and port accepted");
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate (local, 80, peer, 5000), 0, "Duplicate four-tuple accepted");
+
+  Ipv4EndPointDemux::EndPoints found = demux.Lookup (local, 80, peer, 5000, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Exact match should win");
+  NS_TEST_ASSERT_MSG_EQ (found.front (), connected, "Wrong exact match");
+
+  found = demux.Lookup (local, 80, peer, 5001, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Local address match should win");
+  NS_TEST_ASSERT_MSG_EQ (found.front (), bound, "Wrong local address match");
+
+  found = demux.Lookup (Ipv4Address ("10.0.0.3"), 80, peer, 5000, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Wildcard listener should match");
+  NS_TEST_ASSERT_MSG_EQ (found.front (), listener, "Wrong wildcard match");
+
+  NS_TEST_ASSERT_MSG_EQ (demux.Lookup (local, 81, peer, 5000, interface).size (), 0, "No endpoint on port 81");
+
+  // A listener connected after allocation moves to its new four-tuple
+  listener->SetPeer (Ipv4Address ("10.0.0.4"), 6000);
+  found = demux.Lookup (Ipv4Address ("10.0.0.3"), 80, Ipv4Address ("10.0.0.4"), 6000, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Connected listener should match on all but local address");
+  NS_TEST_ASSERT_MSG_EQ (found.front (), listener, "Wrong reindexed endpoint");
+  NS_TEST_ASSERT_MSG_EQ (demux.Lookup (Ipv4Address ("10.0.0.3"), 80, peer, 5000, interface).size (), 0,
+                         "Connected listener should not match other peers");
+
+  // A limited broadcast reaches the endpoints bound to any address only
+  listener->SetPeer (Ipv4Address::GetAny (), 0);
+  found = demux.Lookup (Ipv4Address::GetBroadcast (), 80, peer, 5001, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.size (), 1, "Broadcast should reach the wildcard listener");
+  NS_TEST_ASSERT_MSG_EQ (found.front (), listener, "Wrong broadcast match");
+
+  NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (local, 80, peer, 5000), connected, "Wrong simple exact match");
+
+  demux.DeAllocate (connected);
+  found = demux.Lookup (local, 80, peer, 5000, interface);
+  NS_TEST_ASSERT_MSG_EQ (found.front (), bound, "Deallocated endpoint still found");
+  NS_TEST_ASSERT_MSG_EQ (demux.SimpleLookup (local, 80, peer, 5000), bound, "Wrong simple generic match");
+  demux.DeAllocate (bound);
+  demux.DeAllocate (listener);
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (80), false, "Port 80 should be free");
+  NS_TEST_ASSERT_MSG_EQ (demux.GetAllEndPoints ().size (), 0, "Endpoints left behind");
+
+  // Ephemeral ports count up and skip the ports in use
+  Ipv4EndPoint *fixed = demux.Allocate (49154);
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate ()->GetLocalPort (), 49153, "Wrong first ephemeral port");
+  NS_TEST_ASSERT_MSG_EQ (demux.Allocate ()->GetLocalPort (), 49155, "Port in use not skipped");
+  NS_TEST_ASSERT_MSG_EQ (fixed->GetLocalPort (), 49154, "Wrong fixed port");
+  NS_TEST_ASSERT_MSG_EQ (demux.GetAllEndPoints ().size (), 3, "Wrong number of endpoints");
+}
+
+static class Ipv4EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  Ipv4EndPointDemuxTestSuite ()
+    : TestSuite ("ipv4-end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+  }
+} g_ipv4EndPointDemuxTestSuite;
@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/enum.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/log.h"
+#include <vector>
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4GlobalRoutingEcmpTestSuite");
+
+using namespace ns3;
+
+/**
+ * Flow hashes should spread flows uniformly over the equal cost routes,
+ * be stable for a given flow and hop, and change with the per node salt.
+ */
+class Ipv4GlobalRoutingEcmpHashTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingEcmpHashTestCase (Ipv4GlobalRouting::EcmpHashFunction hash, std::string name);
+
+private:
+  virtual void DoRun (void);
+
+  Ipv4GlobalRouting::EcmpHashFunction m_hash;
+};
+
+Ipv4GlobalRoutingEcmpHashTestCase::Ipv4GlobalRoutingEcmpHashTestCase (Ipv4GlobalRouting::EcmpHashFunction hash,
+                                                                      std::string name)
+  : TestCase ("ECMP flow hash spread, " + name),
+    m_hash (hash)
+{
+}
+
+void
+Ipv4GlobalRoutingEcmpHashTestCase::DoRun (void)
+{
+  Ptr<Ipv4GlobalRouting> routing = CreateObject<Ipv4GlobalRouting> ();
+  routing->SetAttribute ("EcmpHashFunction", EnumValue (m_hash));
+
+  // Incast-like workload: many senders, a few ephemeral ports each, one receiver
+  const uint32_t senders = 250;
+  const uint32_t portsPerSender = 40;
+  const uint32_t flows = senders * portsPerSender;
+  Ipv4Address dst ("10.1.0.2");
+  std::vector<uint32_t> hashes;
+  for (uint32_t s = 0; s < senders; s++)
+    {
+      Ipv4Address src (Ipv4Address ("10.0.0.2").Get () + (s << 8));
+      for (uint32_t p = 0; p < portsPerSender; p++)
+        {
+          hashes.push_back (routing->GetFlowHash (src, dst, 6, 49153 + p, 5000, 7));
+        }
+    }
+
+  // Chi-square goodness of fit against a uniform spread over the routes
+  uint32_t paths[] = { 2, 4, 8 };
+  double critical[] = { 10.83, 16.27, 24.32 }; // p = 0.001 for 1, 3 and 7 degrees of freedom
+  for (uint32_t k = 0; k < 3; k++)
+    {
+      std::vector<uint32_t> bins (paths[k], 0);
+      for (uint32_t i = 0; i < flows; i++)
+        {
+          bins[hashes[i] % paths[k]]++;
+        }
+      double expected = (double) flows / paths[k];
+      double chi2 = 0;
+      for (uint32_t b = 0; b < paths[k]; b++)
+        {
+          chi2 += (bins[b] - expected) * (bins[b] - expected) / expected;
+        }
+      NS_TEST_EXPECT_MSG_LT (chi2, critical[k], "Flows are not spread uniformly over " << paths[k] << " routes");
+    }
+
+  // Same flow and node always hash the same, a different node (salt) re-rolls the choice
+  Ipv4Address src ("10.0.0.2");
+  NS_TEST_ASSERT_MSG_EQ (routing->GetFlowHash (src, dst, 6, 49153, 5000, 7),
+                         routing->GetFlowHash (src, dst, 6, 49153, 5000, 7), "Flow hash is not stable");
+  uint32_t sameRoute = 0;
+  for (uint32_t i = 0; i < flows; i++)
+    {
+      uint32_t other = routing->GetFlowHash (Ipv4Address (src.Get () + ((i / portsPerSender) << 8)), dst, 6,
+                                             49153 + i % portsPerSender, 5000, 8);
+      if (other % 4 == hashes[i] % 4)
+        {
+          sameRoute++;
+        }
+    }
+  NS_TEST_EXPECT_MSG_LT (sameRoute, flows * 0.3, "Per node salt does not decorrelate route choices");
+  NS_TEST_EXPECT_MSG_GT (sameRoute, flows * 0.2, "Per node salt does not decorrelate route choices");
+}
+
+/**
+ * The forwarding table should return the host routes first, then the routes
+ * of the longest matching prefix, with equal cost routes in insertion order,
+ * and follow route additions and removals.
+ */
+class Ipv4GlobalRoutingFibTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingFibTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+Ipv4GlobalRoutingFibTestCase::Ipv4GlobalRoutingFibTestCase ()
+  : TestCase ("Forwarding table longest prefix match and ECMP groups")
+{
+}
+
+void
+Ipv4GlobalRoutingFibTestCase::DoRun (void)
+{
+  Ptr<Ipv4GlobalRouting> routing = CreateObject<Ipv4GlobalRouting> ();
+  Ipv4RoutingTableEntry * const *routes = 0;
+
+  routing->AddNetworkRouteTo (Ipv4Address ("10.0.0.0"), Ipv4Mask ("255.0.0.0"), Ipv4Address ("10.255.0.1"), 1);
+  routing->AddNetworkRouteTo (Ipv4Address ("10.1.0.0"), Ipv4Mask ("255.255.0.0"), Ipv4Address ("10.255.0.2"), 2);
+  routing->AddHostRouteTo (Ipv4Address ("10.1.2.3"), Ipv4Address ("10.255.0.3"), 3);
+  routing->AddNetworkRouteTo (Ipv4Address ("10.1.0.0"), Ipv4Mask ("255.255.0.0"), Ipv4Address ("10.255.0.4"), 4);
+  routing->AddHostRouteTo (Ipv4Address ("10.1.2.3"), Ipv4Address ("10.255.0.5"), 5);
+
+  NS_TEST_ASSERT_MSG_EQ (routing->LookupFib (Ipv4Address ("10.1.2.3"), routes), 2, "Host route group expected");
+  NS_TEST_ASSERT_MSG_EQ (routes[0]->GetInterface (), 3, "Host routes out of order");
+  NS_TEST_ASSERT_MSG_EQ (routes[1]->GetInterface (), 5, "Host routes out of order");
+  NS_TEST_ASSERT_MSG_EQ (routing->LookupFib (Ipv4Address ("10.1.2.4"), routes), 2, "/16 group expected");
+  NS_TEST_ASSERT_MSG_EQ (routes[0]->GetInterface (), 2, "Network routes out of order");
+  NS_TEST_ASSERT_MSG_EQ (routes[1]->GetInterface (), 4, "Network routes out of order");
+  NS_TEST_ASSERT_MSG_EQ (routing->LookupFib (Ipv4Address ("10.2.0.1"), routes), 1, "/8 route expected");
+  NS_TEST_ASSERT_MSG_EQ (routes[0]->GetInterface (), 1, "Wrong /8 route");
+  NS_TEST_ASSERT_MSG_EQ (routing->LookupFib (Ipv4Address ("11.0.0.1"), routes), 0, "No route expected");
+
+  // Routes added after the table has been built are inserted in place
+  routing->AddNetworkRouteTo (Ipv4Address ("10.1.2.0"), Ipv4Mask ("255.255.255.0"), Ipv4Address ("10.255.0.6"), 6);
+  routing->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), Ipv4Address ("10.255.0.7"), 7);
+  NS_TEST_ASSERT_MSG_EQ (routing->LookupFib (Ipv4Address ("10.1.2.4"), routes), 1, "/24 route expected");
+  NS_TEST_ASSERT_MSG_EQ (routes[0]->GetInterface (), 6, "Wrong /24 route");
+  NS_TEST_ASSERT_MSG_EQ (routing->LookupFib (Ipv4Address ("11.0.0.1"), routes), 1, "Default route expected");
+  NS_TEST_ASSERT_MSG_EQ (routes[0]->GetInterface (), 7, "Wrong default route");
+
+  // Route indexes list the host routes first: remove the first host route and the first /16
+  routing->RemoveRoute (0);
+  routing->RemoveRoute (2);
+  NS_TEST_ASSERT_MSG_EQ (routing->GetNRoutes (), 5, "Unexpected number of routes");
+  NS_TEST_ASSERT_MSG_EQ (routing->LookupFib (Ipv4Address ("10.1.2.3"), routes), 1, "Host group not rebuilt");
+  NS_TEST_ASSERT_MSG_EQ (routes[0]->GetInterface (), 5, "Wrong remaining host route");
+  NS_TEST_ASSERT_MSG_EQ (routing->LookupFib (Ipv4Address ("10.1.3.1"), routes), 1, "/16 group not rebuilt");
+  NS_TEST_ASSERT_MSG_EQ (routes[0]->GetInterface (), 4, "Wrong remaining /16 route");
+
+  // A data center sized table: every destination resolves to its own /24 group
+  for (uint32_t pod = 0; pod < 64; pod++)
+    {
+      for (uint32_t path = 0; path < 4; path++)
+        {
+          routing->AddNetworkRouteTo (Ipv4Address ((20 << 24) + (pod << 8)), Ipv4Mask ("255.255.255.0"),
+                                      Ipv4Address ("10.255.0.8"), 10 + path);
+        }
+    }
+  for (uint32_t pod = 0; pod < 64; pod++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (routing->LookupFib (Ipv4Address ((20 << 24) + (pod << 8) + 2), routes), 4, "ECMP group size mismatch");
+      for (uint32_t path = 0; path < 4; path++)
+        {
+          NS_TEST_ASSERT_MSG_EQ (routes[path]->GetDestNetwork ().Get (), (20u << 24) + (pod << 8), "Route of another prefix in the group");
+          NS_TEST_ASSERT_MSG_EQ (routes[path]->GetInterface (), 10 + path, "ECMP group out of order");
+        }
+    }
+}
+
+static class Ipv4GlobalRoutingEcmpTestSuite : public TestSuite
+{
+public:
+  Ipv4GlobalRoutingEcmpTestSuite ()
+    : TestSuite ("ipv4-global-routing-ecmp", UNIT)
+  {
+    AddTestCase (new Ipv4GlobalRoutingEcmpHashTestCase (Ipv4GlobalRouting::ECMP_HASH_STRING, "String"), TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingEcmpHashTestCase (Ipv4GlobalRouting::ECMP_HASH_MURMUR3, "Murmur3"), TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingEcmpHashTestCase (Ipv4GlobalRouting::ECMP_HASH_FNV1A, "Fnv1a"), TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingFibTestCase, TestCase::QUICK);
+  }
+} g_ipv4GlobalRoutingEcmpTestSuite;
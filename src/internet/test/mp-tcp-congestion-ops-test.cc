@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/mp-tcp-congestion-ops.h"
+#include "ns3/object-factory.h"
+#include "ns3/pointer.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpCongestionOpsTestSuite");
+
+using namespace ns3;
+
+/**
+ * Every CongestionControl value should map to the algorithm of the same
+ * name, which should also be reachable through its TypeId, and the
+ * CongestionOps attribute should replace the algorithm of a socket.
+ */
+class MpTcpCongestionOpsTestCase : public TestCase
+{
+public:
+  MpTcpCongestionOpsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpTcpCongestionOpsTestCase::MpTcpCongestionOpsTestCase ()
+  : TestCase ("MPTCP congestion control selection")
+{
+}
+
+void
+MpTcpCongestionOpsTestCase::DoRun (void)
+{
+  struct
+  {
+    CongestionCtrl_t algo;
+    const char *name;
+    const char *tid;
+  } algos[] = {
+    { Uncoupled_TCPs, "Uncoupled_TCPs", "ns3::MpTcpUncoupledTcps" },
+    { Linked_Increases, "Linked_Increases", "ns3::MpTcpLinkedIncreases" },
+    { RTT_Compensator, "RTT_Compensator", "ns3::MpTcpRttCompensator" },
+    { Fully_Coupled, "Fully_Coupled", "ns3::MpTcpFullyCoupled" },
+    { COUPLED_SCALABLE_TCP, "COUPLED_SCALABLE_TCP", "ns3::MpTcpCoupledScalable" },
+    { UNCOUPLED, "UNCOUPLED", "ns3::MpTcpUncoupled" },
+    { COUPLED_EPSILON, "COUPLED_EPSILON", "ns3::MpTcpCoupledEpsilon" },
+    { COUPLED_INC, "COUPLED_INC", "ns3::MpTcpCoupledInc" },
+    { COUPLED_FULLY, "COUPLED_FULLY", "ns3::MpTcpCoupledFully" },
+    { Fast_Uncoupled, "Fast_Uncoupled", "ns3::MpTcpFastUncoupled" },
+    { Fast_Increases, "Fast_Increases", "ns3::MpTcpFastIncreases" },
+    { XCA, "XCA", "ns3::MpTcpXca" },
+  };
+
+  for (uint32_t i = 0; i < sizeof (algos) / sizeof (algos[0]); i++)
+    {
+      Ptr<MpTcpCongestionOps> ops = MpTcpCongestionOps::CreateFor (algos[i].algo);
+      NS_TEST_ASSERT_MSG_EQ (ops->GetName (), algos[i].name, "Wrong algorithm for " << algos[i].name);
+      NS_TEST_ASSERT_MSG_EQ (ops->GetInstanceTypeId ().GetName (), algos[i].tid, "Wrong TypeId for " << algos[i].name);
+
+      ObjectFactory factory;
+      factory.SetTypeId (algos[i].tid);
+      Ptr<MpTcpCongestionOps> created = factory.Create<MpTcpCongestionOps> ();
+      NS_TEST_ASSERT_MSG_EQ (created->GetName (), algos[i].name, "Wrong algorithm created from " << algos[i].tid);
+    }
+
+  Ptr<MpTcpSocketBase> socket = CreateObject<MpTcpSocketBase> ();
+  PointerValue value;
+  socket->GetAttribute ("CongestionOps", value);
+  NS_TEST_ASSERT_MSG_EQ (value.Get<MpTcpCongestionOps> ()->GetName (), "Linked_Increases", "Wrong default algorithm");
+
+  socket->SetCCAlgo ("XCA");
+  NS_TEST_ASSERT_MSG_EQ (socket->GetCongestionOps ()->GetName (), "XCA", "SetCCAlgo should replace the algorithm");
+
+  socket->SetAttribute ("CongestionOps", PointerValue (CreateObject<MpTcpCoupledInc> ()));
+  NS_TEST_ASSERT_MSG_EQ (socket->GetCongestionOps ()->GetName (), "COUPLED_INC", "CongestionOps should replace the algorithm");
+
+  socket->SetCongestionOps (0);
+  NS_TEST_ASSERT_MSG_EQ (socket->GetCongestionOps ()->GetName (), "COUPLED_INC", "A null algorithm should be ignored");
+}
+
+static class MpTcpCongestionOpsTestSuite : public TestSuite
+{
+public:
+  MpTcpCongestionOpsTestSuite ()
+    : TestSuite ("mp-tcp-congestion-ops", UNIT)
+  {
+    AddTestCase (new MpTcpCongestionOpsTestCase, TestCase::QUICK);
+  }
+} g_mpTcpCongestionOpsTestSuite;
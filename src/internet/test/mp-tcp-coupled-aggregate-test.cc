@@ -0,0 +1,171 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <cmath>
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/mp-tcp-typedefs.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/nstime.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpCoupledAggregateTestSuite");
+
+using namespace ns3;
+
+/**
+ * The incrementally maintained aggregates should match the loops over all
+ * subflows that the coupled congestion controls used to run on every ACK:
+ * exactly for the integer terms, up to rounding for the double ones.
+ */
+class MpTcpCoupledAggregateTestCase : public TestCase
+{
+public:
+  MpTcpCoupledAggregateTestCase ();
+
+private:
+  struct Subflow
+  {
+    uint32_t cwnd;
+    uint32_t ssthresh;
+    bool inFastRec;
+    uint32_t mss;
+    Time rtt;
+  };
+  void Check (const std::vector<Subflow> &subflows, CoupledWindowAggregate &aggregate, double e);
+  virtual void DoRun (void);
+};
+
+MpTcpCoupledAggregateTestCase::MpTcpCoupledAggregateTestCase ()
+  : TestCase ("Coupled window aggregates against full recomputation")
+{
+}
+
+void
+MpTcpCoupledAggregateTestCase::Check (const std::vector<Subflow> &subflows, CoupledWindowAggregate &aggregate, double e)
+{
+  uint64_t totalWindow = 0;
+  double linkedMax = 0, linkedSum = 0;
+  uint64_t scaledMax = 0;
+  uint32_t scaledSum = 0;
+  double epsilonMax = 0, epsilonSum = 0;
+  for (uint32_t i = 0; i < subflows.size (); i++)
+    {
+      const Subflow &s = subflows[i];
+      uint32_t window = s.inFastRec ? s.ssthresh : s.cwnd;
+      totalWindow += window;
+
+      double rttUs = s.rtt.GetMicroSeconds ();
+      if (rttUs == 0)
+        rttUs = 1;
+      linkedMax = std::max (linkedMax, s.cwnd / (rttUs * rttUs));
+      linkedSum += s.cwnd / rttUs;
+
+      uint32_t rtt10Us = s.rtt.GetMicroSeconds () / 10;
+      if (rtt10Us == 0)
+        rtt10Us = 1;
+      scaledMax = std::max (scaledMax, (uint64_t) window * s.mss * s.mss / rtt10Us / rtt10Us);
+      scaledSum += window * s.mss / rtt10Us;
+
+      uint32_t rttMs = s.rtt.GetMilliSeconds ();
+      if (rttMs == 0)
+        rttMs = 1;
+      epsilonMax = std::max (epsilonMax, std::pow (window, e / 2) / rttMs);
+      epsilonSum += (double) window / rttMs;
+    }
+  NS_TEST_ASSERT_MSG_EQ (aggregate.GetTotalWindow (), totalWindow, "Wrong total window");
+  NS_TEST_ASSERT_MSG_EQ (aggregate.GetScaledMax (), scaledMax, "Wrong scaled max");
+  NS_TEST_ASSERT_MSG_EQ (aggregate.GetScaledSum (), scaledSum, "Wrong scaled sum");
+  NS_TEST_ASSERT_MSG_EQ (aggregate.GetLinkedMax (), linkedMax, "Wrong linked max");
+  NS_TEST_ASSERT_MSG_EQ (aggregate.GetEpsilonMax (), epsilonMax, "Wrong epsilon max");
+  NS_TEST_ASSERT_MSG_EQ_TOL (aggregate.GetLinkedSum (), linkedSum, linkedSum * 1e-9, "Wrong linked sum");
+  NS_TEST_ASSERT_MSG_EQ_TOL (aggregate.GetEpsilonSum (), epsilonSum, epsilonSum * 1e-9, "Wrong epsilon sum");
+}
+
+void
+MpTcpCoupledAggregateTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  std::vector<Subflow> subflows;
+  CoupledWindowAggregate aggregate;
+  double e = 1;
+  uint8_t idx;
+
+  for (uint32_t step = 0; step < 5000; step++)
+    {
+      if (subflows.size () < 8 && rng->GetInteger (0, 50) == 0)
+        {
+          Subflow s;
+          s.cwnd = 1400;
+          s.ssthresh = 65535;
+          s.inFastRec = false;
+          s.mss = 1400;
+          s.rtt = Seconds (1.5);
+          subflows.push_back (s);
+          aggregate.AddSubflow ();
+        }
+      if (subflows.empty ())
+        continue;
+
+      // Change a few subflows, the way a burst of ACKs would, then read the aggregates
+      uint32_t changes = rng->GetInteger (1, 3);
+      for (uint32_t k = 0; k < changes; k++)
+        {
+          uint32_t i = rng->GetInteger (0, subflows.size () - 1);
+          Subflow &s = subflows[i];
+          switch (rng->GetInteger (0, 3))
+            {
+          case 0:
+            s.cwnd = rng->GetInteger (1, 200) * s.mss;
+            break;
+          case 1:
+            s.ssthresh = rng->GetInteger (2, 100) * s.mss;
+            break;
+          case 2:
+            s.inFastRec = !s.inFastRec;
+            break;
+          default:
+            s.rtt = MicroSeconds (rng->GetInteger (0, 50000));
+            break;
+            }
+          aggregate.MarkDirty (i);
+        }
+      if (rng->GetInteger (0, 500) == 0)
+        e = rng->GetValue (0, 2);
+
+      aggregate.SetEpsilon (e);
+      while (aggregate.PopDirty (idx))
+        {
+          const Subflow &s = subflows[idx];
+          aggregate.Update (idx, s.cwnd, s.inFastRec ? s.ssthresh : s.cwnd, s.mss, s.rtt);
+        }
+      Check (subflows, aggregate, e);
+    }
+  NS_TEST_ASSERT_MSG_EQ (aggregate.GetNSubflows (), subflows.size (), "Wrong number of subflows");
+}
+
+static class MpTcpCoupledAggregateTestSuite : public TestSuite
+{
+public:
+  MpTcpCoupledAggregateTestSuite ()
+    : TestSuite ("mp-tcp-coupled-aggregate", UNIT)
+  {
+    AddTestCase (new MpTcpCoupledAggregateTestCase, TestCase::QUICK);
+  }
+} g_mpTcpCoupledAggregateTestSuite;
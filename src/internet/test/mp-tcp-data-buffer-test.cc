@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/mp-tcp-typedefs.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpDataBufferTestSuite");
+
+using namespace ns3;
+
+class MpTcpDataBufferTestCase : public TestCase
+{
+public:
+  MpTcpDataBufferTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpTcpDataBufferTestCase::MpTcpDataBufferTestCase ()
+  : TestCase ("DataBuffer accounting")
+{
+}
+
+void
+MpTcpDataBufferTestCase::DoRun (void)
+{
+  DataBuffer buf (3000);
+  NS_TEST_ASSERT_MSG_EQ (buf.Empty (), true, "New buffer should be empty");
+
+  // Sending side: fill past the limit, then drain in segments smaller than the writes
+  NS_TEST_ASSERT_MSG_EQ (buf.Add (1400), 1400, "Add should accept the whole segment");
+  NS_TEST_ASSERT_MSG_EQ (buf.Add (1400), 1400, "Add should accept the whole segment");
+  NS_TEST_ASSERT_MSG_EQ (buf.Add (1400), 200, "Add should be bounded by the free space");
+  NS_TEST_ASSERT_MSG_EQ (buf.Full (), true, "Buffer should be full");
+  NS_TEST_ASSERT_MSG_EQ (buf.FreeSpaceSize (), 0, "No free space expected");
+
+  Ptr<Packet> p = buf.CreatePacket (1000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1000, "Packet size mismatch");
+  p = buf.CreatePacket (1000);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1000, "Packet spanning two writes has wrong size");
+  NS_TEST_ASSERT_MSG_EQ (buf.PendingData (), 1000, "Pending data mismatch");
+  p = buf.CreatePacket (1400);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1000, "CreatePacket should be bounded by pending data");
+  NS_TEST_ASSERT_MSG_EQ (buf.Empty (), true, "Buffer should be empty");
+  NS_TEST_ASSERT_MSG_EQ (buf.CreatePacket (1400), 0, "No packet expected from an empty buffer");
+
+  // Receiving side
+  NS_TEST_ASSERT_MSG_EQ (buf.ReadPacket (Create<Packet> (1500), 1500), 1500, "ReadPacket size mismatch");
+  NS_TEST_ASSERT_MSG_EQ (buf.ReadPacket (Create<Packet> (1500), 1500), 1500, "ReadPacket size mismatch");
+  NS_TEST_ASSERT_MSG_EQ (buf.ReadPacket (Create<Packet> (1500), 1500), 0, "ReadPacket should be bounded by the free space");
+  NS_TEST_ASSERT_MSG_EQ (buf.Retrieve (100), 100, "Retrieve size mismatch");
+  p = buf.CreatePacket (1500);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1500, "Packet size mismatch");
+  NS_TEST_ASSERT_MSG_EQ (buf.PendingData (), 1400, "Pending data mismatch");
+  NS_TEST_ASSERT_MSG_EQ (buf.ClearBuffer (), true, "ClearBuffer failed");
+  NS_TEST_ASSERT_MSG_EQ (buf.PendingData (), 0, "Buffer should be empty after ClearBuffer");
+}
+
+static class MpTcpDataBufferTestSuite : public TestSuite
+{
+public:
+  MpTcpDataBufferTestSuite ()
+    : TestSuite ("mp-tcp-data-buffer", UNIT)
+  {
+    AddTestCase (new MpTcpDataBufferTestCase, TestCase::QUICK);
+  }
+
+} g_mpTcpDataBufferTestSuite;
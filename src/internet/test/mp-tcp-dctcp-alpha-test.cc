@@ -0,0 +1,146 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/mp-tcp-typedefs.h"
+#include "ns3/log.h"
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpDctcpAlphaTestSuite");
+
+using namespace ns3;
+
+/**
+ * The fixed-point alpha should follow the Linux tcp_dctcp.c update rule bit for bit, and stay within the
+ * quantization error of the double EWMA of CalculateDCTCPAlpha over a long run of observation windows.
+ */
+class MpTcpDctcpAlphaTestCase : public TestCase
+{
+public:
+  MpTcpDctcpAlphaTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpTcpDctcpAlphaTestCase::MpTcpDctcpAlphaTestCase ()
+  : TestCase ("Fixed-point DCTCP alpha")
+{
+}
+
+void
+MpTcpDctcpAlphaTestCase::DoRun (void)
+{
+  uint32_t shift = 99;
+  NS_TEST_ASSERT_MSG_EQ (DctcpFixedPoint::ShiftFromWeight (1.0 / 16.0, shift), true, "1/16 is a power of two");
+  NS_TEST_ASSERT_MSG_EQ (shift, 4, "Wrong shift for 1/16");
+  NS_TEST_ASSERT_MSG_EQ (DctcpFixedPoint::ShiftFromWeight (0.5, shift), true, "1/2 is a power of two");
+  NS_TEST_ASSERT_MSG_EQ (shift, 1, "Wrong shift for 1/2");
+  NS_TEST_ASSERT_MSG_EQ (DctcpFixedPoint::ShiftFromWeight (1.0, shift), true, "1 is a power of two");
+  NS_TEST_ASSERT_MSG_EQ (shift, 0, "A weight of 1 has no shift");
+  NS_TEST_ASSERT_MSG_EQ (DctcpFixedPoint::ShiftFromWeight (1.0 / 1024.0, shift), true, "2^-10 is in range");
+  NS_TEST_ASSERT_MSG_EQ (shift, 10, "Wrong shift for 2^-10");
+  NS_TEST_ASSERT_MSG_EQ (DctcpFixedPoint::ShiftFromWeight (0.6, shift), false, "0.6 is not a power of two");
+  NS_TEST_ASSERT_MSG_EQ (DctcpFixedPoint::ShiftFromWeight (2.0, shift), false, "Weights above 1 are out of range");
+  NS_TEST_ASSERT_MSG_EQ (DctcpFixedPoint::ShiftFromWeight (1.0 / 2048.0, shift), false, "Weights below 2^-10 are out of range");
+  NS_TEST_ASSERT_MSG_EQ (DctcpFixedPoint::ShiftFromWeight (0.0, shift), false, "0 is not a weight");
+  NS_TEST_ASSERT_MSG_EQ (shift, 10, "A rejected weight should leave the shift alone");
+
+  // With g = 1 alpha is the marked fraction of the last window
+  DctcpFixedPoint whole;
+  whole.Ack (4000, 1000);
+  whole.UpdateAlpha (0);
+  NS_TEST_ASSERT_MSG_EQ (whole.GetAlpha (), 256, "Alpha should be the marked fraction with g = 1");
+  whole.Ack (4000, 0);
+  whole.UpdateAlpha (0);
+  NS_TEST_ASSERT_MSG_EQ (whole.GetAlpha (), 0, "Alpha should forget the previous window with g = 1");
+
+  // Values of the kernel rule with g = 4, worked by hand
+  DctcpFixedPoint d;
+  uint32_t mss = 1000;
+  struct
+  {
+    uint32_t acked;
+    uint32_t marked;
+    uint32_t alpha;
+  } windows[] = {
+    { 10, 10, 64 },  // 0 + (10000 << 6) / 10000
+    { 10, 10, 124 }, // 64 - 4 + 64
+    { 10, 0, 117 },  // 124 - 7
+    { 10, 5, 142 },  // 117 - 7 + 32
+    { 20, 1, 137 },  // 142 - 8 + 3
+  };
+  for (uint32_t i = 0; i < sizeof (windows) / sizeof (windows[0]); i++)
+    {
+      for (uint32_t j = 0; j < windows[i].acked; j++)
+        {
+          d.Ack (mss, j < windows[i].marked ? mss : 0);
+        }
+      d.UpdateAlpha (4);
+      NS_TEST_ASSERT_MSG_EQ (d.GetAlpha (), windows[i].alpha, "Wrong alpha after window " << i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (d.ReduceWindow (10000), 10000 - (10000 * 137 >> 11), "Wrong window reduction");
+
+  // Below 2^g alpha decays to 0 at once, as min_not_zero makes it
+  DctcpFixedPoint small;
+  small.Ack (6400, 100);
+  small.UpdateAlpha (4);
+  NS_TEST_ASSERT_MSG_EQ (small.GetAlpha (), 1, "Wrong alpha for a 1/64 marked fraction");
+  small.Ack (6400, 0);
+  small.UpdateAlpha (4);
+  NS_TEST_ASSERT_MSG_EQ (small.GetAlpha (), 0, "A small alpha should decay to 0");
+
+  // Every byte marked, alpha saturates and halves the window
+  small.Ack (3 * mss, 3 * mss);
+  small.SetAlphaToFraction ();
+  NS_TEST_ASSERT_MSG_EQ (small.GetAlpha (), uint32_t (DctcpFixedPoint::MAX_ALPHA), "Alpha should saturate at 1024");
+  NS_TEST_ASSERT_MSG_EQ (small.ReduceWindow (10000), 5000, "Alpha 1 should halve the window");
+
+  // Trajectories of the double and the fixed-point alpha over bursts of congestion
+  double g = 1.0 / 16.0;
+  double alpha = 0;
+  double maxError = 0;
+  DctcpFixedPoint fixed;
+  uint32_t seed = 1;
+  for (uint32_t w = 0; w < 2000; w++)
+    {
+      seed = seed * 1103515245 + 12345;
+      uint32_t acked = 1 + (seed >> 16) % 64;
+      bool congested = (w / 100) % 2 == 1;
+      uint32_t marked = congested ? (seed >> 8) % (acked + 1) : ((seed >> 8) % 16 == 0);
+      marked = std::min (marked, acked);
+      for (uint32_t j = 0; j < acked; j++)
+        {
+          fixed.Ack (mss, j < marked ? mss : 0);
+        }
+      NS_TEST_ASSERT_MSG_EQ_TOL (fixed.GetFraction (), (double) marked / acked, 1e-9, "Wrong marked fraction");
+      fixed.UpdateAlpha (4);
+      alpha = (1 - g) * alpha + g * ((double) marked / acked);
+      maxError = std::max (maxError, std::fabs (alpha - (double) fixed.GetAlpha () / DctcpFixedPoint::MAX_ALPHA));
+    }
+  NS_TEST_ASSERT_MSG_LT (maxError, 16.0 / DctcpFixedPoint::MAX_ALPHA, "Fixed-point alpha drifts from the double one");
+}
+
+static class MpTcpDctcpAlphaTestSuite : public TestSuite
+{
+public:
+  MpTcpDctcpAlphaTestSuite ()
+    : TestSuite ("mp-tcp-dctcp-alpha", UNIT)
+  {
+    AddTestCase (new MpTcpDctcpAlphaTestCase, TestCase::QUICK);
+  }
+} g_mpTcpDctcpAlphaTestSuite;
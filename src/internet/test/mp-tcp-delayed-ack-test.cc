@@ -0,0 +1,566 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/error-model.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/pointer.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/tcp-header.h"
+#include "ns3/mp-tcp-socket-base.h"
+#include "ns3/mp-tcp-congestion-ops.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/dc-tag.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/log.h"
+#include <vector>
+#include <map>
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpDelayedAckTestSuite");
+
+using namespace ns3;
+
+/**
+ * Drops one data segment, or marks a range of them CE, as they reach the receiver. Segments are counted
+ * in arrival order, retransmissions included.
+ */
+class MpTcpDelayedAckErrorModel : public ErrorModel
+{
+public:
+  static TypeId GetTypeId (void);
+  MpTcpDelayedAckErrorModel ();
+  void SetDrop (uint32_t segment);
+  void SetCe (uint32_t first, uint32_t last);
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+
+  uint32_t m_segments;
+  uint32_t m_drop;
+  uint32_t m_ceFirst;
+  uint32_t m_ceLast;
+};
+
+TypeId
+MpTcpDelayedAckErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpDelayedAckErrorModel")
+    .SetParent<ErrorModel> ()
+    .AddConstructor<MpTcpDelayedAckErrorModel> ();
+  return tid;
+}
+
+MpTcpDelayedAckErrorModel::MpTcpDelayedAckErrorModel ()
+  : m_segments (0),
+    m_drop (0),
+    m_ceFirst (0),
+    m_ceLast (0)
+{
+}
+
+void
+MpTcpDelayedAckErrorModel::SetDrop (uint32_t segment)
+{
+  m_drop = segment;
+}
+
+void
+MpTcpDelayedAckErrorModel::SetCe (uint32_t first, uint32_t last)
+{
+  m_ceFirst = first;
+  m_ceLast = last;
+}
+
+bool
+MpTcpDelayedAckErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  Ptr<Packet> copy = p->Copy ();
+  Ipv4Header ipHeader;
+  copy->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (tcpHeader);
+  if (copy->GetSize () == 0)
+    {
+      return false;
+    }
+  m_segments++;
+  if (m_segments == m_drop)
+    {
+      return true;
+    }
+  if (m_segments >= m_ceFirst && m_segments <= m_ceLast)
+    {
+      DcTag dcTag;
+      p->RemovePacketTag (dcTag);
+      dcTag.SetCe ();
+      p->AddPacketTag (dcTag);
+    }
+  return false;
+}
+
+void
+MpTcpDelayedAckErrorModel::DoReset (void)
+{
+  m_segments = 0;
+}
+
+/**
+ * Receiving socket reporting each segment as it processes it. The IPv4 traces see the segments of a burst
+ * before the endpoint hands them to the socket, so they cannot tell which segment an ACK answers.
+ */
+class MpTcpDelayedAckTestSocket : public MpTcpSocketBase
+{
+public:
+  static TypeId GetTypeId (void);
+  void SetRxCallback (Callback<void, Ptr<const Packet> > rx);
+
+protected:
+  virtual void DoForwardUp (Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface, int sFlowIdx);
+  virtual Ptr<TcpSocketBase> Fork (void);
+
+private:
+  Callback<void, Ptr<const Packet> > m_rx;
+};
+
+TypeId
+MpTcpDelayedAckTestSocket::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpDelayedAckTestSocket")
+    .SetParent<MpTcpSocketBase> ()
+    .AddConstructor<MpTcpDelayedAckTestSocket> ();
+  return tid;
+}
+
+void
+MpTcpDelayedAckTestSocket::SetRxCallback (Callback<void, Ptr<const Packet> > rx)
+{
+  m_rx = rx;
+}
+
+void
+MpTcpDelayedAckTestSocket::DoForwardUp (Ptr<Packet> p, Ipv4Header header, uint16_t port, Ptr<Ipv4Interface> interface,
+                                        int sFlowIdx)
+{
+  m_rx (p);
+  MpTcpSocketBase::DoForwardUp (p, header, port, interface, sFlowIdx);
+}
+
+Ptr<TcpSocketBase>
+MpTcpDelayedAckTestSocket::Fork (void)
+{
+  return CopyObject<MpTcpDelayedAckTestSocket> (this);
+}
+
+/**
+ * Sends a flow to a receiver with delayed ACKs, logs the segments it receives and the ACKs it sends, and
+ * replays the log against the delayed ACK rules of MpTcpSocketBase::AckReceivedData:
+ *
+ *   - in-order segments are acknowledged every DelAckCount segments, or DelAckTimeout after the first one
+ *     left unacknowledged;
+ *   - with AckCoalesceTime, once the subflow has been idle for that long, or once 64KB are unacknowledged;
+ *   - out-of-order segments and the segment filling the hole are acknowledged at once;
+ *   - a change of CE mark flushes the segments received so far, with the ECE value they were received with.
+ */
+class MpTcpDelayedAckTestCase : public TestCase
+{
+public:
+  MpTcpDelayedAckTestCase (std::string name, uint32_t delAckCount, Time coalesceTime, uint32_t drop,
+                           uint32_t ceFirst, uint32_t ceLast);
+
+private:
+  struct Segment
+  {
+    Time time;
+    bool ack;       // An ACK sent by the receiver, otherwise a segment it received
+    uint32_t seq;
+    uint32_t size;
+    bool fin;
+    bool ce;        // CE on a segment, ECE on an ACK
+  };
+
+  virtual void DoRun (void);
+  void SetupSimulation (void);
+  void SendData (Ptr<Socket> socket);
+  void DataSent (Ptr<Socket> socket, uint32_t size);
+  void ConnectionSucceeded (Ptr<Socket> socket);
+  void ConnectionFailed (Ptr<Socket> socket);
+  void HandleAccept (Ptr<Socket> socket, const Address &from);
+  void HandleRead (Ptr<Socket> socket);
+  void Receive (Ptr<const Packet> p);
+  void Send (const Ipv4Header &header, Ptr<const Packet> p, uint32_t interface);
+  bool ExpectAck (uint32_t i, Time time, uint32_t ack, bool ece, std::string why);
+  void CheckAcks (void);
+
+  // A fifth of the 64KB receive window, so that a window of segments reaches the 64KB coalescing limit
+  static const uint32_t SEGMENT_SIZE = 13107;
+  static const uint32_t SEGMENTS = 60;
+
+  uint32_t m_delAckCount;
+  Time m_delAckTimeout;
+  Time m_coalesceTime;
+  uint32_t m_drop;
+  uint32_t m_ceFirst;
+  uint32_t m_ceLast;
+  uint32_t m_txBytes;
+  uint32_t m_rxBytes;
+  std::vector<Ptr<Socket> > m_sockets;  // Scheduled socket events do not hold a reference
+  std::vector<Segment> m_log;
+  // ACKs sent for each rule, see CheckAcks
+  uint32_t m_countAcks;
+  uint32_t m_timeoutAcks;
+  uint32_t m_fullAcks;
+  uint32_t m_gapAcks;
+  uint32_t m_fillAcks;
+  uint32_t m_ceFlushes[2];
+};
+
+MpTcpDelayedAckTestCase::MpTcpDelayedAckTestCase (std::string name, uint32_t delAckCount, Time coalesceTime,
+                                                  uint32_t drop, uint32_t ceFirst, uint32_t ceLast)
+  : TestCase (name),
+    m_delAckCount (delAckCount),
+    m_delAckTimeout (MilliSeconds (200)),
+    m_coalesceTime (coalesceTime),
+    m_drop (drop),
+    m_ceFirst (ceFirst),
+    m_ceLast (ceLast)
+{
+}
+
+void
+MpTcpDelayedAckTestCase::SetupSimulation (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper stack;
+  stack.Install (nodes);
+
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+      dev->SetAddress (Mac48Address::ConvertFrom (Mac48Address::Allocate ()));
+      dev->SetChannel (channel);
+      nodes.Get (i)->AddDevice (dev);
+      devices.Add (dev);
+    }
+  Ptr<MpTcpDelayedAckErrorModel> em = CreateObject<MpTcpDelayedAckErrorModel> ();
+  em->SetDrop (m_drop);
+  em->SetCe (m_ceFirst, m_ceLast);
+  devices.Get (0)->SetAttribute ("ReceiveErrorModel", PointerValue (em));
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+
+  Ptr<Ipv4L3Protocol> ipv4 = nodes.Get (0)->GetObject<Ipv4L3Protocol> ();
+  ipv4->TraceConnectWithoutContext ("SendOutgoing", MakeCallback (&MpTcpDelayedAckTestCase::Send, this));
+
+  uint16_t port = 5000;
+  Ptr<MpTcpDelayedAckTestSocket> receiver = DynamicCast<MpTcpDelayedAckTestSocket> (
+      nodes.Get (0)->GetObject<TcpL4Protocol> ()->CreateSocket (MpTcpDelayedAckTestSocket::GetTypeId ()));
+  receiver->SetRxCallback (MakeCallback (&MpTcpDelayedAckTestCase::Receive, this));
+  receiver->SetAttribute ("SegmentSize", UintegerValue (SEGMENT_SIZE));
+  receiver->SetAttribute ("DelAckCount", UintegerValue (m_delAckCount));
+  receiver->SetAttribute ("DelAckTimeout", TimeValue (m_delAckTimeout));
+  receiver->SetAttribute ("AckCoalesceTime", TimeValue (m_coalesceTime));
+  receiver->Bind (InetSocketAddress (Ipv4Address::GetAny (), port));
+  receiver->Listen ();
+  receiver->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                               MakeCallback (&MpTcpDelayedAckTestCase::HandleAccept, this));
+  m_sockets.push_back (receiver);
+
+  Ptr<MpTcpSocketBase> sender =
+    DynamicCast<MpTcpSocketBase> (nodes.Get (1)->GetObject<TcpL4Protocol> ()->CreateSocket (MpTcpSocketBase::GetTypeId ()));
+  sender->SetAttribute ("SegmentSize", UintegerValue (SEGMENT_SIZE));
+  sender->SetMaxSubFlowNumber (1);
+  sender->Bind ();
+  sender->Connect (InetSocketAddress (interfaces.GetAddress (0), port));
+  sender->SetConnectCallback (MakeCallback (&MpTcpDelayedAckTestCase::ConnectionSucceeded, this),
+                              MakeCallback (&MpTcpDelayedAckTestCase::ConnectionFailed, this));
+  sender->SetDataSentCallback (MakeCallback (&MpTcpDelayedAckTestCase::DataSent, this));
+  m_sockets.push_back (sender);
+}
+
+void
+MpTcpDelayedAckTestCase::SendData (Ptr<Socket> socket)
+{
+  Ptr<MpTcpSocketBase> mpSocket = DynamicCast<MpTcpSocketBase> (socket);
+  uint32_t total = SEGMENTS * SEGMENT_SIZE;
+  if (m_txBytes == total)
+    {
+      return;
+    }
+  while (m_txBytes < total && mpSocket->GetTxAvailable () > 0)
+    {
+      m_txBytes += mpSocket->FillBuffer (std::min (total - m_txBytes, mpSocket->GetTxAvailable ()));
+      mpSocket->SendBufferedData ();
+    }
+  if (m_txBytes == total)
+    {
+      mpSocket->Close ();
+    }
+}
+
+void
+MpTcpDelayedAckTestCase::DataSent (Ptr<Socket> socket, uint32_t size)
+{
+  SendData (socket);
+}
+
+void
+MpTcpDelayedAckTestCase::ConnectionSucceeded (Ptr<Socket> socket)
+{
+  SendData (socket);
+}
+
+void
+MpTcpDelayedAckTestCase::ConnectionFailed (Ptr<Socket> socket)
+{
+  NS_TEST_EXPECT_MSG_EQ (true, false, "Connection failed");
+}
+
+void
+MpTcpDelayedAckTestCase::HandleAccept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&MpTcpDelayedAckTestCase::HandleRead, this));
+  m_sockets.push_back (socket);
+}
+
+void
+MpTcpDelayedAckTestCase::HandleRead (Ptr<Socket> socket)
+{
+  m_rxBytes += DynamicCast<MpTcpSocketBase> (socket)->Recv (SEGMENTS * SEGMENT_SIZE);
+}
+
+void
+MpTcpDelayedAckTestCase::Receive (Ptr<const Packet> p)
+{
+  Ptr<Packet> copy = p->Copy ();
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (tcpHeader);
+  bool fin = (tcpHeader.GetFlags () & TcpHeader::FIN) != 0;
+  if (copy->GetSize () == 0 && !fin)
+    {
+      return;
+    }
+  DcTag dcTag;
+  Segment s;
+  s.time = Simulator::Now ();
+  s.ack = false;
+  s.seq = tcpHeader.GetSequenceNumber ().GetValue ();
+  s.size = copy->GetSize ();
+  s.fin = fin;
+  s.ce = p->PeekPacketTag (dcTag) && dcTag.IsCe ();
+  m_log.push_back (s);
+}
+
+void
+MpTcpDelayedAckTestCase::Send (const Ipv4Header &header, Ptr<const Packet> p, uint32_t interface)
+{
+  Ptr<Packet> copy = p->Copy ();
+  TcpHeader tcpHeader;
+  copy->RemoveHeader (tcpHeader);
+  if (copy->GetSize () != 0 || tcpHeader.GetFlags () != TcpHeader::ACK)
+    {
+      return;
+    }
+  DcTag dcTag;
+  Segment s;
+  s.time = Simulator::Now ();
+  s.ack = true;
+  s.seq = tcpHeader.GetAckNumber ().GetValue ();
+  s.size = 0;
+  s.fin = false;
+  s.ce = p->PeekPacketTag (dcTag) && dcTag.IsEce ();
+  m_log.push_back (s);
+}
+
+bool
+MpTcpDelayedAckTestCase::ExpectAck (uint32_t i, Time time, uint32_t ack, bool ece, std::string why)
+{
+  NS_TEST_EXPECT_MSG_EQ ((i < m_log.size () && m_log[i].ack), true, "No ACK for " << why << " at " << time);
+  if (i >= m_log.size () || !m_log[i].ack)
+    {
+      return false;
+    }
+  NS_TEST_EXPECT_MSG_EQ (m_log[i].time, time, "ACK for " << why << " sent at the wrong time");
+  NS_TEST_EXPECT_MSG_EQ (m_log[i].seq, ack, "ACK for " << why << " at " << time << " has the wrong number");
+  NS_TEST_EXPECT_MSG_EQ (m_log[i].ce, ece, "ACK for " << why << " at " << time << " has the wrong ECE");
+  return true;
+}
+
+void
+MpTcpDelayedAckTestCase::CheckAcks (void)
+{
+  uint32_t rcvNxt = 0;
+  std::map<uint32_t, uint32_t> unordered;  // Sequence number -> size
+  bool gap = false;
+  bool ceState = false;
+  uint32_t pending = 0;                    // In-order segments not acknowledged yet
+  Time firstPending;
+  Time lastPending;
+  for (uint32_t i = 0; i < m_log.size (); i++)
+    {
+      const Segment &s = m_log[i];
+      if (s.fin)
+        { // FIN and what follows are acknowledged at once
+          break;
+        }
+      if (s.ack)
+        { // Nothing received triggered this one, a timer did
+          NS_TEST_EXPECT_MSG_GT (pending, 0, "ACK at " << s.time << " acknowledges nothing new");
+          NS_TEST_EXPECT_MSG_EQ (s.seq, rcvNxt, "Delayed ACK at " << s.time << " has the wrong number");
+          NS_TEST_EXPECT_MSG_EQ (s.ce, ceState, "Delayed ACK at " << s.time << " has the wrong ECE");
+          Time expected = m_coalesceTime.IsStrictlyPositive () ? lastPending + m_coalesceTime : firstPending + m_delAckTimeout;
+          NS_TEST_EXPECT_MSG_EQ (s.time, expected, "Delayed ACK sent at the wrong time");
+          m_timeoutAcks++;
+          pending = 0;
+          continue;
+        }
+      if (rcvNxt == 0)
+        {
+          rcvNxt = s.seq;
+        }
+      if (s.ce != ceState && pending > 0)
+        {
+          if (ExpectAck (i + 1, s.time, rcvNxt, ceState, "a CE change"))
+            {
+              m_ceFlushes[ceState]++;
+              i++;
+            }
+          pending = 0;
+        }
+      ceState = s.ce;
+      if (s.seq != rcvNxt)
+        { // Out of order, or a duplicate
+          if (s.seq > rcvNxt)
+            {
+              unordered[s.seq] = s.size;
+              gap = true;
+            }
+          if (ExpectAck (i + 1, s.time, rcvNxt, ceState, "an out-of-order segment"))
+            {
+              m_gapAcks++;
+              i++;
+            }
+          pending = 0;
+          continue;
+        }
+      rcvNxt += s.size;
+      while (!unordered.empty () && unordered.begin ()->first <= rcvNxt)
+        {
+          rcvNxt = std::max (rcvNxt, unordered.begin ()->first + unordered.begin ()->second);
+          unordered.erase (unordered.begin ());
+        }
+      if (gap)
+        {
+          if (ExpectAck (i + 1, s.time, rcvNxt, ceState, "a hole fill"))
+            {
+              m_fillAcks++;
+              i++;
+            }
+          gap = false;
+          pending = 0;
+          continue;
+        }
+      if (++pending == 1)
+        {
+          firstPending = s.time;
+        }
+      lastPending = s.time;
+      if (m_coalesceTime.IsStrictlyPositive () && pending * SEGMENT_SIZE >= 65535)
+        {
+          if (ExpectAck (i + 1, s.time, rcvNxt, ceState, "64KB"))
+            {
+              m_fullAcks++;
+              i++;
+            }
+          pending = 0;
+        }
+      else if (!m_coalesceTime.IsStrictlyPositive () && pending >= m_delAckCount)
+        {
+          if (ExpectAck (i + 1, s.time, rcvNxt, ceState, "DelAckCount segments"))
+            {
+              m_countAcks++;
+              i++;
+            }
+          pending = 0;
+        }
+    }
+}
+
+void
+MpTcpDelayedAckTestCase::DoRun (void)
+{
+  m_txBytes = 0;
+  m_rxBytes = 0;
+  m_log.clear ();
+  m_countAcks = m_timeoutAcks = m_fullAcks = m_gapAcks = m_fillAcks = 0;
+  m_ceFlushes[0] = m_ceFlushes[1] = 0;
+
+  SetupSimulation ();
+  Simulator::Stop (Seconds (20));
+  Simulator::Run ();
+  Simulator::Destroy ();
+  m_sockets.clear ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rxBytes, SEGMENTS * SEGMENT_SIZE, "The flow did not complete");
+  CheckAcks ();
+  NS_TEST_EXPECT_MSG_GT (m_timeoutAcks, 0, "The delayed ACK timer never fired");
+  if (m_coalesceTime.IsStrictlyPositive ())
+    {
+      NS_TEST_EXPECT_MSG_GT (m_fullAcks, 0, "Coalescing never stopped at 64KB");
+    }
+  else
+    {
+      NS_TEST_EXPECT_MSG_GT (m_countAcks, 0, "No ACK every DelAckCount segments");
+    }
+  if (m_drop > 0)
+    {
+      NS_TEST_EXPECT_MSG_GT (m_gapAcks, 0, "Out-of-order segments were not acknowledged at once");
+      NS_TEST_EXPECT_MSG_GT (m_fillAcks, 0, "The hole fill was not acknowledged at once");
+    }
+  if (m_ceFirst > 0)
+    {
+      NS_TEST_EXPECT_MSG_GT (m_ceFlushes[0], 0, "No flush when the CE mark appears");
+      NS_TEST_EXPECT_MSG_GT (m_ceFlushes[1], 0, "No flush when the CE mark goes away");
+    }
+}
+
+static class MpTcpDelayedAckTestSuite : public TestSuite
+{
+public:
+  MpTcpDelayedAckTestSuite ()
+    : TestSuite ("mp-tcp-delayed-ack", UNIT)
+  {
+    AddTestCase (new MpTcpDelayedAckTestCase ("ACK every DelAckCount segments", 2, Time (0), 0, 0, 0), TestCase::QUICK);
+    AddTestCase (new MpTcpDelayedAckTestCase ("Immediate ACK out of order and on hole fill", 2, Time (0), 8, 0, 0), TestCase::QUICK);
+    AddTestCase (new MpTcpDelayedAckTestCase ("Flush on CE change", 4, Time (0), 0, 10, 20), TestCase::QUICK);
+    AddTestCase (new MpTcpDelayedAckTestCase ("Coalescing up to 64KB", 2, MicroSeconds (500), 0, 0, 0), TestCase::QUICK);
+  }
+} g_mpTcpDelayedAckTestSuite;
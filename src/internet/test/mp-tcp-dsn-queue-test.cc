@@ -0,0 +1,159 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/mp-tcp-typedefs.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpDsnQueueTestSuite");
+
+using namespace ns3;
+
+class MpTcpDsnQueueTestCase : public TestCase
+{
+public:
+  MpTcpDsnQueueTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpTcpDsnQueueTestCase::MpTcpDsnQueueTestCase ()
+  : TestCase ("DSNMappingQueue lookup, discard and wrap around")
+{
+}
+
+void
+MpTcpDsnQueueTestCase::DoRun (void)
+{
+  DSNMappingQueue q;
+  const uint32_t mss = 1400;
+  uint32_t firstSeq = 1;
+  uint32_t nextSeq = firstSeq;
+  uint64_t nextDsn = 1;
+
+  // Enough mappings to grow the ring and the pool several times
+  for (uint32_t i = 0; i < 300; i++)
+    {
+      q.Add (0, nextDsn, mss, nextSeq, 0);
+      nextSeq += mss;
+      nextDsn += mss;
+    }
+  NS_TEST_ASSERT_MSG_EQ (q.size (), 300, "Unexpected queue size");
+  NS_TEST_ASSERT_MSG_EQ (q.Get (0)->subflowSeqNumber, firstSeq, "Oldest mapping should be first");
+
+  DSNMapping *ptrDSN = q.Find (firstSeq + 150 * mss);
+  NS_TEST_ASSERT_MSG_NE (ptrDSN, 0, "Mapping not found");
+  NS_TEST_ASSERT_MSG_EQ (ptrDSN->dataSeqNumber, 1 + 150 * mss, "Wrong mapping found");
+  NS_TEST_ASSERT_MSG_EQ (q.Find (firstSeq + 150 * mss + 1), 0, "Sequence inside a segment should not match");
+  NS_TEST_ASSERT_MSG_EQ (q.FindEndingAt (firstSeq + 151 * mss), ptrDSN, "FindEndingAt should return the same mapping");
+  NS_TEST_ASSERT_MSG_EQ (q.FindEndingAt (firstSeq), 0, "Nothing ends before the first mapping");
+
+  // A partial ack does not release the segment it falls into
+  NS_TEST_ASSERT_MSG_EQ (q.DiscardUpTo (firstSeq + 100 * mss + 10), 100, "Wrong number of discarded mappings");
+  NS_TEST_ASSERT_MSG_EQ (q.Get (0)->subflowSeqNumber, firstSeq + 100 * mss, "Wrong head after discard");
+  NS_TEST_ASSERT_MSG_EQ (q.Find (firstSeq + 99 * mss), 0, "Discarded mapping still found");
+
+  // Keep sending while acking so that the ring wraps around
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      q.Add (0, nextDsn, mss, nextSeq, 0);
+      nextSeq += mss;
+      nextDsn += mss;
+      q.DiscardUpTo (q.Get (0)->subflowSeqNumber + mss);
+    }
+  NS_TEST_ASSERT_MSG_EQ (q.size (), 200, "Unexpected queue size after wrap around");
+  for (uint32_t i = 1; i < q.size (); i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (q.Get (i)->subflowSeqNumber, q.Get (i - 1)->subflowSeqNumber + mss, "Queue is not ordered");
+    }
+  ptrDSN = q.Get (57);
+  NS_TEST_ASSERT_MSG_EQ (q.Find (ptrDSN->subflowSeqNumber), ptrDSN, "Lookup failed after wrap around");
+
+  q.DiscardUpTo (nextSeq);
+  NS_TEST_ASSERT_MSG_EQ (q.empty (), true, "Cumulative ack should empty the queue");
+  q.Add (0, nextDsn, mss, nextSeq, 0);
+  q.clear ();
+  NS_TEST_ASSERT_MSG_EQ (q.size (), 0, "Queue should be empty after clear");
+}
+
+class MpTcpReassemblyQueueTestCase : public TestCase
+{
+public:
+  MpTcpReassemblyQueueTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpTcpReassemblyQueueTestCase::MpTcpReassemblyQueueTestCase ()
+  : TestCase ("DSNReassemblyQueue ordering and subflow index")
+{
+}
+
+void
+MpTcpReassemblyQueueTestCase::DoRun (void)
+{
+  DSNReassemblyQueue q;
+  const uint16_t mss = 1000;
+  // Connection data is striped over two subflows; segments arrive in reverse order
+  for (int32_t i = 9; i >= 0; i--)
+    {
+      uint8_t sFlowIdx = i % 2;
+      uint32_t sflowSeq = 1 + (i / 2) * mss;
+      bool stored = q.Insert (new DSNMapping (sFlowIdx, 1 + i * mss, mss, sflowSeq, 0));
+      NS_TEST_ASSERT_MSG_EQ (stored, true, "Segment should be stored");
+    }
+  DSNMapping *dup = new DSNMapping (0, 1 + 4 * mss, mss, 1 + 2 * mss, 0);
+  NS_TEST_ASSERT_MSG_EQ (q.Insert (dup), false, "Duplicated segment should be rejected");
+  delete dup;
+  // Same subflow segment under a data sequence number not stored yet: rejected from both indexes
+  dup = new DSNMapping (1, 1 + 20 * mss, mss, 1 + 3 * mss, 0);
+  NS_TEST_ASSERT_MSG_EQ (q.Insert (dup), false, "Segment already stored on its subflow should be rejected");
+  delete dup;
+  NS_TEST_ASSERT_MSG_EQ (q.size (), 10, "Unexpected queue size");
+  NS_TEST_ASSERT_MSG_EQ (q.bytes (), 10 * mss, "Stored bytes should not count the rejected segment");
+  NS_TEST_ASSERT_MSG_EQ (q.HasSubflow (1), true, "Subflow 1 has stored segments");
+  NS_TEST_ASSERT_MSG_EQ (q.HasSubflow (2), false, "Subflow 2 has no stored segments");
+
+  DSNMapping *ptrDSN = q.FindSubflowSeq (1, 1 + 3 * mss);
+  NS_TEST_ASSERT_MSG_NE (ptrDSN, 0, "Segment not found by subflow sequence number");
+  NS_TEST_ASSERT_MSG_EQ (ptrDSN->dataSeqNumber, 1 + 7 * mss, "Wrong segment found by subflow sequence number");
+
+  uint64_t expected = 1;
+  while (!q.empty ())
+    {
+      NS_TEST_ASSERT_MSG_EQ (q.Front ()->dataSeqNumber, expected, "Segments should drain in data sequence order");
+      expected += mss;
+      q.PopFront ();
+    }
+  NS_TEST_ASSERT_MSG_EQ (q.bytes (), 0, "No bytes should be left after drain");
+  NS_TEST_ASSERT_MSG_EQ (q.HasSubflow (0), false, "Subflow index should be empty after drain");
+  NS_TEST_ASSERT_MSG_EQ (q.FindSubflowSeq (1, 1 + 3 * mss), 0, "Drained segment still indexed");
+}
+
+static class MpTcpDsnQueueTestSuite : public TestSuite
+{
+public:
+  MpTcpDsnQueueTestSuite ()
+    : TestSuite ("mp-tcp-dsn-queue", UNIT)
+  {
+    AddTestCase (new MpTcpDsnQueueTestCase, TestCase::QUICK);
+    AddTestCase (new MpTcpReassemblyQueueTestCase, TestCase::QUICK);
+  }
+
+} g_mpTcpDsnQueueTestSuite;
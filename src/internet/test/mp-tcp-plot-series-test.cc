@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/mp-tcp-typedefs.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpPlotSeriesTestSuite");
+
+using namespace ns3;
+
+class MpTcpPlotSeriesTestCase : public TestCase
+{
+public:
+  MpTcpPlotSeriesTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpTcpPlotSeriesTestCase::MpTcpPlotSeriesTestCase ()
+  : TestCase ("PlotSeries keeps the newest samples in order")
+{
+}
+
+void
+MpTcpPlotSeriesTestCase::DoRun (void)
+{
+  PlotSeries<uint32_t> series;
+  series.SetMaxSize (100);
+  for (uint32_t i = 0; i < 60; i++)
+    {
+      series.Add (i * 0.001, i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (series.size (), 60, "Samples below the bound should all be kept");
+  NS_TEST_ASSERT_MSG_EQ (series.Get (0).second, 0, "Oldest sample should come first");
+
+  // Past the bound the oldest samples are overwritten
+  for (uint32_t i = 60; i < 1000; i++)
+    {
+      series.Add (i * 0.001, i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (series.size (), 100, "Series should be bounded");
+  uint32_t expected = 900;
+  for (PlotSeries<uint32_t>::iterator it = series.begin (); it != series.end (); it++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (it->second, expected, "Samples out of order after wrap around");
+      NS_TEST_ASSERT_MSG_EQ_TOL (it->first, expected * 0.001, 1e-9, "Sample time mismatch");
+      expected++;
+    }
+  NS_TEST_ASSERT_MSG_EQ (expected, 1000, "Iteration should visit every stored sample");
+
+  // A zero bound disables the series
+  series.SetMaxSize (0);
+  series.Add (1.0, 1);
+  NS_TEST_ASSERT_MSG_EQ (series.empty (), true, "Disabled series should stay empty");
+}
+
+static class MpTcpPlotSeriesTestSuite : public TestSuite
+{
+public:
+  MpTcpPlotSeriesTestSuite ()
+    : TestSuite ("mp-tcp-plot-series", UNIT)
+  {
+    AddTestCase (new MpTcpPlotSeriesTestCase, TestCase::QUICK);
+  }
+
+} g_mpTcpPlotSeriesTestSuite;
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/mp-tcp-typedefs.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpReadySubflowsTestSuite");
+
+using namespace ns3;
+
+/**
+ * The ready set should return the same subflow as a round robin scan over
+ * all subflows would, skipping the busy ones, and only return the subflows
+ * kept aside for the tail of the buffer when asked to.
+ */
+class MpTcpReadySubflowsTestCase : public TestCase
+{
+public:
+  MpTcpReadySubflowsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+MpTcpReadySubflowsTestCase::MpTcpReadySubflowsTestCase ()
+  : TestCase ("Ready subflow set against a round robin scan")
+{
+}
+
+void
+MpTcpReadySubflowsTestCase::DoRun (void)
+{
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  rng->SetStream (1);
+
+  const uint32_t nSubflows = 256;
+  ReadySubflowSet set;
+  std::vector<uint8_t> state (nSubflows, 0); // 0 busy, 1 ready, 2 busy with room for the tail
+  NS_TEST_ASSERT_MSG_EQ (set.Next (0, nSubflows, true), -1, "A new set should be empty");
+
+  set.MarkAllReady (3);
+  for (uint32_t i = 0; i < 3; i++)
+    state[i] = 1;
+
+  for (uint32_t step = 0; step < 20000; step++)
+    {
+      uint32_t i = rng->GetInteger (0, nSubflows - 1);
+      switch (rng->GetInteger (0, 2))
+        {
+      case 0:
+        set.MarkReady (i);
+        state[i] = 1;
+        break;
+      case 1:
+        set.MarkBusy (i, false);
+        state[i] = 0;
+        break;
+      default:
+        set.MarkBusy (i, true);
+        state[i] = 2;
+        break;
+        }
+
+      uint32_t n = rng->GetInteger (1, nSubflows);
+      uint32_t from = rng->GetInteger (0, n - 1);
+      bool withTail = rng->GetInteger (0, 1);
+      int expected = -1;
+      for (uint32_t k = 0; k < n; k++)
+        {
+          uint32_t j = (from + k) % n;
+          if (state[j] == 1 || (withTail && state[j] == 2))
+            {
+              expected = j;
+              break;
+            }
+        }
+      NS_TEST_ASSERT_MSG_EQ (set.Next (from, n, withTail), expected, "Wrong subflow from " << from << " of " << n);
+      bool ready = state[i] == 1 || (withTail && state[i] == 2);
+      NS_TEST_ASSERT_MSG_EQ (set.IsReady (i, withTail), ready, "Wrong state of " << i);
+    }
+}
+
+static class MpTcpReadySubflowsTestSuite : public TestSuite
+{
+public:
+  MpTcpReadySubflowsTestSuite ()
+    : TestSuite ("mp-tcp-ready-subflows", UNIT)
+  {
+    AddTestCase (new MpTcpReadySubflowsTestCase, TestCase::QUICK);
+  }
+} g_mpTcpReadySubflowsTestSuite;
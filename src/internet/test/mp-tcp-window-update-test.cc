@@ -0,0 +1,358 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/error-model.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/ipv4-interface-container.h"
+#include "ns3/pointer.h"
+#include "ns3/boolean.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/tcp-l4-protocol.h"
+#include "ns3/tcp-header.h"
+#include "ns3/mp-tcp-socket-base.h"
+#include "ns3/mp-tcp-congestion-ops.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+#include <vector>
+
+NS_LOG_COMPONENT_DEFINE ("MpTcpWindowUpdateTestSuite");
+
+using namespace ns3;
+
+/**
+ * Sits on both devices. Drops one data segment of the master subflow as it reaches the receiver, and
+ * advertises one window unit less in the ACKs of the other subflow as they reach the sender, so that the
+ * ACKs of the two subflows alternate between two windows. Counts the duplicate ACKs of the master subflow.
+ */
+class MpTcpWindowUpdateErrorModel : public ErrorModel
+{
+public:
+  static TypeId GetTypeId (void);
+  MpTcpWindowUpdateErrorModel ();
+  void SetDrop (uint32_t segment);
+  uint32_t GetDupAcks (void) const;
+  uint32_t GetShrunkAcks (void) const;
+
+private:
+  virtual bool DoCorrupt (Ptr<Packet> p);
+  virtual void DoReset (void);
+
+  uint16_t m_masterPort;  // Sender port of the master subflow, from its SYN
+  uint32_t m_segments;
+  uint32_t m_drop;
+  uint32_t m_lastAck;     // Last ACK number of the master subflow
+  uint32_t m_dupAcks;
+  uint32_t m_shrunkAcks;
+};
+
+TypeId
+MpTcpWindowUpdateErrorModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpWindowUpdateErrorModel")
+    .SetParent<ErrorModel> ()
+    .AddConstructor<MpTcpWindowUpdateErrorModel> ();
+  return tid;
+}
+
+MpTcpWindowUpdateErrorModel::MpTcpWindowUpdateErrorModel ()
+  : m_masterPort (0),
+    m_segments (0),
+    m_drop (0),
+    m_lastAck (0),
+    m_dupAcks (0),
+    m_shrunkAcks (0)
+{
+}
+
+void
+MpTcpWindowUpdateErrorModel::SetDrop (uint32_t segment)
+{
+  m_drop = segment;
+}
+
+uint32_t
+MpTcpWindowUpdateErrorModel::GetDupAcks (void) const
+{
+  return m_dupAcks;
+}
+
+uint32_t
+MpTcpWindowUpdateErrorModel::GetShrunkAcks (void) const
+{
+  return m_shrunkAcks;
+}
+
+bool
+MpTcpWindowUpdateErrorModel::DoCorrupt (Ptr<Packet> p)
+{
+  Ipv4Header ipHeader;
+  p->RemoveHeader (ipHeader);
+  TcpHeader tcpHeader;
+  p->RemoveHeader (tcpHeader);
+  bool drop = false;
+  if (tcpHeader.GetFlags () == TcpHeader::SYN && m_masterPort == 0)
+    {
+      m_masterPort = tcpHeader.GetSourcePort ();
+    }
+  else if (p->GetSize () > 0 && tcpHeader.GetSourcePort () == m_masterPort)
+    {
+      drop = (++m_segments == m_drop);
+    }
+  else if (p->GetSize () == 0 && tcpHeader.GetFlags () == TcpHeader::ACK)
+    {
+      if (tcpHeader.GetDestinationPort () == m_masterPort)
+        {
+          uint32_t ack = tcpHeader.GetAckNumber ().GetValue ();
+          m_dupAcks += (ack == m_lastAck);
+          m_lastAck = ack;
+        }
+      else
+        {
+          tcpHeader.SetWindowSize (tcpHeader.GetWindowSize () - 1);
+          m_shrunkAcks++;
+        }
+    }
+  p->AddHeader (tcpHeader);
+  p->AddHeader (ipHeader);
+  return drop;
+}
+
+void
+MpTcpWindowUpdateErrorModel::DoReset (void)
+{
+  m_segments = 0;
+}
+
+/**
+ * Sending socket counting the duplicate ACKs that reach loss recovery on each subflow.
+ */
+class MpTcpWindowUpdateTestSocket : public MpTcpSocketBase
+{
+public:
+  static TypeId GetTypeId (void);
+  uint32_t GetDupAcks (uint8_t sFlowIdx) const;
+
+protected:
+  using MpTcpSocketBase::DupAck;
+  virtual void DupAck (uint8_t sFlowIdx, DSNMapping *ptrDSN);
+
+private:
+  std::vector<uint32_t> m_dupAcks;
+};
+
+TypeId
+MpTcpWindowUpdateTestSocket::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MpTcpWindowUpdateTestSocket")
+    .SetParent<MpTcpSocketBase> ()
+    .AddConstructor<MpTcpWindowUpdateTestSocket> ();
+  return tid;
+}
+
+uint32_t
+MpTcpWindowUpdateTestSocket::GetDupAcks (uint8_t sFlowIdx) const
+{
+  return sFlowIdx < m_dupAcks.size () ? m_dupAcks[sFlowIdx] : 0;
+}
+
+void
+MpTcpWindowUpdateTestSocket::DupAck (uint8_t sFlowIdx, DSNMapping *ptrDSN)
+{
+  if (m_dupAcks.size () <= sFlowIdx)
+    {
+      m_dupAcks.resize (sFlowIdx + 1, 0);
+    }
+  m_dupAcks[sFlowIdx]++;
+  MpTcpSocketBase::DupAck (sFlowIdx, ptrDSN);
+}
+
+/**
+ * Sends a flow over two subflows with FlowControl, and loses a segment of the master subflow. The ACKs
+ * of the second subflow advertise a different window, so every duplicate ACK of the master subflow
+ * follows a window change on the connection. A window update is judged per subflow, so each of the
+ * duplicate ACKs should still reach DupAck.
+ */
+class MpTcpWindowUpdateTestCase : public TestCase
+{
+public:
+  MpTcpWindowUpdateTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void SetupSimulation (void);
+  void SendData (Ptr<Socket> socket);
+  void DataSent (Ptr<Socket> socket, uint32_t size);
+  void ConnectionSucceeded (Ptr<Socket> socket);
+  void ConnectionFailed (Ptr<Socket> socket);
+  void HandleAccept (Ptr<Socket> socket, const Address &from);
+  void HandleRead (Ptr<Socket> socket);
+
+  static const uint32_t SEGMENT_SIZE = 1000;
+  static const uint32_t SEGMENTS = 200;
+
+  uint32_t m_txBytes;
+  uint32_t m_rxBytes;
+  Ptr<MpTcpWindowUpdateErrorModel> m_errorModel;
+  Ptr<MpTcpWindowUpdateTestSocket> m_sender;
+  std::vector<Ptr<Socket> > m_sockets;  // Scheduled socket events do not hold a reference
+};
+
+MpTcpWindowUpdateTestCase::MpTcpWindowUpdateTestCase ()
+  : TestCase ("Duplicate ACKs after a window change on another subflow")
+{
+}
+
+void
+MpTcpWindowUpdateTestCase::SetupSimulation (void)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  InternetStackHelper stack;
+  stack.Install (nodes);
+
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+      dev->SetAddress (Mac48Address::ConvertFrom (Mac48Address::Allocate ()));
+      dev->SetChannel (channel);
+      nodes.Get (i)->AddDevice (dev);
+      devices.Add (dev);
+    }
+  m_errorModel = CreateObject<MpTcpWindowUpdateErrorModel> ();
+  m_errorModel->SetDrop (20);
+  devices.Get (0)->SetAttribute ("ReceiveErrorModel", PointerValue (m_errorModel));
+  devices.Get (1)->SetAttribute ("ReceiveErrorModel", PointerValue (m_errorModel));
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer interfaces = address.Assign (devices);
+
+  uint16_t port = 5000;
+  Ptr<MpTcpSocketBase> receiver =
+    DynamicCast<MpTcpSocketBase> (nodes.Get (0)->GetObject<TcpL4Protocol> ()->CreateSocket (MpTcpSocketBase::GetTypeId ()));
+  receiver->SetAttribute ("SegmentSize", UintegerValue (SEGMENT_SIZE));
+  receiver->SetAttribute ("FlowControl", BooleanValue (true));
+  receiver->Bind (InetSocketAddress (Ipv4Address::GetAny (), port));
+  receiver->Listen ();
+  receiver->SetAcceptCallback (MakeNullCallback<bool, Ptr<Socket>, const Address &> (),
+                               MakeCallback (&MpTcpWindowUpdateTestCase::HandleAccept, this));
+  m_sockets.push_back (receiver);
+
+  m_sender = DynamicCast<MpTcpWindowUpdateTestSocket> (
+      nodes.Get (1)->GetObject<TcpL4Protocol> ()->CreateSocket (MpTcpWindowUpdateTestSocket::GetTypeId ()));
+  m_sender->SetAttribute ("SegmentSize", UintegerValue (SEGMENT_SIZE));
+  m_sender->SetAttribute ("FlowControl", BooleanValue (true));
+  m_sender->SetMaxSubFlowNumber (2);
+  m_sender->Bind ();
+  m_sender->Connect (InetSocketAddress (interfaces.GetAddress (0), port));
+  m_sender->SetConnectCallback (MakeCallback (&MpTcpWindowUpdateTestCase::ConnectionSucceeded, this),
+                                MakeCallback (&MpTcpWindowUpdateTestCase::ConnectionFailed, this));
+  m_sender->SetDataSentCallback (MakeCallback (&MpTcpWindowUpdateTestCase::DataSent, this));
+  m_sockets.push_back (m_sender);
+}
+
+void
+MpTcpWindowUpdateTestCase::SendData (Ptr<Socket> socket)
+{
+  Ptr<MpTcpSocketBase> mpSocket = DynamicCast<MpTcpSocketBase> (socket);
+  uint32_t total = SEGMENTS * SEGMENT_SIZE;
+  if (m_txBytes == total)
+    {
+      return;
+    }
+  while (m_txBytes < total && mpSocket->GetTxAvailable () > 0)
+    {
+      m_txBytes += mpSocket->FillBuffer (std::min (total - m_txBytes, mpSocket->GetTxAvailable ()));
+      mpSocket->SendBufferedData ();
+    }
+  if (m_txBytes == total)
+    {
+      mpSocket->Close ();
+    }
+}
+
+void
+MpTcpWindowUpdateTestCase::DataSent (Ptr<Socket> socket, uint32_t size)
+{
+  SendData (socket);
+}
+
+void
+MpTcpWindowUpdateTestCase::ConnectionSucceeded (Ptr<Socket> socket)
+{
+  // The links have no delay: wait for the second subflow, or the master one carries the whole flow
+  Simulator::Schedule (MilliSeconds (1), &MpTcpWindowUpdateTestCase::SendData, this, socket);
+}
+
+void
+MpTcpWindowUpdateTestCase::ConnectionFailed (Ptr<Socket> socket)
+{
+  NS_TEST_EXPECT_MSG_EQ (true, false, "Connection failed");
+}
+
+void
+MpTcpWindowUpdateTestCase::HandleAccept (Ptr<Socket> socket, const Address &from)
+{
+  socket->SetRecvCallback (MakeCallback (&MpTcpWindowUpdateTestCase::HandleRead, this));
+  m_sockets.push_back (socket);
+}
+
+void
+MpTcpWindowUpdateTestCase::HandleRead (Ptr<Socket> socket)
+{
+  m_rxBytes += DynamicCast<MpTcpSocketBase> (socket)->Recv (SEGMENTS * SEGMENT_SIZE);
+}
+
+void
+MpTcpWindowUpdateTestCase::DoRun (void)
+{
+  m_txBytes = 0;
+  m_rxBytes = 0;
+
+  SetupSimulation ();
+  Simulator::Stop (Seconds (20));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rxBytes, SEGMENTS * SEGMENT_SIZE, "The flow did not complete");
+  NS_TEST_EXPECT_MSG_GT (m_errorModel->GetShrunkAcks (), 0, "The second subflow sent no ACK");
+  NS_TEST_EXPECT_MSG_GT (m_errorModel->GetDupAcks (), 2, "Too few duplicate ACKs for a fast retransmit");
+  NS_TEST_EXPECT_MSG_EQ (m_sender->GetDupAcks (0), m_errorModel->GetDupAcks (),
+                         "Duplicate ACKs of the master subflow were taken for window updates");
+  m_sockets.clear ();
+  m_sender = 0;
+  m_errorModel = 0;
+}
+
+static class MpTcpWindowUpdateTestSuite : public TestSuite
+{
+public:
+  MpTcpWindowUpdateTestSuite ()
+    : TestSuite ("mp-tcp-window-update", UNIT)
+  {
+    AddTestCase (new MpTcpWindowUpdateTestCase (), TestCase::QUICK);
+  }
+} g_mpTcpWindowUpdateTestSuite;
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/rtt-estimator.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("RttHistoryTestSuite");
+
+using namespace ns3;
+
+/**
+ * Segments sent, retransmitted and acknowledged through the history ring,
+ * across its growth and wrap around: an RTT sample comes from the oldest
+ * acknowledged segment unless it was retransmitted, and every acknowledged
+ * segment counts once in the DCTCP marked / unmarked totals.
+ */
+class RttHistoryTestCase : public TestCase
+{
+public:
+  RttHistoryTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Send (uint32_t first, uint32_t n);
+  void Ack (uint32_t segment, bool marked, Time expected);
+  void Echo (Time echoed, Time expected);
+
+  Ptr<RttMeanDeviation> m_rtt;
+};
+
+RttHistoryTestCase::RttHistoryTestCase ()
+  : TestCase ("RTT history ring and timestamp samples")
+{
+}
+
+void
+RttHistoryTestCase::Send (uint32_t first, uint32_t n)
+{
+  for (uint32_t i = first; i < first + n; i++)
+    {
+      m_rtt->SentSeq (SequenceNumber32 (1 + i * 1000), 1000);
+    }
+}
+
+void
+RttHistoryTestCase::Ack (uint32_t segment, bool marked, Time expected)
+{
+  Time m = m_rtt->AckSeq (SequenceNumber32 (1 + segment * 1000), marked);
+  NS_TEST_EXPECT_MSG_EQ (m, expected, "Wrong RTT sample for the ACK of segment " << segment);
+}
+
+void
+RttHistoryTestCase::Echo (Time echoed, Time expected)
+{
+  NS_TEST_EXPECT_MSG_EQ (m_rtt->AckTimestamp (echoed), expected, "Wrong RTT sample from the timestamp");
+}
+
+void
+RttHistoryTestCase::DoRun (void)
+{
+  m_rtt = CreateObject<RttMeanDeviation> ();
+
+  // 40 segments grow the ring twice, then 5 and 6 are retransmitted
+  Simulator::Schedule (MilliSeconds (0), &RttHistoryTestCase::Send, this, 0, 40);
+  Simulator::Schedule (MilliSeconds (10), &RttHistoryTestCase::Send, this, 5, 2);
+  Simulator::Schedule (MilliSeconds (20), &RttHistoryTestCase::Ack, this, 3, false, MilliSeconds (20));
+  Simulator::Schedule (MilliSeconds (30), &RttHistoryTestCase::Ack, this, 6, true, MilliSeconds (30));
+  Simulator::Schedule (MilliSeconds (40), &RttHistoryTestCase::Ack, this, 7, false, Seconds (0));
+  // Duplicate ACKs and retransmissions below the window leave the history alone
+  Simulator::Schedule (MilliSeconds (45), &RttHistoryTestCase::Ack, this, 7, false, Seconds (0));
+  Simulator::Schedule (MilliSeconds (45), &RttHistoryTestCase::Send, this, 2, 1);
+  // These wrap around the end of the ring, where 65 is retransmitted
+  Simulator::Schedule (MilliSeconds (50), &RttHistoryTestCase::Send, this, 40, 30);
+  Simulator::Schedule (MilliSeconds (60), &RttHistoryTestCase::Send, this, 65, 1);
+  Simulator::Schedule (MilliSeconds (70), &RttHistoryTestCase::Ack, this, 65, false, MilliSeconds (70));
+  Simulator::Schedule (MilliSeconds (80), &RttHistoryTestCase::Ack, this, 66, false, Seconds (0));
+  Simulator::Schedule (MilliSeconds (90), &RttHistoryTestCase::Ack, this, 70, false, MilliSeconds (40));
+  Simulator::Schedule (MilliSeconds (100), &RttHistoryTestCase::Echo, this, MilliSeconds (75), MilliSeconds (25));
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  NS_TEST_ASSERT_MSG_EQ (m_rtt->m_marked, 3, "Every segment of a marked ACK should count as marked");
+  NS_TEST_ASSERT_MSG_EQ (m_rtt->m_nonMarked, 67, "Every segment of an unmarked ACK should count as unmarked");
+
+  // A cleared history starts over from the first sequence number
+  m_rtt->ClearSent ();
+  Send (0, 1);
+  NS_TEST_ASSERT_MSG_EQ (m_rtt->AckSeq (SequenceNumber32 (1001)), Seconds (0), "Wrong RTT sample after ClearSent");
+  NS_TEST_ASSERT_MSG_EQ (m_rtt->m_nonMarked, 68, "The segment sent after ClearSent should be acknowledged");
+  m_rtt = 0;
+}
+
+static class RttHistoryTestSuite : public TestSuite
+{
+public:
+  RttHistoryTestSuite ()
+    : TestSuite ("rtt-history", UNIT)
+  {
+    AddTestCase (new RttHistoryTestCase, TestCase::QUICK);
+  }
+} g_rttHistoryTestSuite;
@@ -0,0 +1,148 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/tcp-header.h"
+#include "ns3/packet.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("TcpHeaderOptionsTestSuite");
+
+using namespace ns3;
+
+/**
+ * MPTCP options stored in a TcpHeader should go through the wire format
+ * unchanged, and survive copies of the header.
+ */
+class TcpHeaderOptionsTestCase : public TestCase
+{
+public:
+  TcpHeaderOptionsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpHeaderOptionsTestCase::TcpHeaderOptionsTestCase ()
+  : TestCase ("TcpHeader MPTCP options serialization")
+{
+}
+
+void
+TcpHeaderOptionsTestCase::DoRun (void)
+{
+  TcpHeader header;
+  header.SetSourcePort (5000);
+  header.SetDestinationPort (80);
+  header.SetFlags (TcpHeader::SYN);
+  header.AddOptMPC (OPT_MPC, 0xdeadbeef);
+  header.AddOptADDR (OPT_ADDR, 1, Ipv4Address ("10.0.1.2"));
+  header.AddOptJOIN (OPT_JOIN, 42, 3);
+  header.AddOptDSN (OPT_DSN, 0x100000001ULL, 1400, 7001, 99, 1);
+  header.AddOptWS (OPT_WS, 7);
+  NS_TEST_ASSERT_MSG_EQ (header.GetNOptions (), 5, "Wrong number of options");
+  NS_TEST_ASSERT_MSG_EQ ((int) header.GetOptionsLength (), 39, "Wrong options length");
+
+  // Same framing as the sockets: options padded to a multiple of 4 bytes
+  uint8_t olen = header.GetOptionsLength ();
+  uint8_t plen = (4 - (olen % 4)) % 4;
+  header.SetLength (5 + (olen + plen) / 4);
+  header.SetPaddingLength (plen);
+
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (header);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100 + 20 + 40, "Wrong serialized size");
+
+  TcpHeader received;
+  p->RemoveHeader (received);
+  TcpHeader copy (received);
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      const TcpHeader &h = k == 0 ? received : copy;
+      NS_TEST_ASSERT_MSG_EQ (h.GetSourcePort (), 5000, "Wrong source port");
+      NS_TEST_ASSERT_MSG_EQ (h.GetNOptions (), 5, "Wrong number of options read back");
+      NS_TEST_ASSERT_MSG_EQ (h.GetOption (0).optName, OPT_MPC, "Wrong first option");
+      NS_TEST_ASSERT_MSG_EQ (h.GetOption (0).mpc.senderToken, 0xdeadbeef, "Wrong token");
+      NS_TEST_ASSERT_MSG_EQ (h.GetOption (1).optName, OPT_ADDR, "Wrong second option");
+      NS_TEST_ASSERT_MSG_EQ ((int) h.GetOption (1).addAddr.addrID, 1, "Wrong address id");
+      NS_TEST_ASSERT_MSG_EQ (h.GetOption (1).addAddr.GetAddress (), Ipv4Address ("10.0.1.2"), "Wrong address");
+      NS_TEST_ASSERT_MSG_EQ (h.GetOption (2).join.receiverToken, 42, "Wrong join token");
+      NS_TEST_ASSERT_MSG_EQ ((int) h.GetOption (2).join.addrID, 3, "Wrong join address id");
+      const OptDataSeqMapping &dsn = h.GetOption (3).dsn;
+      NS_TEST_ASSERT_MSG_EQ (h.GetOption (3).optName, OPT_DSN, "Wrong fourth option");
+      NS_TEST_ASSERT_MSG_EQ (dsn.dataSeqNumber, 0x100000001ULL, "Wrong data sequence number");
+      NS_TEST_ASSERT_MSG_EQ (dsn.dataLevelLength, 1400, "Wrong data level length");
+      NS_TEST_ASSERT_MSG_EQ (dsn.subflowSeqNumber, 7001, "Wrong subflow sequence number");
+      NS_TEST_ASSERT_MSG_EQ (dsn.receiverToken, 99, "Wrong receiver token");
+      NS_TEST_ASSERT_MSG_EQ ((int) dsn.pScatter, 1, "Wrong packet scatter flag");
+      NS_TEST_ASSERT_MSG_EQ (h.GetOption (4).optName, OPT_WS, "Wrong last option");
+      NS_TEST_ASSERT_MSG_EQ ((int) h.GetOption (4).ws.shift, 7, "Wrong window scale");
+    }
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100, "Options and padding should all be removed");
+}
+
+/**
+ * A header holds as many options as 40 bytes of option space allow, and
+ * refuses more without aborting.
+ */
+class TcpHeaderFullOptionsTestCase : public TestCase
+{
+public:
+  TcpHeaderFullOptionsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+TcpHeaderFullOptionsTestCase::TcpHeaderFullOptionsTestCase ()
+  : TestCase ("TcpHeader with a full option space")
+{
+}
+
+void
+TcpHeaderFullOptionsTestCase::DoRun (void)
+{
+  TcpHeader header;
+  for (uint32_t k = 0; k < TcpHeader::MAX_OPTIONS; k++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (header.AddOptWS (OPT_WS, k), true, "Option " << k << " refused");
+    }
+  NS_TEST_ASSERT_MSG_EQ (header.AddOptADDR (OPT_ADDR, 1, Ipv4Address ("10.0.1.2")), false,
+                         "Option accepted past the option space");
+  NS_TEST_ASSERT_MSG_EQ ((int) header.GetOptionsLength (), 40, "Wrong options length");
+  header.SetLength (5 + 40 / 4);
+
+  Ptr<Packet> p = Create<Packet> (100);
+  p->AddHeader (header);
+  TcpHeader received;
+  p->RemoveHeader (received);
+  NS_TEST_ASSERT_MSG_EQ (received.GetNOptions (), TcpHeader::MAX_OPTIONS, "Wrong number of options read back");
+  NS_TEST_ASSERT_MSG_EQ ((int) received.GetOption (TcpHeader::MAX_OPTIONS - 1).ws.shift, TcpHeader::MAX_OPTIONS - 1,
+                         "Wrong last option");
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 100, "Options should all be removed");
+}
+
+static class TcpHeaderOptionsTestSuite : public TestSuite
+{
+public:
+  TcpHeaderOptionsTestSuite ()
+    : TestSuite ("tcp-header-options", UNIT)
+  {
+    AddTestCase (new TcpHeaderOptionsTestCase, TestCase::QUICK);
+    AddTestCase (new TcpHeaderFullOptionsTestCase, TestCase::QUICK);
+  }
+} g_tcpHeaderOptionsTestSuite;
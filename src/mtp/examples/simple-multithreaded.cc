@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * Dumbbell of point-to-point links, with an OnOff client on each left
+ * leaf sending to a packet sink on the matching right leaf. With --mtp,
+ * the simulation runs on MultithreadedSimulatorImpl: every node is a
+ * partition of its own, and the leaf links give the lookahead.
+ *
+ *   ./waf --run "simple-multithreaded --mtp=1 --threads=4"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/point-to-point-dumbbell.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/system-wall-clock-ms.h"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("SimpleMultithreaded");
+
+int
+main (int argc, char *argv[])
+{
+  bool mtp = false;
+  uint32_t threads = 0;
+  uint32_t nLeaves = 8;
+  double stopTime = 5.0;
+
+  CommandLine cmd;
+  cmd.AddValue ("mtp", "Run on ns3::MultithreadedSimulatorImpl", mtp);
+  cmd.AddValue ("threads", "Maximum number of threads, 0 for one per CPU", threads);
+  cmd.AddValue ("leaves", "Number of leaves on each side of the dumbbell", nLeaves);
+  cmd.AddValue ("stop", "Simulated seconds", stopTime);
+  cmd.Parse (argc, argv);
+
+  if (mtp)
+    {
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue ("ns3::MultithreadedSimulatorImpl"));
+      Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (threads));
+    }
+  Config::SetDefault ("ns3::OnOffApplication::DataRate", StringValue ("5Mbps"));
+  Config::SetDefault ("ns3::OnOffApplication::PacketSize", UintegerValue (1000));
+
+  PointToPointHelper leaf;
+  leaf.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  leaf.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  PointToPointHelper bottleneck;
+  bottleneck.SetDeviceAttribute ("DataRate", StringValue ("100Mbps"));
+  bottleneck.SetChannelAttribute ("Delay", StringValue ("5ms"));
+  PointToPointDumbbellHelper dumbbell (nLeaves, leaf, nLeaves, leaf, bottleneck);
+
+  InternetStackHelper stack;
+  dumbbell.InstallStack (stack);
+  dumbbell.AssignIpv4Addresses (Ipv4AddressHelper ("10.1.0.0", "255.255.255.0"),
+                                Ipv4AddressHelper ("10.2.0.0", "255.255.255.0"),
+                                Ipv4AddressHelper ("10.3.0.0", "255.255.255.0"));
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  ApplicationContainer sinks;
+  for (uint32_t i = 0; i < nLeaves; ++i)
+    {
+      PacketSinkHelper sink ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), 9));
+      sinks.Add (sink.Install (dumbbell.GetRight (i)));
+      OnOffHelper client ("ns3::UdpSocketFactory", InetSocketAddress (dumbbell.GetRightIpv4Address (i), 9));
+      client.SetAttribute ("OnTime", StringValue ("ns3::ExponentialRandomVariable[Mean=0.2]"));
+      client.SetAttribute ("OffTime", StringValue ("ns3::ExponentialRandomVariable[Mean=0.1]"));
+      ApplicationContainer app = client.Install (dumbbell.GetLeft (i));
+      app.Start (Seconds (0.1 * (i + 1)));
+    }
+
+  Simulator::Stop (Seconds (stopTime));
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t elapsed = clock.End ();
+
+  Ptr<MultithreadedSimulatorImpl> impl = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  if (impl != 0)
+    {
+      std::cout << impl->GetPartitionCount () << " partitions, lookahead "
+                << impl->GetLookAhead ().GetSeconds () << "s" << std::endl;
+    }
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < sinks.GetN (); ++i)
+    {
+      uint64_t rx = DynamicCast<PacketSink> (sinks.Get (i))->GetTotalRx ();
+      std::cout << "sink " << i << " " << rx << " bytes" << std::endl;
+      total += rx;
+    }
+  std::cout << "total " << total << " bytes in " << elapsed << "ms" << std::endl;
+  Simulator::Destroy ();
+  return 0;
+}
@@ -0,0 +1,786 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/uinteger.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include "ns3/channel.h"
+#include "ns3/net-device.h"
+#include "ns3/point-to-point-channel.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <unistd.h>
+#include <sched.h>
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the possibility
+// of causing recursions leading to stack overflow
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl)
+  ;
+
+// partition index of the events which run on the main thread
+static const uint32_t NO_PARTITION = 0xffffffff;
+static const uint64_t MAX_TS = 0x7fffffffffffffffULL;
+
+#ifdef NS3_MTP
+__thread MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::m_current = 0;
+#else
+MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::m_current = 0;
+#endif
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("MaxThreads",
+                   "Maximum number of threads running partitions, 0 for one per online CPU. "
+                   "Builds configured without --enable-mtp always use a single thread.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_maxThreads),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+  m_stop = false;
+  // uids are allocated from 4, see DefaultSimulatorImpl
+  m_uid = 4;
+  m_currentUid = 0;
+  m_currentTs = 0;
+  m_currentContext = 0xffffffff;
+  m_maxThreads = 0;
+  m_lookAhead = MAX_TS;
+  m_windowEnd = 0;
+  m_nextActive = 0;
+  m_exit = false;
+  m_barrierCount = 0;
+  m_barrierGeneration = 0;
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_events->IsEmpty ())
+    {
+      Scheduler::Event next = m_events->RemoveNext ();
+      next.impl->Unref ();
+    }
+  m_events = 0;
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      Partition *partition = m_partitions[i];
+      while (!partition->events->IsEmpty ())
+        {
+          Scheduler::Event next = partition->events->RemoveNext ();
+          next.impl->Unref ();
+        }
+      delete partition;
+    }
+  m_partitions.clear ();
+  m_nodePartition.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  m_schedulerFactory = schedulerFactory;
+  Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+  if (m_events != 0)
+    {
+      while (!m_events->IsEmpty ())
+        {
+          scheduler->Insert (m_events->RemoveNext ());
+        }
+    }
+  m_events = scheduler;
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      Partition *partition = m_partitions[i];
+      scheduler = schedulerFactory.Create<Scheduler> ();
+      while (!partition->events->IsEmpty ())
+        {
+          scheduler->Insert (partition->events->RemoveNext ());
+        }
+      partition->events = scheduler;
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartitionCount (void) const
+{
+  return m_partitions.size ();
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetPartition (uint32_t nodeId) const
+{
+  NS_ASSERT (nodeId < m_nodePartition.size ());
+  return m_nodePartition[nodeId];
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookAhead (void) const
+{
+  return TimeStep (m_lookAhead);
+}
+
+static uint32_t
+FindRoot (std::vector<uint32_t> &parent, uint32_t i)
+{
+  while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+  return i;
+}
+
+void
+MultithreadedSimulatorImpl::DoPartition (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nNodes = NodeList::GetNNodes ();
+
+  // Nodes end up in the same partition unless all the channels between
+  // them are point-to-point channels with a delay to use as lookahead.
+  std::vector<uint32_t> parent (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      parent[i] = i;
+    }
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          Ptr<Channel> channel = node->GetDevice (j)->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          if (DynamicCast<PointToPointChannel> (channel) != 0)
+            {
+              TimeValue delay;
+              channel->GetAttribute ("Delay", delay);
+              if (delay.Get ().IsStrictlyPositive ())
+                {
+                  continue;
+                }
+            }
+          for (uint32_t k = 0; k < channel->GetNDevices (); ++k)
+            {
+              uint32_t a = FindRoot (parent, i);
+              uint32_t b = FindRoot (parent, channel->GetDevice (k)->GetNode ()->GetId ());
+              parent[a > b ? a : b] = a > b ? b : a;
+            }
+        }
+    }
+
+  // partitions are numbered in the order of their first node
+  m_nodePartition.assign (nNodes, NO_PARTITION);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      uint32_t root = FindRoot (parent, i);
+      if (m_nodePartition[root] == NO_PARTITION)
+        {
+          Partition *partition = new Partition ();
+          partition->events = m_schedulerFactory.Create<Scheduler> ();
+          partition->currentTs = m_currentTs;
+          partition->currentUid = m_currentUid;
+          partition->currentContext = 0xffffffff;
+          partition->uid = m_uid;
+          partition->streamIndex = (1ULL << 62) + (static_cast<uint64_t> (m_partitions.size ()) << 32);
+          partition->stop = false;
+          m_nodePartition[root] = m_partitions.size ();
+          m_partitions.push_back (partition);
+        }
+      m_nodePartition[i] = m_nodePartition[root];
+    }
+
+  m_lookAhead = MAX_TS;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          Ptr<Channel> channel = node->GetDevice (j)->GetChannel ();
+          if (channel == 0 || DynamicCast<PointToPointChannel> (channel) == 0)
+            {
+              continue;
+            }
+          for (uint32_t k = 0; k < channel->GetNDevices (); ++k)
+            {
+              if (m_nodePartition[channel->GetDevice (k)->GetNode ()->GetId ()] != m_nodePartition[i])
+                {
+                  TimeValue delay;
+                  channel->GetAttribute ("Delay", delay);
+                  if ((uint64_t)delay.Get ().GetTimeStep () < m_lookAhead)
+                    {
+                      m_lookAhead = delay.Get ().GetTimeStep ();
+                    }
+                }
+            }
+        }
+    }
+  NS_LOG_INFO (m_partitions.size () << " partitions of " << nNodes << " nodes, lookahead " << GetLookAhead ());
+
+  // hand the events scheduled so far over to their partitions, keeping their uids
+  Ptr<Scheduler> global = m_schedulerFactory.Create<Scheduler> ();
+  while (!m_events->IsEmpty ())
+    {
+      Scheduler::Event next = m_events->RemoveNext ();
+      Partition *partition = PeekPartition (next.key.m_context);
+      if (partition != 0)
+        {
+          partition->events->Insert (next);
+        }
+      else
+        {
+          global->Insert (next);
+        }
+    }
+  m_events = global;
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::PeekPartition (uint32_t context) const
+{
+  if (context < m_nodePartition.size ())
+    {
+      return m_partitions[m_nodePartition[context]];
+    }
+  return 0;
+}
+
+void
+MultithreadedSimulatorImpl::CheckAccess (Partition *partition, const char *method) const
+{
+  // the events of the main thread may be looked at, not removed, by partitions
+  if (m_current != 0 && partition != m_current && (partition != 0 || method[0] == 'R'))
+    {
+      NS_FATAL_ERROR ("Simulator::" << method << " on an event of another partition");
+    }
+}
+
+uint32_t
+MultithreadedSimulatorImpl::Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event)
+{
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = ts;
+  ev.key.m_context = context;
+  if (partition == 0)
+    {
+      ev.key.m_uid = m_uid;
+      m_uid++;
+      m_events->Insert (ev);
+    }
+  else
+    {
+      ev.key.m_uid = partition->uid;
+      partition->uid++;
+      partition->events->Insert (ev);
+    }
+  return ev.key.m_uid;
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop || !m_events->IsEmpty ())
+    {
+      return m_stop;
+    }
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      if (!m_partitions[i]->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent (void)
+{
+  Scheduler::Event next = m_events->RemoveNext ();
+
+  NS_ASSERT (next.key.m_ts >= m_currentTs);
+  m_currentTs = next.key.m_ts;
+  m_currentContext = next.key.m_context;
+  m_currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::RunPartition (Partition *partition)
+{
+  m_current = partition;
+  RngSeedManager::SetStreamIndexCounter (&partition->streamIndex);
+  while (!partition->events->IsEmpty () && !partition->stop
+         && partition->events->PeekNext ().key.m_ts < m_windowEnd)
+    {
+      Scheduler::Event next = partition->events->RemoveNext ();
+      partition->currentTs = next.key.m_ts;
+      partition->currentContext = next.key.m_context;
+      partition->currentUid = next.key.m_uid;
+      next.impl->Invoke ();
+      next.impl->Unref ();
+    }
+  RngSeedManager::SetStreamIndexCounter (0);
+  m_current = 0;
+}
+
+void
+MultithreadedSimulatorImpl::DeliverOutboxes (void)
+{
+  // Packets crossing partitions are queued by their sender and merged
+  // here in partition order, so that the receivers get the same uids
+  // whichever thread ran the senders.
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      std::vector<OutboxEvent> &outbox = m_partitions[i]->outbox;
+      for (std::vector<OutboxEvent>::const_iterator j = outbox.begin (); j != outbox.end (); ++j)
+        {
+          if (j->ts < m_windowEnd)
+            {
+              NS_FATAL_ERROR ("Event for context " << j->context << " scheduled at " << TimeStep (j->ts)
+                              << " within the lookahead of its sender");
+            }
+          Insert (j->partition == NO_PARTITION ? 0 : m_partitions[j->partition], j->ts, j->context, j->event);
+        }
+      outbox.clear ();
+      if (m_partitions[i]->stop)
+        {
+          m_partitions[i]->stop = false;
+          m_stop = true;
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Barrier (void)
+{
+  uint32_t generation = m_barrierGeneration;
+  if (__sync_add_and_fetch (&m_barrierCount, 1) == m_threads.size () + 1)
+    {
+      m_barrierCount = 0;
+      __sync_add_and_fetch (&m_barrierGeneration, 1);
+    }
+  else
+    {
+      while (m_barrierGeneration == generation)
+        {
+          sched_yield ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::ClaimPartitions (void)
+{
+  while (true)
+    {
+      uint32_t i = __sync_fetch_and_add (&m_nextActive, 1);
+      if (i >= m_active.size ())
+        {
+          break;
+        }
+      RunPartition (m_active[i]);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Worker (void)
+{
+  while (true)
+    {
+      Barrier ();
+      if (m_exit)
+        {
+          break;
+        }
+      ClaimPartitions ();
+      Barrier ();
+    }
+  // the events freed by this thread would be lost with it
+  EventImpl::ReleasePool ();
+}
+
+void
+MultithreadedSimulatorImpl::RunWindow (void)
+{
+  m_active.clear ();
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      Partition *partition = m_partitions[i];
+      if (!partition->events->IsEmpty () && partition->events->PeekNext ().key.m_ts < m_windowEnd)
+        {
+          m_active.push_back (partition);
+        }
+    }
+  m_nextActive = 0;
+  if (m_threads.empty () || m_active.size () == 1)
+    {
+      ClaimPartitions ();
+      return;
+    }
+  Barrier ();
+  ClaimPartitions ();
+  Barrier ();
+}
+
+void
+MultithreadedSimulatorImpl::StartThreads (void)
+{
+  uint32_t nThreads = 1;
+#ifdef NS3_MTP
+  nThreads = m_maxThreads;
+  if (nThreads == 0)
+    {
+      long online = sysconf (_SC_NPROCESSORS_ONLN);
+      nThreads = online > 0 ? online : 1;
+    }
+#endif
+  if (nThreads > m_partitions.size ())
+    {
+      nThreads = m_partitions.size ();
+    }
+  m_exit = false;
+  for (uint32_t i = 1; i < nThreads; ++i)
+    {
+      Ptr<SystemThread> thread = Create<SystemThread> (MakeCallback (&MultithreadedSimulatorImpl::Worker, this));
+      m_threads.push_back (thread);
+    }
+  for (uint32_t i = 0; i < m_threads.size (); ++i)
+    {
+      m_threads[i]->Start ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::StopThreads (void)
+{
+  if (m_threads.empty ())
+    {
+      return;
+    }
+  m_exit = true;
+  Barrier ();
+  for (uint32_t i = 0; i < m_threads.size (); ++i)
+    {
+      m_threads[i]->Join ();
+    }
+  m_threads.clear ();
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_partitions.empty ())
+    {
+      DoPartition ();
+    }
+  m_stop = false;
+  StartThreads ();
+
+  while (!m_stop)
+    {
+      uint64_t next = MAX_TS;
+      bool pending = false;
+      for (uint32_t i = 0; i < m_partitions.size (); ++i)
+        {
+          if (!m_partitions[i]->events->IsEmpty ())
+            {
+              uint64_t ts = m_partitions[i]->events->PeekNext ().key.m_ts;
+              next = ts < next ? ts : next;
+              pending = true;
+            }
+        }
+      if (!m_events->IsEmpty () && (!pending || m_events->PeekNext ().key.m_ts <= next))
+        {
+          ProcessOneEvent ();
+          continue;
+        }
+      if (!pending)
+        {
+          break;
+        }
+      m_windowEnd = next + (m_lookAhead < MAX_TS - next ? m_lookAhead : MAX_TS - next);
+      if (!m_events->IsEmpty () && m_events->PeekNext ().key.m_ts < m_windowEnd)
+        {
+          m_windowEnd = m_events->PeekNext ().key.m_ts;
+        }
+      RunWindow ();
+      DeliverOutboxes ();
+    }
+
+  StopThreads ();
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      if (m_partitions[i]->currentTs > m_currentTs)
+        {
+          m_currentTs = m_partitions[i]->currentTs;
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_current != 0)
+    {
+      // the other partitions complete the current window
+      m_current->stop = true;
+    }
+  else
+    {
+      m_stop = true;
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &time)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep ());
+  Simulator::Schedule (time, &Simulator::Stop);
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << time.GetTimeStep () << event);
+
+  Time tAbsolute = time + Now ();
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= Now ());
+  uint64_t ts = tAbsolute.GetTimeStep ();
+  uint32_t context = GetContext ();
+  Partition *partition = m_current != 0 ? m_current : PeekPartition (context);
+  uint32_t uid = Insert (partition, ts, context, event);
+  return EventId (event, ts, context, uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << time.GetTimeStep () << event);
+
+  uint64_t ts = (time + Now ()).GetTimeStep ();
+  Partition *partition = PeekPartition (context);
+  if (m_current == 0 || partition == m_current)
+    {
+      Insert (partition, ts, context, event);
+    }
+  else
+    {
+      OutboxEvent ev;
+      ev.partition = partition != 0 ? m_nodePartition[context] : NO_PARTITION;
+      ev.ts = ts;
+      ev.context = context;
+      ev.event = event;
+      m_current->outbox.push_back (ev);
+    }
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  uint64_t ts = Now ().GetTimeStep ();
+  uint32_t context = GetContext ();
+  Partition *partition = m_current != 0 ? m_current : PeekPartition (context);
+  uint32_t uid = Insert (partition, ts, context, event);
+  return EventId (event, ts, context, uid);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  EventId id (Ptr<EventImpl> (event, false), Now ().GetTimeStep (), 0xffffffff, 2);
+  CriticalSection cs (m_destroyEventsMutex);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (m_current != 0 ? m_current->currentTs : m_currentTs);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return m_current != 0 ? m_current->currentContext : m_currentContext;
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs ()) - Now ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyEventsMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (IsExpired (id))
+    {
+      return;
+    }
+  Partition *partition = PeekPartition (id.GetContext ());
+  CheckAccess (partition, "Remove");
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  (partition != 0 ? partition->events : m_events)->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &ev) const
+{
+  if (ev.GetUid () == 2)
+    {
+      if (ev.PeekEventImpl () == 0 ||
+          ev.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_destroyEventsMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == ev)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  if (ev.PeekEventImpl () == 0)
+    {
+      return true;
+    }
+  // uids are only ordered within the queue which holds the event
+  Partition *partition = PeekPartition (ev.GetContext ());
+  CheckAccess (partition, "IsExpired");
+  uint64_t currentTs = partition != 0 ? partition->currentTs : m_currentTs;
+  uint32_t currentUid = partition != 0 ? partition->currentUid : m_currentUid;
+  if (ev.GetTs () < currentTs ||
+      (ev.GetTs () == currentTs &&
+       ev.GetUid () <= currentUid) ||
+      ev.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+} // namespace ns3
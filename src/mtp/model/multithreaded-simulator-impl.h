@@ -0,0 +1,169 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#include "ns3/object-factory.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+#include "ns3/core-config.h"
+
+#include <list>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup mtp
+ *
+ * \brief Conservative parallel simulator running node partitions on
+ * threads of a single process
+ *
+ * When Run is first called, the nodes of the NodeList are split into
+ * partitions joined only by point-to-point channels with a non-zero
+ * delay. The smallest such delay is the lookahead: the partitions
+ * execute their events in parallel in windows of that length, and the
+ * packets they send to each other are handed over, as events holding
+ * the Packet itself, at the barrier which closes each window.
+ *
+ * Events which are not bound to a node of a partition (context
+ * 0xffffffff, or nodes created after the first Run) execute on the
+ * main thread while the partitions are idle.
+ *
+ * Within a partition, events run in the same order whatever the number
+ * of threads, so that a simulation is reproducible for a given seed
+ * and topology. Threads are only used in builds configured with
+ * --enable-mtp; other builds run the partitions one after the other.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &time);
+  virtual EventId Schedule (Time const &time, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &time, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &ev);
+  virtual void Cancel (const EventId &ev);
+  virtual bool IsExpired (const EventId &ev) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * \returns the number of node partitions, 0 before the first Run
+   */
+  uint32_t GetPartitionCount (void) const;
+  /**
+   * \param nodeId a node of the NodeList
+   * \returns the partition which runs the events of the node
+   */
+  uint32_t GetPartition (uint32_t nodeId) const;
+  /**
+   * \returns the length of the windows executed in parallel
+   */
+  Time GetLookAhead (void) const;
+
+private:
+  struct OutboxEvent
+  {
+    uint32_t partition;
+    uint64_t ts;
+    uint32_t context;
+    EventImpl *event;
+  };
+  struct Partition
+  {
+    Ptr<Scheduler> events;
+    uint64_t currentTs;
+    uint32_t currentUid;
+    uint32_t currentContext;
+    uint32_t uid;
+    uint64_t streamIndex;
+    bool stop;
+    std::vector<OutboxEvent> outbox;
+  };
+
+  virtual void DoDispose (void);
+  void DoPartition (void);
+  Partition *PeekPartition (uint32_t context) const;
+  void CheckAccess (Partition *partition, const char *method) const;
+  uint32_t Insert (Partition *partition, uint64_t ts, uint32_t context, EventImpl *event);
+  void ProcessOneEvent (void);
+  void DeliverOutboxes (void);
+  void RunPartition (Partition *partition);
+  void RunWindow (void);
+  void ClaimPartitions (void);
+  void StartThreads (void);
+  void StopThreads (void);
+  void Worker (void);
+  void Barrier (void);
+
+  typedef std::list<EventId> DestroyEvents;
+  DestroyEvents m_destroyEvents;
+  SystemMutex m_destroyEventsMutex;
+  bool m_stop;
+  ObjectFactory m_schedulerFactory;
+  Ptr<Scheduler> m_events;
+
+  uint32_t m_uid;
+  uint32_t m_currentUid;
+  uint64_t m_currentTs;
+  uint32_t m_currentContext;
+
+  uint32_t m_maxThreads;
+  std::vector<Partition *> m_partitions;
+  std::vector<uint32_t> m_nodePartition;
+  uint64_t m_lookAhead;
+
+  // state of the window being executed, shared with the workers
+  std::vector<Partition *> m_active;
+  uint64_t m_windowEnd;
+  volatile uint32_t m_nextActive;
+  volatile bool m_exit;
+  std::vector<Ptr<SystemThread> > m_threads;
+  volatile uint32_t m_barrierCount;
+  volatile uint32_t m_barrierGeneration;
+
+  // partition run by the calling thread, 0 on the main thread
+#ifdef NS3_MTP
+  static __thread Partition *m_current;
+#else
+  static Partition *m_current;
+#endif
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
@@ -0,0 +1,245 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/global-value.h"
+#include "ns3/config.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/multithreaded-simulator-impl.h"
+
+#include <sstream>
+
+using namespace ns3;
+
+/**
+ * Chain of five nodes, 0-1-2-3-4, sending packets from both ends. The
+ * link between nodes 3 and 4 has no delay, so that they share a
+ * partition. Every node logs the packets it receives.
+ */
+class MtpChain
+{
+public:
+  MtpChain (bool jitter);
+  /**
+   * \param impl simulator implementation to run the chain with
+   * \param threads MaxThreads of ns3::MultithreadedSimulatorImpl
+   * \returns the receive logs of all nodes
+   */
+  std::string Run (std::string impl, uint32_t threads);
+
+  uint32_t m_partitions;
+  Time m_lookAhead;
+  bool m_sharedPartition;
+
+private:
+  bool Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+  void Send (Ptr<NetDevice> device, Ptr<Packet> packet);
+  void Generate (Ptr<NetDevice> device, Time interval, uint32_t size, uint32_t count);
+
+  bool m_jitter;
+  std::vector<std::string> m_logs;
+  std::vector<Ptr<UniformRandomVariable> > m_rvs;
+};
+
+MtpChain::MtpChain (bool jitter)
+  : m_partitions (0),
+    m_sharedPartition (false),
+    m_jitter (jitter)
+{
+}
+
+bool
+MtpChain::Receive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  Ptr<Node> node = device->GetNode ();
+  std::ostringstream oss;
+  oss << node->GetId () << " " << Simulator::Now ().GetNanoSeconds () << " " << packet->GetSize () << "\n";
+  m_logs[node->GetId ()] += oss.str ();
+  if (node->GetNDevices () < 2)
+    {
+      return true;
+    }
+  Ptr<NetDevice> next = node->GetDevice (1 - device->GetIfIndex ());
+  if (!m_jitter)
+    {
+      Send (next, packet->Copy ());
+      return true;
+    }
+  // created while the simulation runs, to check the streams of the partitions
+  if (m_rvs[node->GetId ()] == 0)
+    {
+      m_rvs[node->GetId ()] = CreateObject<UniformRandomVariable> ();
+    }
+  Simulator::Schedule (MicroSeconds (m_rvs[node->GetId ()]->GetInteger (0, 500)),
+                       &MtpChain::Send, this, next, packet->Copy ());
+  return true;
+}
+
+void
+MtpChain::Send (Ptr<NetDevice> device, Ptr<Packet> packet)
+{
+  device->Send (packet, device->GetBroadcast (), 0x800);
+}
+
+void
+MtpChain::Generate (Ptr<NetDevice> device, Time interval, uint32_t size, uint32_t count)
+{
+  Send (device, Create<Packet> (size));
+  if (count > 1)
+    {
+      Simulator::Schedule (interval, &MtpChain::Generate, this, device, interval, size, count - 1);
+    }
+}
+
+std::string
+MtpChain::Run (std::string impl, uint32_t threads)
+{
+  Simulator::Destroy ();
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue (impl));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (threads));
+
+  NodeContainer nodes;
+  nodes.Create (5);
+  PointToPointHelper p2p;
+  p2p.SetDeviceAttribute ("DataRate", StringValue ("10Mbps"));
+  NetDeviceContainer devices;
+  const char *delays[] = { "2ms", "3ms", "1ms", "0ms" };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      p2p.SetChannelAttribute ("Delay", StringValue (delays[i]));
+      devices.Add (p2p.Install (nodes.Get (i), nodes.Get (i + 1)));
+    }
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      devices.Get (i)->SetReceiveCallback (MakeCallback (&MtpChain::Receive, this));
+    }
+  m_logs.assign (nodes.GetN (), "");
+  m_rvs.assign (nodes.GetN (), 0);
+
+  Ptr<NetDevice> first = devices.Get (0);
+  Ptr<NetDevice> last = devices.Get (devices.GetN () - 1);
+  Simulator::ScheduleWithContext (0, Seconds (0), &MtpChain::Generate, this,
+                                  first, MicroSeconds (1000), 500, 20);
+  Simulator::ScheduleWithContext (4, MicroSeconds (250), &MtpChain::Generate, this,
+                                  last, MicroSeconds (1300), 300, 20);
+  Simulator::Run ();
+
+  Ptr<MultithreadedSimulatorImpl> mtp = DynamicCast<MultithreadedSimulatorImpl> (Simulator::GetImplementation ());
+  if (mtp != 0)
+    {
+      m_partitions = mtp->GetPartitionCount ();
+      m_lookAhead = mtp->GetLookAhead ();
+      m_sharedPartition = mtp->GetPartition (3) == mtp->GetPartition (4);
+    }
+  m_rvs.clear ();
+  Simulator::Destroy ();
+  GlobalValue::Bind ("SimulatorImplementationType", StringValue ("ns3::DefaultSimulatorImpl"));
+  Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (0));
+
+  std::string log;
+  for (uint32_t i = 0; i < m_logs.size (); i++)
+    {
+      log += m_logs[i];
+    }
+  return log;
+}
+
+class MtpPartitionTestCase : public TestCase
+{
+public:
+  MtpPartitionTestCase ();
+  virtual void DoRun (void);
+};
+
+MtpPartitionTestCase::MtpPartitionTestCase ()
+  : TestCase ("Check the partitions and the lookahead of a point-to-point chain")
+{
+}
+
+void
+MtpPartitionTestCase::DoRun (void)
+{
+  MtpChain chain (false);
+  std::string log = chain.Run ("ns3::MultithreadedSimulatorImpl", 1);
+  NS_TEST_ASSERT_MSG_EQ (chain.m_partitions, 4, "nodes 3 and 4 are not separated by a delay");
+  NS_TEST_ASSERT_MSG_EQ (chain.m_sharedPartition, true, "nodes 3 and 4 are in different partitions");
+  NS_TEST_ASSERT_MSG_EQ (chain.m_lookAhead, MilliSeconds (1), "lookahead is not the smallest delay");
+  NS_TEST_ASSERT_MSG_EQ (log.empty (), false, "no packet received");
+}
+
+class MtpDefaultTestCase : public TestCase
+{
+public:
+  MtpDefaultTestCase ();
+  virtual void DoRun (void);
+};
+
+MtpDefaultTestCase::MtpDefaultTestCase ()
+  : TestCase ("Check that partitions receive packets as with the default simulator")
+{
+}
+
+void
+MtpDefaultTestCase::DoRun (void)
+{
+  MtpChain chain (false);
+  std::string expected = chain.Run ("ns3::DefaultSimulatorImpl", 0);
+  NS_TEST_ASSERT_MSG_EQ (chain.Run ("ns3::MultithreadedSimulatorImpl", 1), expected, "single thread differs");
+  NS_TEST_ASSERT_MSG_EQ (chain.Run ("ns3::MultithreadedSimulatorImpl", 4), expected, "four threads differ");
+}
+
+class MtpThreadsTestCase : public TestCase
+{
+public:
+  MtpThreadsTestCase ();
+  virtual void DoRun (void);
+};
+
+MtpThreadsTestCase::MtpThreadsTestCase ()
+  : TestCase ("Check that random forwarding delays do not depend on the number of threads")
+{
+}
+
+void
+MtpThreadsTestCase::DoRun (void)
+{
+  MtpChain chain (true);
+  std::string expected = chain.Run ("ns3::MultithreadedSimulatorImpl", 1);
+  NS_TEST_ASSERT_MSG_EQ (chain.Run ("ns3::MultithreadedSimulatorImpl", 2), expected, "two threads differ");
+  NS_TEST_ASSERT_MSG_EQ (chain.Run ("ns3::MultithreadedSimulatorImpl", 4), expected, "four threads differ");
+}
+
+class MtpTestSuite : public TestSuite
+{
+public:
+  MtpTestSuite ();
+};
+
+MtpTestSuite::MtpTestSuite ()
+  : TestSuite ("multithreaded-simulator", UNIT)
+{
+  AddTestCase (new MtpPartitionTestCase, TestCase::QUICK);
+  AddTestCase (new MtpDefaultTestCase, TestCase::QUICK);
+  AddTestCase (new MtpThreadsTestCase, TestCase::QUICK);
+}
+
+static MtpTestSuite g_mtpTestSuite;
@@ -24,6 +24,7 @@
 #include <vector>
 #include <ostream>
 #include "ns3/assert.h"
+#include "ns3/atomic-counter.h"
 
 #define noBUFFER_FREE_LIST 1
 
@@ -594,7 +595,11 @@ private:
    * writing data. i.e., m_start should be initialized to this 
    * value.
    */
+#ifdef NS3_MTP
+  static __thread uint32_t g_recommendedStart;
+#else
   static uint32_t g_recommendedStart;
+#endif
 
   /* offset to the start of the virtual zero area from the start 
    * of m_data->m_data
@@ -861,7 +866,7 @@ Buffer::Buffer (Buffer const&o)
     m_start (o.m_start),
     m_end (o.m_end)
 {
-  m_data->m_count++;
+  AtomicIncrement (m_data->m_count);
   NS_ASSERT (CheckInternalState ());
 }
 
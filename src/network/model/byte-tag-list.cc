@@ -18,13 +18,17 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "byte-tag-list.h"
+#include "ns3/atomic-counter.h"
 #include "ns3/log.h"
 #include <vector>
 #include <cstring>
 
 NS_LOG_COMPONENT_DEFINE ("ByteTagList");
 
+#ifndef NS3_MTP
+// The free list is shared by all threads
 #define USE_FREE_LIST 1
+#endif
 #define FREE_LIST_SIZE 1000
 #define OFFSET_MAX (2147483647)
 
@@ -135,7 +139,7 @@ ByteTagList::ByteTagList (const ByteTagList &o)
   NS_LOG_FUNCTION (this << &o);
   if (m_data != 0)
     {
-      m_data->count++;
+      AtomicIncrement (m_data->count);
     }
 }
 ByteTagList &
@@ -151,7 +155,7 @@ ByteTagList::operator = (const ByteTagList &o)
   m_used = o.m_used;
   if (m_data != 0)
     {
-      m_data->count++;
+      AtomicIncrement (m_data->count);
     }
   return *this;
 }
@@ -174,8 +178,13 @@ ByteTagList::Add (TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
       m_data = Allocate (spaceNeeded);
       m_used = 0;
     } 
+#ifdef NS3_MTP
+  // Lists of other threads may append to the same shared data at once
+  else if (m_data->size < spaceNeeded || m_data->count != 1)
+#else
   else if (m_data->size < spaceNeeded ||
            (m_data->count != 1 && m_data->dirty != m_used))
+#endif
     {
       struct ByteTagListData *newData = Allocate (spaceNeeded);
       std::memcpy (&newData->data, &m_data->data, m_used);
@@ -375,8 +384,7 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
       return;
     }
   g_maxSize = std::max (g_maxSize, data->size);
-  data->count--;
-  if (data->count == 0)
+  if (AtomicDecrement (data->count) == 0)
     {
       if (g_freeList.size () > FREE_LIST_SIZE ||
           data->size < g_maxSize)
@@ -413,8 +421,7 @@ ByteTagList::Deallocate (struct ByteTagListData *data)
     {
       return;
     }
-  data->count--;
-  if (data->count == 0)
+  if (AtomicDecrement (data->count) == 0)
     {
       uint8_t *buffer = (uint8_t *)data;
       delete [] buffer;
@@ -77,8 +77,7 @@ PacketMetadata::ReserveCopy (uint32_t size)
   struct PacketMetadata::Data *newData = PacketMetadata::Create (m_used + size);
   memcpy (newData->m_data, m_data->m_data, m_used);
   newData->m_dirtyEnd = m_used;
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (AtomicDecrement (m_data->m_count) == 0) 
     {
       PacketMetadata::Recycle (m_data);
     }
@@ -95,15 +94,27 @@ PacketMetadata::ReserveCopy (uint32_t size)
       Append16 (0xffff, start);
     }
 }
+/*
+ * Items can be written past m_used when the data is not shared, or when this instance
+ * owns the end of the written area. Instances held by other threads may claim that
+ * area at the same time in --enable-mtp builds, so shared data is then always copied.
+ */
+bool
+PacketMetadata::CanAppendInPlace (void) const
+{
+#ifdef NS3_MTP
+  return m_data->m_count == 1;
+#else
+  return m_head == 0xffff || m_data->m_count == 1 || m_data->m_dirtyEnd == m_used;
+#endif
+}
+
 void
 PacketMetadata::Reserve (uint32_t size)
 {
   NS_LOG_FUNCTION (this << size);
   NS_ASSERT (m_data != 0);
-  if (m_data->m_size >= m_used + size &&
-      (m_head == 0xffff ||
-       m_data->m_count == 1 ||
-       m_data->m_dirtyEnd == m_used))
+  if (m_data->m_size >= m_used + size && CanAppendInPlace ())
     {
       /* enough room, not dirty. */
     }
@@ -380,10 +391,7 @@ PacketMetadata::AddSmall (const struct PacketMetadata::SmallItem *item)
   uint32_t typeUidSize = GetUleb128Size (item->typeUid);
   uint32_t sizeSize = GetUleb128Size (item->size);
   uint32_t n =  2 + 2 + typeUidSize + sizeSize + 2;
-  if (m_used + n > m_data->m_size ||
-      (m_head != 0xffff &&
-       m_data->m_count != 1 &&
-       m_used != m_data->m_dirtyEnd))
+  if (m_used + n > m_data->m_size || !CanAppendInPlace ())
     {
       ReserveCopy (n);
     }
@@ -418,10 +426,7 @@ PacketMetadata::AddBig (uint32_t next, uint32_t prev,
   uint32_t fragEndSize = GetUleb128Size (extraItem->fragmentEnd);
   uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2 + fragStartSize + fragEndSize + 4;
 
-  if (m_used + n > m_data->m_size ||
-      (m_head != 0xffff &&
-       m_data->m_count != 1 &&
-       m_used != m_data->m_dirtyEnd))
+  if (m_used + n > m_data->m_size || !CanAppendInPlace ())
     {
       ReserveCopy (n);
     }
@@ -582,6 +587,10 @@ struct PacketMetadata::Data *
 PacketMetadata::Create (uint32_t size)
 {
   NS_LOG_FUNCTION (size);
+#ifdef NS3_MTP
+  // m_maxSize and the free list are shared by all threads
+  return PacketMetadata::Allocate (size);
+#else
   NS_LOG_LOGIC ("create size="<<size<<", max="<<m_maxSize);
   if (size > m_maxSize)
     {
@@ -602,12 +611,16 @@ PacketMetadata::Create (uint32_t size)
     }
   NS_LOG_LOGIC ("create alloc size="<<m_maxSize);
   return PacketMetadata::Allocate (m_maxSize);
+#endif
 }
 
 void
 PacketMetadata::Recycle (struct PacketMetadata::Data *data)
 {
   NS_LOG_FUNCTION (data);
+#ifdef NS3_MTP
+  PacketMetadata::Deallocate (data);
+#else
   if (!m_enable)
     {
       PacketMetadata::Deallocate (data);
@@ -624,6 +637,7 @@ PacketMetadata::Recycle (struct PacketMetadata::Data *data)
     {
       m_freeList.push_back (data);
     }
+#endif
 }
 
 struct PacketMetadata::Data *
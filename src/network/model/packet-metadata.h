@@ -25,6 +25,7 @@
 #include <limits>
 #include "ns3/callback.h"
 #include "ns3/assert.h"
+#include "ns3/atomic-counter.h"
 #include "ns3/type-id.h"
 #include "buffer.h"
 
@@ -320,6 +321,7 @@ public:
   void AppendValueExtra (uint32_t value, uint8_t *buffer);
   inline void Reserve (uint32_t n);
   void ReserveCopy (uint32_t n);
+  inline bool CanAppendInPlace (void) const;
   uint32_t GetTotalSize (void) const;
   uint32_t ReadItems (uint16_t current, 
                       struct PacketMetadata::SmallItem *item,
@@ -385,7 +387,7 @@ PacketMetadata::PacketMetadata (PacketMetadata const &o)
 {
   NS_ASSERT (m_data != 0);
   NS_ASSERT (m_data->m_count < std::numeric_limits<uint32_t>::max());
-  m_data->m_count++;
+  AtomicIncrement (m_data->m_count);
 }
 PacketMetadata &
 PacketMetadata::operator = (PacketMetadata const& o)
@@ -394,14 +396,13 @@ PacketMetadata::operator = (PacketMetadata const& o)
     {
       // not self assignment
       NS_ASSERT (m_data != 0);
-      m_data->m_count--;
-      if (m_data->m_count == 0) 
+      if (AtomicDecrement (m_data->m_count) == 0) 
         {
           PacketMetadata::Recycle (m_data);
         }
       m_data = o.m_data;
       NS_ASSERT (m_data != 0);
-      m_data->m_count++;
+      AtomicIncrement (m_data->m_count);
     }
   m_head = o.m_head;
   m_tail = o.m_tail;
@@ -412,8 +413,7 @@ PacketMetadata::operator = (PacketMetadata const& o)
 PacketMetadata::~PacketMetadata ()
 {
   NS_ASSERT (m_data != 0);
-  m_data->m_count--;
-  if (m_data->m_count == 0) 
+  if (AtomicDecrement (m_data->m_count) == 0) 
     {
       PacketMetadata::Recycle (m_data);
     }
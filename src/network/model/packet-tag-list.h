@@ -22,17 +22,18 @@
 
 /**
 \file   packet-tag-list.h
-\brief  Defines a linked list of Packet tags, including copy-on-write semantics.
+\brief  Defines a small inline array of Packet tags.
 */
 
 #include <stdint.h>
 #include <ostream>
 #include "ns3/type-id.h"
+#include "ns3/assert.h"
+#include "tag.h"
+#include "tag-buffer.h"
 
 namespace ns3 {
 
-class Tag;
-
 /**
  * \ingroup packet
  *
@@ -43,96 +44,35 @@ class Tag;
  *
  * \internal
  *
- * The implementation of this class is a bit tricky.  Refer to this
- * diagram in the discussion that follows.
- *
- * \dot
- *    digraph {
- *        rankdir = "LR";
- *        clusterrank = local;
- *        node [ shape = record, fontname="FreeSans", fontsize="10" ];
- *        oth  [ label="<l> Other branch | <n> next | <c> ..." ];
- *        PTL1 [ label="<l> PacketTagList A | <n> m_next" , shape=Mrecord];
- *        PTL2 [ label="<l> PacketTagList B | <n> m_next" , shape=Mrecord];
- *        oth:n  -> T7:l ;
- *        PTL2:n -> T6:l ;
- *        PTL1:n -> T5:l ;
- *        T1   [ label="<l> T1  | <n> next | <c> count = 1" ];
- *        T2   [ label="<l> T2  | <n> next | <c> count = 1" ];
- *        T3   [ label="<l> T3  | <n> next | <c> count = 2" ];
- *        T4   [ label="<l> T4  | <n> next | <c> count = 1" ];
- *        T5   [ label="<l> T5  | <n> next | <c> count = 2" ];
- *        T6   [ label="<l> T6  | <n> next | <c> count = 1" ];
- *        T7   [ label="<l> T7  | <n> next | <c> count = 1" ];
- *        NULL [ label="0", shape = ellipse ];
- *        subgraph cluster_list {
- *          penwidth = 0;
- *          T6:n -> T5:l ;
- *          T5:n -> T4:l ;
- *          T4:n -> T3:l ;
- *          T7:n -> T3:l ;
- *          T3:n -> T2:l ;
- *          T2:n -> T1:l ;
- *          T1:n -> NULL ;
- *        };
- *      };
- * \enddot
- *
- *   - Tags are stored in serialized form in a tree of TagData
- *     structures. (<tt>T1-T7</tt> in the diagram)
- *
- *   - Each TagData points (\c next pointers in the diagram)
- *     toward the root of the tree, which is a null pointer.
- *
- *   - \c count is the number of incoming pointers to this
- *     TagData.  Branch points, where branches merge or join, have
- *     <tt>count \> 1</tt> (\c T3, \c T5); successive links along
- *     a branch have <tt>count = 1</tt> (\c T1, \c T2, \c T4, \c T6, \c T7).
+ * Packets rarely carry more than a couple of packet tags, while the
+ * tags are added, peeked and removed at every hop. The list is therefore
+ * stored as a small array:
  *
- *   - Each PacketTagList points to a specific TagData,
- *     which is the most recent Tag added to the packet. (<tt>T5-T7</tt>)
+ *   - Up to #INLINE_CAPACITY serialized tags (TagData) are stored inside
+ *     the PacketTagList itself, so the common case never allocates.
+ *     Further tags move the whole array to the heap, doubling its capacity
+ *     as needed.
  *
- *   - Conceptually, therefore, each Packet has a PacketTagList which
- *     points to a singly-linked list of TagData.
+ *   - Tags are kept in insertion order, and iterated most recent first.
  *
- * \par <b> Copy-on-write </b> is implemented as follows:
+ *   - A 64 bit mask, indexed by the TypeId uid of the tags present,
+ *     answers #Peek, #Remove and #Replace for a missing tag type without
+ *     looking at the array. A second mask records the bits shared by
+ *     several tags, so that #Remove only rescans the array on such a
+ *     collision.
  *
- *   - #Add prepends the new tag to the list (growing that branch of the tree,
- *     as \c T6). This is a constant time operation, and does not affect
- *     any other #PacketTagList's, hence this is a \c const function.
- *
- *   - Copy constructor (PacketTagList(const PacketTagList & o))
- *     and assignment (#operator=(const PacketTagList & o)
- *     simply join the tree at the same place as the original
- *     PacketTagList \c o, incrementing the \c count.
- *     For assignment, the old branch is deleted, up to
- *     the first branch point, which has its \c count decremented.
- *     (PacketTagList \c B started as a copy of PacketTagList \c A,
- *     before \c T6 was added to \c B).
- *
- *   - #Remove and #Replace are a little tricky, depending on where the
- *     target tag is found relative to the first branch point:
- *     - \e Target before <em> the first branch point: </em> \n
- *       The target is just dealt with in place (linked around and deleted,
- *       in the case of #Remove; rewritten in the case of #Replace).
- *     - \e Target at or after <em> the first branch point: </em> \n
- *       The portion of the list between the first branch and the target is
- *       shared. This portion is copied before the #Remove or #Replace is
- *       performed.
+ *   - Copies (copy constructor and assignment) copy the serialized tags
+ *     present, there is no sharing between lists.
  *
  * \par <b> Memory Management: </b>
  * \n
  * Packet tags must serialize to a finite maximum size, see TagData
- *
- * This documentation entitles the original author to a free beer.
  */
 class PacketTagList 
 {
 public:
   /**
-   * Tree node for sharing serialized tags.
-   *
-   * See PacketTagList for a discussion of the data structure.
+   * A serialized tag.
    *
    * See TagData::TagData_e for a discussion of the size limit on
    * tag serialization.
@@ -146,15 +86,8 @@ public:
      * in this constant.
      *
      * \internal
-     * Ideally, TagData would be 32 bytes in size, so they require
-     * no padding on 64-bit architectures.  (The architecture
-     * affects the size because of the \c #next pointer.)
-     * This would leave 18 bytes for \c #data.  However,
-     * ns3:Ipv6PacketInfoTag needs 19 bytes!  The current
-     * implementation allows 20 bytes, which gives TagData
-     * a size of 30 bytes on 32-byte machines (which gets
-     * padded with 2 bytes), and 34 bytes on 64-bit machines, which
-     * gets padded to 40 bytes.
+     * ns3:Ipv6PacketInfoTag needs 19 bytes, the current
+     * implementation allows 20 bytes.
      */
     enum TagData_e
     {
@@ -162,11 +95,14 @@ public:
   };
 
     uint8_t data[MAX_SIZE];   /**< Serialization buffer */
-    struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
-    uint32_t count;           /**< Number of incoming links */
   };  /* struct TagData */
 
+  enum
+  {
+    INLINE_CAPACITY = 4       /**< Tags stored without heap allocation */
+  };
+
   /**
    * Create a new PacketTagList.
    */
@@ -175,33 +111,25 @@ public:
    * Copy constructor
    *
    * \param [in] o The PacketTagList to copy.
-   *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
    */
   inline PacketTagList (PacketTagList const &o);
   /**
    * Assignment
    *
    * \param [in] o The PacketTagList to copy.
-   *
-   * This makes a light-weight copy by #RemoveAll, then
-   * pointing to the same \ref TagData as \pname{o}.
    */
   inline PacketTagList &operator = (PacketTagList const &o);
   /**
    * Destructor
-   *
-   * #RemoveAll's the tags up to the first merge.
    */
   inline ~PacketTagList ();
 
   /**
-   * Add a tag to the head of this branch.
+   * Add a tag to the list.
    *
    * \param [in] tag The tag to add
    */
-  void Add (Tag const&tag) const;
+  inline void Add (Tag const&tag) const;
   /**
    * Remove (the first instance of) tag from the list.
    *
@@ -209,7 +137,7 @@ public:
    *          \pname{tag} is set to the value of the tag found.
    * \returns True if \pname{tag} is found, false otherwise.
    */
-  bool Remove (Tag &tag);
+  inline bool Remove (Tag &tag);
   /**
    * Replace the value of a tag.
    *
@@ -219,7 +147,7 @@ public:
    *        If \pname{tag} wasn't found, Add is performed instead (so
    *        the list is guaranteed to have the new tag value either way).
    */
-  bool Replace (Tag &tag);
+  inline bool Replace (Tag &tag);
   /**
    * Find a tag and return its value.
    *
@@ -227,69 +155,50 @@ public:
    *          \pname{tag} is set to the value of the tag found.
    * \returns True if \pname{tag} is found, false otherwise.
    */
-  bool Peek (Tag &tag) const;
+  inline bool Peek (Tag &tag) const;
   /**
-   * Remove all tags from this list (up to the first merge).
+   * Remove all tags from this list.
    */
   inline void RemoveAll (void);
   /**
-   * \returns pointer to head of tag list
+   * \returns pointer to the first (oldest) tag of the list
    */
-  const struct PacketTagList::TagData *Head (void) const;
+  inline const struct PacketTagList::TagData *Begin (void) const;
+  /**
+   * \returns pointer past the last (most recent) tag of the list
+   */
+  inline const struct PacketTagList::TagData *End (void) const;
 
 private:
   /**
-   * Typedef of method function pointer for copy-on-write operations
-   *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True if operation successful, false otherwise
+   * \param [in] tid The tag type
+   * \returns the bit of #m_mask for this tag type
    */
-  typedef bool (PacketTagList::*COWWriter)
-    (Tag       & tag, bool         preMerge,
-    struct TagData * cur, struct TagData ** prevNext);
+  static inline uint64_t MaskBit (TypeId tid);
   /**
-   * Traverse the list implementing copy-on-write, using \pname{Writer}.
-   *
-   * \param [in] tag The tag type to operate on.
-   * \param [in] Writer The copy-on-write function to use.
-   * \returns True if \pname{tag} found, false otherwise.
+   * \param [in] tid The tag type
+   * \returns the index of the tag in the array, or #m_size if missing
    */
-  bool COWTraverse   (Tag & tag, PacketTagList::COWWriter Writer);
+  inline uint16_t Find (TypeId tid) const;
   /**
-   * Copy-on-write implementing Remove.
-   *
-   * \param [in] tag The target tag type to remove.
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *             false otherwise.
-   * \param [in] cur Pointer to the tag.
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag will definitely be removed.
+   * Make room for one more tag once the array is full, moving it to the heap
    */
-  bool RemoveWriter  (Tag       & tag, bool         preMerge,
-                      struct TagData * cur, struct TagData ** prevNext);
+  void Grow (void);
   /**
-   * Copy-on-write implementing Replace
-   *
-   * \param [in] tag The target tag type to replace
-   * \param [in] preMerge True if \pname{tag} was found before the first merge,
-   *          false otherwise.
-   * \param [in] cur Pointer to the tag
-   * \param [in] prevNext Pointer to the struct TagData.next pointer
-   *          pointing to \pname{cur}.
-   * \returns True, since tag value will definitely be replaced.
+   * Rebuild #m_mask and #m_collisions from the tags present
    */
-  bool ReplaceWriter (Tag & tag, bool preMerge, struct TagData * cur, struct TagData ** prevNext);
-
+  void RebuildMasks (void);
   /**
-   * Pointer to first \ref TagData on the list
+   * \param [in] o The PacketTagList to copy into this empty list.
    */
-  struct TagData *m_next;
+  inline void CopyFrom (PacketTagList const &o);
+
+  TagData m_inline[INLINE_CAPACITY]; /**< Inline storage */
+  TagData *m_heap;                   /**< Heap storage, once the inline storage is full */
+  uint16_t m_size;                   /**< Number of tags */
+  uint16_t m_capacity;               /**< Capacity of #m_heap */
+  uint64_t m_mask;                   /**< Bits of the tag types present, see #MaskBit */
+  uint64_t m_collisions;             /**< Bits of #m_mask set by more than one tag */
 };
 
 } // namespace ns3
@@ -301,63 +210,197 @@ private:
 namespace ns3 {
 
 PacketTagList::PacketTagList ()
-  : m_next ()
+  : m_heap (0),
+    m_size (0),
+    m_capacity (0),
+    m_mask (0),
+    m_collisions (0)
 {
 }
 
 PacketTagList::PacketTagList (PacketTagList const &o)
-  : m_next (o.m_next)
+  : m_heap (0),
+    m_size (0),
+    m_capacity (0),
+    m_mask (0),
+    m_collisions (0)
 {
-  if (m_next != 0)
-    {
-      m_next->count++;
-    }
+  CopyFrom (o);
 }
 
 PacketTagList &
 PacketTagList::operator = (PacketTagList const &o)
 {
   // self assignment
-  if (m_next == o.m_next) 
+  if (this == &o) 
     {
       return *this;
     }
   RemoveAll ();
-  m_next = o.m_next;
-  if (m_next != 0) 
-    {
-      m_next->count++;
-    }
+  CopyFrom (o);
   return *this;
 }
 
 PacketTagList::~PacketTagList ()
 {
-  RemoveAll ();
+  delete [] m_heap;
 }
 
 void
 PacketTagList::RemoveAll (void)
 {
-  struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  delete [] m_heap;
+  m_heap = 0;
+  m_capacity = 0;
+  m_size = 0;
+  m_mask = 0;
+  m_collisions = 0;
+}
+
+const struct PacketTagList::TagData *
+PacketTagList::Begin (void) const
+{
+  return m_heap != 0 ? m_heap : m_inline;
+}
+
+const struct PacketTagList::TagData *
+PacketTagList::End (void) const
+{
+  return Begin () + m_size;
+}
+
+uint64_t
+PacketTagList::MaskBit (TypeId tid)
+{
+  return ((uint64_t) 1) << (tid.GetUid () & 63);
+}
+
+void
+PacketTagList::CopyFrom (PacketTagList const &o)
+{
+  // Only the tags present are copied, and a heap list which has shrunk
+  // back to the inline capacity is copied inline.
+  TagData *tags = m_inline;
+  if (o.m_size > INLINE_CAPACITY)
     {
-      cur->count--;
-      if (cur->count > 0) 
-        {
-          break;
-        }
-      if (prev != 0) 
+      m_heap = new TagData[o.m_capacity];
+      m_capacity = o.m_capacity;
+      tags = m_heap;
+    }
+  const TagData *from = o.Begin ();
+  for (uint16_t i = 0; i < o.m_size; i++)
+    {
+      tags[i] = from[i];
+    }
+  m_size = o.m_size;
+  m_mask = o.m_mask;
+  m_collisions = o.m_collisions;
+}
+
+uint16_t
+PacketTagList::Find (TypeId tid) const
+{
+  const TagData *tags = Begin ();
+  for (uint16_t i = 0; i < m_size; i++)
+    {
+      if (tags[i].tid == tid)
         {
-	  delete prev;
+          return i;
         }
-      prev = cur;
     }
-  if (prev != 0) 
+  return m_size;
+}
+
+void
+PacketTagList::Add (const Tag &tag) const
+{
+  TypeId tid = tag.GetInstanceTypeId ();
+  // ensure this id was not yet added
+  NS_ASSERT ((m_mask & MaskBit (tid)) == 0 || Find (tid) == m_size);
+  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
+
+  PacketTagList *self = const_cast<PacketTagList *> (this);
+  if (m_size == (m_heap != 0 ? m_capacity : (uint16_t) INLINE_CAPACITY))
+    {
+      self->Grow ();
+    }
+  TagData *tail = const_cast<TagData *> (End ());
+  tail->tid = tid;
+  tag.Serialize (TagBuffer (tail->data, tail->data + tag.GetSerializedSize ()));
+  self->m_size++;
+  uint64_t bit = MaskBit (tid);
+  self->m_collisions |= m_mask & bit;
+  self->m_mask |= bit;
+}
+
+bool
+PacketTagList::Remove (Tag &tag)
+{
+  TypeId tid = tag.GetInstanceTypeId ();
+  uint64_t bit = MaskBit (tid);
+  if ((m_mask & bit) == 0)
+    {
+      return false;
+    }
+  uint16_t i = Find (tid);
+  if (i == m_size)
+    {
+      return false;
+    }
+  TagData *tags = const_cast<TagData *> (Begin ());
+  tag.Deserialize (TagBuffer (tags[i].data, tags[i].data + TagData::MAX_SIZE));
+  // Keep insertion order
+  m_size--;
+  for (uint16_t j = i; j < m_size; j++)
+    {
+      tags[j] = tags[j + 1];
+    }
+  if ((m_collisions & bit) == 0)
+    {
+      m_mask &= ~bit;
+    }
+  else
+    {
+      // another tag type may share the bit
+      RebuildMasks ();
+    }
+  return true;
+}
+
+bool
+PacketTagList::Replace (Tag &tag)
+{
+  TypeId tid = tag.GetInstanceTypeId ();
+  uint16_t i = ((m_mask & MaskBit (tid)) != 0) ? Find (tid) : m_size;
+  if (i == m_size)
+    {
+      Add (tag);
+      return false;
+    }
+  TagData *tags = const_cast<TagData *> (Begin ());
+  NS_ASSERT (tag.GetSerializedSize () <= TagData::MAX_SIZE);
+  tag.Serialize (TagBuffer (tags[i].data, tags[i].data + tag.GetSerializedSize ()));
+  return true;
+}
+
+bool
+PacketTagList::Peek (Tag &tag) const
+{
+  TypeId tid = tag.GetInstanceTypeId ();
+  if ((m_mask & MaskBit (tid)) == 0)
+    {
+      /* no tag found */
+      return false;
+    }
+  uint16_t i = Find (tid);
+  if (i == m_size)
     {
-      delete prev;
+      return false;
     }
-  m_next = 0;
+  const TagData *tags = Begin ();
+  tag.Deserialize (TagBuffer (const_cast<uint8_t *> (tags[i].data),
+                              const_cast<uint8_t *> (tags[i].data) + TagData::MAX_SIZE));
+  return true;
 }
 
 } // namespace ns3
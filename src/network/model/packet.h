@@ -147,8 +147,10 @@ private:
   Item Next (void);
 private:
   friend class Packet;
-  PacketTagIterator (const struct PacketTagList::TagData *head);
-  const struct PacketTagList::TagData *m_current;
+  PacketTagIterator (const struct PacketTagList::TagData *begin,
+                     const struct PacketTagList::TagData *end);
+  const struct PacketTagList::TagData *m_begin;
+  const struct PacketTagList::TagData *m_current; // One past the next item, tags are visited most recent first
 };
 
 /**
@@ -592,6 +594,7 @@ private:
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector;
 
+  static uint32_t AllocateUid (void);
   static uint32_t m_globalUid;
 };
 
@@ -19,6 +19,8 @@
 #include "ns3/test.h"
 #include "ns3/drop-tail-queue.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/dc-tag.h"
 
 using namespace ns3;
 
@@ -77,6 +79,72 @@ DropTailQueueTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ ((p == 0), true, "There are really no packets in there");
 }
 
+/**
+ * A super-segment should occupy the queue and be marked as its segments
+ * would be, one behind the other.
+ */
+class DropTailQueueSuperSegmentTestCase : public TestCase
+{
+public:
+  DropTailQueueSuperSegmentTestCase ();
+  virtual void DoRun (void);
+
+private:
+  Ptr<Packet> CreateSegments (uint8_t segments);
+};
+
+DropTailQueueSuperSegmentTestCase::DropTailQueueSuperSegmentTestCase ()
+  : TestCase ("Super-segments in the drop tail queue")
+{
+}
+
+Ptr<Packet>
+DropTailQueueSuperSegmentTestCase::CreateSegments (uint8_t segments)
+{
+  Ptr<Packet> p = Create<Packet> (1000 * segments);
+  DcTag tag;
+  tag.SetEct ();
+  if (segments > 1)
+    tag.SetSegments (segments, 60);
+  p->AddPacketTag (tag);
+  return p;
+}
+
+void
+DropTailQueueSuperSegmentTestCase::DoRun (void)
+{
+  Ptr<DropTailQueue> queue = CreateObject<DropTailQueue> ();
+  queue->SetAttribute ("MaxPackets", UintegerValue (8));
+  queue->SetAttribute ("MarkingTh", UintegerValue (3));
+  queue->SetAttribute ("Marking", BooleanValue (true));
+
+  queue->Enqueue (CreateSegments (1));
+  queue->Enqueue (CreateSegments (1));
+  Ptr<Packet> super = CreateSegments (4);
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (super), true, "The super-segment should be accepted");
+
+  DcTag tag;
+  super->PeekPacketTag (tag);
+  NS_TEST_EXPECT_MSG_EQ (tag.IsCe (), true, "The super-segment should be marked");
+  NS_TEST_EXPECT_MSG_EQ ((uint32_t) tag.GetMarkedSegments (), 3, "Segments 2 to 4 find 3 or more packets queued");
+  NS_TEST_EXPECT_MSG_EQ (tag.GetWireSize (super->GetSize ()), 4180, "Each segment should carry its headers");
+
+  // 6 packets are queued for the limit, the next super-segment overshoots it
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (CreateSegments (1)), true, "The 7th packet should be accepted");
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (CreateSegments (4)), true, "The first segment fits, so does the super-segment");
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (CreateSegments (1)), false, "The queue should be full");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 5, "There should be five packets in there");
+
+  for (uint32_t i = 0; i < 3; i++)
+    queue->Dequeue ();
+  // Left: one packet and one super-segment of 4
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (CreateSegments (1)), true, "Dequeued segments should be freed");
+  Ptr<Packet> last = CreateSegments (1);
+  NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (last), true, "6 segments are queued, below the limit");
+  last->PeekPacketTag (tag);
+  NS_TEST_EXPECT_MSG_EQ (tag.IsCe (), true, "6 segments are queued, above the marking threshold");
+}
+
 static class DropTailQueueTestSuite : public TestSuite
 {
 public:
@@ -84,5 +152,6 @@ public:
     : TestSuite ("drop-tail-queue", UNIT)
   {
     AddTestCase (new DropTailQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new DropTailQueueSuperSegmentTestCase (), TestCase::QUICK);
   }
 } g_dropTailQueueTestSuite;
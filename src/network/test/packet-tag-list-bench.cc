@@ -0,0 +1,440 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Compares the Add/Peek/Remove throughput of PacketTagList with the
+ * copy-on-write linked list it replaced, which is kept below for reference
+ * with the same logging. Run it on an optimized build for meaningful numbers:
+ *
+ *   ./test.py --constrain=performance --suite=packet-tag-list-bench --verbose
+ */
+
+#include "ns3/packet-tag-list.h"
+#include "ns3/tag.h"
+#include "ns3/tag-buffer.h"
+#include "ns3/test.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/log.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+
+NS_LOG_COMPONENT_DEFINE ("PacketTagListBench");
+
+using namespace ns3;
+
+namespace {
+
+template <int N>
+class BenchTag : public Tag
+{
+public:
+  static std::string GetName (void)
+  {
+    std::ostringstream oss;
+    oss << "anon::BenchTag<" << N << ">";
+    return oss.str ();
+  }
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId (GetName ().c_str ())
+      .SetParent<Tag> ()
+      .AddConstructor<BenchTag<N> > ()
+    ;
+    return tid;
+  }
+  virtual TypeId GetInstanceTypeId (void) const { return GetTypeId (); }
+  virtual uint32_t GetSerializedSize (void) const { return N; }
+  virtual void Serialize (TagBuffer buf) const
+  {
+    for (uint32_t i = 0; i < N; ++i)
+      {
+        buf.WriteU8 (m_data);
+      }
+  }
+  virtual void Deserialize (TagBuffer buf)
+  {
+    for (uint32_t i = 0; i < N; ++i)
+      {
+        m_data = buf.ReadU8 ();
+      }
+  }
+  virtual void Print (std::ostream &os) const { os << N << "(" << (int)m_data << ")"; }
+  BenchTag () : m_data (0) {}
+  BenchTag (uint8_t data) : m_data (data) {}
+  uint8_t m_data;
+};
+
+/**
+ * The copy-on-write singly linked list of serialized tags PacketTagList
+ * used to be: copies share the list, adding a tag allocates a node and
+ * removing or replacing a shared tag copies the nodes in front of it.
+ */
+class LegacyPacketTagList
+{
+public:
+  struct TagData
+  {
+    enum { MAX_SIZE = 20 };
+    uint8_t data[MAX_SIZE];
+    struct TagData * next;
+    TypeId tid;
+    uint32_t count;
+  };
+
+  LegacyPacketTagList () : m_next (0) {}
+  LegacyPacketTagList (LegacyPacketTagList const &o)
+    : m_next (o.m_next)
+  {
+    if (m_next != 0)
+      {
+        m_next->count++;
+      }
+  }
+  LegacyPacketTagList &operator = (LegacyPacketTagList const &o)
+  {
+    if (m_next == o.m_next)
+      {
+        return *this;
+      }
+    RemoveAll ();
+    m_next = o.m_next;
+    if (m_next != 0)
+      {
+        m_next->count++;
+      }
+    return *this;
+  }
+  ~LegacyPacketTagList ()
+  {
+    RemoveAll ();
+  }
+
+  void Add (Tag const &tag) const
+  {
+    NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ());
+    for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+      {
+        NS_ASSERT (cur->tid != tag.GetInstanceTypeId ());
+      }
+    struct TagData * head = new struct TagData ();
+    head->count = 1;
+    head->tid = tag.GetInstanceTypeId ();
+    head->next = m_next;
+    tag.Serialize (TagBuffer (head->data, head->data + tag.GetSerializedSize ()));
+    const_cast<LegacyPacketTagList *> (this)->m_next = head;
+  }
+  bool Peek (Tag &tag) const
+  {
+    TypeId tid = tag.GetInstanceTypeId ();
+    NS_LOG_FUNCTION (this << tid);
+    for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+      {
+        if (cur->tid == tid)
+          {
+            tag.Deserialize (TagBuffer (cur->data, cur->data + TagData::MAX_SIZE));
+            return true;
+          }
+      }
+    return false;
+  }
+  bool Remove (Tag &tag)
+  {
+    return COWTraverse (tag, &LegacyPacketTagList::RemoveWriter);
+  }
+  bool Replace (Tag &tag)
+  {
+    bool found = COWTraverse (tag, &LegacyPacketTagList::ReplaceWriter);
+    if (!found)
+      {
+        Add (tag);
+      }
+    return found;
+  }
+  void RemoveAll (void)
+  {
+    struct TagData *prev = 0;
+    for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+      {
+        cur->count--;
+        if (cur->count > 0)
+          {
+            break;
+          }
+        if (prev != 0)
+          {
+            delete prev;
+          }
+        prev = cur;
+      }
+    if (prev != 0)
+      {
+        delete prev;
+      }
+    m_next = 0;
+  }
+
+private:
+  typedef bool (LegacyPacketTagList::*COWWriter)
+    (Tag & tag, bool preMerge, struct TagData * cur, struct TagData ** prevNext);
+
+  bool COWTraverse (Tag & tag, COWWriter Writer)
+  {
+    TypeId tid = tag.GetInstanceTypeId ();
+    NS_LOG_FUNCTION (this << tid);
+    struct TagData ** prevNext = &m_next;
+    struct TagData * cur = m_next;
+    while (cur != 0)
+      {
+        if (cur->count > 1)
+          {
+            break;
+          }
+        else if (cur->tid == tid)
+          {
+            return (this->*Writer)(tag, true, cur, prevNext);
+          }
+        prevNext = &cur->next;
+        cur = cur->next;
+      }
+    if (cur == 0)
+      {
+        return false;
+      }
+    struct TagData * it;
+    for (it = cur; it != 0; it = it->next)
+      {
+        if (it->tid == tid)
+          {
+            break;
+          }
+      }
+    if (it == 0)
+      {
+        return false;
+      }
+    while (cur->tid != tid)
+      {
+        cur->count--;
+        struct TagData * copy = new struct TagData ();
+        copy->tid = cur->tid;
+        copy->count = 1;
+        memcpy (copy->data, cur->data, TagData::MAX_SIZE);
+        copy->next = cur->next;
+        copy->next->count++;
+        *prevNext = copy;
+        prevNext = &copy->next;
+        cur = copy->next;
+      }
+    return (this->*Writer)(tag, false, cur, prevNext);
+  }
+  bool RemoveWriter (Tag & tag, bool preMerge, struct TagData * cur, struct TagData ** prevNext)
+  {
+    tag.Deserialize (TagBuffer (cur->data, cur->data + TagData::MAX_SIZE));
+    *prevNext = cur->next;
+    if (preMerge)
+      {
+        delete cur;
+      }
+    else
+      {
+        cur->count--;
+        if (cur->next != 0)
+          {
+            cur->next->count++;
+          }
+      }
+    return true;
+  }
+  bool ReplaceWriter (Tag & tag, bool preMerge, struct TagData * cur, struct TagData ** prevNext)
+  {
+    if (preMerge)
+      {
+        tag.Serialize (TagBuffer (cur->data, cur->data + tag.GetSerializedSize ()));
+      }
+    else
+      {
+        cur->count--;
+        struct TagData * copy = new struct TagData ();
+        copy->tid = tag.GetInstanceTypeId ();
+        copy->count = 1;
+        tag.Serialize (TagBuffer (copy->data, copy->data + tag.GetSerializedSize ()));
+        copy->next = cur->next;
+        if (copy->next != 0)
+          {
+            copy->next->count++;
+          }
+        *prevNext = copy;
+      }
+    return true;
+  }
+
+  struct TagData *m_next;
+};
+
+// Tag types standing for DcTag, a flow id and a timestamp
+typedef BenchTag<2> DcBenchTag;
+typedef BenchTag<4> FlowBenchTag;
+typedef BenchTag<8> TimeBenchTag;
+
+/**
+ * Add a tag and remove it again, as a socket tagging its own packet.
+ */
+template <typename List>
+uint32_t
+AddRemove (uint32_t n)
+{
+  uint32_t sum = 0;
+  List list;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      list.Add (DcBenchTag (i));
+      DcBenchTag tag;
+      list.Remove (tag);
+      sum += tag.m_data;
+    }
+  return sum;
+}
+
+/**
+ * Peek a present and a missing tag in a list of two tags.
+ */
+template <typename List>
+uint32_t
+Peek (uint32_t n)
+{
+  uint32_t sum = 0;
+  List list;
+  list.Add (DcBenchTag (1));
+  list.Add (FlowBenchTag (2));
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      DcBenchTag dc;
+      TimeBenchTag time;
+      sum += list.Peek (dc) + list.Peek (time) + dc.m_data;
+    }
+  return sum;
+}
+
+/**
+ * The life of a data center packet: tagged by the sender, copied into
+ * four queues, which look for the ECN marks and sometimes set CE, then
+ * untagged by the receiver.
+ */
+template <typename List>
+uint32_t
+Path (uint32_t n)
+{
+  uint32_t sum = 0;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      List list;
+      list.Add (FlowBenchTag (i));
+      list.Add (DcBenchTag (1));
+      for (uint32_t hop = 0; hop < 4; ++hop)
+        {
+          List copy (list);
+          DcBenchTag dc;
+          TimeBenchTag time;
+          copy.Peek (dc);
+          copy.Peek (time);
+          if ((i + hop) % 8 == 0)
+            {
+              dc.m_data |= 2;
+              copy.Replace (dc);
+            }
+          list = copy;
+        }
+      DcBenchTag dc;
+      FlowBenchTag flow;
+      list.Remove (dc);
+      list.Remove (flow);
+      sum += dc.m_data + flow.m_data;
+    }
+  return sum;
+}
+
+} // anonymous namespace
+
+class PacketTagListBenchTestCase : public TestCase
+{
+public:
+  PacketTagListBenchTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void Run (uint32_t (*pattern)(uint32_t), uint32_t n, uint32_t &sum, int64_t &ms);
+  void Report (std::string name, uint32_t n, int64_t legacyMs, int64_t ms);
+};
+
+PacketTagListBenchTestCase::PacketTagListBenchTestCase ()
+  : TestCase ("PacketTagList throughput against the copy-on-write list")
+{
+}
+
+void
+PacketTagListBenchTestCase::Run (uint32_t (*pattern)(uint32_t), uint32_t n, uint32_t &sum, int64_t &ms)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  sum = pattern (n);
+  ms = time.End ();
+}
+
+void
+PacketTagListBenchTestCase::Report (std::string name, uint32_t n, int64_t legacyMs, int64_t ms)
+{
+  std::cout << std::left << std::setw (12) << name << std::right
+            << " legacy " << std::setw (10) << (legacyMs ? n * 1000.0 / legacyMs : 0) << " /s"
+            << ", inline " << std::setw (10) << (ms ? n * 1000.0 / ms : 0) << " /s"
+            << std::endl;
+}
+
+void
+PacketTagListBenchTestCase::DoRun (void)
+{
+  const uint32_t n = 20000000;
+  struct
+  {
+    const char *name;
+    uint32_t (*legacy)(uint32_t);
+    uint32_t (*current)(uint32_t);
+  } patterns[] = {
+    { "Add/Remove", &AddRemove<LegacyPacketTagList>, &AddRemove<PacketTagList> },
+    { "Peek", &Peek<LegacyPacketTagList>, &Peek<PacketTagList> },
+    { "Path", &Path<LegacyPacketTagList>, &Path<PacketTagList> },
+  };
+  for (uint32_t i = 0; i < sizeof (patterns) / sizeof (patterns[0]); ++i)
+    {
+      uint32_t legacySum, sum;
+      int64_t legacyMs, ms;
+      Run (patterns[i].legacy, n, legacySum, legacyMs);
+      Run (patterns[i].current, n, sum, ms);
+      NS_TEST_EXPECT_MSG_EQ (sum, legacySum, patterns[i].name << ": both lists should find the same tags");
+      Report (patterns[i].name, n, legacyMs, ms);
+    }
+}
+
+static class PacketTagListBenchTestSuite : public TestSuite
+{
+public:
+  PacketTagListBenchTestSuite ()
+    : TestSuite ("packet-tag-list-bench", PERFORMANCE)
+  {
+    AddTestCase (new PacketTagListBenchTestCase, TestCase::QUICK);
+  }
+} g_packetTagListBenchTestSuite;
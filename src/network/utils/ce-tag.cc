@@ -1,85 +0,0 @@
-/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
-/*
- * Copyright (c) 2008 INRIA
- *
- * This program is free software; you can redistribute it and/or modify
- * it under the terms of the GNU General Public License version 2 as
- * published by the Free Software Foundation;
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * along with this program; if not, write to the Free Software
- * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
- *
- * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
- */
-#include "ce-tag.h"
-#include "ns3/log.h"
-
-NS_LOG_COMPONENT_DEFINE ("CeTag");
-
-namespace ns3 {
-
-NS_OBJECT_ENSURE_REGISTERED (CeTag);
-
-TypeId 
-CeTag::GetTypeId (void)
-{
-  static TypeId tid = TypeId ("ns3::CeTag")
-    .SetParent<Tag> ()
-    .AddConstructor<CeTag> ()
-  ;
-  return tid;
-}
-TypeId 
-CeTag::GetInstanceTypeId (void) const
-{
-  return GetTypeId ();
-}
-uint32_t 
-CeTag::GetSerializedSize (void) const
-{
-  NS_LOG_FUNCTION (this);
-  return 1;
-}
-void 
-CeTag::Serialize (TagBuffer buf) const
-{
-  NS_LOG_FUNCTION (this << &buf);
-  buf.WriteU8 (m_ce);
-}
-void 
-CeTag::Deserialize (TagBuffer buf)
-{
-  NS_LOG_FUNCTION (this << &buf);
-  m_ce = buf.ReadU8();
-}
-void 
-CeTag::Print (std::ostream &os) const
-{
-  NS_LOG_FUNCTION (this << &os);
-  os << "Congestion Experienced  = " << (int)m_ce;
-}
-CeTag::CeTag ()
-  : Tag () 
-{
-  NS_LOG_FUNCTION (this);
-}
-void
-CeTag::SetCe (uint8_t ce)
-{
-  NS_LOG_FUNCTION (this << ce);
-  m_ce = ce;
-}
-uint8_t
-CeTag::GetCe (void) const
-{
-  NS_LOG_FUNCTION (this);
-  return m_ce;
-}
-
-} // namespace ns3
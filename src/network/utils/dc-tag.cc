@@ -0,0 +1,208 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#include "dc-tag.h"
+#include "ns3/log.h"
+
+NS_LOG_COMPONENT_DEFINE ("DcTag");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (DcTag);
+
+TypeId 
+DcTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DcTag")
+    .SetParent<Tag> ()
+    .AddConstructor<DcTag> ()
+  ;
+  return tid;
+}
+TypeId 
+DcTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t 
+DcTag::GetSerializedSize (void) const
+{
+  return (m_flags & (SUPER | ECHO)) ? 12 : 2;
+}
+void 
+DcTag::Serialize (TagBuffer buf) const
+{
+  buf.WriteU8 (m_flags);
+  buf.WriteU8 (m_ecmp);
+  if (m_flags & (SUPER | ECHO))
+    {
+      buf.WriteU8 (m_segments);
+      buf.WriteU8 (m_overhead);
+      buf.WriteU64 (m_ceMask);
+    }
+}
+void 
+DcTag::Deserialize (TagBuffer buf)
+{
+  m_flags = buf.ReadU8 ();
+  m_ecmp = buf.ReadU8 ();
+  if (m_flags & (SUPER | ECHO))
+    {
+      m_segments = buf.ReadU8 ();
+      m_overhead = buf.ReadU8 ();
+      m_ceMask = buf.ReadU64 ();
+    }
+}
+void 
+DcTag::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "ECT=" << IsEct () << " CE=" << IsCe () << " ECE=" << IsEce () << " Control=" << IsControl ();
+  if (HasEcmp ())
+    {
+      os << " ECMP=" << (int) m_ecmp;
+    }
+  if (m_flags & SUPER)
+    {
+      os << " Segments=" << (int) m_segments << " Marked=" << (int) GetMarkedSegments ();
+    }
+  if (m_flags & ECHO)
+    {
+      os << " Echoed=" << (int) m_segments << " Marked=" << (int) GetMarkedSegments ();
+    }
+}
+DcTag::DcTag ()
+  : Tag (),
+    m_flags (0),
+    m_ecmp (0),
+    m_segments (1),
+    m_overhead (0),
+    m_ceMask (0)
+{
+}
+uint8_t
+DcTag::GetFlags (void) const
+{
+  return m_flags;
+}
+void
+DcTag::SetEct (void)
+{
+  m_flags |= ECT;
+}
+bool
+DcTag::IsEct (void) const
+{
+  return m_flags & ECT;
+}
+void
+DcTag::SetCe (void)
+{
+  m_flags |= CE;
+}
+bool
+DcTag::IsCe (void) const
+{
+  return m_flags & CE;
+}
+void
+DcTag::SetEce (void)
+{
+  m_flags |= ECE;
+}
+bool
+DcTag::IsEce (void) const
+{
+  return m_flags & ECE;
+}
+void
+DcTag::SetControl (void)
+{
+  m_flags |= CONTROL;
+}
+bool
+DcTag::IsControl (void) const
+{
+  return m_flags & CONTROL;
+}
+void
+DcTag::SetEcmp (uint8_t ecmp)
+{
+  m_flags |= ECMP;
+  m_ecmp = ecmp;
+}
+bool
+DcTag::HasEcmp (void) const
+{
+  return m_flags & ECMP;
+}
+uint8_t
+DcTag::GetEcmp (void) const
+{
+  return m_ecmp;
+}
+void
+DcTag::SetSegments (uint8_t segments, uint8_t overhead)
+{
+  NS_ASSERT (segments >= 1 && segments <= 64);
+  m_flags |= SUPER;
+  m_segments = segments;
+  m_overhead = overhead;
+}
+uint8_t
+DcTag::GetSegments (void) const
+{
+  return (m_flags & SUPER) ? m_segments : 1;
+}
+uint8_t
+DcTag::GetSegmentOverhead (void) const
+{
+  return (m_flags & SUPER) ? m_overhead : 0;
+}
+uint32_t
+DcTag::GetWireSize (uint32_t size) const
+{
+  return size + (GetSegments () - 1) * GetSegmentOverhead ();
+}
+void
+DcTag::SetCe (uint8_t segment)
+{
+  NS_ASSERT (segment < GetSegments ());
+  m_flags |= CE;
+  m_ceMask |= (uint64_t) 1 << segment;
+}
+uint8_t
+DcTag::GetMarkedSegments (void) const
+{
+  if (!(m_flags & (SUPER | ECHO)))
+    return (m_flags & (CE | ECE)) ? 1 : 0;
+  return __builtin_popcountll (m_ceMask);
+}
+void
+DcTag::SetEcho (uint8_t segments, uint8_t marked)
+{
+  NS_ASSERT (!(m_flags & SUPER) && marked <= segments && marked <= 64);
+  m_flags |= ECHO;
+  m_segments = segments;
+  m_ceMask = marked < 64 ? ((uint64_t) 1 << marked) - 1 : ~(uint64_t) 0;
+}
+uint8_t
+DcTag::GetEchoedSegments (void) const
+{
+  return (m_flags & ECHO) ? m_segments : 0;
+}
+
+} // namespace ns3
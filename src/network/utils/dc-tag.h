@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#ifndef DC_TAG_H
+#define DC_TAG_H
+
+#include "ns3/tag.h"
+
+namespace ns3 {
+
+/**
+ * \brief Data center metadata of a packet: ECN bits, control packet flag
+ * and explicit ECMP path index, packed in two bytes.
+ *
+ * Senders build the whole tag and add it once, queues peek it once and only
+ * rewrite it to set CE, receivers remove it once.
+ *
+ * A super-segment (SetSegments) is one packet standing for several back to
+ * back segments of the same size. Its tag also carries the number of
+ * segments, the header bytes each of them would carry on the wire and which
+ * of them were marked CE, so queues and links can account for them one by
+ * one. An ACK of super-segments echoes how many segments it covers and how
+ * many of them were marked (SetEcho).
+ */
+class DcTag : public Tag
+{
+public:
+  enum Flags
+  {
+    ECT     = 1,  // ECN capable transport
+    CE      = 2,  // Congestion experienced, set by the queues
+    ECE     = 4,  // ECN echo, set on acks
+    CONTROL = 8,  // Control packet, never dropped nor marked by the queues
+    ECMP    = 16, // The ECMP path index is set
+    SUPER   = 32, // Super-segment, see SetSegments
+    ECHO    = 64  // ACK echoing segment and CE counts, see SetEcho
+  };
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+
+  DcTag ();
+  uint8_t GetFlags (void) const;
+  void SetEct (void);
+  bool IsEct (void) const;
+  void SetCe (void);
+  bool IsCe (void) const;
+  void SetEce (void);
+  bool IsEce (void) const;
+  void SetControl (void);
+  bool IsControl (void) const;
+  void SetEcmp (uint8_t ecmp);
+  bool HasEcmp (void) const;
+  uint8_t GetEcmp (void) const;
+  void SetSegments (uint8_t segments, uint8_t overhead);
+  uint8_t GetSegments (void) const;               // 1 unless this is a super-segment
+  uint8_t GetSegmentOverhead (void) const;        // Header bytes below the payload of each segment
+  uint32_t GetWireSize (uint32_t size) const;     // Bytes of the segments once split, size is the packet size
+  void SetCe (uint8_t segment);                   // Mark one segment of a super-segment, and the packet
+  uint8_t GetMarkedSegments (void) const;         // CE segments, or CE segments echoed
+  void SetEcho (uint8_t segments, uint8_t marked);
+  uint8_t GetEchoedSegments (void) const;         // 0 unless SetEcho
+
+private:
+  uint8_t m_flags;
+  uint8_t m_ecmp;
+  uint8_t m_segments;
+  uint8_t m_overhead;
+  uint64_t m_ceMask;  // Bit i: segment i was marked CE
+};
+
+} // namespace ns3
+
+#endif /* DC_TAG_H */
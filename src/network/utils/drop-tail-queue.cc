@@ -20,9 +20,7 @@
 #include "ns3/enum.h"
 #include "ns3/uinteger.h"
 #include "drop-tail-queue.h"
-#include "ns3/ce-tag.h" //Morteza
-#include "ns3/control-tag.h" //Morteza
-#include "ns3/ect-tag.h" //Morteza
+#include "ns3/dc-tag.h" //Morteza
 
 
 NS_LOG_COMPONENT_DEFINE ("DropTailQueue");
@@ -71,7 +69,8 @@ TypeId DropTailQueue::GetTypeId (void)
 DropTailQueue::DropTailQueue () :
   Queue (),
   m_packets (),
-  m_bytesInQueue (0)
+  m_bytesInQueue (0),
+  m_extraSegments (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -100,19 +99,21 @@ DropTailQueue::DoEnqueue (Ptr<Packet> p)
 {
   NS_LOG_FUNCTION (this << p);
 
-  ControlTag controlTag;
-  bool isControlPkt = p->PeekPacketTag(controlTag);
-  EctTag ectTag;
-  bool isEct = p->PeekPacketTag(ectTag);
+  DcTag dcTag;
+  bool hasDcTag = p->PeekPacketTag (dcTag);
+  bool isControlPkt = hasDcTag && dcTag.IsControl ();
+  bool isEct = hasDcTag && dcTag.IsEct ();
+  uint32_t segments = dcTag.GetSegments ();
+  uint32_t size = dcTag.GetWireSize (p->GetSize ());
 
-  if (m_mode == QUEUE_MODE_PACKETS && (m_packets.size () >= m_maxPackets) && !isControlPkt)
+  if (m_mode == QUEUE_MODE_PACKETS && (m_packets.size () + m_extraSegments >= m_maxPackets) && !isControlPkt)
     {
       NS_LOG_LOGIC ("Queue full (at max packets) -- droppping pkt");
       Drop (p);
       return false;
     }
 
-  if (m_mode == QUEUE_MODE_BYTES && (m_bytesInQueue + p->GetSize () >= m_maxBytes) && !isControlPkt)
+  if (m_mode == QUEUE_MODE_BYTES && (m_bytesInQueue + size / segments >= m_maxBytes) && !isControlPkt)
     {
       NS_LOG_LOGIC ("Queue full (packet would exceed max bytes) -- droppping pkt");
       Drop (p);
@@ -122,38 +123,55 @@ DropTailQueue::DoEnqueue (Ptr<Packet> p)
   if (m_isMarking)
     {
       uint32_t queueSize;
+      uint32_t step;
       if (m_mode == QUEUE_MODE_BYTES)
-        queueSize = m_bytesInQueue;
+        {
+          queueSize = m_bytesInQueue;
+          step = size / segments;
+        }
       else if (m_mode == QUEUE_MODE_PACKETS)
-        queueSize = m_packets.size ();
+        {
+          queueSize = m_packets.size () + m_extraSegments;
+          step = 1;
+        }
 
-      if (queueSize >= m_markingTh)
-        { // We do not mark control packets && packet should be ECN capable (ECT)
+      bool marked = false;
+      for (uint32_t i = 0; i < segments; i++)
+        {
+          if (queueSize + i * step < m_markingTh)
+            continue;
+          // We do not mark control packets && packet should be ECN capable (ECT)
           if (isEct)
             {
-              CeTag ceTag;
-              bool exist = p->PeekPacketTag (ceTag);
-              if (!exist && !isControlPkt)
+              if (segments > 1 && !isControlPkt)
+                {
+                  dcTag.SetCe (i);
+                  marked = true;
+                }
+              else if (!dcTag.IsCe () && !isControlPkt)
                 {
-                  ceTag.SetCe (1);
-                  p->AddPacketTag (ceTag);
+                  dcTag.SetCe ();
+                  marked = true;
                 }
             }
           else if (!isEct && isControlPkt)
             {
               // Do not drop control packets, when marking threshold has been reached!
             }
-          else
+          else if (i == 0)
             {
               NS_LOG_LOGIC ("Queue non-ECT packet need to be drop when Red reaches it marking threshold!");
               Drop (p);
               return false;
             }
         }
+      if (marked)
+        p->ReplacePacketTag (dcTag);
     }
 
   if (!isControlPkt)
-    m_bytesInQueue += p->GetSize ();
+    m_bytesInQueue += size;
+  m_extraSegments += segments - 1;
   m_packets.push (p);
 
   NS_LOG_LOGIC ("Number packets " << m_packets.size ());
@@ -174,11 +192,12 @@ DropTailQueue::DoDequeue (void)
     }
 
   Ptr<Packet> p = m_packets.front ();
-  ControlTag controlTag;
-  bool isControlPkt = p->PeekPacketTag(controlTag);
+  DcTag dcTag;
+  bool isControlPkt = p->PeekPacketTag (dcTag) && dcTag.IsControl ();
   m_packets.pop ();
   if (!isControlPkt)
-    m_bytesInQueue -= p->GetSize ();
+    m_bytesInQueue -= dcTag.GetWireSize (p->GetSize ());
+  m_extraSegments -= dcTag.GetSegments () - 1;
 
   NS_LOG_LOGIC ("Popped " << p);
 
@@ -32,6 +32,11 @@ class TraceContainer;
  * \ingroup queue
  *
  * \brief A FIFO packet queue that drops tail-end packets on overflow
+ *
+ * A super-segment (see DcTag::SetSegments) occupies the queue as its
+ * segments would, and each segment is marked as if it had been enqueued on
+ * its own behind the previous ones. It is dropped as a whole when its first
+ * segment would be, the following ones are always accepted.
  */
 class DropTailQueue : public Queue {
 public:
@@ -69,6 +74,7 @@ private:
   uint32_t m_maxPackets;
   uint32_t m_maxBytes;
   uint32_t m_bytesInQueue;
+  uint32_t m_extraSegments;  // Segments of the queued super-segments beyond their first one
   uint32_t m_markingTh;
   bool     m_isMarking;
   QueueMode m_mode;
@@ -65,9 +65,7 @@
 #include "ns3/random-variable-stream.h"
 #include "red-queue.h"
 #include "ns3/flow-id-tag.h"
-#include "ns3/ce-tag.h"
-#include "ns3/ect-tag.h"
-#include "ns3/control-tag.h"
+#include "ns3/dc-tag.h"
 
 NS_LOG_COMPONENT_DEFINE ("RedQueue");
 
@@ -162,6 +160,7 @@ RedQueue::RedQueue () :
   Queue (),
   m_packets (),
   m_bytesInQueue (0),
+  m_extraSegments (0),
   m_hasRedStarted (false)
 {
   NS_LOG_FUNCTION (this);
@@ -231,19 +230,111 @@ RedQueue::DoEnqueue (Ptr<Packet> p)
       m_hasRedStarted = true;
     }
 
+  DcTag dcTag;
+  bool hasDcTag = p->PeekPacketTag (dcTag);
+  bool isControlPkt = hasDcTag && dcTag.IsControl ();
+  // Extract ECT bit
+  bool isEct = hasDcTag && dcTag.IsEct ();
+  uint32_t segments = dcTag.GetSegments ();
+  uint32_t size = dcTag.GetWireSize (p->GetSize ()) / segments;
+
   uint32_t nQueued = 0;
+  uint32_t step = 0;
 
   if (GetMode () == QUEUE_MODE_BYTES)
     {
       NS_LOG_DEBUG ("Enqueue in bytes mode");
       nQueued = m_bytesInQueue;
+      step = size;
     }
   else if (GetMode () == QUEUE_MODE_PACKETS)
     {
       NS_LOG_DEBUG ("Enqueue in packets mode");
-      nQueued = m_packets.size ();
+      nQueued = m_packets.size () + m_extraSegments;
+      step = 1;
     }
 
+  // Each segment of a super-segment arrives behind the previous ones
+  bool marked = false;
+  for (uint32_t i = 0; i < segments; i++)
+    {
+      uint32_t dropType = Arrive (size, nQueued + i * step, isControlPkt);
+
+      // Try to mark ECN bits first
+      if (dropType == DTYPE_UNFORCED_SOFT || dropType == DTYPE_UNFORCED_HARD)
+        {
+          if (m_useCurrent && isEct) // This means running red with DCTCP
+            {
+              if (segments > 1 && !isControlPkt)
+                {
+                  dcTag.SetCe (i);
+                  marked = true;
+                }
+              else if (!dcTag.IsCe () && !isControlPkt)
+                {
+                  dcTag.SetCe ();
+                  marked = true;
+                }
+              m_stats.marked++;
+              dropType = DTYPE_NONE; // We marked ECN bits! Packet shouldn't be dropped
+            }
+          else if (m_useCurrent && isControlPkt)
+            { // Control packets
+              dropType = DTYPE_NONE;
+            }
+        }
+
+      if (dropType == DTYPE_NONE)
+        {
+          continue;
+        }
+      else if (i > 0)
+        {
+          NS_LOG_DEBUG ("\t Not dropping segment " << i << " of a super-segment");
+          continue;
+        }
+
+      if (dropType == DTYPE_UNFORCED_SOFT) //DTYPE_UNFORCED
+        {
+          NS_LOG_DEBUG ("\t Dropping due to Prob Mark " << m_qAvg);
+          m_stats.unforcedDrop++;
+          Drop (p);
+          return false;
+        }
+      else if (dropType == DTYPE_FORCED || dropType == DTYPE_UNFORCED_HARD)
+        {
+          NS_LOG_DEBUG ("\t Dropping due to Hard Mark " << m_qAvg);
+          if (dropType == DTYPE_FORCED)
+            m_stats.qLimDrop++;
+          m_stats.forcedDrop++;
+          Drop (p);
+          if (m_isNs1Compat)
+            {
+              m_count = 0;
+              m_countBytes = 0;
+            }
+          return false;
+        }
+    }
+  if (marked)
+    p->ReplacePacketTag (dcTag);
+
+  if (!isControlPkt) // If not control packet then add pkt size to the queue size
+    m_bytesInQueue += dcTag.GetWireSize (p->GetSize ());
+  m_extraSegments += segments - 1;
+  m_packets.push_back (p);
+
+  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
+  NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
+
+  return true;
+}
+
+uint32_t
+RedQueue::Arrive (uint32_t size, uint32_t nQueued, bool isControlPkt)
+{
+  NS_LOG_FUNCTION (this << size << nQueued << isControlPkt);
+
   // simulate number of packets arrival during idle period
   uint32_t m = 0;
 
@@ -276,7 +367,7 @@ RedQueue::DoEnqueue (Ptr<Packet> p)
   NS_LOG_DEBUG ("\t packetsInQueue  " << m_packets.size () << "\tQavg " << m_qAvg);
 
   m_count++;
-  m_countBytes += p->GetSize ();
+  m_countBytes += size;
 
   uint32_t dropType = DTYPE_NONE;
   if (m_qAvg >= m_minTh && nQueued > 1)
@@ -296,10 +387,10 @@ RedQueue::DoEnqueue (Ptr<Packet> p)
            * above "minthresh" with a nonempty queue.
            */
           m_count = 1;
-          m_countBytes = p->GetSize ();
+          m_countBytes = size;
           m_old = 1;
         }
-      else if (DropEarly (p, nQueued))
+      else if (DropEarly (size, nQueued))
         {
           NS_LOG_LOGIC ("DropEarly returns 1");
           dropType = DTYPE_UNFORCED_SOFT; // dropType = DTYPE_UNFORCED;
@@ -312,67 +403,13 @@ RedQueue::DoEnqueue (Ptr<Packet> p)
       m_old = 0;
     }
 
-  ControlTag controlPkt;
-  bool isControlPkt = p->PeekPacketTag(controlPkt);
   if (nQueued >= m_queueLimit && !isControlPkt)
     {
-      NS_LOG_DEBUG ("\t Dropping due to Queue Full " << nQueued);
+      NS_LOG_DEBUG ("\t Queue Full " << nQueued);
       dropType = DTYPE_FORCED;
-      m_stats.qLimDrop++;
-    }
-
-  // Extract ECT bit
-  EctTag ectTag;
-  bool isEct =  p->PeekPacketTag(ectTag);
-	// Try to mark ECN bits first
-  if (dropType == DTYPE_UNFORCED_SOFT || dropType == DTYPE_UNFORCED_HARD)
-    {
-      if (m_useCurrent && isEct) // This means running red with DCTCP
-        {
-          CeTag ceTag;
-          bool exist = p->PeekPacketTag (ceTag);
-          if (!exist && !isControlPkt)
-            {
-              ceTag.SetCe (1);
-              p->AddPacketTag (ceTag);
-            }
-          m_stats.marked++;
-          dropType = DTYPE_NONE; // We marked ECN bits! Packet shouldn't be dropped
-        }
-      else if (m_useCurrent && isControlPkt)
-        { // Control packets
-          dropType = DTYPE_NONE;
-        }
     }
 
-  if (dropType == DTYPE_UNFORCED_SOFT) //DTYPE_UNFORCED
-    {
-      NS_LOG_DEBUG ("\t Dropping due to Prob Mark " << m_qAvg);
-      m_stats.unforcedDrop++;
-      Drop (p);
-      return false;
-    }
-  else if (dropType == DTYPE_FORCED || dropType == DTYPE_UNFORCED_HARD)
-    {
-      NS_LOG_DEBUG ("\t Dropping due to Hard Mark " << m_qAvg);
-      m_stats.forcedDrop++;
-      Drop (p);
-      if (m_isNs1Compat)
-        {
-          m_count = 0;
-          m_countBytes = 0;
-        }
-      return false;
-    }
-
-  if (!isControlPkt) // If not control packet then add pkt size to the queue size
-    m_bytesInQueue += p->GetSize ();
-  m_packets.push_back (p);
-
-  NS_LOG_LOGIC ("Number packets " << m_packets.size ());
-  NS_LOG_LOGIC ("Number bytes " << m_bytesInQueue);
-
-  return true;
+  return dropType;
 }
 
 /*
@@ -479,13 +516,13 @@ RedQueue::Estimator (uint32_t nQueued, uint32_t m, double qAvg, double qW)
   return newAve;
 }
 
-// Check if packet p needs to be dropped due to probability mark
+// Check if a packet of this size needs to be dropped due to probability mark
 uint32_t
-RedQueue::DropEarly (Ptr<Packet> p, uint32_t qSize)
+RedQueue::DropEarly (uint32_t size, uint32_t qSize)
 {
-  NS_LOG_FUNCTION (this << p << qSize);
+  NS_LOG_FUNCTION (this << size << qSize);
   m_vProb1 = CalculatePNew (m_qAvg, m_maxTh, m_isGentle, m_vA, m_vB, m_vC, m_vD, m_curMaxP);
-  m_vProb = ModifyP (m_vProb1, m_count, m_countBytes, m_meanPktSize, m_isWait, p->GetSize ());
+  m_vProb = ModifyP (m_vProb1, m_count, m_countBytes, m_meanPktSize, m_isWait, size);
 
   // Drop probability is computed, pick random number and act
   if (m_cautious == 1)
@@ -644,7 +681,7 @@ RedQueue::GetQueueSize (void)
     }
   else if (GetMode () == QUEUE_MODE_PACKETS)
     {
-      return m_packets.size ();
+      return m_packets.size () + m_extraSegments;
     }
   else
     {
@@ -669,11 +706,12 @@ RedQueue::DoDequeue (void)
     {
       m_idle = 0;
       Ptr<Packet> p = m_packets.front ();
-      ControlTag controlTag;
-      bool isControlpkt = p->PeekPacketTag(controlTag);
+      DcTag dcTag;
+      bool isControlpkt = p->PeekPacketTag (dcTag) && dcTag.IsControl ();
       m_packets.pop_front ();
       if (!isControlpkt)
-        m_bytesInQueue -= p->GetSize ();
+        m_bytesInQueue -= dcTag.GetWireSize (p->GetSize ());
+      m_extraSegments -= dcTag.GetSegments () - 1;
 
       NS_LOG_LOGIC ("Popped " << p);
 
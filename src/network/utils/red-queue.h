@@ -78,6 +78,10 @@ class UniformRandomVariable;
  * \ingroup queue
  *
  * \brief A RED packet queue
+ *
+ * The segments of a super-segment (see DcTag::SetSegments) go through RED
+ * one by one, as back to back arrivals. The super-segment is dropped as a
+ * whole when its first segment is, later drops are not applied.
  */
 class RedQueue : public Queue
 {
@@ -185,8 +189,10 @@ private:
   void InitializeParams (void);
   // Compute the average queue size
   double Estimator (uint32_t nQueued, uint32_t m, double qAvg, double qW);
-  // Check if packet p needs to be dropped due to probability mark
-  uint32_t DropEarly (Ptr<Packet> p, uint32_t qSize);
+  // Update the average for the arrival of one packet or segment and return its drop type
+  uint32_t Arrive (uint32_t size, uint32_t nQueued, bool isControlPkt);
+  // Check if a packet of this size needs to be dropped due to probability mark
+  uint32_t DropEarly (uint32_t size, uint32_t qSize);
   // Returns a probability using these function parameters for the DropEarly funtion
   double CalculatePNew (double qAvg, double maxTh, bool gentle, double vA,
                         double vB, double vC, double vD, double maxP);
@@ -197,6 +203,7 @@ private:
   std::list<Ptr<Packet> > m_packets;
 
   uint32_t m_bytesInQueue;
+  uint32_t m_extraSegments;  // Segments of the queued super-segments beyond their first one
   bool m_hasRedStarted;
   Stats m_stats;
 
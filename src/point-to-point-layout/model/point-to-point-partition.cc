@@ -0,0 +1,300 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <functional>
+
+// ns3 includes
+#include "ns3/log.h"
+#include "ns3/point-to-point-partition.h"
+#include "ns3/node.h"
+#include "ns3/uinteger.h"
+
+NS_LOG_COMPONENT_DEFINE ("PointToPointPartitionHelper");
+
+namespace ns3 {
+
+static const uint32_t NONE = 0xffffffff;
+
+PointToPointPartitionHelper::PointToPointPartitionHelper ()
+  : m_imbalance (0.1),
+    m_lookAhead (Time::Max ()),
+    m_cutTraffic (0)
+{
+}
+
+PointToPointPartitionHelper::~PointToPointPartitionHelper ()
+{
+}
+
+void
+PointToPointPartitionHelper::SetImbalance (double imbalance)
+{
+  m_imbalance = imbalance;
+}
+
+uint32_t
+PointToPointPartitionHelper::GetIndex (Ptr<Node> node)
+{
+  std::map<uint32_t, uint32_t>::const_iterator i = m_index.find (node->GetId ());
+  if (i != m_index.end ())
+    {
+      return i->second;
+    }
+  m_index[node->GetId ()] = m_nodes.size ();
+  m_nodes.push_back (node);
+  return m_nodes.size () - 1;
+}
+
+void
+PointToPointPartitionHelper::AddLink (Ptr<Node> a, Ptr<Node> b, Time delay, double traffic)
+{
+  Link link;
+  link.a = GetIndex (a);
+  link.b = GetIndex (b);
+  link.delay = delay;
+  link.traffic = traffic;
+  m_links.push_back (link);
+}
+
+Time
+PointToPointPartitionHelper::GetLookAhead (void) const
+{
+  return m_lookAhead;
+}
+
+double
+PointToPointPartitionHelper::GetCutTraffic (void) const
+{
+  return m_cutTraffic;
+}
+
+double
+PointToPointPartitionHelper::Split (const std::vector<uint32_t> &group, uint32_t nGroups,
+                                    uint32_t systems, std::vector<uint32_t> &assignment) const
+{
+  std::vector<double> weight (nGroups, 0);
+  std::vector<std::map<uint32_t, double> > adjacent (nGroups);
+  double total = 0;
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      uint32_t a = group[i->a];
+      uint32_t b = group[i->b];
+      weight[a] += i->traffic;
+      weight[b] += i->traffic;
+      total += 2 * i->traffic;
+      if (a != b)
+        {
+          adjacent[a][b] += i->traffic;
+          adjacent[b][a] += i->traffic;
+        }
+    }
+  double average = total / systems;
+  double maxLoad = average * (1 + m_imbalance);
+
+  // Grow the systems one after the other from the heaviest group left,
+  // adding the group most connected to the system until it has its share.
+  std::vector<uint32_t> part (nGroups, NONE);
+  std::vector<double> load (systems, 0);
+  uint32_t unassigned = nGroups;
+  for (uint32_t s = 0; s + 1 < systems; s++)
+    {
+      std::vector<double> connection (nGroups, 0);
+      bool empty = true;
+      while (unassigned > systems - s - 1 && load[s] < average)
+        {
+          uint32_t best = NONE;
+          for (uint32_t g = 0; g < nGroups; g++)
+            {
+              if (part[g] != NONE || (!empty && load[s] + weight[g] > maxLoad))
+                {
+                  continue;
+                }
+              if (best == NONE || connection[g] > connection[best]
+                  || (connection[g] == connection[best] && weight[g] > weight[best]))
+                {
+                  best = g;
+                }
+            }
+          if (best == NONE)
+            {
+              break;
+            }
+          part[best] = s;
+          load[s] += weight[best];
+          unassigned--;
+          empty = false;
+          for (std::map<uint32_t, double>::const_iterator j = adjacent[best].begin (); j != adjacent[best].end (); ++j)
+            {
+              connection[j->first] += j->second;
+            }
+        }
+    }
+  for (uint32_t g = 0; g < nGroups; g++)
+    {
+      if (part[g] == NONE)
+        {
+          part[g] = systems - 1;
+          load[systems - 1] += weight[g];
+        }
+    }
+
+  // Then move single groups while this cuts less traffic without
+  // overloading a system, or relieves an overloaded one.
+  for (uint32_t iteration = 0; iteration < 4 * nGroups; iteration++)
+    {
+      uint32_t heaviest = std::max_element (load.begin (), load.end ()) - load.begin ();
+      uint32_t bestGroup = NONE;
+      uint32_t bestSystem = NONE;
+      double bestGain = 0;
+      bool balancing = false;
+      for (uint32_t g = 0; g < nGroups; g++)
+        {
+          std::vector<double> connection (systems, 0);
+          for (std::map<uint32_t, double>::const_iterator j = adjacent[g].begin (); j != adjacent[g].end (); ++j)
+            {
+              connection[part[j->first]] += j->second;
+            }
+          uint32_t from = part[g];
+          for (uint32_t s = 0; s < systems; s++)
+            {
+              if (s == from)
+                {
+                  continue;
+                }
+              double gain = connection[s] - connection[from];
+              bool relieves = from == heaviest && load[from] > maxLoad && load[s] + weight[g] < load[from];
+              bool improves = gain > 0 && load[s] + weight[g] <= maxLoad;
+              if (!(relieves || improves))
+                {
+                  continue;
+                }
+              if (bestGroup == NONE || (relieves && !balancing) || (relieves == balancing && gain > bestGain))
+                {
+                  bestGroup = g;
+                  bestSystem = s;
+                  bestGain = gain;
+                  balancing = relieves;
+                }
+            }
+        }
+      if (bestGroup == NONE)
+        {
+          break;
+        }
+      load[part[bestGroup]] -= weight[bestGroup];
+      load[bestSystem] += weight[bestGroup];
+      part[bestGroup] = bestSystem;
+    }
+
+  assignment.resize (group.size ());
+  for (uint32_t i = 0; i < group.size (); i++)
+    {
+      assignment[i] = part[group[i]];
+    }
+  return average > 0 ? *std::max_element (load.begin (), load.end ()) / average : 1;
+}
+
+static uint32_t
+FindRoot (std::vector<uint32_t> &parent, uint32_t i)
+{
+  while (parent[i] != i)
+    {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+  return i;
+}
+
+void
+PointToPointPartitionHelper::Partition (NodeContainer nodes, uint32_t systems)
+{
+  NS_LOG_FUNCTION (this << systems);
+  for (NodeContainer::Iterator i = nodes.Begin (); i != nodes.End (); ++i)
+    {
+      GetIndex (*i);
+    }
+  uint32_t n = m_nodes.size ();
+  std::vector<uint32_t> assignment (n, 0);
+
+  // Try the lookaheads from the largest: links shorter than the
+  // lookahead keep their nodes together, and the first lookahead which
+  // gives balanced systems wins.
+  std::vector<Time> delays;
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (i->delay.IsStrictlyPositive ())
+        {
+          delays.push_back (i->delay);
+        }
+    }
+  std::sort (delays.begin (), delays.end (), std::greater<Time> ());
+  delays.erase (std::unique (delays.begin (), delays.end ()), delays.end ());
+
+  for (uint32_t d = 0; systems > 1 && d < delays.size (); d++)
+    {
+      std::vector<uint32_t> parent (n);
+      for (uint32_t i = 0; i < n; i++)
+        {
+          parent[i] = i;
+        }
+      for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+        {
+          if (i->delay < delays[d])
+            {
+              uint32_t a = FindRoot (parent, i->a);
+              uint32_t b = FindRoot (parent, i->b);
+              parent[std::max (a, b)] = std::min (a, b);
+            }
+        }
+      std::vector<uint32_t> group (n, NONE);
+      uint32_t nGroups = 0;
+      for (uint32_t i = 0; i < n; i++)
+        {
+          uint32_t root = FindRoot (parent, i);
+          if (group[root] == NONE)
+            {
+              group[root] = nGroups++;
+            }
+          group[i] = group[root];
+        }
+      double imbalance = Split (group, nGroups, systems, assignment);
+      NS_LOG_INFO ("lookahead " << delays[d] << ": " << nGroups << " groups, heaviest system at "
+                                << imbalance << " of the average load");
+      if (imbalance <= 1 + m_imbalance)
+        {
+          break;
+        }
+    }
+
+  m_lookAhead = Time::Max ();
+  m_cutTraffic = 0;
+  for (std::vector<Link>::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+    {
+      if (assignment[i->a] != assignment[i->b])
+        {
+          m_lookAhead = std::min (m_lookAhead, i->delay);
+          m_cutTraffic += i->traffic;
+        }
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      m_nodes[i]->SetAttribute ("SystemId", UintegerValue (assignment[i]));
+    }
+  NS_LOG_INFO ("lookahead " << m_lookAhead << ", cut traffic " << m_cutTraffic);
+}
+
+} // namespace ns3
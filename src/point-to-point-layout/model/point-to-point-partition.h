@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Define an object to split a point-to-point topology between the
+// systems of a distributed simulation.
+
+#ifndef POINT_TO_POINT_PARTITION_HELPER_H
+#define POINT_TO_POINT_PARTITION_HELPER_H
+
+#include <vector>
+#include <map>
+
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup point-to-point-layout
+ *
+ * \brief A helper to assign the system ids of a distributed simulation
+ * to the nodes of a point-to-point topology
+ *
+ * The links of the topology are described with AddLink before they are
+ * installed, together with the traffic they are expected to carry.
+ * Partition then sets the SystemId attribute of the nodes so that:
+ *
+ *   - links shorter than the lookahead are never cut, the lookahead
+ *     being as large as the balance of the systems allows;
+ *   - the systems carry about the same load, the load of a node being
+ *     the traffic of its links;
+ *   - the traffic of the links cut between systems is small.
+ *
+ * Links installed afterwards by PointToPointHelper between nodes of
+ * different systems use a PointToPointRemoteChannel once MPI is enabled.
+ */
+class PointToPointPartitionHelper
+{
+public:
+  PointToPointPartitionHelper ();
+  ~PointToPointPartitionHelper ();
+
+  /**
+   * \param imbalance how much heavier than the average a system may be,
+   *        0.1 by default
+   */
+  void SetImbalance (double imbalance);
+
+  /**
+   * \param a one end of the link
+   * \param b the other end of the link
+   * \param delay the propagation delay of the link
+   * \param traffic the expected traffic of the link, in any unit
+   *        shared by all the links
+   */
+  void AddLink (Ptr<Node> a, Ptr<Node> b, Time delay, double traffic = 1.0);
+
+  /**
+   * Set the SystemId attribute of the nodes, including the nodes of
+   * the container which have no link.
+   *
+   * \param nodes all the nodes of the topology
+   * \param systems the number of systems, e.g. MpiInterface::GetSize ()
+   */
+  void Partition (NodeContainer nodes, uint32_t systems);
+
+  /**
+   * \returns the smallest delay of the links between two systems
+   */
+  Time GetLookAhead (void) const;
+
+  /**
+   * \returns the traffic of the links between two systems
+   */
+  double GetCutTraffic (void) const;
+
+private:
+  struct Link
+  {
+    uint32_t a;
+    uint32_t b;
+    Time delay;
+    double traffic;
+  };
+
+  uint32_t GetIndex (Ptr<Node> node);
+  double Split (const std::vector<uint32_t> &group, uint32_t nGroups,
+                uint32_t systems, std::vector<uint32_t> &assignment) const;
+
+  std::vector<Ptr<Node> > m_nodes;
+  std::map<uint32_t, uint32_t> m_index;
+  std::vector<Link> m_links;
+  double m_imbalance;
+  Time m_lookAhead;
+  double m_cutTraffic;
+};
+
+} // namespace ns3
+
+#endif /* POINT_TO_POINT_PARTITION_HELPER_H */
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/point-to-point-partition.h"
+
+using namespace ns3;
+
+class PointToPointPartitionCutTest : public TestCase
+{
+public:
+  PointToPointPartitionCutTest ();
+  virtual void DoRun (void);
+};
+
+PointToPointPartitionCutTest::PointToPointPartitionCutTest ()
+  : TestCase ("Check that two busy cliques are split at their idle bridge")
+{
+}
+
+void
+PointToPointPartitionCutTest::DoRun (void)
+{
+  NodeContainer nodes;
+  nodes.Create (8);
+  PointToPointPartitionHelper partition;
+  for (uint32_t c = 0; c < 8; c += 4)
+    {
+      for (uint32_t i = c; i < c + 4; i++)
+        {
+          for (uint32_t j = i + 1; j < c + 4; j++)
+            {
+              partition.AddLink (nodes.Get (i), nodes.Get (j), MilliSeconds (1), 10);
+            }
+        }
+    }
+  partition.AddLink (nodes.Get (3), nodes.Get (4), MilliSeconds (1), 1);
+  partition.Partition (nodes, 2);
+
+  NS_TEST_ASSERT_MSG_EQ (partition.GetCutTraffic (), 1, "more than the bridge is cut");
+  NS_TEST_ASSERT_MSG_EQ (partition.GetLookAhead (), MilliSeconds (1), "wrong lookahead");
+  for (uint32_t i = 1; i < 8; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ ((nodes.Get (i)->GetSystemId () == nodes.Get (0)->GetSystemId ()), (i < 4),
+                             "node " << i << " in the wrong system");
+    }
+  Simulator::Destroy ();
+}
+
+class PointToPointPartitionLookAheadTest : public TestCase
+{
+public:
+  PointToPointPartitionLookAheadTest ();
+  virtual void DoRun (void);
+};
+
+PointToPointPartitionLookAheadTest::PointToPointPartitionLookAheadTest ()
+  : TestCase ("Check that short links are only cut to balance the systems")
+{
+}
+
+void
+PointToPointPartitionLookAheadTest::DoRun (void)
+{
+  // 0 --10ms-- 1 --1ms-- 2 --10ms-- 3
+  NodeContainer nodes;
+  nodes.Create (4);
+  PointToPointPartitionHelper partition;
+  partition.AddLink (nodes.Get (0), nodes.Get (1), MilliSeconds (10));
+  partition.AddLink (nodes.Get (1), nodes.Get (2), MilliSeconds (1));
+  partition.AddLink (nodes.Get (2), nodes.Get (3), MilliSeconds (10));
+
+  // keeping 1 and 2 together loads a system with 4 of the 6 link ends
+  partition.SetImbalance (0.5);
+  partition.Partition (nodes, 2);
+  NS_TEST_ASSERT_MSG_EQ (partition.GetLookAhead (), MilliSeconds (10), "short link cut");
+  NS_TEST_ASSERT_MSG_EQ (nodes.Get (1)->GetSystemId (), nodes.Get (2)->GetSystemId (), "short link cut");
+  NS_TEST_ASSERT_MSG_EQ (partition.GetCutTraffic (), 2, "wrong cut");
+
+  partition.SetImbalance (0.1);
+  partition.Partition (nodes, 2);
+  NS_TEST_ASSERT_MSG_EQ (partition.GetLookAhead (), MilliSeconds (1), "systems not balanced");
+  NS_TEST_ASSERT_MSG_EQ (nodes.Get (0)->GetSystemId (), nodes.Get (1)->GetSystemId (), "wrong split");
+  NS_TEST_ASSERT_MSG_EQ (nodes.Get (2)->GetSystemId (), nodes.Get (3)->GetSystemId (), "wrong split");
+  NS_TEST_ASSERT_MSG_EQ (partition.GetCutTraffic (), 1, "wrong cut");
+  Simulator::Destroy ();
+}
+
+class PointToPointPartitionTestSuite : public TestSuite
+{
+public:
+  PointToPointPartitionTestSuite ();
+};
+
+PointToPointPartitionTestSuite::PointToPointPartitionTestSuite ()
+  : TestSuite ("point-to-point-partition", UNIT)
+{
+  AddTestCase (new PointToPointPartitionCutTest, TestCase::QUICK);
+  AddTestCase (new PointToPointPartitionLookAheadTest, TestCase::QUICK);
+}
+
+static PointToPointPartitionTestSuite g_pointToPointPartitionTestSuite;
@@ -22,6 +22,7 @@
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
 #include "ns3/log.h"
+#include "ns3/core-config.h"
 
 NS_LOG_COMPONENT_DEFINE ("PointToPointChannel");
 
@@ -94,6 +95,11 @@ PointToPointChannel::TransmitStart (
 
   uint32_t wire = src == m_link[0].m_src ? 0 : 1;
 
+#ifdef NS3_MTP
+  // The receiver may run on another thread of MultithreadedSimulatorImpl
+  // while the sender still holds the packet: hand it a copy of its own.
+  p = p->Copy ();
+#endif
   Simulator::ScheduleWithContext (m_link[wire].m_dst->GetNode ()->GetId (),
                                   txTime + m_delay, &PointToPointNetDevice::Receive,
                                   m_link[wire].m_dst, p);
@@ -25,6 +25,7 @@
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
 #include "ns3/pointer.h"
+#include "ns3/dc-tag.h"
 #include "point-to-point-net-device.h"
 #include "point-to-point-channel.h"
 #include "ppp-header.h"
@@ -219,7 +220,15 @@ PointToPointNetDevice::TransmitStart (Ptr<Packet> p)
   m_currentPkt = p;
   m_phyTxBeginTrace (m_currentPkt);
 
-  Time txTime = Seconds (m_bps.CalculateTxTime (p->GetSize ()));
+  // A super-segment takes as long as its segments would, each with its own headers
+  uint32_t size = p->GetSize ();
+  DcTag dcTag;
+  if (p->PeekPacketTag (dcTag) && dcTag.GetSegments () > 1)
+    {
+      size = dcTag.GetWireSize (size) + (dcTag.GetSegments () - 1) * PppHeader ().GetSerializedSize ();
+    }
+
+  Time txTime = Seconds (m_bps.CalculateTxTime (size));
   Time txCompleteTime = txTime + m_tInterframeGap;
 
   NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << txCompleteTime.GetSeconds () << "sec");
@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Micro-benchmark of the MPTCP connection level DataBuffer. Each iteration
+ * pushes one segment through the sending buffer (FillBuffer -> CreatePacket)
+ * and the receiving buffer (ReadPacket -> Recv), as SendDataPacket and
+ * ReceivedData do. The previous byte-per-element queue is kept here as a
+ * reference point.
+ */
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/packet.h"
+#include "ns3/mp-tcp-typedefs.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <queue>
+#include <string.h>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+static const uint32_t g_segmentSize = 1400;
+static const uint32_t g_bufferSize = 50000000;
+
+// The DataBuffer implementation we used to have: one queue element per byte.
+class ByteQueueBuffer
+{
+public:
+  ByteQueueBuffer (uint32_t size) : bufMaxSize (size) {}
+  uint32_t Add (uint32_t size)
+  {
+    uint32_t toWrite = std::min (size, (bufMaxSize - (uint32_t) buffer.size ()));
+    for (uint32_t i = 0; i < toWrite; i++)
+      buffer.push ((uint8_t) i);
+    return toWrite;
+  }
+  Ptr<Packet> CreatePacket (uint32_t size)
+  {
+    uint32_t quantity = std::min (size, (uint32_t) buffer.size ());
+    for (uint32_t i = 0; i < quantity; i++)
+      buffer.pop ();
+    return Create<Packet> (quantity);
+  }
+  uint32_t ReadPacket (Ptr<Packet> pkt, uint32_t dataLen)
+  {
+    uint32_t toWrite = std::min (dataLen, (bufMaxSize - (uint32_t) buffer.size ()));
+    for (uint32_t i = 0; i < toWrite; i++)
+      buffer.push (0);
+    return toWrite;
+  }
+  uint32_t Retrieve (uint32_t size)
+  {
+    uint32_t quantity = std::min (size, (uint32_t) buffer.size ());
+    for (uint32_t i = 0; i < quantity; i++)
+      buffer.pop ();
+    return quantity;
+  }
+private:
+  std::queue<uint8_t> buffer;
+  uint32_t bufMaxSize;
+};
+
+template <typename T>
+static void
+benchSegments (T &tx, T &rx, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      tx.Add (g_segmentSize);
+      Ptr<Packet> p = tx.CreatePacket (g_segmentSize);
+      rx.ReadPacket (p, p->GetSize ());
+      rx.Retrieve (g_segmentSize);
+    }
+}
+
+static void
+benchByteQueue (uint32_t n)
+{
+  ByteQueueBuffer tx (g_bufferSize);
+  ByteQueueBuffer rx (g_bufferSize);
+  benchSegments (tx, rx, n);
+}
+
+static void
+benchCounter (uint32_t n)
+{
+  DataBuffer tx (g_bufferSize);
+  DataBuffer rx (g_bufferSize);
+  benchSegments (tx, rx, n);
+}
+
+static void
+runBench (void (*bench) (uint32_t), uint32_t n, char const *name)
+{
+  SystemWallClockMs time;
+  time.Start ();
+  (*bench) (n);
+  uint64_t deltaMs = time.End ();
+  double ps = n;
+  ps *= 1000;
+  ps /= (deltaMs > 0 ? deltaMs : 1);
+  std::cout << ps << " segments/s"
+            << " (" << deltaMs << " ms elapsed)\t"
+            << name
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  while (argc > 0) {
+      if (strncmp ("--n=", argv[0],strlen ("--n=")) == 0)
+        {
+          char const *nAscii = argv[0] + strlen ("--n=");
+          std::istringstream iss;
+          iss.str (nAscii);
+          iss >> n;
+        }
+      argc--;
+      argv++;
+  }
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of segments must be specified " <<
+        "by command-line argument --n=(number of segments)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-mptcp-buffer with n=" << n
+            << " segments of " << g_segmentSize << " bytes" << std::endl;
+
+  runBench (&benchByteQueue, n, "Byte-per-element queue (previous DataBuffer)");
+  runBench (&benchCounter, n, "DataBuffer, byte counting");
+
+  return 0;
+}
@@ -0,0 +1,234 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Replay a trace of scheduler operations against every scheduler.
+ *
+ * Traces are written by ns3::RecordingScheduler, for instance with
+ *   ./waf --run "amp_model --SchedulerType=ns3::RecordingScheduler
+ *                --ns3::RecordingScheduler::FileName=amp.trace"
+ * Without --file a synthetic data center pattern is replayed: bursts of events at the
+ * same time, packet events a few microseconds ahead, and retransmission timers 200 ms
+ * ahead which are mostly cancelled, that is dequeued without effect.
+ * Each event dequeued is checked against the trace, so a scheduler which reorders
+ * events is reported.
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <set>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+struct Op
+{
+  char op;
+  Scheduler::EventKey key;
+};
+
+std::vector<Op>
+ReadTrace (std::string filename)
+{
+  std::vector<Op> ops;
+  std::ifstream input (filename.c_str (), std::ios::in | std::ios::binary);
+  if (!input.good ())
+    {
+      NS_FATAL_ERROR ("Cannot open " << filename);
+    }
+  Op op;
+  op.key.m_context = 0;
+  while (input.read (&op.op, 1)
+         && input.read (reinterpret_cast<char *> (&op.key.m_ts), sizeof (op.key.m_ts))
+         && input.read (reinterpret_cast<char *> (&op.key.m_uid), sizeof (op.key.m_uid)))
+    {
+      ops.push_back (op);
+    }
+  return ops;
+}
+
+std::vector<Op>
+SyntheticTrace (uint32_t flows, uint32_t total)
+{
+  std::vector<Op> ops;
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  std::set<std::pair<uint64_t, uint32_t> > pending;
+  uint64_t now = 0;
+  uint32_t uid = 0;
+  Op op;
+  op.key.m_context = 0;
+  for (uint32_t i = 0; i < flows; i++)
+    {
+      op.op = 'i';
+      op.key.m_ts = rng->GetInteger (0, 1000);
+      op.key.m_uid = uid++;
+      ops.push_back (op);
+      pending.insert (std::make_pair (op.key.m_ts, op.key.m_uid));
+    }
+  while (uid < total)
+    {
+      op.op = 'r';
+      op.key.m_ts = pending.begin ()->first;
+      op.key.m_uid = pending.begin ()->second;
+      ops.push_back (op);
+      pending.erase (pending.begin ());
+      now = op.key.m_ts;
+      // A packet event schedules the next hop a serialization time ahead, a burst of
+      // events at the same time, and now and then re-arms a retransmission timer.
+      uint32_t n = rng->GetInteger (0, 2);
+      for (uint32_t j = 0; j < n; j++)
+        {
+          op.op = 'i';
+          double kind = rng->GetValue ();
+          if (kind < 0.2)
+            {
+              op.key.m_ts = now;
+            }
+          else if (kind < 0.9)
+            {
+              op.key.m_ts = now + rng->GetInteger (120, 12000);
+            }
+          else
+            {
+              op.key.m_ts = now + 200000000 + rng->GetInteger (0, 100000);
+            }
+          op.key.m_uid = uid++;
+          ops.push_back (op);
+          pending.insert (std::make_pair (op.key.m_ts, op.key.m_uid));
+        }
+      if (pending.empty ())
+        {
+          op.op = 'i';
+          op.key.m_ts = now + 1000;
+          op.key.m_uid = uid++;
+          ops.push_back (op);
+          pending.insert (std::make_pair (op.key.m_ts, op.key.m_uid));
+        }
+    }
+  return ops;
+}
+
+void
+Replay (std::string type, const std::vector<Op> &ops)
+{
+  ObjectFactory factory;
+  factory.SetTypeId (type);
+  Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+
+  uint32_t errors = 0;
+  uint32_t pending = 0;
+  uint32_t maxPending = 0;
+  SystemWallClockMs time;
+  time.Start ();
+  for (std::vector<Op>::const_iterator i = ops.begin (); i != ops.end (); ++i)
+    {
+      Scheduler::Event ev;
+      ev.impl = 0;
+      ev.key = i->key;
+      switch (i->op)
+        {
+        case 'i':
+          scheduler->Insert (ev);
+          pending++;
+          maxPending = std::max (maxPending, pending);
+          break;
+        case 'r':
+          ev = scheduler->RemoveNext ();
+          pending--;
+          if (ev.key.m_uid != i->key.m_uid)
+            {
+              errors++;
+            }
+          break;
+        case 'x':
+          scheduler->Remove (ev);
+          pending--;
+          break;
+        default:
+          NS_FATAL_ERROR ("Unknown operation " << i->op);
+        }
+    }
+  while (!scheduler->IsEmpty ())
+    {
+      scheduler->RemoveNext ();
+    }
+  double s = time.End () / 1000.0;
+  LOG (std::left << std::setw (22) << type
+       << std::right << std::setw (10) << s
+       << std::setw (14) << (s > 0 ? ops.size () / s : 0)
+       << std::setw (12) << s / ops.size () * 1e9
+       << std::setw (10) << maxPending
+       << std::setw (8) << errors);
+}
+
+int main (int argc, char *argv[])
+{
+  std::string filename = "";
+  uint32_t flows = 10000;
+  uint32_t total = 2000000;
+  uint32_t runs = 1;
+  bool list = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("file",  "trace written by ns3::RecordingScheduler", filename);
+  cmd.AddValue ("flows", "synthetic trace: events pending at start (default 1E4)", flows);
+  cmd.AddValue ("total", "synthetic trace: events inserted (default 2E6)", total);
+  cmd.AddValue ("runs",  "number of replays per scheduler (default 1)", runs);
+  cmd.AddValue ("list",  "also replay on ListScheduler, which is O(n) per insert", list);
+  cmd.Parse (argc, argv);
+
+  std::vector<Op> ops;
+  if (filename == "")
+    {
+      ops = SyntheticTrace (flows, total);
+      LOG ("synthetic trace: " << ops.size () << " operations");
+    }
+  else
+    {
+      ops = ReadTrace (filename);
+      LOG (filename << ": " << ops.size () << " operations");
+    }
+
+  std::vector<std::string> types;
+  if (list)
+    {
+      types.push_back ("ns3::ListScheduler");
+    }
+  types.push_back ("ns3::MapScheduler");
+  types.push_back ("ns3::HeapScheduler");
+  types.push_back ("ns3::CalendarScheduler");
+  types.push_back ("ns3::LadderScheduler");
+
+  LOG (std::left << std::setw (22) << "Scheduler"
+       << std::right << std::setw (10) << "Time (s)"
+       << std::setw (14) << "Rate (op/s)"
+       << std::setw (12) << "Per (ns/op)"
+       << std::setw (10) << "Pending"
+       << std::setw (8) << "Errors");
+  for (uint32_t r = 0; r < runs; r++)
+    {
+      for (std::vector<std::string>::const_iterator i = types.begin (); i != types.end (); ++i)
+        {
+          Replay (*i, ops);
+        }
+    }
+  return 0;
+}
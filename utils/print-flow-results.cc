@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Prints the per flow results files written by FlowResultsSink (Csv or
+ * Binary format) as one CSV table on the standard output, e.g.
+ *
+ *   ./waf --run "print-flow-results results_1.data results_2.data" > all.csv
+ *
+ * With --summary, prints the number of flows, the mean goodput and the mean
+ * and 99th percentile flow completion time of each file instead.
+ */
+#include "ns3/flow-results-sink.h"
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h> // for exit ()
+
+using namespace ns3;
+
+static void
+printSummary (std::string fileName, const std::vector<FlowResult> &results)
+{
+  std::vector<double> fct;
+  double goodput = 0;
+  for (std::vector<FlowResult>::const_iterator it = results.begin (); it != results.end (); ++it)
+    {
+      fct.push_back (it->fct);
+      goodput += it->goodput;
+    }
+  std::cout << fileName << ": " << results.size () << " flows";
+  if (!results.empty ())
+    {
+      std::sort (fct.begin (), fct.end ());
+      double meanFct = 0;
+      for (uint32_t i = 0; i < fct.size (); i++)
+        {
+          meanFct += fct[i];
+        }
+      std::cout << ", goodput " << goodput / results.size () << " Mbps"
+                << ", FCT mean " << meanFct / fct.size () << " s"
+                << ", p99 " << fct[(fct.size () - 1) * 99 / 100] << " s";
+    }
+  std::cout << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  bool summary = false;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++)
+    {
+      if (strcmp ("--summary", argv[i]) == 0)
+        {
+          summary = true;
+        }
+      else
+        {
+          files.push_back (argv[i]);
+        }
+    }
+  if (files.empty ())
+    {
+      std::cerr << "Usage: print-flow-results [--summary] FILE..." << std::endl;
+      exit (1);
+    }
+
+  if (!summary)
+    {
+      FlowResultsSink::PrintCsvHeader (std::cout);
+    }
+  for (uint32_t i = 0; i < files.size (); i++)
+    {
+      FlowResultsReader reader;
+      if (!reader.Open (files[i]))
+        {
+          std::cerr << files[i] << ": not a Csv or Binary flow results file" << std::endl;
+          exit (1);
+        }
+      std::vector<FlowResult> results;
+      FlowResult r;
+      while (reader.Read (r))
+        {
+          if (summary)
+            {
+              results.push_back (r);
+            }
+          else
+            {
+              FlowResultsSink::PrintCsv (std::cout, r);
+            }
+        }
+      if (summary)
+        {
+          printSummary (files[i], results);
+        }
+    }
+  return 0;
+}